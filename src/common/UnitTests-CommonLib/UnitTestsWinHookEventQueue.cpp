@@ -0,0 +1,160 @@
+#include "pch.h"
+
+#include "win_hook_event_queue.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsWinHookEventQueue
+{
+    HWND Window(size_t id)
+    {
+        return reinterpret_cast<HWND>(id);
+    }
+
+    WinHookEvent Event(DWORD event, size_t window, DWORD time = 0)
+    {
+        return { event, Window(window), OBJID_WINDOW, CHILDID_SELF, 0, time };
+    }
+
+    TEST_CLASS (WinHookEventQueueTests)
+    {
+    public:
+        TEST_METHOD (PushReportsWhenThePendingBatchWasEmpty)
+        {
+            WinHookEventQueue queue;
+            Assert::IsTrue(queue.empty());
+            Assert::IsTrue(queue.push(Event(EVENT_SYSTEM_MOVESIZESTART, 1)));
+            Assert::IsFalse(queue.push(Event(EVENT_SYSTEM_MOVESIZEEND, 1)));
+            Assert::IsFalse(queue.empty());
+        }
+        TEST_METHOD (LocationChangesOfTheSameWindowObjectAreCoalesced)
+        {
+            WinHookEventQueue queue;
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 1));
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 2));
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 3));
+
+            std::vector<WinHookEvent> batch;
+            queue.swap_batch(batch);
+            Assert::AreEqual(size_t{ 1 }, batch.size());
+            Assert::AreEqual(DWORD{ 3 }, batch[0].dwmsEventTime);
+            Assert::AreEqual(size_t{ 2 }, queue.coalesced_count());
+        }
+        TEST_METHOD (ChangesOfDifferentWindowsOrObjectsAreNotCoalesced)
+        {
+            WinHookEventQueue queue;
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1));
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 2));
+            WinHookEvent caret = Event(EVENT_OBJECT_LOCATIONCHANGE, 2);
+            caret.idObject = OBJID_CARET;
+            queue.push(caret);
+            queue.push(Event(EVENT_OBJECT_NAMECHANGE, 2));
+
+            std::vector<WinHookEvent> batch;
+            queue.swap_batch(batch);
+            Assert::AreEqual(size_t{ 4 }, batch.size());
+            Assert::AreEqual(size_t{ 0 }, queue.coalesced_count());
+        }
+        TEST_METHOD (ChangesAreNotCoalescedAcrossAnotherEventOfTheWindow)
+        {
+            WinHookEventQueue queue;
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 1));
+            queue.push(Event(EVENT_SYSTEM_MOVESIZEEND, 1, 2));
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 3));
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 4));
+
+            std::vector<WinHookEvent> batch;
+            queue.swap_batch(batch);
+            Assert::AreEqual(size_t{ 3 }, batch.size());
+            Assert::AreEqual(DWORD{ 1 }, batch[0].dwmsEventTime);
+            Assert::AreEqual(DWORD{ EVENT_SYSTEM_MOVESIZEEND }, batch[1].event);
+            Assert::AreEqual(DWORD{ 4 }, batch[2].dwmsEventTime);
+        }
+        TEST_METHOD (SwapBatchStartsANewGeneration)
+        {
+            WinHookEventQueue queue;
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 1));
+
+            std::vector<WinHookEvent> batch;
+            queue.swap_batch(batch);
+            Assert::IsTrue(queue.empty());
+
+            // The event taken by the batch must not be coalesced with the next one
+            Assert::IsTrue(queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 2)));
+            Assert::AreEqual(size_t{ 1 }, batch.size());
+            Assert::AreEqual(DWORD{ 1 }, batch[0].dwmsEventTime);
+            Assert::AreEqual(size_t{ 0 }, queue.coalesced_count());
+
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1, 3));
+            queue.swap_batch(batch);
+            Assert::AreEqual(size_t{ 1 }, batch.size());
+            Assert::AreEqual(DWORD{ 3 }, batch[0].dwmsEventTime);
+            Assert::AreEqual(size_t{ 1 }, queue.coalesced_count());
+        }
+        TEST_METHOD (ClearStartsANewGeneration)
+        {
+            WinHookEventQueue queue;
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1));
+            queue.clear();
+            Assert::IsTrue(queue.empty());
+            Assert::IsTrue(queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, 1)));
+            Assert::AreEqual(size_t{ 0 }, queue.coalesced_count());
+        }
+        TEST_METHOD (OverflowDropsTheNewLocationChange)
+        {
+            WinHookEventQueue queue;
+            for (size_t i = 1; i <= WinHookEventQueue::capacity; ++i)
+            {
+                queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, i));
+            }
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, WinHookEventQueue::capacity + 1));
+
+            std::vector<WinHookEvent> batch;
+            queue.swap_batch(batch);
+            Assert::AreEqual(WinHookEventQueue::capacity, batch.size());
+            Assert::IsTrue(Window(WinHookEventQueue::capacity) == batch.back().hwnd);
+            Assert::AreEqual(size_t{ 1 }, queue.dropped_count());
+        }
+        TEST_METHOD (OverflowEvictsTheOldestLocationChangeForOtherEvents)
+        {
+            WinHookEventQueue queue;
+            queue.push(Event(EVENT_SYSTEM_MOVESIZESTART, 1));
+            for (size_t i = 2; i <= WinHookEventQueue::capacity; ++i)
+            {
+                queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, i));
+            }
+            queue.push(Event(EVENT_SYSTEM_MOVESIZEEND, 1));
+            queue.push(Event(EVENT_SYSTEM_MENUSTART, WinHookEventQueue::capacity + 1));
+            Assert::AreEqual(size_t{ 2 }, queue.dropped_count());
+
+            // The positions moved by the evictions are still found for coalescing
+            queue.push(Event(EVENT_OBJECT_LOCATIONCHANGE, WinHookEventQueue::capacity, 1));
+            Assert::AreEqual(size_t{ 1 }, queue.coalesced_count());
+
+            std::vector<WinHookEvent> batch;
+            queue.swap_batch(batch);
+            Assert::AreEqual(WinHookEventQueue::capacity, batch.size());
+            Assert::AreEqual(DWORD{ EVENT_SYSTEM_MOVESIZESTART }, batch[0].event);
+            Assert::IsTrue(Window(4) == batch[1].hwnd);
+            Assert::IsTrue(Window(WinHookEventQueue::capacity) == batch[WinHookEventQueue::capacity - 3].hwnd);
+            Assert::AreEqual(DWORD{ 1 }, batch[WinHookEventQueue::capacity - 3].dwmsEventTime);
+            Assert::AreEqual(DWORD{ EVENT_SYSTEM_MOVESIZEEND }, batch[WinHookEventQueue::capacity - 2].event);
+            Assert::AreEqual(DWORD{ EVENT_SYSTEM_MENUSTART }, batch[WinHookEventQueue::capacity - 1].event);
+        }
+        TEST_METHOD (OverflowDropsOtherEventsOnlyWhenNothingCanBeEvicted)
+        {
+            WinHookEventQueue queue;
+            for (size_t i = 1; i <= WinHookEventQueue::capacity; ++i)
+            {
+                queue.push(Event(EVENT_SYSTEM_MOVESIZEEND, i));
+            }
+            queue.push(Event(EVENT_OBJECT_INVOKED, WinHookEventQueue::capacity + 1));
+
+            std::vector<WinHookEvent> batch;
+            queue.swap_batch(batch);
+            Assert::AreEqual(WinHookEventQueue::capacity, batch.size());
+            Assert::AreEqual(DWORD{ EVENT_SYSTEM_MOVESIZEEND }, batch.back().event);
+            Assert::AreEqual(size_t{ 1 }, queue.dropped_count());
+        }
+    };
+}
@@ -0,0 +1,85 @@
+#include "pch.h"
+
+#include "win_hook_event_ranges.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTestsWinHookEventRanges
+{
+    void AssertRanges(const std::vector<WinHookEventRange>& expected, const std::vector<WinHookEventRange>& actual)
+    {
+        Assert::AreEqual(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            Assert::AreEqual(expected[i].min, actual[i].min);
+            Assert::AreEqual(expected[i].max, actual[i].max);
+        }
+    }
+
+    TEST_CLASS (WinHookEventRanges)
+    {
+    public:
+        TEST_METHOD (NullTableMeansAllEvents)
+        {
+            AssertRanges({ { EVENT_MIN, EVENT_MAX } }, win_hook_event_ranges_from_table(nullptr));
+        }
+        TEST_METHOD (TableIsCopiedUpToTheTerminator)
+        {
+            const WinHookEventRange table[] = {
+                { EVENT_SYSTEM_MOVESIZESTART, EVENT_SYSTEM_MOVESIZEEND },
+                { EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE },
+                { 0, 0 },
+                { EVENT_OBJECT_CREATE, EVENT_OBJECT_CREATE },
+            };
+            AssertRanges({ { EVENT_SYSTEM_MOVESIZESTART, EVENT_SYSTEM_MOVESIZEEND }, { EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE } },
+                         win_hook_event_ranges_from_table(table));
+        }
+        TEST_METHOD (EmptyTableMeansNoEvents)
+        {
+            const WinHookEventRange table[] = { { 0, 0 } };
+            Assert::IsTrue(win_hook_event_ranges_from_table(table).empty());
+        }
+        TEST_METHOD (OverlappingRangesAreMerged)
+        {
+            AssertRanges({ { 10, 30 } }, merge_win_hook_event_ranges({ { 20, 30 }, { 10, 25 } }));
+            AssertRanges({ { 10, 30 } }, merge_win_hook_event_ranges({ { 10, 30 }, { 15, 20 } }));
+        }
+        TEST_METHOD (AdjacentRangesAreMerged)
+        {
+            AssertRanges({ { 10, 30 } }, merge_win_hook_event_ranges({ { 21, 30 }, { 10, 20 } }));
+            AssertRanges({ { 5, 5 } }, merge_win_hook_event_ranges({ { 5, 5 }, { 5, 5 } }));
+        }
+        TEST_METHOD (DisjointRangesAreSortedAndKept)
+        {
+            AssertRanges({ { 10, 20 }, { 22, 30 } }, merge_win_hook_event_ranges({ { 22, 30 }, { 10, 20 } }));
+        }
+        TEST_METHOD (InvertedRangesAreDropped)
+        {
+            AssertRanges({ { 10, 20 } }, merge_win_hook_event_ranges({ { 40, 30 }, { 10, 20 } }));
+            Assert::IsTrue(merge_win_hook_event_ranges({}).empty());
+        }
+        TEST_METHOD (AllEventsAbsorbTheOtherRanges)
+        {
+            AssertRanges({ { EVENT_MIN, EVENT_MAX } },
+                         merge_win_hook_event_ranges({ { EVENT_SYSTEM_MENUSTART, EVENT_SYSTEM_MENUSTART }, { EVENT_MIN, EVENT_MAX }, { EVENT_OBJECT_INVOKED, EVENT_OBJECT_INVOKED } }));
+        }
+        TEST_METHOD (EventsAreRoutedOnlyToTheirRanges)
+        {
+            const std::vector<WinHookEventRange> ranges = { { EVENT_SYSTEM_MOVESIZESTART, EVENT_SYSTEM_MOVESIZEEND }, { EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE } };
+            Assert::IsTrue(win_hook_event_ranges_contain(ranges, EVENT_SYSTEM_MOVESIZESTART));
+            Assert::IsTrue(win_hook_event_ranges_contain(ranges, EVENT_SYSTEM_MOVESIZEEND));
+            Assert::IsTrue(win_hook_event_ranges_contain(ranges, EVENT_OBJECT_LOCATIONCHANGE));
+            Assert::IsFalse(win_hook_event_ranges_contain(ranges, EVENT_SYSTEM_MOVESIZESTART - 1));
+            Assert::IsFalse(win_hook_event_ranges_contain(ranges, EVENT_SYSTEM_MOVESIZEEND + 1));
+            Assert::IsFalse(win_hook_event_ranges_contain(ranges, EVENT_OBJECT_NAMECHANGE));
+            Assert::IsFalse(win_hook_event_ranges_contain({}, EVENT_SYSTEM_MOVESIZESTART));
+        }
+        TEST_METHOD (AllEventsReceiverIsRoutedEveryEvent)
+        {
+            const auto ranges = win_hook_event_ranges_from_table(nullptr);
+            Assert::IsTrue(win_hook_event_ranges_contain(ranges, EVENT_MIN));
+            Assert::IsTrue(win_hook_event_ranges_contain(ranges, EVENT_OBJECT_INVOKED));
+            Assert::IsTrue(win_hook_event_ranges_contain(ranges, EVENT_MAX));
+        }
+    };
+}
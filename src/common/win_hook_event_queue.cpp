@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "win_hook_event_queue.h"
+
+namespace
+{
+    // The events which describe the current state of a window object, so only the latest one matters
+    bool is_coalescable(DWORD event)
+    {
+        return event == EVENT_OBJECT_LOCATIONCHANGE || event == EVENT_OBJECT_NAMECHANGE;
+    }
+}
+
+WinHookEventQueue::WinHookEventQueue() :
+    window_slots(window_slot_count)
+{
+    pending.reserve(capacity);
+}
+
+bool WinHookEventQueue::push(const WinHookEvent& event)
+{
+    const bool was_empty = pending.empty();
+    WindowSlot& slot = find_window_slot(event.hwnd);
+    if (slot.generation == generation && is_coalescable(event.event))
+    {
+        WinHookEvent& previous = pending[slot.position];
+        if (previous.event == event.event && previous.idObject == event.idObject && previous.idChild == event.idChild)
+        {
+            previous = event;
+            ++coalesced;
+            return was_empty;
+        }
+    }
+
+    if (pending.size() == capacity)
+    {
+        // Losing an intermediate location or name change is harmless, losing e.g. the end of a move or size isn't
+        ++dropped;
+        if (is_coalescable(event.event) || !evict_coalescable())
+        {
+            return was_empty;
+        }
+        // The eviction moved the slots
+        find_window_slot(event.hwnd) = { event.hwnd, static_cast<uint32_t>(pending.size()), generation };
+    }
+    else
+    {
+        slot = { event.hwnd, static_cast<uint32_t>(pending.size()), generation };
+    }
+    pending.push_back(event);
+    return was_empty;
+}
+
+void WinHookEventQueue::swap_batch(std::vector<WinHookEvent>& batch)
+{
+    batch.clear();
+    batch.reserve(capacity);
+    pending.swap(batch);
+    next_generation();
+}
+
+bool WinHookEventQueue::empty() const
+{
+    return pending.empty();
+}
+
+void WinHookEventQueue::clear()
+{
+    pending.clear();
+    next_generation();
+}
+
+size_t WinHookEventQueue::dropped_count() const
+{
+    return dropped;
+}
+
+size_t WinHookEventQueue::coalesced_count() const
+{
+    return coalesced;
+}
+
+WinHookEventQueue::WindowSlot& WinHookEventQueue::find_window_slot(HWND hwnd)
+{
+    const size_t mask = window_slot_count - 1;
+    for (size_t i = std::hash<HWND>{}(hwnd) & mask;; i = (i + 1) & mask)
+    {
+        WindowSlot& slot = window_slots[i];
+        if (slot.generation != generation || slot.hwnd == hwnd)
+        {
+            return slot;
+        }
+    }
+}
+
+bool WinHookEventQueue::evict_coalescable()
+{
+    auto evicted = std::find_if(begin(pending), end(pending), [](const WinHookEvent& event) { return is_coalescable(event.event); });
+    if (evicted == end(pending))
+    {
+        return false;
+    }
+    pending.erase(evicted);
+
+    // The positions after the evicted event changed, so index the pending events again. This only happens
+    // while the dispatch thread is behind, and keeps the probing of the slots free of removed entries
+    next_generation();
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        find_window_slot(pending[i].hwnd) = { pending[i].hwnd, static_cast<uint32_t>(i), generation };
+    }
+    return true;
+}
+
+void WinHookEventQueue::next_generation()
+{
+    // The slots of the previous generations become free at once. When the counter wraps around, they are reset
+    if (++generation == 0)
+    {
+        std::fill(begin(window_slots), end(window_slots), WindowSlot{});
+        generation = 1;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../modules/interface/win_hook_event_data.h"
+#include <vector>
+
+// Bounded queue of the win hook events, not synchronized. The hook proc appends the events to a pending batch,
+// which the dispatch thread swaps out whole. A location or name change replaces the previous event of the same
+// window object if that is the last queued event of the window. When the pending batch is full, a location or
+// name change is dropped, and any other event evicts the oldest pending location or name change to make room.
+// Other events are dropped only when the pending batch holds nothing else.
+class WinHookEventQueue
+{
+public:
+    static constexpr size_t capacity = 1024;
+
+    WinHookEventQueue();
+
+    // Add the event to the pending batch. Returns true if the pending batch was empty
+    bool push(const WinHookEvent& event);
+    // Replace the contents of the batch with the pending events, and reuse the batch storage for the next pending events
+    void swap_batch(std::vector<WinHookEvent>& batch);
+    bool empty() const;
+    void clear();
+
+    // Number of the events dropped or evicted because the pending batch was full
+    size_t dropped_count() const;
+    // Number of the events which replaced a previous event of the same window object
+    size_t coalesced_count() const;
+
+private:
+    // Position of the last pending event of a window, valid while generation is the one of the pending batch
+    struct WindowSlot
+    {
+        HWND hwnd;
+        uint32_t position;
+        uint32_t generation;
+    };
+    // Twice the capacity, so the open addressing table is never more than half full
+    static constexpr size_t window_slot_count = 2 * capacity;
+    static_assert((window_slot_count & (window_slot_count - 1)) == 0, "The window slot count must be a power of two");
+
+    WindowSlot& find_window_slot(HWND hwnd);
+    void next_generation();
+    // Remove the oldest pending location or name change. Returns false if there is none
+    bool evict_coalescable();
+
+    std::vector<WinHookEvent> pending;
+    std::vector<WindowSlot> window_slots;
+    uint32_t generation = 1;
+    size_t dropped = 0;
+    size_t coalesced = 0;
+};
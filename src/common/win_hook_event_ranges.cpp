@@ -0,0 +1,43 @@
+#include "pch.h"
+#include "win_hook_event_ranges.h"
+
+#include <algorithm>
+
+std::vector<WinHookEventRange> win_hook_event_ranges_from_table(const WinHookEventRange* table)
+{
+    std::vector<WinHookEventRange> ranges;
+    if (!table)
+    {
+        ranges.push_back({ EVENT_MIN, EVENT_MAX });
+        return ranges;
+    }
+
+    for (; table->min != 0; ++table)
+    {
+        ranges.push_back(*table);
+    }
+    return ranges;
+}
+
+std::vector<WinHookEventRange> merge_win_hook_event_ranges(std::vector<WinHookEventRange> ranges)
+{
+    std::sort(begin(ranges), end(ranges), [](const WinHookEventRange& a, const WinHookEventRange& b) { return a.min < b.min; });
+    std::vector<WinHookEventRange> merged;
+    for (auto& range : ranges)
+    {
+        if (range.min > range.max)
+            continue;
+        if (!merged.empty() && range.min <= merged.back().max + 1)
+            merged.back().max = std::max(merged.back().max, range.max);
+        else
+            merged.push_back(range);
+    }
+    return merged;
+}
+
+bool win_hook_event_ranges_contain(const std::vector<WinHookEventRange>& ranges, DWORD event)
+{
+    return std::any_of(begin(ranges), end(ranges), [event](const WinHookEventRange& range) {
+        return event >= range.min && event <= range.max;
+    });
+}
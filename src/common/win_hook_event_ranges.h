@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../modules/interface/win_hook_event_data.h"
+
+#include <vector>
+
+// Copy the table returned by get_win_hook_event_ranges(), terminated by a range with min equal to 0.
+// A nullptr table means all the events.
+std::vector<WinHookEventRange> win_hook_event_ranges_from_table(const WinHookEventRange* table);
+
+// Sort the ranges and merge the overlapping and adjacent ones, so that their union is hooked with the fewest hooks
+std::vector<WinHookEventRange> merge_win_hook_event_ranges(std::vector<WinHookEventRange> ranges);
+
+// Check if the event is in any of the ranges
+bool win_hook_event_ranges_contain(const std::vector<WinHookEventRange>& ranges, DWORD event);
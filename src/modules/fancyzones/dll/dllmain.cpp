@@ -147,6 +147,8 @@ public:
     virtual void destroy() override
     {
         Disable(false);
+        // Write the changes which are still pending, and stop the writer thread before the dll is unloaded
+        FancyZonesDataInstance().FlushFancyZonesData();
         delete this;
     }
 
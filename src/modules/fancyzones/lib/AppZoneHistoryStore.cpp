@@ -0,0 +1,226 @@
+#include "pch.h"
+#include "AppZoneHistoryStore.h"
+
+AppZoneHistoryStore::Atom AppZoneHistoryStore::Atoms::Intern(std::wstring_view str)
+{
+    if (auto it = m_atoms.find(str); it != m_atoms.end())
+    {
+        return it->second;
+    }
+
+    const Atom atom = static_cast<Atom>(m_strings.size());
+    const std::wstring& stored = m_strings.emplace_back(str);
+    m_atoms.emplace(std::wstring_view{ stored }, atom);
+    return atom;
+}
+
+bool AppZoneHistoryStore::Atoms::Find(std::wstring_view str, Atom& atom) const
+{
+    auto it = m_atoms.find(str);
+    if (it == m_atoms.end())
+    {
+        return false;
+    }
+    atom = it->second;
+    return true;
+}
+
+void AppZoneHistoryStore::Atoms::Clear()
+{
+    m_atoms.clear();
+    m_strings.clear();
+}
+
+size_t AppZoneHistoryStore::KeyHash::operator()(const Key& key) const noexcept
+{
+    uint64_t hash = (static_cast<uint64_t>(key.app) << 32) | key.device;
+    hash ^= static_cast<uint64_t>(key.zoneSet) * 0x9E3779B97F4A7C15ull;
+    return std::hash<uint64_t>{}(hash);
+}
+
+void AppZoneHistoryStore::Assign(JSONHelpers::TAppZoneHistoryMap map)
+{
+    m_map = std::move(map);
+    Rebuild();
+    m_changedApps.clear();
+    m_allChanged = false;
+}
+
+void AppZoneHistoryStore::Clear()
+{
+    m_map.clear();
+    Rebuild();
+    m_allChanged = true;
+}
+
+FancyZonesDataTypes::AppZoneHistoryData* AppZoneHistoryStore::Find(std::wstring_view appPath, std::wstring_view deviceId)
+{
+    return const_cast<FancyZonesDataTypes::AppZoneHistoryData*>(std::as_const(*this).Find(appPath, deviceId));
+}
+
+const FancyZonesDataTypes::AppZoneHistoryData* AppZoneHistoryStore::Find(std::wstring_view appPath, std::wstring_view deviceId) const
+{
+    Key key;
+    if (!FindKey(appPath, deviceId, key))
+    {
+        return nullptr;
+    }
+    key.zoneSet = AnyZoneSet;
+    return FindEntry(key);
+}
+
+FancyZonesDataTypes::AppZoneHistoryData* AppZoneHistoryStore::Find(std::wstring_view appPath, std::wstring_view deviceId, std::wstring_view zoneSetId)
+{
+    return const_cast<FancyZonesDataTypes::AppZoneHistoryData*>(std::as_const(*this).Find(appPath, deviceId, zoneSetId));
+}
+
+const FancyZonesDataTypes::AppZoneHistoryData* AppZoneHistoryStore::Find(std::wstring_view appPath, std::wstring_view deviceId, std::wstring_view zoneSetId) const
+{
+    Key key;
+    if (!FindKey(appPath, deviceId, key) || !m_zoneSetAtoms.Find(zoneSetId, key.zoneSet))
+    {
+        return nullptr;
+    }
+    return FindEntry(key);
+}
+
+void AppZoneHistoryStore::Add(const std::wstring& appPath, FancyZonesDataTypes::AppZoneHistoryData data)
+{
+    m_map[appPath].push_back(std::move(data));
+    IndexApp(appPath);
+    m_changedApps.insert(appPath);
+}
+
+void AppZoneHistoryStore::Remove(const std::wstring& appPath, const FancyZonesDataTypes::AppZoneHistoryData* entry)
+{
+    auto it = m_map.find(appPath);
+    if (it == m_map.end())
+    {
+        return;
+    }
+
+    m_changedApps.insert(appPath);
+    auto& entries = it->second;
+    entries.erase(entries.begin() + (entry - entries.data()));
+    if (!entries.empty())
+    {
+        IndexApp(appPath);
+        return;
+    }
+
+    Atom app;
+    if (m_appAtoms.Find(appPath, app))
+    {
+        RemoveAppKeys(app);
+        m_appEntries[app] = nullptr;
+    }
+    m_map.erase(it);
+}
+
+void AppZoneHistoryStore::SetZones(const std::wstring& appPath, FancyZonesDataTypes::AppZoneHistoryData* entry, const std::wstring& zoneSetId, const std::vector<int>& zoneIndexSet)
+{
+    entry->zoneIndexSet = zoneIndexSet;
+    if (entry->zoneSetUuid != zoneSetId)
+    {
+        entry->zoneSetUuid = zoneSetId;
+        IndexApp(appPath);
+    }
+    m_changedApps.insert(appPath);
+}
+
+void AppZoneHistoryStore::Update(const std::function<bool(FancyZonesDataTypes::AppZoneHistoryData&)>& update)
+{
+    for (auto it = m_map.begin(); it != m_map.end();)
+    {
+        auto& entries = it->second;
+        entries.erase(std::remove_if(entries.begin(), entries.end(), update), entries.end());
+        if (entries.empty())
+        {
+            it = m_map.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    Rebuild();
+    m_allChanged = true;
+}
+
+bool AppZoneHistoryStore::TakeChanges(std::vector<std::wstring>& changedApps)
+{
+    const bool allChanged = std::exchange(m_allChanged, false);
+    if (!allChanged)
+    {
+        changedApps.assign(m_changedApps.begin(), m_changedApps.end());
+    }
+    m_changedApps.clear();
+    return allChanged;
+}
+
+bool AppZoneHistoryStore::FindKey(std::wstring_view appPath, std::wstring_view deviceId, Key& key) const
+{
+    return m_appAtoms.Find(appPath, key.app) && m_deviceAtoms.Find(deviceId, key.device);
+}
+
+const FancyZonesDataTypes::AppZoneHistoryData* AppZoneHistoryStore::FindEntry(const Key& key) const
+{
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+    {
+        return nullptr;
+    }
+    return &(*m_appEntries[key.app])[it->second];
+}
+
+void AppZoneHistoryStore::IndexApp(const std::wstring& appPath)
+{
+    const Atom app = m_appAtoms.Intern(appPath);
+    if (app >= m_appEntries.size())
+    {
+        m_appEntries.resize(app + 1);
+        m_appKeys.resize(app + 1);
+    }
+    RemoveAppKeys(app);
+
+    auto& entries = m_map.at(appPath);
+    m_appEntries[app] = &entries;
+    auto& keys = m_appKeys[app];
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const Atom device = m_deviceAtoms.Intern(entries[i].deviceId);
+        // Like a scan of the entries, the lookups find the first matching entry
+        for (Key key : { Key{ app, device, AnyZoneSet }, Key{ app, device, m_zoneSetAtoms.Intern(entries[i].zoneSetUuid) } })
+        {
+            if (m_index.emplace(key, i).second)
+            {
+                keys.push_back(key);
+            }
+        }
+    }
+}
+
+void AppZoneHistoryStore::RemoveAppKeys(Atom app)
+{
+    for (const Key& key : m_appKeys[app])
+    {
+        m_index.erase(key);
+    }
+    m_appKeys[app].clear();
+}
+
+void AppZoneHistoryStore::Rebuild()
+{
+    m_index.clear();
+    m_appEntries.clear();
+    m_appKeys.clear();
+    m_appAtoms.Clear();
+    m_deviceAtoms.Clear();
+    m_zoneSetAtoms.Clear();
+
+    m_index.reserve(2 * m_map.size());
+    for (const auto& [appPath, entries] : m_map)
+    {
+        IndexApp(appPath);
+    }
+}
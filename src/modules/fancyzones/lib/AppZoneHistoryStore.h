@@ -0,0 +1,139 @@
+#pragma once
+
+#include "JsonHelpers.h"
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Zone history of the applications, indexed for constant time lookups by application path, device id and
+ * zone set id. The strings are interned into integer atoms, and the positions of the history entries are
+ * indexed by composite keys of the atoms, so a lookup hashes each string once instead of scanning the
+ * entries of the application. The entries keep the layout of the persisted data, a map from the application
+ * path to the history of the application on each device.
+ *
+ * The store tracks the applications whose history changed, so only their history is saved.
+ */
+class AppZoneHistoryStore
+{
+public:
+    /**
+     * @returns Map from the application path to the history of the application.
+     */
+    const JSONHelpers::TAppZoneHistoryMap& Map() const noexcept { return m_map; }
+
+    /**
+     * Replace the history with the saved history. Previous content and changes are discarded.
+     */
+    void Assign(JSONHelpers::TAppZoneHistoryMap map);
+    /**
+     * Remove all the history.
+     */
+    void Clear();
+
+    /**
+     * Find the first entry of the application on the device. The device and zone set ids of the entry must
+     * only be changed through Update.
+     *
+     * @returns Pointer to the entry, or nullptr if there is none. It's valid until the store is modified.
+     */
+    FancyZonesDataTypes::AppZoneHistoryData* Find(std::wstring_view appPath, std::wstring_view deviceId);
+    const FancyZonesDataTypes::AppZoneHistoryData* Find(std::wstring_view appPath, std::wstring_view deviceId) const;
+    /**
+     * Find the first entry of the application on the device with the zone set.
+     */
+    FancyZonesDataTypes::AppZoneHistoryData* Find(std::wstring_view appPath, std::wstring_view deviceId, std::wstring_view zoneSetId);
+    const FancyZonesDataTypes::AppZoneHistoryData* Find(std::wstring_view appPath, std::wstring_view deviceId, std::wstring_view zoneSetId) const;
+
+    /**
+     * Add an entry after the existing entries of the application.
+     */
+    void Add(const std::wstring& appPath, FancyZonesDataTypes::AppZoneHistoryData data);
+    /**
+     * Remove the entry, which must have been found for the application. The application is removed
+     * when it has no entries left.
+     */
+    void Remove(const std::wstring& appPath, const FancyZonesDataTypes::AppZoneHistoryData* entry);
+    /**
+     * Set the zone set id and the zones of the entry, which must have been found for the application.
+     */
+    void SetZones(const std::wstring& appPath, FancyZonesDataTypes::AppZoneHistoryData* entry, const std::wstring& zoneSetId, const std::vector<int>& zoneIndexSet);
+    /**
+     * Call the function for every entry, which can modify any field of the entry or return true to remove it,
+     * and rebuild the index.
+     */
+    void Update(const std::function<bool(FancyZonesDataTypes::AppZoneHistoryData&)>& update);
+
+    /**
+     * Take the applications whose history changed since the last call.
+     *
+     * @param   changedApps Receives the paths of the changed applications, including the removed ones.
+     * @returns True if all the history has to be saved, after Clear, Update or MarkAllChanged.
+     */
+    bool TakeChanges(std::vector<std::wstring>& changedApps);
+    /**
+     * Mark all the history changed, e.g. when it wasn't saved in the current format yet.
+     */
+    void MarkAllChanged() noexcept { m_allChanged = true; }
+
+private:
+    using Atom = uint32_t;
+    static constexpr Atom AnyZoneSet = UINT32_MAX;
+
+    // Interned strings. The views used as keys point to the strings of the deque, which never moves them
+    class Atoms
+    {
+    public:
+        Atom Intern(std::wstring_view str);
+        bool Find(std::wstring_view str, Atom& atom) const;
+        void Clear();
+
+    private:
+        std::deque<std::wstring> m_strings;
+        std::unordered_map<std::wstring_view, Atom> m_atoms;
+    };
+
+    struct Key
+    {
+        Atom app;
+        Atom device;
+        // AnyZoneSet for the key of the first entry of the application on the device
+        Atom zoneSet;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    bool FindKey(std::wstring_view appPath, std::wstring_view deviceId, Key& key) const;
+    const FancyZonesDataTypes::AppZoneHistoryData* FindEntry(const Key& key) const;
+
+    // Index the entries of the application, replacing its previous keys
+    void IndexApp(const std::wstring& appPath);
+    void RemoveAppKeys(Atom app);
+    void Rebuild();
+
+    JSONHelpers::TAppZoneHistoryMap m_map;
+
+    Atoms m_appAtoms;
+    Atoms m_deviceAtoms;
+    Atoms m_zoneSetAtoms;
+    // Position of the entry in the entries of the application
+    std::unordered_map<Key, size_t, KeyHash> m_index;
+    // Entries of the application with the atom in m_map, or nullptr if the application has no entries.
+    // Values of the unordered map don't move when it's modified
+    std::vector<std::vector<FancyZonesDataTypes::AppZoneHistoryData>*> m_appEntries;
+    // Keys of the application with the atom, to remove them when the entries of the application change
+    std::vector<std::vector<Key>> m_appKeys;
+
+    std::unordered_set<std::wstring> m_changedApps;
+    bool m_allChanged{};
+};
@@ -10,6 +10,7 @@
 #include "lib/FancyZonesData.h"
 #include "lib/ZoneSet.h"
 #include "lib/WindowMoveHandler.h"
+#include "lib/WindowMoveBatch.h"
 #include "lib/FancyZonesWinHookEventIDs.h"
 #include "lib/util.h"
 #include "trace.h"
@@ -657,6 +658,9 @@ void FancyZones::ToggleEditor() noexcept
         return;
     }
 
+    // The editor reads the layouts from zones-settings.json, whose changes may still be waiting for the background writer
+    fancyZonesData.WritePendingFancyZonesData();
+
     const std::wstring params =
         /*1*/ editorLocation + L" " +
         /*2*/ L"\"" + std::to_wstring(GetCurrentProcessId()) + L"\"";
@@ -879,8 +883,8 @@ void FancyZones::AddZoneWindow(HMONITOR monitor, PCWSTR deviceId) noexcept
             auto workArea = MakeZoneWindow(this, m_hinstance, monitor, uniqueId, parentId, flash);
             if (workArea)
             {
+                // The zone window schedules the save of its device, so the UI thread doesn't wait for the disk
                 m_workAreaHandler.AddWorkArea(m_currentDesktopId, monitor, workArea);
-                FancyZonesDataInstance().SaveFancyZonesData();
             }
         }
     }
@@ -945,11 +949,24 @@ void FancyZones::UpdateZoneWindows() noexcept
 void FancyZones::UpdateWindowsPositions() noexcept
 {
     auto callback = [](HWND window, LPARAM data) -> BOOL {
-        size_t bitmask = reinterpret_cast<size_t>(::GetProp(window, MULTI_ZONE_STAMP));
+        if (::GetProp(window, MULTI_ZONE_STAMP) != nullptr)
+        {
+            reinterpret_cast<std::vector<HWND>*>(data)->push_back(window);
+        }
+        return TRUE;
+    };
+    std::vector<HWND> zonedWindows;
+    EnumWindows(callback, reinterpret_cast<LPARAM>(&zonedWindows));
 
-        if (bitmask != 0)
+    // The windows are assigned to their zones under one lock, and moved together once it's released
+    WindowMoveBatch batch;
+    {
+        std::unique_lock writeLock(m_lock);
+        std::vector<int> indexSet;
+        for (HWND window : zonedWindows)
         {
-            std::vector<int> indexSet;
+            size_t bitmask = reinterpret_cast<size_t>(::GetProp(window, MULTI_ZONE_STAMP));
+            indexSet.clear();
             for (int i = 0; i < std::numeric_limits<size_t>::digits; i++)
             {
                 if ((1ull << i) & bitmask)
@@ -958,17 +975,15 @@ void FancyZones::UpdateWindowsPositions() noexcept
                 }
             }
 
-            auto strongThis = reinterpret_cast<FancyZones*>(data);
-            std::unique_lock writeLock(strongThis->m_lock);
-            auto zoneWindow = strongThis->m_workAreaHandler.GetWorkArea(window);
-            if (zoneWindow)
+            RECT rect;
+            auto zoneWindow = m_workAreaHandler.GetWorkArea(window);
+            if (zoneWindow && m_windowMoveHandler.PrepareWindowMove(window, indexSet, zoneWindow, rect))
             {
-                strongThis->m_windowMoveHandler.MoveWindowIntoZoneByIndexSet(window, indexSet, zoneWindow);
+                batch.Add(window, rect);
             }
         }
-        return TRUE;
-    };
-    EnumWindows(callback, reinterpret_cast<LPARAM>(this));
+    }
+    batch.Apply();
 }
 
 void FancyZones::CycleActiveZoneSet(DWORD vkCode) noexcept
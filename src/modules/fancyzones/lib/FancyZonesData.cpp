@@ -2,6 +2,7 @@
 #include "FancyZonesData.h"
 #include "FancyZonesDataTypes.h"
 #include "JsonHelpers.h"
+#include "ZoneGeometryCache.h"
 #include "ZoneSet.h"
 #include "Settings.h"
 
@@ -28,6 +29,7 @@ namespace
 {
     const wchar_t* FANCY_ZONES_DATA_FILE = L"zones-settings.json";
     const wchar_t* FANCY_ZONES_APP_ZONE_HISTORY_FILE = L"app-zone-history.json";
+    const wchar_t* FANCY_ZONES_APP_ZONE_HISTORY_LOG_FILE = L"app-zone-history.log";
     const wchar_t* DEFAULT_GUID = L"{00000000-0000-0000-0000-000000000000}";
     const wchar_t* REG_SETTINGS = L"Software\\SuperFancyZones";
 
@@ -35,6 +37,11 @@ namespace
     const wchar_t AppliedZoneSetsTmpFileName[] = L"FancyZonesAppliedZoneSets.json";
     const wchar_t DeletedCustomZoneSetsTmpFileName[] = L"FancyZonesDeletedCustomZoneSets.json";
 
+    // A burst of changes, e.g. snapping windows one after the other, is written once the changes stop for this long
+    const std::chrono::milliseconds SaveDebounce{ 1000 };
+    // Changes are written at the latest this long after the first of them, even if they don't stop
+    const std::chrono::milliseconds SaveMaxDelay{ 10000 };
+
     std::wstring ExtractVirtualDesktopId(const std::wstring& deviceId)
     {
         // Format: <device-id>_<resolution>_<virtual-desktop-id>
@@ -68,11 +75,13 @@ FancyZonesData& FancyZonesDataInstance()
     return instance;
 }
 
-FancyZonesData::FancyZonesData()
+FancyZonesData::FancyZonesData() :
+    persistence(SaveDebounce, SaveMaxDelay, { [this] { return SaveZonesSettings(); }, [this] { return SaveAppZoneHistory(); } })
 {
     std::wstring saveFolderPath = PTSettingsHelper::get_module_save_folder_location(NonLocalizable::FancyZonesStr);
     zonesSettingsFileName = saveFolderPath + L"\\" + std::wstring(FANCY_ZONES_DATA_FILE);
     appZoneHistoryFileName = saveFolderPath + L"\\" + std::wstring(FANCY_ZONES_APP_ZONE_HISTORY_FILE);
+    appZoneHistoryLog = RecordLog{ saveFolderPath + L"\\" + std::wstring(FANCY_ZONES_APP_ZONE_HISTORY_LOG_FILE) };
 
     activeZoneSetTmpFileName = GetTempDirPath() + ActiveZoneSetsTmpFileName;
     appliedZoneSetTmpFileName = GetTempDirPath() + AppliedZoneSetsTmpFileName;
@@ -100,6 +109,7 @@ void FancyZonesData::AddDevice(const std::wstring& deviceId)
     {
         // Creates default entry in map when ZoneWindow is created
         deviceInfoMap[deviceId] = FancyZonesDataTypes::DeviceInfoData{ FancyZonesDataTypes::ZoneSetData{ NonLocalizable::NullStr, FancyZonesDataTypes::ZoneSetLayoutType::Blank } };
+        ScheduleSave(ZonesSettingsFile);
     }
 }
 
@@ -123,6 +133,7 @@ void FancyZonesData::CloneDeviceInfo(const std::wstring& source, const std::wstr
     {
         destInfo = deviceInfoMap[source];
     }
+    ScheduleSave(ZonesSettingsFile);
 }
 
 void FancyZonesData::UpdatePrimaryDesktopData(const std::wstring& desktopId)
@@ -137,16 +148,13 @@ void FancyZonesData::UpdatePrimaryDesktopData(const std::wstring& desktopId)
         return deviceId.substr(0, deviceId.rfind('_') + 1) + desktopId;
     };
     std::scoped_lock lock{ dataLock };
-    for (auto& [path, perDesktopData] : appZoneHistoryMap)
-    {
-        for (auto& data : perDesktopData)
+    appZoneHistoryStore.Update([&](FancyZonesDataTypes::AppZoneHistoryData& data) {
+        if (ExtractVirtualDesktopId(data.deviceId) == DEFAULT_GUID)
         {
-            if (ExtractVirtualDesktopId(data.deviceId) == DEFAULT_GUID)
-            {
-                data.deviceId = replaceDesktopId(data.deviceId);
-            }
+            data.deviceId = replaceDesktopId(data.deviceId);
         }
-    }
+        return false;
+    });
     std::vector<std::wstring> toReplace{};
     for (const auto& [id, data] : deviceInfoMap)
     {
@@ -161,12 +169,14 @@ void FancyZonesData::UpdatePrimaryDesktopData(const std::wstring& desktopId)
         mapEntry.key() = replaceDesktopId(id);
         deviceInfoMap.insert(std::move(mapEntry));
     }
-    SaveFancyZonesData();
+    ScheduleSave(ZonesSettingsFile);
+    ScheduleSave(AppZoneHistoryFile);
 }
 
 void FancyZonesData::RemoveDeletedDesktops(const std::vector<std::wstring>& activeDesktops)
 {
     std::unordered_set<std::wstring> active(std::begin(activeDesktops), std::end(activeDesktops));
+    std::unordered_set<std::wstring> deleted;
     std::scoped_lock lock{ dataLock };
     for (auto it = std::begin(deviceInfoMap); it != std::end(deviceInfoMap);)
     {
@@ -174,7 +184,7 @@ void FancyZonesData::RemoveDeletedDesktops(const std::vector<std::wstring>& acti
         auto foundId = active.find(desktopId);
         if (foundId == std::end(active))
         {
-            RemoveDesktopAppZoneHistory(desktopId);
+            deleted.insert(std::move(desktopId));
             it = deviceInfoMap.erase(it);
         }
         else
@@ -182,37 +192,31 @@ void FancyZonesData::RemoveDeletedDesktops(const std::vector<std::wstring>& acti
             ++it;
         }
     }
-    SaveFancyZonesData();
+    RemoveDesktopAppZoneHistory(deleted);
+    ScheduleSave(ZonesSettingsFile);
+    ScheduleSave(AppZoneHistoryFile);
 }
 
 bool FancyZonesData::IsAnotherWindowOfApplicationInstanceZoned(HWND window, const std::wstring_view& deviceId) const
 {
     std::scoped_lock lock{ dataLock };
-    auto processPath = get_process_path(window);
+    const auto& processPath = processPathCache.GetProcessPath(window);
     if (!processPath.empty())
     {
-        auto history = appZoneHistoryMap.find(processPath);
-        if (history != std::end(appZoneHistoryMap))
+        if (const auto* data = appZoneHistoryStore.Find(processPath, deviceId))
         {
-            auto& perDesktopData = history->second;
-            for (auto& data : perDesktopData)
-            {
-                if (data.deviceId == deviceId)
-                {
-                    DWORD processId = 0;
-                    GetWindowThreadProcessId(window, &processId);
+            DWORD processId = 0;
+            GetWindowThreadProcessId(window, &processId);
 
-                    auto processIdIt = data.processIdToHandleMap.find(processId);
+            auto processIdIt = data->processIdToHandleMap.find(processId);
 
-                    if (processIdIt == std::end(data.processIdToHandleMap))
-                    {
-                        return false;
-                    }
-                    else if (processIdIt->second != window && IsWindow(processIdIt->second))
-                    {
-                        return true;
-                    }
-                }
+            if (processIdIt == std::end(data->processIdToHandleMap))
+            {
+                return false;
+            }
+            else if (processIdIt->second != window && IsWindow(processIdIt->second))
+            {
+                return true;
             }
         }
     }
@@ -223,23 +227,14 @@ bool FancyZonesData::IsAnotherWindowOfApplicationInstanceZoned(HWND window, cons
 void FancyZonesData::UpdateProcessIdToHandleMap(HWND window, const std::wstring_view& deviceId)
 {
     std::scoped_lock lock{ dataLock };
-    auto processPath = get_process_path(window);
+    const auto& processPath = processPathCache.GetProcessPath(window);
     if (!processPath.empty())
     {
-        auto history = appZoneHistoryMap.find(processPath);
-        if (history != std::end(appZoneHistoryMap))
+        if (auto* data = appZoneHistoryStore.Find(processPath, deviceId))
         {
-            auto& perDesktopData = history->second;
-            for (auto& data : perDesktopData)
-            {
-                if (data.deviceId == deviceId)
-                {
-                    DWORD processId = 0;
-                    GetWindowThreadProcessId(window, &processId);
-                    data.processIdToHandleMap[processId] = window;
-                    break;
-                }
-            }
+            DWORD processId = 0;
+            GetWindowThreadProcessId(window, &processId);
+            data->processIdToHandleMap[processId] = window;
         }
     }
 }
@@ -247,20 +242,12 @@ void FancyZonesData::UpdateProcessIdToHandleMap(HWND window, const std::wstring_
 std::vector<int> FancyZonesData::GetAppLastZoneIndexSet(HWND window, const std::wstring_view& deviceId, const std::wstring_view& zoneSetId) const
 {
     std::scoped_lock lock{ dataLock };
-    auto processPath = get_process_path(window);
+    const auto& processPath = processPathCache.GetProcessPath(window);
     if (!processPath.empty())
     {
-        auto history = appZoneHistoryMap.find(processPath);
-        if (history != std::end(appZoneHistoryMap))
+        if (const auto* data = appZoneHistoryStore.Find(processPath, deviceId, zoneSetId))
         {
-            const auto& perDesktopData = history->second;
-            for (const auto& data : perDesktopData)
-            {
-                if (data.zoneSetUuid == zoneSetId && data.deviceId == deviceId)
-                {
-                    return data.zoneIndexSet;
-                }
-            }
+            return data->zoneIndexSet;
         }
     }
 
@@ -270,49 +257,34 @@ std::vector<int> FancyZonesData::GetAppLastZoneIndexSet(HWND window, const std::
 bool FancyZonesData::RemoveAppLastZone(HWND window, const std::wstring_view& deviceId, const std::wstring_view& zoneSetId)
 {
     std::scoped_lock lock{ dataLock };
-    auto processPath = get_process_path(window);
+    // Copied, the check for another zoned window below queries the path again
+    const std::wstring processPath = processPathCache.GetProcessPath(window);
     if (!processPath.empty())
     {
-        auto history = appZoneHistoryMap.find(processPath);
-        if (history != std::end(appZoneHistoryMap))
+        if (auto* data = appZoneHistoryStore.Find(processPath, deviceId, zoneSetId))
         {
-            auto& perDesktopData = history->second;
-            for (auto data = std::begin(perDesktopData); data != std::end(perDesktopData);)
+            if (!IsAnotherWindowOfApplicationInstanceZoned(window, deviceId))
             {
-                if (data->deviceId == deviceId && data->zoneSetUuid == zoneSetId)
-                {
-                    if (!IsAnotherWindowOfApplicationInstanceZoned(window, deviceId))
-                    {
-                        DWORD processId = 0;
-                        GetWindowThreadProcessId(window, &processId);
+                DWORD processId = 0;
+                GetWindowThreadProcessId(window, &processId);
 
-                        data->processIdToHandleMap.erase(processId);
-                    }
-
-                    // if there is another instance of same application placed in the same zone don't erase history
-                    size_t windowZoneStamp = reinterpret_cast<size_t>(::GetProp(window, MULTI_ZONE_STAMP));
-                    for (auto placedWindow : data->processIdToHandleMap)
-                    {
-                        size_t placedWindowZoneStamp = reinterpret_cast<size_t>(::GetProp(placedWindow.second, MULTI_ZONE_STAMP));
-                        if (IsWindow(placedWindow.second) && (windowZoneStamp == placedWindowZoneStamp))
-                        {
-                            return false;
-                        }
-                    }
+                data->processIdToHandleMap.erase(processId);
+            }
 
-                    data = perDesktopData.erase(data);
-                    if (perDesktopData.empty())
-                    {
-                        appZoneHistoryMap.erase(processPath);
-                    }
-                    SaveFancyZonesData();
-                    return true;
-                }
-                else
+            // if there is another instance of same application placed in the same zone don't erase history
+            size_t windowZoneStamp = reinterpret_cast<size_t>(::GetProp(window, MULTI_ZONE_STAMP));
+            for (auto placedWindow : data->processIdToHandleMap)
+            {
+                size_t placedWindowZoneStamp = reinterpret_cast<size_t>(::GetProp(placedWindow.second, MULTI_ZONE_STAMP));
+                if (IsWindow(placedWindow.second) && (windowZoneStamp == placedWindowZoneStamp))
                 {
-                    ++data;
+                    return false;
                 }
             }
+
+            appZoneHistoryStore.Remove(processPath, data);
+            ScheduleSave(AppZoneHistoryFile);
+            return true;
         }
     }
 
@@ -328,7 +300,7 @@ bool FancyZonesData::SetAppLastZones(HWND window, const std::wstring& deviceId,
         return false;
     }
 
-    auto processPath = get_process_path(window);
+    const auto& processPath = processPathCache.GetProcessPath(window);
     if (processPath.empty())
     {
         return false;
@@ -337,22 +309,13 @@ bool FancyZonesData::SetAppLastZones(HWND window, const std::wstring& deviceId,
     DWORD processId = 0;
     GetWindowThreadProcessId(window, &processId);
 
-    auto history = appZoneHistoryMap.find(processPath);
-    if (history != std::end(appZoneHistoryMap))
+    if (auto* data = appZoneHistoryStore.Find(processPath, deviceId))
     {
-        auto& perDesktopData = history->second;
-        for (auto& data : perDesktopData)
-        {
-            if (data.deviceId == deviceId)
-            {
-                // application already has history on this work area, update it with new window position
-                data.processIdToHandleMap[processId] = window;
-                data.zoneSetUuid = zoneSetId;
-                data.zoneIndexSet = zoneIndexSet;
-                SaveFancyZonesData();
-                return true;
-            }
-        }
+        // application already has history on this work area, update it with new window position
+        data->processIdToHandleMap[processId] = window;
+        appZoneHistoryStore.SetZones(processPath, data, zoneSetId, zoneIndexSet);
+        ScheduleSave(AppZoneHistoryFile);
+        return true;
     }
 
     std::unordered_map<DWORD, HWND> processIdToHandleMap{};
@@ -362,18 +325,10 @@ bool FancyZonesData::SetAppLastZones(HWND window, const std::wstring& deviceId,
                                                     .deviceId = deviceId,
                                                     .zoneIndexSet = zoneIndexSet };
 
-    if (appZoneHistoryMap.contains(processPath))
-    {
-        // application already has history but on other desktop, add with new desktop info
-        appZoneHistoryMap[processPath].push_back(data);
-    }
-    else
-    {
-        // new application, create entry in app zone history map
-        appZoneHistoryMap[processPath] = std::vector<FancyZonesDataTypes::AppZoneHistoryData>{ data };
-    }
+    // new application or application with history on other desktops, add with new desktop info
+    appZoneHistoryStore.Add(processPath, std::move(data));
 
-    SaveFancyZonesData();
+    ScheduleSave(AppZoneHistoryFile);
     return true;
 }
 
@@ -384,6 +339,7 @@ void FancyZonesData::SetActiveZoneSet(const std::wstring& deviceId, const FancyZ
     if (it != deviceInfoMap.end())
     {
         it->second.activeZoneSet = data;
+        ScheduleSave(ZonesSettingsFile);
     }
 }
 
@@ -406,7 +362,7 @@ void FancyZonesData::ParseDataFromTmpFiles()
     ParseDeviceInfoFromTmpFile(activeZoneSetTmpFileName);
     ParseDeletedCustomZoneSetsFromTmpFile(deletedCustomZoneSetsTmpFileName);
     ParseCustomZoneSetFromTmpFile(appliedZoneSetTmpFileName);
-    SaveFancyZonesData();
+    ScheduleSave(ZonesSettingsFile);
 }
 
 void FancyZonesData::ParseDeviceInfoFromTmpFile(std::wstring_view tmpFilePath)
@@ -428,6 +384,7 @@ void FancyZonesData::ParseCustomZoneSetFromTmpFile(std::wstring_view tmpFilePath
     if (customZoneSet)
     {
         customZoneSetsMap[customZoneSet->uuid] = std::move(customZoneSet->data);
+        ZoneGeometryCacheInstance().InvalidateCustomLayouts();
     }
 }
 
@@ -439,6 +396,11 @@ void FancyZonesData::ParseDeletedCustomZoneSetsFromTmpFile(std::wstring_view tmp
     {
         customZoneSetsMap.erase(zoneSet);
     }
+
+    if (!deletedCustomZoneSets.empty())
+    {
+        ZoneGeometryCacheInstance().InvalidateCustomLayouts();
+    }
 }
 
 json::JsonObject FancyZonesData::GetPersistFancyZonesJSON()
@@ -455,22 +417,123 @@ void FancyZonesData::LoadFancyZonesData()
     }
     else
     {
-        json::JsonObject fancyZonesDataJSON = GetPersistFancyZonesJSON();
+        // zones-settings.json is read by the editor as well, so the devices and the custom zone sets stay in it
+        json::JsonObject zonesSettingsJSON = json::from_file(zonesSettingsFileName).value_or(json::JsonObject{});
+        deviceInfoMap = JSONHelpers::ParseDeviceInfos(zonesSettingsJSON);
+        customZoneSetsMap = JSONHelpers::ParseCustomZoneSets(zonesSettingsJSON);
+        ZoneGeometryCacheInstance().InvalidateCustomLayouts();
+
+        if (!LoadAppZoneHistoryLog())
+        {
+            // Previous versions saved the history in app-zone-history.json, or in zones-settings.json before that
+            appZoneHistoryStore.Assign(JSONHelpers::ParseAppZoneHistory(GetPersistFancyZonesJSON()));
+            appZoneHistoryStore.MarkAllChanged();
+            ScheduleSave(AppZoneHistoryFile);
+        }
+    }
+}
+
+bool FancyZonesData::LoadAppZoneHistoryLog()
+{
+    JSONHelpers::TAppZoneHistoryMap appZoneHistoryMap;
+    const bool exists = appZoneHistoryLog.Read([&appZoneHistoryMap](const std::wstring& appPath, const json::JsonObject* value) {
+        std::optional<JSONHelpers::AppZoneHistoryJSON> appZoneHistory;
+        if (value)
+        {
+            appZoneHistory = JSONHelpers::AppZoneHistoryJSON::FromJson(*value);
+        }
+
+        if (appZoneHistory.has_value())
+        {
+            appZoneHistoryMap[appPath] = std::move(appZoneHistory->data);
+        }
+        else
+        {
+            appZoneHistoryMap.erase(appPath);
+        }
+    });
 
-        appZoneHistoryMap = JSONHelpers::ParseAppZoneHistory(fancyZonesDataJSON);
-        deviceInfoMap = JSONHelpers::ParseDeviceInfos(fancyZonesDataJSON);
-        customZoneSetsMap = JSONHelpers::ParseCustomZoneSets(fancyZonesDataJSON);
+    if (exists)
+    {
+        appZoneHistoryStore.Assign(std::move(appZoneHistoryMap));
     }
+    return exists;
 }
 
 void FancyZonesData::SaveFancyZonesData() const
 {
-    std::scoped_lock lock{ dataLock };
-    JSONHelpers::SaveFancyZonesData(zonesSettingsFileName,
-									appZoneHistoryFileName,
-									deviceInfoMap,
-									customZoneSetsMap,
-									appZoneHistoryMap);
+    persistence.WriteAll();
+}
+
+void FancyZonesData::FlushFancyZonesData() const
+{
+    persistence.Stop();
+}
+
+void FancyZonesData::WritePendingFancyZonesData() const
+{
+    persistence.Flush();
+}
+
+void FancyZonesData::ScheduleSave(PersistedFile file) const
+{
+    persistence.MarkDirty(file);
+}
+
+bool FancyZonesData::SaveZonesSettings() const
+{
+    json::JsonObject zonesSettings;
+    std::wstring fileName;
+    {
+        std::scoped_lock lock{ dataLock };
+        zonesSettings = JSONHelpers::SerializeZonesSettings(deviceInfoMap, customZoneSetsMap);
+        fileName = zonesSettingsFileName;
+    }
+    return JSONHelpers::SaveZonesSettings(fileName, zonesSettings);
+}
+
+bool FancyZonesData::SaveAppZoneHistory()
+{
+    RecordLog::Batch records;
+    bool compact = false;
+    {
+        std::scoped_lock lock{ dataLock };
+        const auto& appZoneHistoryMap = appZoneHistoryStore.Map();
+
+        // The log is only used by this function, whose calls are serialized by the persistence service
+        std::vector<std::wstring> changedApps;
+        compact = appZoneHistoryStore.TakeChanges(changedApps) || appZoneHistoryLog.NeedsCompaction(changedApps.size(), appZoneHistoryMap.size());
+        if (compact)
+        {
+            for (const auto& [appPath, data] : appZoneHistoryMap)
+            {
+                records.Set(appPath, JSONHelpers::AppZoneHistoryJSON::ToJson({ appPath, data }));
+            }
+        }
+        else
+        {
+            for (const auto& appPath : changedApps)
+            {
+                if (auto it = appZoneHistoryMap.find(appPath); it != appZoneHistoryMap.end())
+                {
+                    records.Set(appPath, JSONHelpers::AppZoneHistoryJSON::ToJson({ appPath, it->second }));
+                }
+                else
+                {
+                    records.Remove(appPath);
+                }
+            }
+        }
+    }
+
+    if (!(compact ? appZoneHistoryLog.Compact(records) : appZoneHistoryLog.Append(records)))
+    {
+        // The changes which weren't written are only known by the whole history now
+        std::scoped_lock lock{ dataLock };
+        appZoneHistoryStore.MarkAllChanged();
+        return false;
+    }
+    return true;
 }
 
 void FancyZonesData::MigrateCustomZoneSetsFromRegistry()
@@ -575,30 +638,14 @@ void FancyZonesData::MigrateCustomZoneSetsFromRegistry()
     }
 }
 
-void FancyZonesData::RemoveDesktopAppZoneHistory(const std::wstring& desktopId)
+void FancyZonesData::RemoveDesktopAppZoneHistory(const std::unordered_set<std::wstring>& desktopIds)
 {
-    for (auto it = std::begin(appZoneHistoryMap); it != std::end(appZoneHistoryMap);)
+    if (desktopIds.empty())
     {
-        auto& perDesktopData = it->second;
-        for (auto desktopIt = std::begin(perDesktopData); desktopIt != std::end(perDesktopData);)
-        {
-            if (ExtractVirtualDesktopId(desktopIt->deviceId) == desktopId)
-            {
-                desktopIt = perDesktopData.erase(desktopIt);
-            }
-            else
-            {
-                ++desktopIt;
-            }
-        }
-
-        if (perDesktopData.empty())
-        {
-            it = appZoneHistoryMap.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
+        return;
     }
+
+    appZoneHistoryStore.Update([&desktopIds](FancyZonesDataTypes::AppZoneHistoryData& data) {
+        return desktopIds.contains(ExtractVirtualDesktopId(data.deviceId));
+    });
 }
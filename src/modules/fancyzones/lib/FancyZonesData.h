@@ -1,6 +1,10 @@
 #pragma once
 
+#include "AppZoneHistoryStore.h"
 #include "JsonHelpers.h"
+#include "PersistenceService.h"
+#include "ProcessPathCache.h"
+#include "RecordLog.h"
 
 #include <common/settings_helpers.h>
 #include <common/json.h>
@@ -8,6 +12,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <optional>
 #include <vector>
 #include <winnt.h>
@@ -54,7 +59,7 @@ public:
     inline const std::unordered_map<std::wstring, std::vector<FancyZonesDataTypes::AppZoneHistoryData>>& GetAppZoneHistoryMap() const
     {
         std::scoped_lock lock{ dataLock };
-        return appZoneHistoryMap;
+        return appZoneHistoryStore.Map();
     }
 
     void AddDevice(const std::wstring& deviceId);
@@ -76,7 +81,12 @@ public:
     json::JsonObject GetPersistFancyZonesJSON();
 
     void LoadFancyZonesData();
+    // Writes all the data files now. Must not be called while holding dataLock
     void SaveFancyZonesData() const;
+    // Writes the pending changes and stops the background writer. Must not be called while holding dataLock
+    void FlushFancyZonesData() const;
+    // Writes the pending changes now, so that the editor reads them. Must not be called while holding dataLock
+    void WritePendingFancyZonesData() const;
 
 private:
 #if defined(UNIT_TESTS)
@@ -98,7 +108,7 @@ private:
 
     inline void clear_data()
     {
-        appZoneHistoryMap.clear();
+        appZoneHistoryStore.Clear();
         deviceInfoMap.clear();
         customZoneSetsMap.clear();
     }
@@ -108,6 +118,7 @@ private:
         std::wstring result = PTSettingsHelper::get_module_save_folder_location(moduleName);
         zonesSettingsFileName = result + L"\\" + std::wstring(L"zones-settings.json");
         appZoneHistoryFileName = result + L"\\" + std::wstring(L"app-zone-history.json");
+        appZoneHistoryLog = RecordLog{ result + L"\\" + std::wstring(L"app-zone-history.log") };
     }
 #endif
     void ParseDeviceInfoFromTmpFile(std::wstring_view tmpFilePath);
@@ -115,23 +126,45 @@ private:
     void ParseDeletedCustomZoneSetsFromTmpFile(std::wstring_view tmpFilePath);
 
     void MigrateCustomZoneSetsFromRegistry();
-    void RemoveDesktopAppZoneHistory(const std::wstring& desktopId);
+    void RemoveDesktopAppZoneHistory(const std::unordered_set<std::wstring>& desktopIds);
 
-    // Maps app path to app's zone history data
-    std::unordered_map<std::wstring, std::vector<FancyZonesDataTypes::AppZoneHistoryData>> appZoneHistoryMap{};
+    // Indices of the data files in the persistence service
+    enum PersistedFile : size_t
+    {
+        ZonesSettingsFile,
+        AppZoneHistoryFile,
+    };
+    // Schedules a background write of the file, after the changes stop for a while
+    void ScheduleSave(PersistedFile file) const;
+    // Write functions of the persistence service, returning false if the file wasn't written
+    bool SaveZonesSettings() const;
+    bool SaveAppZoneHistory();
+    // Loads the app zone history from its log. Returns false if there is no log yet
+    bool LoadAppZoneHistoryLog();
+
+    // Maps app path to app's zone history data, indexed by app path, device id and zoneset id
+    AppZoneHistoryStore appZoneHistoryStore{};
+    // Caches the process path of the windows looked up in the app zone history
+    mutable ProcessPathCache processPathCache{};
     // Maps device unique ID to device data
     std::unordered_map<std::wstring, FancyZonesDataTypes::DeviceInfoData> deviceInfoMap{};
     // Maps custom zoneset UUID to it's data
     std::unordered_map<std::wstring, FancyZonesDataTypes::CustomZoneSetData> customZoneSetsMap{};
 
     std::wstring zonesSettingsFileName;
+    // Previous format of the app zone history, read once to migrate it to the log
     std::wstring appZoneHistoryFileName;
+    // One record per application, appended when the history of the application changes
+    RecordLog appZoneHistoryLog;
 
     std::wstring activeZoneSetTmpFileName;
     std::wstring appliedZoneSetTmpFileName;
     std::wstring deletedCustomZoneSetsTmpFileName;
 
     mutable std::recursive_mutex dataLock;
+
+    // Declared last, so that it writes the pending changes before the data is destroyed
+    mutable PersistenceService persistence;
 };
 
 FancyZonesData& FancyZonesDataInstance();
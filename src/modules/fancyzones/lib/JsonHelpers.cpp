@@ -2,6 +2,7 @@
 
 #include "JsonHelpers.h"
 #include "FancyZonesDataTypes.h"
+#include "PersistenceService.h"
 #include "trace.h"
 #include "util.h"
 
@@ -474,21 +475,40 @@ namespace JSONHelpers
                             const TAppZoneHistoryMap& appZoneHistoryMap)
 
     {
-        json::JsonObject root{};
-        json::JsonObject appZoneHistoryRoot{};
+        SaveZonesSettings(zonesSettingsFileName, SerializeZonesSettings(deviceInfoMap, customZoneSetsMap));
+        SaveAppZoneHistory(appZoneHistoryFileName, SerializeAppZoneHistoryFile(appZoneHistoryMap));
+    }
 
-        appZoneHistoryRoot.SetNamedValue(NonLocalizable::AppZoneHistoryStr, JSONHelpers::SerializeAppZoneHistory(appZoneHistoryMap));
+    json::JsonObject SerializeZonesSettings(const TDeviceInfoMap& deviceInfoMap, const TCustomZoneSetsMap& customZoneSetsMap)
+    {
+        json::JsonObject root{};
         root.SetNamedValue(NonLocalizable::DevicesStr, JSONHelpers::SerializeDeviceInfos(deviceInfoMap));
         root.SetNamedValue(NonLocalizable::CustomZoneSetsStr, JSONHelpers::SerializeCustomZoneSets(customZoneSetsMap));
+        return root;
+    }
+
+    json::JsonObject SerializeAppZoneHistoryFile(const TAppZoneHistoryMap& appZoneHistoryMap)
+    {
+        json::JsonObject appZoneHistoryRoot{};
+        appZoneHistoryRoot.SetNamedValue(NonLocalizable::AppZoneHistoryStr, JSONHelpers::SerializeAppZoneHistory(appZoneHistoryMap));
+        return appZoneHistoryRoot;
+    }
 
+    bool SaveZonesSettings(const std::wstring& zonesSettingsFileName, const json::JsonObject& zonesSettings)
+    {
+        const auto content = zonesSettings.Stringify();
         auto before = json::from_file(zonesSettingsFileName);
-        if (!before.has_value() || before.value().Stringify() != root.Stringify())
+        if (!before.has_value() || before.value().Stringify() != content)
         {
             Trace::FancyZones::DataChanged();
         }
 
-        json::to_file(zonesSettingsFileName, root);
-        json::to_file(appZoneHistoryFileName, appZoneHistoryRoot);
+        return PersistenceService::WriteFileAtomically(zonesSettingsFileName, winrt::to_string(content));
+    }
+
+    bool SaveAppZoneHistory(const std::wstring& appZoneHistoryFileName, const json::JsonObject& appZoneHistory)
+    {
+        return PersistenceService::WriteFileAtomically(appZoneHistoryFileName, winrt::to_string(appZoneHistory.Stringify()));
     }
 
     TAppZoneHistoryMap ParseAppZoneHistory(const json::JsonObject& fancyZonesDataJSON)
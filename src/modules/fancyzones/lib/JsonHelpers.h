@@ -67,6 +67,12 @@ namespace JSONHelpers
 							const TCustomZoneSetsMap& customZoneSetsMap,
 							const TAppZoneHistoryMap& appZoneHistoryMap);
 
+    json::JsonObject SerializeZonesSettings(const TDeviceInfoMap& deviceInfoMap, const TCustomZoneSetsMap& customZoneSetsMap);
+    json::JsonObject SerializeAppZoneHistoryFile(const TAppZoneHistoryMap& appZoneHistoryMap);
+    // Return false if the file wasn't written
+    bool SaveZonesSettings(const std::wstring& zonesSettingsFileName, const json::JsonObject& zonesSettings);
+    bool SaveAppZoneHistory(const std::wstring& appZoneHistoryFileName, const json::JsonObject& appZoneHistory);
+
     TAppZoneHistoryMap ParseAppZoneHistory(const json::JsonObject& fancyZonesDataJSON);
     json::JsonArray SerializeAppZoneHistory(const TAppZoneHistoryMap& appZoneHistoryMap);
 
@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "PersistenceService.h"
+
+#include <fstream>
+
+PersistenceService::PersistenceService(std::chrono::milliseconds debounce, std::chrono::milliseconds maxDelay, std::vector<WriteFunction> writers) :
+    m_debounce(debounce), m_maxDelay(maxDelay), m_writers(std::move(writers))
+{
+}
+
+PersistenceService::~PersistenceService()
+{
+    Stop();
+}
+
+void PersistenceService::MarkDirty(size_t file)
+{
+    std::unique_lock lock{ m_mutex };
+    MarkDirtyLocked(1u << file);
+
+    if (!m_thread.joinable())
+    {
+        m_stopping = false;
+        m_thread = std::thread([this] { Run(); });
+    }
+    lock.unlock();
+    m_cv.notify_one();
+}
+
+void PersistenceService::Flush()
+{
+    WriteDirty();
+}
+
+void PersistenceService::WriteAll()
+{
+    std::scoped_lock writeLock{ m_writeMutex };
+    {
+        std::scoped_lock lock{ m_mutex };
+        m_dirtyFiles = 0;
+    }
+    Write(static_cast<uint32_t>((1ull << m_writers.size()) - 1));
+}
+
+void PersistenceService::Stop()
+{
+    {
+        std::unique_lock lock{ m_mutex };
+        if (m_thread.joinable())
+        {
+            m_stopping = true;
+            lock.unlock();
+            m_cv.notify_one();
+            m_thread.join();
+        }
+    }
+    WriteDirty();
+}
+
+bool PersistenceService::WriteFileAtomically(const std::wstring& fileName, const std::string& content)
+{
+    const std::wstring tmpFileName = fileName + L".tmp";
+    {
+        std::ofstream file{ tmpFileName, std::ios::binary | std::ios::trunc };
+        if (!file.is_open() || !(file << content).flush())
+        {
+            return false;
+        }
+    }
+
+    if (!MoveFileExW(tmpFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        DeleteFileW(tmpFileName.c_str());
+        return false;
+    }
+    return true;
+}
+
+void PersistenceService::Run()
+{
+    std::unique_lock lock{ m_mutex };
+    while (!m_stopping)
+    {
+        if (m_dirtyFiles == 0)
+        {
+            m_cv.wait(lock, [this] { return m_stopping || m_dirtyFiles != 0; });
+            continue;
+        }
+
+        // Every change postpones the write by the debounce window, up to the maximum delay since the first change
+        const auto deadline = (std::min)(m_lastChange + m_debounce, m_firstChange + m_maxDelay);
+        if (std::chrono::steady_clock::now() < deadline)
+        {
+            m_cv.wait_until(lock, deadline);
+            continue;
+        }
+
+        lock.unlock();
+        WriteDirty();
+        lock.lock();
+    }
+}
+
+void PersistenceService::WriteDirty()
+{
+    // A flush which finds no dirty file must still wait for the files being written by another thread
+    std::scoped_lock writeLock{ m_writeMutex };
+    uint32_t files;
+    {
+        std::scoped_lock lock{ m_mutex };
+        files = std::exchange(m_dirtyFiles, 0);
+    }
+    Write(files);
+}
+
+void PersistenceService::MarkDirtyLocked(uint32_t files)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (m_dirtyFiles == 0)
+    {
+        m_firstChange = now;
+    }
+    m_dirtyFiles |= files;
+    m_lastChange = now;
+}
+
+void PersistenceService::Write(uint32_t files)
+{
+    uint32_t failedFiles = 0;
+    for (size_t i = 0; i < m_writers.size(); ++i)
+    {
+        if ((files & (1u << i)) && !m_writers[i]())
+        {
+            failedFiles |= 1u << i;
+        }
+    }
+
+    if (failedFiles != 0)
+    {
+        // Retried after the debounce window, e.g. once the editor doesn't hold the file open anymore
+        {
+            std::scoped_lock lock{ m_mutex };
+            MarkDirtyLocked(failedFiles);
+        }
+        m_cv.notify_one();
+    }
+}
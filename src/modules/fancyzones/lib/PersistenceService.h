@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Write-behind persistence of a fixed set of files. Changes only mark their file dirty, and a background
+ * thread writes the dirty files once no change was made for the debounce window, so a burst of changes
+ * produces a single write and the thread making the change never waits for the disk.
+ */
+class PersistenceService
+{
+public:
+    /**
+     * Function writing one file, called on the writer thread or on the thread flushing the changes.
+     * Calls writing files of the same service never overlap. Returns false if the file wasn't written,
+     * and the file is marked dirty again so the next scheduled write retries it.
+     */
+    using WriteFunction = std::function<bool()>;
+
+    /**
+     * @param   debounce Time without changes after which the dirty files are written.
+     * @param   maxDelay Time after which the dirty files are written even if they keep changing.
+     * @param   writers  Write functions, position in the vector is the file index. At most 32 files.
+     */
+    PersistenceService(std::chrono::milliseconds debounce, std::chrono::milliseconds maxDelay, std::vector<WriteFunction> writers);
+    /**
+     * Writes the dirty files and stops the writer thread.
+     */
+    ~PersistenceService();
+
+    PersistenceService(const PersistenceService&) = delete;
+    PersistenceService& operator=(const PersistenceService&) = delete;
+
+    /**
+     * Mark the file dirty, and start the writer thread if it isn't running.
+     *
+     * @param   file Index of the file.
+     */
+    void MarkDirty(size_t file);
+    /**
+     * Write the dirty files on the calling thread. Also waits for a write in progress on the writer thread,
+     * so the files are up to date for another process once this returns.
+     */
+    void Flush();
+    /**
+     * Write all the files on the calling thread, whether they are dirty or not.
+     */
+    void WriteAll();
+    /**
+     * Write the dirty files and stop the writer thread. The thread is started again by the next change,
+     * which also retries the files whose write failed.
+     */
+    void Stop();
+
+    /**
+     * Write the content to the file atomically, by writing a temporary file next to it and renaming it
+     * over the file, so the file is never left partially written.
+     *
+     * @returns True if the file was written.
+     */
+    static bool WriteFileAtomically(const std::wstring& fileName, const std::string& content);
+
+private:
+    void Run();
+    // Mark the files of the mask dirty, and postpone the write by the debounce window. The caller holds m_mutex
+    void MarkDirtyLocked(uint32_t files);
+    // Take the dirty files and write them
+    void WriteDirty();
+    // Write the files of the mask, and mark the ones which failed dirty again. The caller holds m_writeMutex
+    void Write(uint32_t files);
+
+    const std::chrono::milliseconds m_debounce;
+    const std::chrono::milliseconds m_maxDelay;
+    const std::vector<WriteFunction> m_writers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    // Bit i is set when the file with index i has changes which weren't written
+    uint32_t m_dirtyFiles{};
+    std::chrono::steady_clock::time_point m_firstChange;
+    std::chrono::steady_clock::time_point m_lastChange;
+    bool m_stopping{};
+    std::thread m_thread;
+
+    // Serializes the write functions. Held from taking the dirty files until they are written, and locked before m_mutex
+    std::mutex m_writeMutex;
+};
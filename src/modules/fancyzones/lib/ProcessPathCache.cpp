@@ -0,0 +1,79 @@
+#include "pch.h"
+#include "ProcessPathCache.h"
+
+#include <common/common.h>
+
+namespace
+{
+    const wchar_t AppFrameHostStr[] = L"ApplicationFrameHost.exe";
+
+    bool IsRunning(HANDLE process) noexcept
+    {
+        return WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    }
+}
+
+const std::wstring& ProcessPathCache::GetProcessPath(HWND window)
+{
+    DWORD pid{};
+    GetWindowThreadProcessId(window, &pid);
+
+    auto it = m_processes.find(pid);
+    if (it == m_processes.end() || !IsRunning(it->second.handle.get()))
+    {
+        if (it != m_processes.end())
+        {
+            m_processes.erase(it);
+        }
+
+        // Same access rights as get_process_path, so the same processes can be queried
+        wil::unique_handle handle{ OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ | SYNCHRONIZE, FALSE, pid) };
+        if (!handle)
+        {
+            m_uncachedPath = get_process_path(window);
+            return m_uncachedPath;
+        }
+
+        Process process{ .handle = std::move(handle), .path = std::wstring(MAX_PATH, L'\0') };
+        DWORD length = static_cast<DWORD>(process.path.length());
+        if (QueryFullProcessImageNameW(process.handle.get(), 0, process.path.data(), &length) == 0)
+        {
+            length = 0;
+        }
+        process.path.resize(length);
+        process.isFrameHost = process.path.ends_with(AppFrameHostStr);
+
+        if (m_processes.size() >= PruneThreshold)
+        {
+            PruneExitedProcesses();
+        }
+        it = m_processes.emplace(pid, std::move(process)).first;
+    }
+
+    if (it->second.isFrameHost)
+    {
+        m_uncachedPath = get_process_path(window);
+        return m_uncachedPath;
+    }
+    return it->second.path;
+}
+
+void ProcessPathCache::Clear() noexcept
+{
+    m_processes.clear();
+}
+
+void ProcessPathCache::PruneExitedProcesses()
+{
+    for (auto it = m_processes.begin(); it != m_processes.end();)
+    {
+        if (IsRunning(it->second.handle.get()))
+        {
+            ++it;
+        }
+        else
+        {
+            it = m_processes.erase(it);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+/**
+ * Cache of the executable paths of the processes owning windows. A process is opened and queried once,
+ * and its handle is kept while it's cached, so its id can't be reused by another process in the meantime.
+ * Not synchronized.
+ */
+class ProcessPathCache
+{
+public:
+    /**
+     * Get the path of the process owning the window, the same as get_process_path(window).
+     *
+     * @param   window Window handle.
+     * @returns Path of the process, or an empty string if the process can't be queried. The reference is
+     *          valid until the next call.
+     */
+    const std::wstring& GetProcessPath(HWND window);
+    /**
+     * Remove all processes from the cache.
+     */
+    void Clear() noexcept;
+
+private:
+    struct Process
+    {
+        wil::unique_handle handle;
+        std::wstring path;
+        // The path of an UWP app window depends on the window it hosts, so it isn't cached
+        bool isFrameHost{};
+    };
+
+    // Number of processes above which the exited processes are removed from the cache
+    static constexpr size_t PruneThreshold = 256;
+
+    void PruneExitedProcesses();
+
+    std::unordered_map<DWORD, Process> m_processes;
+    // Result of the last query which wasn't cached
+    std::wstring m_uncachedPath;
+};
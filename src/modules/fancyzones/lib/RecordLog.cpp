@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "RecordLog.h"
+
+#include "PersistenceService.h"
+
+#include <algorithm>
+#include <fstream>
+
+// Non-Localizable strings
+namespace NonLocalizable
+{
+    const wchar_t KeyStr[] = L"key";
+    const wchar_t ValueStr[] = L"value";
+}
+
+void RecordLog::Batch::Set(const std::wstring& key, const json::JsonObject& value)
+{
+    json::JsonObject record;
+    record.SetNamedValue(NonLocalizable::KeyStr, json::value(key));
+    record.SetNamedValue(NonLocalizable::ValueStr, value);
+    AddLine(record);
+}
+
+void RecordLog::Batch::Remove(const std::wstring& key)
+{
+    json::JsonObject record;
+    record.SetNamedValue(NonLocalizable::KeyStr, json::value(key));
+    AddLine(record);
+}
+
+void RecordLog::Batch::AddLine(const json::JsonObject& record)
+{
+    // Stringify escapes the line breaks of the strings, so a record is always a single line
+    m_lines += winrt::to_string(record.Stringify());
+    m_lines += '\n';
+    ++m_count;
+}
+
+RecordLog::RecordLog(std::wstring fileName) :
+    m_fileName(std::move(fileName))
+{
+}
+
+bool RecordLog::Read(const RecordFunction& onRecord)
+{
+    m_recordCount = 0;
+    m_hasInvalidRecords = false;
+
+    std::ifstream file{ m_fileName, std::ios::binary };
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        // A line without line break is the end of an interrupted append, so the next append must not follow it
+        if (file.eof())
+        {
+            m_hasInvalidRecords = true;
+        }
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+
+        ++m_recordCount;
+        json::JsonObject record;
+        if (!json::JsonObject::TryParse(winrt::to_hstring(line), record) || !json::has(record, NonLocalizable::KeyStr, json::JsonValueType::String))
+        {
+            m_hasInvalidRecords = true;
+            continue;
+        }
+
+        const std::wstring key{ record.GetNamedString(NonLocalizable::KeyStr) };
+        if (json::has(record, NonLocalizable::ValueStr, json::JsonValueType::Object))
+        {
+            const json::JsonObject value = record.GetNamedObject(NonLocalizable::ValueStr);
+            onRecord(key, &value);
+        }
+        else if (record.HasKey(NonLocalizable::ValueStr))
+        {
+            // A value which isn't an object is not a removal
+            m_hasInvalidRecords = true;
+        }
+        else
+        {
+            onRecord(key, nullptr);
+        }
+    }
+
+    return true;
+}
+
+bool RecordLog::NeedsCompaction(size_t appendedRecords, size_t liveRecords) const noexcept
+{
+    return m_hasInvalidRecords || m_recordCount + appendedRecords > std::max(2 * liveRecords, MinCompactionRecords);
+}
+
+bool RecordLog::Append(const Batch& batch)
+{
+    if (batch.m_count == 0)
+    {
+        return true;
+    }
+
+    std::ofstream file{ m_fileName, std::ios::binary | std::ios::app };
+    if (!file.is_open() || !(file << batch.m_lines).flush())
+    {
+        // The file may end with a partial record
+        m_hasInvalidRecords = true;
+        return false;
+    }
+
+    m_recordCount += batch.m_count;
+    return true;
+}
+
+bool RecordLog::Compact(const Batch& batch)
+{
+    if (!PersistenceService::WriteFileAtomically(m_fileName, batch.m_lines))
+    {
+        return false;
+    }
+
+    m_recordCount = batch.m_count;
+    m_hasInvalidRecords = false;
+    return true;
+}
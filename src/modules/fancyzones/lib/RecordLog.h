@@ -0,0 +1,83 @@
+#pragma once
+
+#include <common/json.h>
+
+#include <functional>
+#include <string>
+
+/**
+ * Append-only log of keyed JSON records, one record per line of the file. A record replaces the previous
+ * record with the same key, and a record without a value removes the key. Saving a change appends only its
+ * record, and the log is compacted into one record per live key once most of its records are superseded.
+ *
+ * The log is not thread safe, it's meant to be used by a single writer.
+ */
+class RecordLog
+{
+public:
+    /**
+     * Records to write, formatted as the lines of the log.
+     */
+    class Batch
+    {
+    public:
+        void Set(const std::wstring& key, const json::JsonObject& value);
+        void Remove(const std::wstring& key);
+
+        size_t Size() const noexcept { return m_count; }
+
+    private:
+        friend class RecordLog;
+
+        void AddLine(const json::JsonObject& record);
+
+        std::string m_lines;
+        size_t m_count{};
+    };
+
+    /**
+     * Function called for each record read from the log, with nullptr as the value of a removed key.
+     */
+    using RecordFunction = std::function<void(const std::wstring& key, const json::JsonObject* value)>;
+
+    RecordLog() = default;
+    explicit RecordLog(std::wstring fileName);
+
+    /**
+     * Read the records of the log in order, one line at a time. Lines which can't be parsed, e.g. the last line
+     * of an append interrupted by a crash, and records whose value isn't an object are skipped, and the next
+     * write compacts the log.
+     *
+     * @returns False if the log doesn't exist.
+     */
+    bool Read(const RecordFunction& onRecord);
+
+    /**
+     * @param   appendedRecords Number of records about to be appended.
+     * @param   liveRecords     Number of live keys after the append.
+     * @returns True if the log should be compacted instead of appended to.
+     */
+    bool NeedsCompaction(size_t appendedRecords, size_t liveRecords) const noexcept;
+
+    /**
+     * Append the records to the log.
+     *
+     * @returns True if the records were written.
+     */
+    bool Append(const Batch& batch);
+    /**
+     * Replace the log with the records, which must hold one record per live key.
+     *
+     * @returns True if the log was written.
+     */
+    bool Compact(const Batch& batch);
+
+private:
+    // Compacting a smaller log isn't worth the rewrite
+    static constexpr size_t MinCompactionRecords = 64;
+
+    std::wstring m_fileName;
+    // Number of lines of the log, including the superseded and invalid ones
+    size_t m_recordCount{};
+    bool m_hasInvalidRecords{};
+};
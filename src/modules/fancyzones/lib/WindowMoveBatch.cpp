@@ -0,0 +1,113 @@
+#include "pch.h"
+#include "WindowMoveBatch.h"
+
+#include "util.h"
+
+#include <algorithm>
+
+namespace
+{
+    class DesktopPositioner : public IWindowPositioner
+    {
+    public:
+        bool CanDeferMove(const WindowMove& move) override
+        {
+            // The transaction waits for every window, while the placement of a hung window is set asynchronously
+            if (IsHungAppWindow(move.window))
+            {
+                return false;
+            }
+
+            WINDOWPLACEMENT placement{ sizeof(placement) };
+            if (!::GetWindowPlacement(move.window, &placement) || placement.showCmd != SW_SHOWNORMAL)
+            {
+                return false;
+            }
+
+            // A window moved to a monitor with a different DPI resizes itself after the move, which the
+            // placement path handles by moving it twice (Issue #365)
+            const RECT screenRect = ToScreen(move);
+            return MonitorFromRect(&screenRect, MONITOR_DEFAULTTONULL) == MonitorFromWindow(move.window, MONITOR_DEFAULTTONULL);
+        }
+
+        bool DeferMoves(const std::vector<WindowMove>& moves) override
+        {
+            HDWP windowPositions = BeginDeferWindowPos(static_cast<int>(moves.size()));
+            for (const auto& move : moves)
+            {
+                if (!windowPositions)
+                {
+                    // The transaction was discarded, none of the windows has been moved
+                    return false;
+                }
+
+                const RECT rect = ToScreen(move);
+                windowPositions = DeferWindowPos(windowPositions, move.window, nullptr, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, SWP_NOZORDER | SWP_NOOWNERZORDER | SWP_NOACTIVATE);
+            }
+            return windowPositions && EndDeferWindowPos(windowPositions);
+        }
+
+        void MoveWithPlacement(const WindowMove& move) override
+        {
+            SizeWindowToRect(move.window, move.rect);
+        }
+
+    private:
+        // Workspace coordinates are relative to the work area of the monitor, which excludes the taskbar
+        static RECT ToScreen(const WindowMove& move) noexcept
+        {
+            RECT rect = move.rect;
+            MONITORINFO mi{ sizeof(mi) };
+            if (GetMonitorInfoW(MonitorFromWindow(move.window, MONITOR_DEFAULTTONEAREST), &mi))
+            {
+                OffsetRect(&rect, std::abs(mi.rcMonitor.left - mi.rcWork.left), std::abs(mi.rcMonitor.top - mi.rcWork.top));
+            }
+            return rect;
+        }
+    };
+}
+
+IWindowPositioner& DesktopWindowPositioner() noexcept
+{
+    static DesktopPositioner positioner;
+    return positioner;
+}
+
+void WindowMoveBatch::Add(HWND window, const RECT& rect)
+{
+    auto it = std::find_if(m_moves.begin(), m_moves.end(), [window](const WindowMove& move) { return move.window == window; });
+    if (it != m_moves.end())
+    {
+        it->rect = rect;
+    }
+    else
+    {
+        m_moves.push_back({ window, rect });
+    }
+}
+
+void WindowMoveBatch::Apply(IWindowPositioner& positioner)
+{
+    m_deferredMoves.clear();
+    for (const auto& move : m_moves)
+    {
+        if (positioner.CanDeferMove(move))
+        {
+            m_deferredMoves.push_back(move);
+        }
+        else
+        {
+            positioner.MoveWithPlacement(move);
+        }
+    }
+
+    if (!m_deferredMoves.empty() && !positioner.DeferMoves(m_deferredMoves))
+    {
+        for (const auto& move : m_deferredMoves)
+        {
+            positioner.MoveWithPlacement(move);
+        }
+    }
+
+    m_moves.clear();
+}
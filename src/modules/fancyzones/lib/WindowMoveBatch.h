@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * Move of a window to a rect in workspace coordinates, like the normal position of the window placement.
+ */
+struct WindowMove
+{
+    HWND window;
+    RECT rect;
+};
+
+/**
+ * Window system side of a window move batch, so the batch can be tested without moving real windows.
+ */
+class IWindowPositioner
+{
+public:
+    virtual ~IWindowPositioner() = default;
+
+    /**
+     * @returns True if the window can be moved by a deferred move, false if it has to be moved through its
+     *          placement, e.g. because it's minimized or maximized.
+     */
+    virtual bool CanDeferMove(const WindowMove& move) = 0;
+    /**
+     * Move the windows in one transaction, so the desktop is repainted once.
+     *
+     * @returns False if the transaction failed.
+     */
+    virtual bool DeferMoves(const std::vector<WindowMove>& moves) = 0;
+    /**
+     * Move the window through its placement, restoring it if it's maximized.
+     */
+    virtual void MoveWithPlacement(const WindowMove& move) = 0;
+};
+
+/**
+ * @returns Positioner moving the windows of the desktop.
+ */
+IWindowPositioner& DesktopWindowPositioner() noexcept;
+
+/**
+ * Window moves collected first and applied together. The windows which can be moved by a deferred move are
+ * moved in a single transaction, instead of repainting the desktop for every window, and the others are moved
+ * through their placement one at a time.
+ */
+class WindowMoveBatch
+{
+public:
+    /**
+     * Add the move of the window, replacing the previous move of the same window.
+     */
+    void Add(HWND window, const RECT& rect);
+
+    size_t Size() const noexcept { return m_moves.size(); }
+
+    /**
+     * Move the windows and clear the batch. If the deferred transaction fails, the windows are moved
+     * through their placement instead.
+     */
+    void Apply(IWindowPositioner& positioner = DesktopWindowPositioner());
+
+private:
+    std::vector<WindowMove> m_moves;
+    // Moves of the deferred transaction, kept to reuse their storage
+    std::vector<WindowMove> m_deferredMoves;
+};
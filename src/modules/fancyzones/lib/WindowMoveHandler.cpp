@@ -81,6 +81,7 @@ public:
     void MoveSizeEnd(HWND window, POINT const& ptScreen, const std::unordered_map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap) noexcept;
 
     void MoveWindowIntoZoneByIndexSet(HWND window, const std::vector<int>& indexSet, winrt::com_ptr<IZoneWindow> zoneWindow) noexcept;
+    bool PrepareWindowMove(HWND window, const std::vector<int>& indexSet, winrt::com_ptr<IZoneWindow> zoneWindow, RECT& rect) noexcept;
     bool MoveWindowIntoZoneByDirection(HWND window, DWORD vkCode, bool cycle, winrt::com_ptr<IZoneWindow> zoneWindow);
 
 private:
@@ -167,6 +168,11 @@ void WindowMoveHandler::MoveWindowIntoZoneByIndexSet(HWND window, const std::vec
     pimpl->MoveWindowIntoZoneByIndexSet(window, indexSet, zoneWindow);
 }
 
+bool WindowMoveHandler::PrepareWindowMove(HWND window, const std::vector<int>& indexSet, winrt::com_ptr<IZoneWindow> zoneWindow, RECT& rect) noexcept
+{
+    return pimpl->PrepareWindowMove(window, indexSet, zoneWindow, rect);
+}
+
 bool WindowMoveHandler::MoveWindowIntoZoneByDirection(HWND window, DWORD vkCode, bool cycle, winrt::com_ptr<IZoneWindow> zoneWindow)
 {
     return pimpl->MoveWindowIntoZoneByDirection(window, vkCode, cycle, zoneWindow);
@@ -387,6 +393,11 @@ void WindowMoveHandlerPrivate::MoveWindowIntoZoneByIndexSet(HWND window, const s
     }
 }
 
+bool WindowMoveHandlerPrivate::PrepareWindowMove(HWND window, const std::vector<int>& indexSet, winrt::com_ptr<IZoneWindow> zoneWindow, RECT& rect) noexcept
+{
+    return window != m_windowMoveSize && zoneWindow->PrepareWindowMove(window, indexSet, rect);
+}
+
 bool WindowMoveHandlerPrivate::MoveWindowIntoZoneByDirection(HWND window, DWORD vkCode, bool cycle, winrt::com_ptr<IZoneWindow> zoneWindow)
 {
     return zoneWindow && zoneWindow->MoveWindowIntoZoneByDirection(window, vkCode, cycle);
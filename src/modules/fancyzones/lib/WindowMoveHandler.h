@@ -24,6 +24,8 @@ public:
     void MoveSizeEnd(HWND window, POINT const& ptScreen, const std::unordered_map<HMONITOR, winrt::com_ptr<IZoneWindow>>& zoneWindowMap) noexcept;
 
     void MoveWindowIntoZoneByIndexSet(HWND window, const std::vector<int>& indexSet, winrt::com_ptr<IZoneWindow> zoneWindow) noexcept;
+    // Assigns the window to the zones without moving it, returns false if it doesn't have to be moved to rect
+    bool PrepareWindowMove(HWND window, const std::vector<int>& indexSet, winrt::com_ptr<IZoneWindow> zoneWindow, RECT& rect) noexcept;
     bool MoveWindowIntoZoneByDirection(HWND window, DWORD vkCode, bool cycle, winrt::com_ptr<IZoneWindow> zoneWindow);
 
 private:
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "ZoneGeometryCache.h"
+
+namespace
+{
+    void HashCombine(size_t& hash, size_t value) noexcept
+    {
+        hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+    }
+}
+
+ZoneGeometryCache::Key ZoneGeometryCache::MakeKey(const GUID& layoutId, FancyZonesDataTypes::ZoneSetLayoutType layoutType, HMONITOR monitor, int zoneCount, int width, int height, int spacing) noexcept
+{
+    Key key{ GUID_NULL, layoutType, zoneCount, width, height, spacing, 0 };
+    if (layoutType == FancyZonesDataTypes::ZoneSetLayoutType::Custom)
+    {
+        // The zone count of a custom layout comes from its data
+        key.customLayoutId = layoutId;
+        key.zoneCount = 0;
+
+        // Same monitor fallback as DPIAware::Convert, which scales the canvas zones
+        if (monitor == NULL)
+        {
+            monitor = MonitorFromPoint(POINT{ 0, 0 }, MONITOR_DEFAULTTOPRIMARY);
+        }
+
+        UINT dpiX = 0, dpiY = 0;
+        if (GetDpiForMonitor(monitor, MDT_EFFECTIVE_DPI, &dpiX, &dpiY) == S_OK)
+        {
+            key.dpi = dpiX;
+        }
+    }
+
+    return key;
+}
+
+std::optional<std::vector<RECT>> ZoneGeometryCache::Find(const Key& key) const
+{
+    std::scoped_lock lock{ m_lock };
+    auto it = m_entries.find(key);
+    return it != m_entries.end() ? std::optional{ it->second } : std::nullopt;
+}
+
+unsigned int ZoneGeometryCache::CustomLayoutsGeneration() const noexcept
+{
+    std::scoped_lock lock{ m_lock };
+    return m_customLayoutsGeneration;
+}
+
+void ZoneGeometryCache::Insert(const Key& key, std::vector<RECT> zoneRects, unsigned int generation)
+{
+    std::scoped_lock lock{ m_lock };
+    if (key.layoutType == FancyZonesDataTypes::ZoneSetLayoutType::Custom && generation != m_customLayoutsGeneration)
+    {
+        return;
+    }
+
+    if (m_entries.size() >= MaxEntries)
+    {
+        m_entries.clear();
+    }
+
+    m_entries.insert_or_assign(key, std::move(zoneRects));
+}
+
+void ZoneGeometryCache::InvalidateCustomLayouts() noexcept
+{
+    std::scoped_lock lock{ m_lock };
+    ++m_customLayoutsGeneration;
+    std::erase_if(m_entries, [](const auto& entry) {
+        return entry.first.layoutType == FancyZonesDataTypes::ZoneSetLayoutType::Custom;
+    });
+}
+
+void ZoneGeometryCache::Clear() noexcept
+{
+    std::scoped_lock lock{ m_lock };
+    m_entries.clear();
+}
+
+size_t ZoneGeometryCache::Size() const noexcept
+{
+    std::scoped_lock lock{ m_lock };
+    return m_entries.size();
+}
+
+size_t ZoneGeometryCache::KeyHash::operator()(const Key& key) const noexcept
+{
+    const uint64_t* id = reinterpret_cast<const uint64_t*>(&key.customLayoutId);
+    size_t hash = std::hash<uint64_t>{}(id[0]);
+    HashCombine(hash, std::hash<uint64_t>{}(id[1]));
+    HashCombine(hash, std::hash<int>{}(static_cast<int>(key.layoutType)));
+    HashCombine(hash, std::hash<int>{}(key.zoneCount));
+    HashCombine(hash, std::hash<int>{}(key.width));
+    HashCombine(hash, std::hash<int>{}(key.height));
+    HashCombine(hash, std::hash<int>{}(key.spacing));
+    HashCombine(hash, std::hash<UINT>{}(key.dpi));
+    return hash;
+}
+
+ZoneGeometryCache& ZoneGeometryCacheInstance()
+{
+    static ZoneGeometryCache instance;
+    return instance;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "FancyZonesDataTypes.h"
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Zone rectangles of the computed layouts, so a layout is calculated once for a work area instead of every time
+ * a zone window is created for it, e.g. on each virtual desktop switch, display change or layout cycle.
+ *
+ * Template layouts only depend on their type, zone count, spacing and the size of the work area. Custom layouts
+ * depend on their data as well, so their entries are dropped when a custom layout is edited or deleted.
+ */
+class ZoneGeometryCache
+{
+public:
+    struct Key
+    {
+        // Id of the custom layout, GUID_NULL for template layouts
+        GUID customLayoutId;
+        FancyZonesDataTypes::ZoneSetLayoutType layoutType;
+        int zoneCount;
+        int width;
+        int height;
+        int spacing;
+        // DPI of the monitor, canvas zones are scaled by it. Zero for template layouts
+        UINT dpi;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    /**
+     * @param   layoutId   Id of the zone set.
+     * @param   layoutType Type of the zone set.
+     * @param   monitor    Monitor of the work area, the primary monitor is used if it's NULL.
+     * @returns Key of the layout calculated for the work area.
+     */
+    static Key MakeKey(const GUID& layoutId, FancyZonesDataTypes::ZoneSetLayoutType layoutType, HMONITOR monitor, int zoneCount, int width, int height, int spacing) noexcept;
+
+    /**
+     * @returns Zone rectangles of the layout, or nullopt if they aren't cached.
+     */
+    std::optional<std::vector<RECT>> Find(const Key& key) const;
+
+    /**
+     * @returns Generation of the custom layouts, read before the custom layout data and passed to Insert.
+     */
+    unsigned int CustomLayoutsGeneration() const noexcept;
+
+    /**
+     * Cache the zone rectangles of the layout. Rectangles of a custom layout calculated before the custom layouts
+     * were invalidated are dropped.
+     *
+     * @param   generation Generation of the custom layouts read before calculating the layout.
+     */
+    void Insert(const Key& key, std::vector<RECT> zoneRects, unsigned int generation);
+
+    /**
+     * Drop the rectangles of all custom layouts, called when the custom layouts change.
+     */
+    void InvalidateCustomLayouts() noexcept;
+
+    void Clear() noexcept;
+
+    size_t Size() const noexcept;
+
+private:
+    // The cache is cleared once it gets bigger, e.g. after many display changes, instead of tracking recency
+    static constexpr size_t MaxEntries = 256;
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    mutable std::mutex m_lock;
+    std::unordered_map<Key, std::vector<RECT>, KeyHash> m_entries;
+    unsigned int m_customLayoutsGeneration{};
+};
+
+ZoneGeometryCache& ZoneGeometryCacheInstance();
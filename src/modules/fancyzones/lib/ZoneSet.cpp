@@ -2,6 +2,8 @@
 
 #include "util.h"
 #include "lib/ZoneSet.h"
+#include "ZoneGeometryCache.h"
+#include "ZoneSpatialIndex.h"
 #include "Settings.h"
 #include "FancyZonesData.h"
 #include "FancyZonesDataTypes.h"
@@ -138,6 +140,8 @@ public:
     IFACEMETHODIMP_(void)
     MoveWindowIntoZoneByIndexSet(HWND window, HWND windowZone, const std::vector<int>& indexSet) noexcept;
     IFACEMETHODIMP_(bool)
+    PrepareWindowMove(HWND window, HWND windowZone, const std::vector<int>& indexSet, RECT& rect) noexcept;
+    IFACEMETHODIMP_(bool)
     MoveWindowIntoZoneByDirection(HWND window, HWND zoneWindow, DWORD vkCode, bool cycle) noexcept;
     IFACEMETHODIMP_(void)
     MoveWindowIntoZoneByPoint(HWND window, HWND zoneWindow, POINT ptClient) noexcept;
@@ -154,10 +158,13 @@ private:
     bool CalculateCustomLayout(Rect workArea, int spacing) noexcept;
     bool CalculateGridZones(Rect workArea, FancyZonesDataTypes::GridLayoutInfo gridLayoutInfo, int spacing);
     void StampWindow(HWND window, size_t bitmask) noexcept;
+    void UpdateZoneIndex() noexcept;
 
     std::vector<winrt::com_ptr<IZone>> m_zones;
     std::map<HWND, std::vector<int>> m_windowIndexSet;
     ZoneSetConfig m_config;
+    ZoneSpatialIndex m_zoneIndex;
+    bool m_zoneIndexValid{ false };
 };
 
 IFACEMETHODIMP ZoneSet::AddZone(winrt::com_ptr<IZone> zone) noexcept
@@ -167,82 +174,19 @@ IFACEMETHODIMP ZoneSet::AddZone(winrt::com_ptr<IZone> zone) noexcept
     // Important not to set Id 0 since we store it in the HWND using SetProp.
     // SetProp(0) doesn't really work.
     zone->SetId(m_zones.size());
+    m_zoneIndexValid = false;
     return S_OK;
 }
 
 IFACEMETHODIMP_(std::vector<int>)
 ZoneSet::ZonesFromPoint(POINT pt) noexcept
 {
-    const int SENSITIVITY_RADIUS = 20;
-    std::vector<int> capturedZones;
-    std::vector<int> strictlyCapturedZones;
-    for (size_t i = 0; i < m_zones.size(); i++)
-    {
-        auto zone = m_zones[i];
-        RECT newZoneRect = zone->GetZoneRect();
-        if (newZoneRect.left < newZoneRect.right && newZoneRect.top < newZoneRect.bottom) // proper zone
-        {
-            if (newZoneRect.left - SENSITIVITY_RADIUS <= pt.x && pt.x <= newZoneRect.right + SENSITIVITY_RADIUS &&
-                newZoneRect.top - SENSITIVITY_RADIUS <= pt.y && pt.y <= newZoneRect.bottom + SENSITIVITY_RADIUS)
-            {
-                capturedZones.emplace_back(static_cast<int>(i));
-            }
-            
-            if (newZoneRect.left <= pt.x && pt.x < newZoneRect.right &&
-                newZoneRect.top <= pt.y && pt.y < newZoneRect.bottom)
-            {
-                strictlyCapturedZones.emplace_back(static_cast<int>(i));
-            }
-        }
-    }
-
-    // If only one zone is captured, but it's not strictly captured
-    // don't consider it as captured
-    if (capturedZones.size() == 1 && strictlyCapturedZones.size() == 0)
+    if (!m_zoneIndexValid)
     {
-        return {};
+        UpdateZoneIndex();
     }
 
-    // If captured zones do not overlap, return all of them
-    // Otherwise, return the smallest one
-
-    bool overlap = false;
-    for (size_t i = 0; i < capturedZones.size(); ++i)
-    {
-        for (size_t j = i + 1; j < capturedZones.size(); ++j)
-        {
-            auto rectI = m_zones[capturedZones[i]]->GetZoneRect();
-            auto rectJ = m_zones[capturedZones[j]]->GetZoneRect();
-            if (max(rectI.top, rectJ.top) + SENSITIVITY_RADIUS < min(rectI.bottom, rectJ.bottom) &&
-                max(rectI.left, rectJ.left) + SENSITIVITY_RADIUS < min(rectI.right, rectJ.right))
-            {
-                overlap = true;
-                i = capturedZones.size() - 1;
-                break;
-            }
-        }
-    }
-
-    if (overlap)
-    {
-        size_t smallestIdx = 0;
-        for (size_t i = 1; i < capturedZones.size(); ++i)
-        {
-            auto rectS = m_zones[capturedZones[smallestIdx]]->GetZoneRect();
-            auto rectI = m_zones[capturedZones[i]]->GetZoneRect();
-            int smallestSize = (rectS.bottom - rectS.top) * (rectS.right - rectS.left);
-            int iSize = (rectI.bottom - rectI.top) * (rectI.right - rectI.left);
-
-            if (iSize <= smallestSize)
-            {
-                smallestIdx = i;
-            }
-        }
-
-        capturedZones = { capturedZones[smallestIdx] };
-    }
-
-    return capturedZones;
+    return m_zoneIndex.ZonesFromPoint(pt);
 }
 
 std::vector<int> ZoneSet::GetZoneIndexSetFromWindow(HWND window) noexcept
@@ -266,10 +210,20 @@ ZoneSet::MoveWindowIntoZoneByIndex(HWND window, HWND windowZone, int index) noex
 
 IFACEMETHODIMP_(void)
 ZoneSet::MoveWindowIntoZoneByIndexSet(HWND window, HWND windowZone, const std::vector<int>& indexSet) noexcept
+{
+    RECT size;
+    if (PrepareWindowMove(window, windowZone, indexSet, size))
+    {
+        SizeWindowToRect(window, size);
+    }
+}
+
+IFACEMETHODIMP_(bool)
+ZoneSet::PrepareWindowMove(HWND window, HWND windowZone, const std::vector<int>& indexSet, RECT& rect) noexcept
 {
     if (m_zones.empty())
     {
-        return;
+        return false;
     }
 
     RECT size;
@@ -306,12 +260,15 @@ ZoneSet::MoveWindowIntoZoneByIndexSet(HWND window, HWND windowZone, const std::v
         }
     }
 
-    if (!sizeEmpty)
+    if (sizeEmpty)
     {
-        SaveWindowSizeAndOrigin(window);
-        SizeWindowToRect(window, size);
-        StampWindow(window, bitmask);
+        return false;
     }
+
+    SaveWindowSizeAndOrigin(window);
+    StampWindow(window, bitmask);
+    rect = size;
+    return true;
 }
 
 IFACEMETHODIMP_(bool)
@@ -384,6 +341,26 @@ ZoneSet::CalculateZones(MONITORINFO monitorInfo, int zoneCount, int spacing) noe
         return false;
     }
 
+    // Zone sets are calculated once after they're created, so the cached rects are only used for an empty set
+    const bool useGeometryCache = m_zones.empty();
+    auto& geometryCache = ZoneGeometryCacheInstance();
+    const auto cacheKey = ZoneGeometryCache::MakeKey(m_config.Id, m_config.LayoutType, m_config.Monitor, zoneCount, workArea.width(), workArea.height(), spacing);
+    if (useGeometryCache)
+    {
+        if (auto zoneRects = geometryCache.Find(cacheKey))
+        {
+            for (const auto& zoneRect : *zoneRects)
+            {
+                AddZone(MakeZone(zoneRect));
+            }
+
+            UpdateZoneIndex();
+            return true;
+        }
+    }
+
+    const auto customLayoutsGeneration = geometryCache.CustomLayoutsGeneration();
+
     bool success = true;
     switch (m_config.LayoutType)
     {
@@ -403,6 +380,19 @@ ZoneSet::CalculateZones(MONITORINFO monitorInfo, int zoneCount, int spacing) noe
         break;
     }
 
+    if (useGeometryCache && success)
+    {
+        std::vector<RECT> zoneRects;
+        zoneRects.reserve(m_zones.size());
+        for (const auto& zone : m_zones)
+        {
+            zoneRects.emplace_back(zone->GetZoneRect());
+        }
+
+        geometryCache.Insert(cacheKey, std::move(zoneRects), customLayoutsGeneration);
+    }
+
+    UpdateZoneIndex();
     return success;
 }
 
@@ -702,6 +692,20 @@ void ZoneSet::StampWindow(HWND window, size_t bitmask) noexcept
     SetProp(window, MULTI_ZONE_STAMP, reinterpret_cast<HANDLE>(bitmask));
 }
 
+void ZoneSet::UpdateZoneIndex() noexcept
+{
+    // Zone rects are immutable, so the index only needs to be rebuilt when the set of zones changes
+    std::vector<RECT> zoneRects;
+    zoneRects.reserve(m_zones.size());
+    for (const auto& zone : m_zones)
+    {
+        zoneRects.emplace_back(zone->GetZoneRect());
+    }
+
+    m_zoneIndex.Build(zoneRects);
+    m_zoneIndexValid = true;
+}
+
 winrt::com_ptr<IZoneSet> MakeZoneSet(ZoneSetConfig const& config) noexcept
 {
     return winrt::make_self<ZoneSet>(config);
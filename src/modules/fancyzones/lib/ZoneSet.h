@@ -63,6 +63,18 @@ interface __declspec(uuid("{E4839EB7-669D-49CF-84A9-71A2DFD851A3}")) IZoneSet :
      * @param   indexSet   The set of zone indices within zone layout.
      */
     IFACEMETHOD_(void, MoveWindowIntoZoneByIndexSet)(HWND window, HWND zoneWindow, const std::vector<int>& indexSet) = 0;
+    /**
+     * Assign window to the zones based on the set of zone indices inside zone layout, without moving it.
+     *
+     * @param   window     Handle of window which should be assigned to zone.
+     * @param   zoneWindow The m_window of a ZoneWindow, it's a hidden window representing the
+     *                     current monitor desktop work area.
+     * @param   indexSet   The set of zone indices within zone layout.
+     * @param   rect       Receives the rect the window has to be moved to, in workspace coordinates
+     *                     like the normal position of the window placement.
+     * @returns True if the window was assigned and has to be moved to rect.
+     */
+    IFACEMETHOD_(bool, PrepareWindowMove)(HWND window, HWND zoneWindow, const std::vector<int>& indexSet, RECT& rect) = 0;
     /**
      * Assign window to the zone based on direction (using WIN + LEFT/RIGHT arrow).
      *
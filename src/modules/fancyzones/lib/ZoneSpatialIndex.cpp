@@ -0,0 +1,198 @@
+#include "pch.h"
+
+#include "ZoneSpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int MAX_GRID_DIMENSION = 32;
+
+    bool IsProperZone(const RECT& rect) noexcept
+    {
+        return rect.left < rect.right && rect.top < rect.bottom;
+    }
+}
+
+void ZoneSpatialIndex::Build(const std::vector<RECT>& zoneRects)
+{
+    Clear();
+
+    m_rects = zoneRects;
+    const size_t count = m_rects.size();
+
+    m_areas.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& rect = m_rects[i];
+        m_areas[i] = (rect.bottom - rect.top) * (rect.right - rect.left);
+    }
+
+    // Precompute which pairs of zones are considered to be overlapping
+    m_overlapWords = (count + 63) / 64;
+    m_overlaps.assign(count * m_overlapWords, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t j = i + 1; j < count; ++j)
+        {
+            const auto& rectI = m_rects[i];
+            const auto& rectJ = m_rects[j];
+            if (max(rectI.top, rectJ.top) + SENSITIVITY_RADIUS < min(rectI.bottom, rectJ.bottom) &&
+                max(rectI.left, rectJ.left) + SENSITIVITY_RADIUS < min(rectI.right, rectJ.right))
+            {
+                m_overlaps[i * m_overlapWords + j / 64] |= 1ull << (j % 64);
+                m_overlaps[j * m_overlapWords + i / 64] |= 1ull << (i % 64);
+            }
+        }
+    }
+
+    // Bounds of all proper zones, extended by the sensitivity radius (inclusive)
+    int properCount = 0;
+    for (const auto& rect : m_rects)
+    {
+        if (!IsProperZone(rect))
+        {
+            continue;
+        }
+
+        if (properCount == 0)
+        {
+            m_bounds = RECT{ rect.left - SENSITIVITY_RADIUS, rect.top - SENSITIVITY_RADIUS, rect.right + SENSITIVITY_RADIUS, rect.bottom + SENSITIVITY_RADIUS };
+        }
+        else
+        {
+            m_bounds.left = min(m_bounds.left, rect.left - SENSITIVITY_RADIUS);
+            m_bounds.top = min(m_bounds.top, rect.top - SENSITIVITY_RADIUS);
+            m_bounds.right = max(m_bounds.right, rect.right + SENSITIVITY_RADIUS);
+            m_bounds.bottom = max(m_bounds.bottom, rect.bottom + SENSITIVITY_RADIUS);
+        }
+        properCount++;
+    }
+
+    if (properCount == 0)
+    {
+        return;
+    }
+
+    const int dimension = std::clamp(static_cast<int>(std::ceil(std::sqrt(properCount))), 1, MAX_GRID_DIMENSION);
+    const LONG spanX = m_bounds.right - m_bounds.left + 1;
+    const LONG spanY = m_bounds.bottom - m_bounds.top + 1;
+    m_columns = static_cast<int>(min(static_cast<LONG>(dimension), spanX));
+    m_rows = static_cast<int>(min(static_cast<LONG>(dimension), spanY));
+    m_cellWidth = (spanX + m_columns - 1) / m_columns;
+    m_cellHeight = (spanY + m_rows - 1) / m_rows;
+    m_cells.resize(static_cast<size_t>(m_columns) * m_rows);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& rect = m_rects[i];
+        if (!IsProperZone(rect))
+        {
+            continue;
+        }
+
+        const int firstColumn = (rect.left - SENSITIVITY_RADIUS - m_bounds.left) / m_cellWidth;
+        const int lastColumn = (rect.right + SENSITIVITY_RADIUS - m_bounds.left) / m_cellWidth;
+        const int firstRow = (rect.top - SENSITIVITY_RADIUS - m_bounds.top) / m_cellHeight;
+        const int lastRow = (rect.bottom + SENSITIVITY_RADIUS - m_bounds.top) / m_cellHeight;
+
+        for (int row = firstRow; row <= lastRow; ++row)
+        {
+            for (int column = firstColumn; column <= lastColumn; ++column)
+            {
+                // Zones are visited in ascending order, so every cell stays sorted
+                m_cells[static_cast<size_t>(row) * m_columns + column].push_back(static_cast<int>(i));
+            }
+        }
+    }
+}
+
+void ZoneSpatialIndex::Clear() noexcept
+{
+    m_rects.clear();
+    m_areas.clear();
+    m_overlaps.clear();
+    m_overlapWords = 0;
+    m_bounds = {};
+    m_cellWidth = 1;
+    m_cellHeight = 1;
+    m_columns = 0;
+    m_rows = 0;
+    m_cells.clear();
+}
+
+std::vector<int> ZoneSpatialIndex::ZonesFromPoint(POINT pt) const
+{
+    if (m_cells.empty() ||
+        pt.x < m_bounds.left || pt.x > m_bounds.right ||
+        pt.y < m_bounds.top || pt.y > m_bounds.bottom)
+    {
+        return {};
+    }
+
+    const int column = (pt.x - m_bounds.left) / m_cellWidth;
+    const int row = (pt.y - m_bounds.top) / m_cellHeight;
+    const auto& candidates = m_cells[static_cast<size_t>(row) * m_columns + column];
+
+    std::vector<int> capturedZones;
+    bool strictlyCaptured = false;
+    for (int i : candidates)
+    {
+        const auto& rect = m_rects[i];
+        if (rect.left - SENSITIVITY_RADIUS <= pt.x && pt.x <= rect.right + SENSITIVITY_RADIUS &&
+            rect.top - SENSITIVITY_RADIUS <= pt.y && pt.y <= rect.bottom + SENSITIVITY_RADIUS)
+        {
+            capturedZones.emplace_back(i);
+        }
+
+        if (rect.left <= pt.x && pt.x < rect.right &&
+            rect.top <= pt.y && pt.y < rect.bottom)
+        {
+            strictlyCaptured = true;
+        }
+    }
+
+    // If only one zone is captured, but it's not strictly captured
+    // don't consider it as captured
+    if (capturedZones.size() == 1 && !strictlyCaptured)
+    {
+        return {};
+    }
+
+    // If captured zones do not overlap, return all of them
+    // Otherwise, return the smallest one
+    bool overlap = false;
+    for (size_t i = 0; i < capturedZones.size() && !overlap; ++i)
+    {
+        for (size_t j = i + 1; j < capturedZones.size(); ++j)
+        {
+            if (Overlap(capturedZones[i], capturedZones[j]))
+            {
+                overlap = true;
+                break;
+            }
+        }
+    }
+
+    if (overlap)
+    {
+        size_t smallestIdx = 0;
+        for (size_t i = 1; i < capturedZones.size(); ++i)
+        {
+            if (m_areas[capturedZones[i]] <= m_areas[capturedZones[smallestIdx]])
+            {
+                smallestIdx = i;
+            }
+        }
+
+        capturedZones = { capturedZones[smallestIdx] };
+    }
+
+    return capturedZones;
+}
+
+bool ZoneSpatialIndex::Overlap(size_t first, size_t second) const noexcept
+{
+    return (m_overlaps[first * m_overlapWords + second / 64] >> (second % 64)) & 1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+/**
+ * Spatial index over the zone rectangles of a single zone layout, used for hit-testing the cursor
+ * while a window is being dragged. Zones are bucketed into a uniform grid and the overlap relation
+ * between every pair of zones is precomputed, so a lookup only touches the zones sharing the cell
+ * of the cursor instead of every zone in the layout.
+ */
+class ZoneSpatialIndex
+{
+public:
+    /**
+     * Distance (in pixels) around the zone in which the cursor is still considered to be inside of it.
+     */
+    static constexpr LONG SENSITIVITY_RADIUS = 20;
+
+    /**
+     * Rebuild the index from zone rectangles. Previous content is discarded.
+     *
+     * @param   zoneRects Zone rectangles, position in the vector is the zone index.
+     */
+    void Build(const std::vector<RECT>& zoneRects);
+    /**
+     * Remove all zones from the index.
+     */
+    void Clear() noexcept;
+    /**
+     * Get zones from cursor coordinates.
+     *
+     * @param   pt Cursor coordinates.
+     * @returns Vector of indices of the zones considered active, in ascending order. If captured
+     *          zones overlap, only the smallest one is returned.
+     */
+    std::vector<int> ZonesFromPoint(POINT pt) const;
+    /**
+     * @returns Number of zones in the index.
+     */
+    size_t ZoneCount() const noexcept { return m_rects.size(); }
+
+private:
+    bool Overlap(size_t first, size_t second) const noexcept;
+
+    std::vector<RECT> m_rects;
+    std::vector<int> m_areas;
+    // Bit matrix, m_overlapWords words per zone
+    std::vector<uint64_t> m_overlaps;
+    size_t m_overlapWords{};
+
+    // Uniform grid covering zone rectangles extended by the sensitivity radius
+    RECT m_bounds{};
+    LONG m_cellWidth{ 1 };
+    LONG m_cellHeight{ 1 };
+    int m_columns{};
+    int m_rows{};
+    std::vector<std::vector<int>> m_cells;
+};
@@ -179,6 +179,8 @@ public:
     IFACEMETHODIMP_(void)
     MoveWindowIntoZoneByIndexSet(HWND window, const std::vector<int>& indexSet) noexcept;
     IFACEMETHODIMP_(bool)
+    PrepareWindowMove(HWND window, const std::vector<int>& indexSet, RECT& rect) noexcept;
+    IFACEMETHODIMP_(bool)
     MoveWindowIntoZoneByDirection(HWND window, DWORD vkCode, bool cycle) noexcept;
     IFACEMETHODIMP_(void)
     CycleActiveZoneSet(DWORD vkCode) noexcept;
@@ -421,6 +423,12 @@ ZoneWindow::MoveWindowIntoZoneByIndexSet(HWND window, const std::vector<int>& in
     }
 }
 
+IFACEMETHODIMP_(bool)
+ZoneWindow::PrepareWindowMove(HWND window, const std::vector<int>& indexSet, RECT& rect) noexcept
+{
+    return m_activeZoneSet && m_activeZoneSet->PrepareWindowMove(window, m_window.get(), indexSet, rect);
+}
+
 IFACEMETHODIMP_(bool)
 ZoneWindow::MoveWindowIntoZoneByDirection(HWND window, DWORD vkCode, bool cycle) noexcept
 {
@@ -56,6 +56,15 @@ interface __declspec(uuid("{7F017528-8110-4FB3-BE41-F472969C2560}")) IZoneWindow
      * @param   indexSet The set of zone indices within zone layout.
      */
     IFACEMETHOD_(void, MoveWindowIntoZoneByIndexSet)(HWND window, const std::vector<int>& indexSet) = 0;
+    /**
+     * Assign window to the zones based on the set of zone indices inside zone layout, without moving it.
+     *
+     * @param   window   Handle of window which should be assigned to zone.
+     * @param   indexSet The set of zone indices within zone layout.
+     * @param   rect     Receives the rect the window has to be moved to, in workspace coordinates.
+     * @returns True if the window was assigned and has to be moved to rect.
+     */
+    IFACEMETHOD_(bool, PrepareWindowMove)(HWND window, const std::vector<int>& indexSet, RECT& rect) = 0;
     /**
      * Assign window to the zone based on direction (using WIN + LEFT/RIGHT arrow).
      *
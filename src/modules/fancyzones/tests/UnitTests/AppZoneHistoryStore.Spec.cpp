@@ -0,0 +1,107 @@
+#include "pch.h"
+#include <lib/AppZoneHistoryStore.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FancyZonesDataTypes;
+
+namespace FancyZonesUnitTests
+{
+    TEST_CLASS (AppZoneHistoryStoreUnitTests)
+    {
+    private:
+        const std::wstring m_appPath = L"C:\\Program Files\\App\\app.exe";
+        const std::wstring m_otherAppPath = L"C:\\Program Files\\Other\\other.exe";
+        const std::wstring m_deviceId = L"AOC2460#4&fe3a015&0&UID65793_1920_1200_{39B25DD2-130D-4B5D-8851-4791D66B1539}";
+        const std::wstring m_otherDeviceId = L"AOC2460#4&fe3a015&0&UID65793_1920_1200_{00000000-0000-0000-0000-000000000000}";
+        const std::wstring m_zoneSetId = L"{33A2B101-06E0-437B-A61E-CDBECF502906}";
+        const std::wstring m_otherZoneSetId = L"{8A0CF37B-5A0F-4E6A-88EC-2D6F18F4A2E8}";
+
+        static AppZoneHistoryData CreateData(const std::wstring& deviceId, const std::wstring& zoneSetId, int zoneIndex)
+        {
+            AppZoneHistoryData data;
+            data.zoneSetUuid = zoneSetId;
+            data.deviceId = deviceId;
+            data.zoneIndexSet = { zoneIndex };
+            return data;
+        }
+
+    public:
+        TEST_METHOD (FindByDeviceAndZoneSet)
+        {
+            AppZoneHistoryStore store;
+            store.Add(m_appPath, CreateData(m_deviceId, m_zoneSetId, 1));
+            store.Add(m_appPath, CreateData(m_otherDeviceId, m_otherZoneSetId, 2));
+            store.Add(m_otherAppPath, CreateData(m_deviceId, m_otherZoneSetId, 3));
+
+            Assert::IsTrue(std::vector<int>{ 1 } == store.Find(m_appPath, m_deviceId)->zoneIndexSet);
+            Assert::IsTrue(std::vector<int>{ 2 } == store.Find(m_appPath, m_otherDeviceId, m_otherZoneSetId)->zoneIndexSet);
+            Assert::IsTrue(std::vector<int>{ 3 } == store.Find(m_otherAppPath, m_deviceId, m_otherZoneSetId)->zoneIndexSet);
+            Assert::IsNull(store.Find(m_appPath, m_deviceId, m_otherZoneSetId));
+            Assert::IsNull(store.Find(m_otherAppPath, m_otherDeviceId));
+            Assert::IsNull(store.Find(L"unknown.exe", m_deviceId));
+            Assert::AreEqual((size_t)2, store.Map().size());
+        }
+
+        TEST_METHOD (FindFirstEntry)
+        {
+            JSONHelpers::TAppZoneHistoryMap map;
+            map[m_appPath] = { CreateData(m_deviceId, m_zoneSetId, 1), CreateData(m_deviceId, m_otherZoneSetId, 2) };
+
+            AppZoneHistoryStore store;
+            store.Assign(std::move(map));
+
+            Assert::IsTrue(std::vector<int>{ 1 } == store.Find(m_appPath, m_deviceId)->zoneIndexSet);
+            Assert::IsTrue(std::vector<int>{ 2 } == store.Find(m_appPath, m_deviceId, m_otherZoneSetId)->zoneIndexSet);
+        }
+
+        TEST_METHOD (RemoveUpdatesIndex)
+        {
+            AppZoneHistoryStore store;
+            store.Add(m_appPath, CreateData(m_deviceId, m_zoneSetId, 1));
+            store.Add(m_appPath, CreateData(m_otherDeviceId, m_zoneSetId, 2));
+
+            store.Remove(m_appPath, store.Find(m_appPath, m_deviceId));
+            Assert::IsNull(store.Find(m_appPath, m_deviceId));
+            Assert::IsTrue(std::vector<int>{ 2 } == store.Find(m_appPath, m_otherDeviceId, m_zoneSetId)->zoneIndexSet);
+
+            store.Remove(m_appPath, store.Find(m_appPath, m_otherDeviceId));
+            Assert::IsNull(store.Find(m_appPath, m_otherDeviceId));
+            Assert::IsTrue(store.Map().empty());
+
+            store.Add(m_appPath, CreateData(m_deviceId, m_zoneSetId, 3));
+            Assert::IsTrue(std::vector<int>{ 3 } == store.Find(m_appPath, m_deviceId, m_zoneSetId)->zoneIndexSet);
+        }
+
+        TEST_METHOD (SetZonesUpdatesIndex)
+        {
+            AppZoneHistoryStore store;
+            store.Add(m_appPath, CreateData(m_deviceId, m_zoneSetId, 1));
+
+            store.SetZones(m_appPath, store.Find(m_appPath, m_deviceId), m_otherZoneSetId, { 2 });
+            Assert::IsNull(store.Find(m_appPath, m_deviceId, m_zoneSetId));
+            Assert::IsTrue(std::vector<int>{ 2 } == store.Find(m_appPath, m_deviceId, m_otherZoneSetId)->zoneIndexSet);
+        }
+
+        TEST_METHOD (UpdateModifiesAndRemovesEntries)
+        {
+            AppZoneHistoryStore store;
+            store.Add(m_appPath, CreateData(m_deviceId, m_zoneSetId, 1));
+            store.Add(m_appPath, CreateData(m_otherDeviceId, m_zoneSetId, 2));
+            store.Add(m_otherAppPath, CreateData(m_otherDeviceId, m_zoneSetId, 3));
+
+            store.Update([this](AppZoneHistoryData& data) {
+                if (data.deviceId == m_deviceId)
+                {
+                    data.deviceId = L"new-device-id";
+                    return false;
+                }
+                return true;
+            });
+
+            Assert::AreEqual((size_t)1, store.Map().size());
+            Assert::IsTrue(std::vector<int>{ 1 } == store.Find(m_appPath, L"new-device-id", m_zoneSetId)->zoneIndexSet);
+            Assert::IsNull(store.Find(m_appPath, m_deviceId));
+            Assert::IsNull(store.Find(m_otherAppPath, m_otherDeviceId));
+        }
+    };
+}
@@ -1768,6 +1768,60 @@ namespace FancyZonesUnitTests
                 Assert::AreEqual({ expectedZoneIndex }, data.GetAppLastZoneIndexSet(window, deviceId, zoneSetId));
             }
 
+            TEST_METHOD (AppLastZonesSavedInBackground)
+            {
+                const std::wstring zoneSetId = L"zoneset-uuid";
+                const std::wstring deviceId = L"device-id";
+                const auto window = Mocks::WindowCreate(m_hInst);
+                FancyZonesData data;
+                data.SetSettingsModulePath(m_moduleName);
+                const auto appZoneHistoryLogPath = PTSettingsHelper::get_module_save_folder_location(m_moduleName) + L"\\app-zone-history.log";
+
+                for (int i = 0; i < 100; i++)
+                {
+                    Assert::IsTrue(data.SetAppLastZones(window, deviceId, zoneSetId, { i }));
+                }
+                Assert::IsFalse(std::filesystem::exists(appZoneHistoryLogPath));
+
+                data.FlushFancyZonesData();
+                Assert::IsTrue(std::filesystem::exists(appZoneHistoryLogPath));
+                Assert::IsFalse(std::filesystem::exists(data.zonesSettingsFileName));
+                Assert::IsFalse(std::filesystem::exists(data.appZoneHistoryFileName));
+
+                FancyZonesData loaded;
+                loaded.SetSettingsModulePath(m_moduleName);
+                Assert::IsTrue(loaded.LoadAppZoneHistoryLog());
+                Assert::AreEqual({ 99 }, loaded.GetAppZoneHistoryMap().begin()->second[0].zoneIndexSet);
+            }
+
+            TEST_METHOD (AppZoneHistoryMigratedToLog)
+            {
+                FancyZonesData data;
+                data.SetSettingsModulePath(m_moduleName);
+
+                AppZoneHistoryData expected{ .zoneSetUuid = L"{33A2B101-06E0-437B-A61E-CDBECF502906}", .deviceId = m_defaultDeviceId, .zoneIndexSet = { 1, 2 } };
+                JSONHelpers::TAppZoneHistoryMap appZoneHistoryMap{ { L"app-path", { expected } } };
+                json::JsonObject zonesSettings;
+                zonesSettings.SetNamedValue(L"devices", json::JsonArray{});
+                zonesSettings.SetNamedValue(L"custom-zone-sets", json::JsonArray{});
+                json::to_file(data.zonesSettingsFileName, zonesSettings);
+                json::to_file(data.appZoneHistoryFileName, JSONHelpers::SerializeAppZoneHistoryFile(appZoneHistoryMap));
+
+                data.LoadFancyZonesData();
+                Assert::AreEqual((size_t)1, data.GetAppZoneHistoryMap().size());
+                data.FlushFancyZonesData();
+
+                FancyZonesData loaded;
+                loaded.SetSettingsModulePath(m_moduleName);
+                Assert::IsTrue(loaded.LoadAppZoneHistoryLog());
+
+                const auto& actual = loaded.GetAppZoneHistoryMap().at(L"app-path");
+                Assert::AreEqual((size_t)1, actual.size());
+                Assert::AreEqual(expected.zoneSetUuid.c_str(), actual[0].zoneSetUuid.c_str());
+                Assert::AreEqual(expected.deviceId.c_str(), actual[0].deviceId.c_str());
+                Assert::AreEqual(expected.zoneIndexSet, actual[0].zoneIndexSet);
+            }
+
             TEST_METHOD (AppLastZoneIndexZero)
             {
                 const std::wstring zoneSetId = L"zoneset-uuid";
@@ -0,0 +1,154 @@
+#include "pch.h"
+#include <lib/PersistenceService.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    TEST_CLASS (PersistenceServiceUnitTests)
+    {
+    private:
+        std::atomic<int> m_firstFileWrites{};
+        std::atomic<int> m_secondFileWrites{};
+
+        std::vector<PersistenceService::WriteFunction> CountingWriters()
+        {
+            return { [this] { m_firstFileWrites++; return true; }, [this] { m_secondFileWrites++; return true; } };
+        }
+
+        TEST_METHOD_INITIALIZE(Init)
+        {
+            m_firstFileWrites = 0;
+            m_secondFileWrites = 0;
+        }
+
+    public:
+        TEST_METHOD (BurstOfChangesIsWrittenOnce)
+        {
+            PersistenceService persistence(std::chrono::milliseconds(50), std::chrono::seconds(10), CountingWriters());
+            for (int i = 0; i < 100; i++)
+            {
+                persistence.MarkDirty(0);
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            Assert::AreEqual(1, m_firstFileWrites.load());
+            Assert::AreEqual(0, m_secondFileWrites.load());
+        }
+
+        TEST_METHOD (ChangesAreNotWrittenBeforeDebounce)
+        {
+            PersistenceService persistence(std::chrono::seconds(10), std::chrono::seconds(10), CountingWriters());
+            persistence.MarkDirty(1);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            Assert::AreEqual(0, m_secondFileWrites.load());
+
+            persistence.Flush();
+            Assert::AreEqual(1, m_secondFileWrites.load());
+
+            // Nothing is left to write when the service stops
+            persistence.Stop();
+            Assert::AreEqual(1, m_secondFileWrites.load());
+            Assert::AreEqual(0, m_firstFileWrites.load());
+        }
+
+        TEST_METHOD (FlushWaitsForTheWriteInProgress)
+        {
+            std::atomic<bool> writing{};
+            std::atomic<bool> written{};
+            PersistenceService persistence(std::chrono::milliseconds(10), std::chrono::seconds(10), { [&] {
+                                               writing = true;
+                                               std::this_thread::sleep_for(std::chrono::milliseconds(300));
+                                               written = true;
+                                               return true;
+                                           } });
+            persistence.MarkDirty(0);
+            while (!writing)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            // The file isn't dirty anymore, but it must be written once the flush returns
+            persistence.Flush();
+            Assert::IsTrue(written.load());
+        }
+
+        TEST_METHOD (FailedWriteIsRetried)
+        {
+            std::atomic<int> attempts{};
+            PersistenceService persistence(std::chrono::milliseconds(50), std::chrono::seconds(10), { [&] {
+                                               // Fails like a sharing violation the first time
+                                               return ++attempts > 1;
+                                           } });
+            persistence.MarkDirty(0);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            Assert::AreEqual(2, attempts.load());
+        }
+
+        TEST_METHOD (FailedFlushIsRetried)
+        {
+            std::atomic<int> attempts{};
+            PersistenceService persistence(std::chrono::seconds(10), std::chrono::seconds(10), { [&] {
+                                               return ++attempts > 1;
+                                           } });
+            persistence.MarkDirty(0);
+            persistence.Flush();
+            Assert::AreEqual(1, attempts.load());
+
+            // The file is dirty again, so it is written by the next flush without any change
+            persistence.Flush();
+            Assert::AreEqual(2, attempts.load());
+            persistence.Flush();
+            Assert::AreEqual(2, attempts.load());
+        }
+
+        TEST_METHOD (ContinuousChangesAreWrittenAfterMaxDelay)
+        {
+            PersistenceService persistence(std::chrono::milliseconds(100), std::chrono::milliseconds(300), CountingWriters());
+            const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(1000);
+            while (std::chrono::steady_clock::now() < end)
+            {
+                persistence.MarkDirty(0);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            Assert::IsTrue(m_firstFileWrites.load() >= 2);
+        }
+
+        TEST_METHOD (PendingChangesAreWrittenOnDestruction)
+        {
+            {
+                PersistenceService persistence(std::chrono::seconds(10), std::chrono::seconds(10), CountingWriters());
+                persistence.MarkDirty(0);
+                persistence.MarkDirty(1);
+            }
+
+            Assert::AreEqual(1, m_firstFileWrites.load());
+            Assert::AreEqual(1, m_secondFileWrites.load());
+        }
+
+        TEST_METHOD (WriteFileAtomicallyReplacesFile)
+        {
+            wchar_t tempFolder[MAX_PATH];
+            GetTempPath(MAX_PATH, tempFolder);
+            const std::wstring fileName = std::wstring(tempFolder) + L"PersistenceServiceUnitTests.json";
+
+            Assert::IsTrue(PersistenceService::WriteFileAtomically(fileName, "{ \"first\": 1 }"));
+            Assert::IsTrue(PersistenceService::WriteFileAtomically(fileName, "{}"));
+
+            std::ifstream file(fileName, std::ios::binary);
+            std::string content{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+            file.close();
+            Assert::AreEqual(std::string("{}"), content);
+            Assert::IsFalse(std::filesystem::exists(fileName + L".tmp"));
+
+            std::filesystem::remove(fileName);
+        }
+    };
+}
@@ -0,0 +1,137 @@
+#include "pch.h"
+#include <lib/RecordLog.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    TEST_CLASS (RecordLogUnitTests)
+    {
+    private:
+        std::wstring m_fileName;
+
+        static json::JsonObject CreateValue(int number)
+        {
+            json::JsonObject value;
+            value.SetNamedValue(L"number", json::value(number));
+            return value;
+        }
+
+        // Reads the live records of the log, mapped to the number of their value
+        static std::map<std::wstring, int> ReadLive(RecordLog& log)
+        {
+            std::map<std::wstring, int> live;
+            Assert::IsTrue(log.Read([&live](const std::wstring& key, const json::JsonObject* value) {
+                if (value)
+                {
+                    live[key] = static_cast<int>(value->GetNamedNumber(L"number"));
+                }
+                else
+                {
+                    live.erase(key);
+                }
+            }));
+            return live;
+        }
+
+        TEST_METHOD_INITIALIZE(Init)
+        {
+            wchar_t tempFolder[MAX_PATH];
+            GetTempPath(MAX_PATH, tempFolder);
+            m_fileName = std::wstring(tempFolder) + L"RecordLogUnitTests.log";
+            std::filesystem::remove(m_fileName);
+        }
+
+        TEST_METHOD_CLEANUP(Cleanup)
+        {
+            std::filesystem::remove(m_fileName);
+        }
+
+    public:
+        TEST_METHOD (ReadMissingLog)
+        {
+            RecordLog log{ m_fileName };
+            Assert::IsFalse(log.Read([](const std::wstring&, const json::JsonObject*) {
+                Assert::Fail();
+            }));
+        }
+
+        TEST_METHOD (LaterRecordsReplaceEarlierOnes)
+        {
+            RecordLog log{ m_fileName };
+
+            RecordLog::Batch first;
+            first.Set(L"a", CreateValue(1));
+            first.Set(L"b", CreateValue(2));
+            first.Set(L"c\nd", CreateValue(3));
+            Assert::IsTrue(log.Append(first));
+
+            RecordLog::Batch second;
+            second.Set(L"a", CreateValue(4));
+            second.Remove(L"b");
+            Assert::IsTrue(log.Append(second));
+
+            RecordLog reader{ m_fileName };
+            const auto live = ReadLive(reader);
+            Assert::AreEqual((size_t)2, live.size());
+            Assert::AreEqual(4, live.at(L"a"));
+            Assert::AreEqual(3, live.at(L"c\nd"));
+        }
+
+        TEST_METHOD (CompactReplacesLog)
+        {
+            RecordLog log{ m_fileName };
+            RecordLog::Batch records;
+            for (int i = 0; i < 100; i++)
+            {
+                records.Set(L"a", CreateValue(i));
+            }
+            Assert::IsTrue(log.Append(records));
+            Assert::IsTrue(log.NeedsCompaction(1, 1));
+
+            RecordLog::Batch live;
+            live.Set(L"a", CreateValue(99));
+            Assert::IsTrue(log.Compact(live));
+            Assert::IsFalse(log.NeedsCompaction(1, 1));
+
+            RecordLog reader{ m_fileName };
+            Assert::AreEqual(99, ReadLive(reader).at(L"a"));
+            Assert::IsFalse(reader.NeedsCompaction(1, 1));
+        }
+
+        TEST_METHOD (InterruptedAppendIsSkipped)
+        {
+            RecordLog log{ m_fileName };
+            RecordLog::Batch records;
+            records.Set(L"a", CreateValue(1));
+            Assert::IsTrue(log.Append(records));
+            std::ofstream{ m_fileName, std::ios::binary | std::ios::app } << "{\"key\":\"b\",\"val";
+
+            RecordLog reader{ m_fileName };
+            const auto live = ReadLive(reader);
+            Assert::AreEqual((size_t)1, live.size());
+            Assert::AreEqual(1, live.at(L"a"));
+            Assert::IsTrue(reader.NeedsCompaction(1, 1));
+        }
+
+        TEST_METHOD (RecordWithNonObjectValueIsSkipped)
+        {
+            RecordLog log{ m_fileName };
+            RecordLog::Batch records;
+            records.Set(L"a", CreateValue(1));
+            Assert::IsTrue(log.Append(records));
+            std::ofstream{ m_fileName, std::ios::binary | std::ios::app } << "{\"key\":\"a\",\"value\":1}\n";
+
+            // The record neither replaces nor removes the value
+            RecordLog reader{ m_fileName };
+            const auto live = ReadLive(reader);
+            Assert::AreEqual((size_t)1, live.size());
+            Assert::AreEqual(1, live.at(L"a"));
+            Assert::IsTrue(reader.NeedsCompaction(1, 1));
+        }
+    };
+}
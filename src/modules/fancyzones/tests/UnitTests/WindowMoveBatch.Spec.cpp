@@ -0,0 +1,130 @@
+#include "pch.h"
+#include <lib/WindowMoveBatch.h>
+
+#include <unordered_set>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    // Records the moves instead of moving windows, the windows are never dereferenced
+    class MockWindowPositioner : public IWindowPositioner
+    {
+    public:
+        std::unordered_set<HWND> placementOnlyWindows;
+        bool deferSucceeds = true;
+
+        std::vector<std::vector<WindowMove>> deferredBatches;
+        std::vector<WindowMove> placementMoves;
+
+        bool CanDeferMove(const WindowMove& move) override
+        {
+            return !placementOnlyWindows.contains(move.window);
+        }
+
+        bool DeferMoves(const std::vector<WindowMove>& moves) override
+        {
+            deferredBatches.push_back(moves);
+            return deferSucceeds;
+        }
+
+        void MoveWithPlacement(const WindowMove& move) override
+        {
+            placementMoves.push_back(move);
+        }
+    };
+
+    TEST_CLASS (WindowMoveBatchUnitTests)
+    {
+    private:
+        static HWND Window(size_t id)
+        {
+            return reinterpret_cast<HWND>(id);
+        }
+
+        static void AssertMove(HWND window, LONG left, const WindowMove& move)
+        {
+            Assert::IsTrue(window == move.window);
+            Assert::AreEqual(left, move.rect.left);
+        }
+
+    public:
+        TEST_METHOD (WindowsAreMovedInOneTransaction)
+        {
+            WindowMoveBatch batch;
+            for (size_t i = 1; i <= 60; i++)
+            {
+                batch.Add(Window(i), RECT{ static_cast<LONG>(i), 0, 100, 100 });
+            }
+
+            MockWindowPositioner positioner;
+            batch.Apply(positioner);
+
+            Assert::AreEqual((size_t)1, positioner.deferredBatches.size());
+            Assert::AreEqual((size_t)60, positioner.deferredBatches[0].size());
+            AssertMove(Window(1), 1, positioner.deferredBatches[0].front());
+            AssertMove(Window(60), 60, positioner.deferredBatches[0].back());
+            Assert::IsTrue(positioner.placementMoves.empty());
+            Assert::AreEqual((size_t)0, batch.Size());
+        }
+
+        TEST_METHOD (LaterMoveOfWindowReplacesEarlierOne)
+        {
+            WindowMoveBatch batch;
+            batch.Add(Window(1), RECT{ 1, 0, 100, 100 });
+            batch.Add(Window(2), RECT{ 2, 0, 100, 100 });
+            batch.Add(Window(1), RECT{ 3, 0, 100, 100 });
+            Assert::AreEqual((size_t)2, batch.Size());
+
+            MockWindowPositioner positioner;
+            batch.Apply(positioner);
+
+            Assert::AreEqual((size_t)2, positioner.deferredBatches[0].size());
+            AssertMove(Window(1), 3, positioner.deferredBatches[0][0]);
+            AssertMove(Window(2), 2, positioner.deferredBatches[0][1]);
+        }
+
+        TEST_METHOD (WindowsWhichCantBeDeferredAreMovedThroughPlacement)
+        {
+            WindowMoveBatch batch;
+            batch.Add(Window(1), RECT{ 1, 0, 100, 100 });
+            batch.Add(Window(2), RECT{ 2, 0, 100, 100 });
+            batch.Add(Window(3), RECT{ 3, 0, 100, 100 });
+
+            MockWindowPositioner positioner;
+            positioner.placementOnlyWindows = { Window(2) };
+            batch.Apply(positioner);
+
+            Assert::AreEqual((size_t)1, positioner.deferredBatches.size());
+            Assert::AreEqual((size_t)2, positioner.deferredBatches[0].size());
+            Assert::AreEqual((size_t)1, positioner.placementMoves.size());
+            AssertMove(Window(2), 2, positioner.placementMoves[0]);
+        }
+
+        TEST_METHOD (FailedTransactionFallsBackToPlacement)
+        {
+            WindowMoveBatch batch;
+            batch.Add(Window(1), RECT{ 1, 0, 100, 100 });
+            batch.Add(Window(2), RECT{ 2, 0, 100, 100 });
+
+            MockWindowPositioner positioner;
+            positioner.deferSucceeds = false;
+            batch.Apply(positioner);
+
+            Assert::AreEqual((size_t)1, positioner.deferredBatches.size());
+            Assert::AreEqual((size_t)2, positioner.placementMoves.size());
+            AssertMove(Window(1), 1, positioner.placementMoves[0]);
+            AssertMove(Window(2), 2, positioner.placementMoves[1]);
+        }
+
+        TEST_METHOD (EmptyBatchMovesNothing)
+        {
+            WindowMoveBatch batch;
+            MockWindowPositioner positioner;
+            batch.Apply(positioner);
+
+            Assert::IsTrue(positioner.deferredBatches.empty());
+            Assert::IsTrue(positioner.placementMoves.empty());
+        }
+    };
+}
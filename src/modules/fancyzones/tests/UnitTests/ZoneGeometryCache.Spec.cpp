@@ -0,0 +1,92 @@
+#include "pch.h"
+#include <lib/ZoneGeometryCache.h>
+
+#include <algorithm>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FancyZonesDataTypes;
+
+namespace FancyZonesUnitTests
+{
+    TEST_CLASS (ZoneGeometryCacheUnitTests)
+    {
+    private:
+        ZoneGeometryCache m_cache;
+        HMONITOR m_monitor{};
+        GUID m_id{};
+
+        static bool AreEqual(const std::vector<RECT>& expected, const std::vector<RECT>& actual)
+        {
+            return expected.size() == actual.size() && std::equal(expected.begin(), expected.end(), actual.begin(), [](const RECT& a, const RECT& b) {
+                       return EqualRect(&a, &b);
+                   });
+        }
+
+        TEST_METHOD_INITIALIZE(Init)
+        {
+            Assert::AreEqual(S_OK, CoCreateGuid(&m_id));
+            m_monitor = MonitorFromPoint(POINT{ 0, 0 }, MONITOR_DEFAULTTOPRIMARY);
+        }
+
+    public:
+        TEST_METHOD (FindMissingLayout)
+        {
+            const auto key = ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Columns, m_monitor, 3, 1920, 1080, 16);
+            Assert::IsFalse(m_cache.Find(key).has_value());
+        }
+
+        TEST_METHOD (FindInsertedLayout)
+        {
+            const std::vector<RECT> zoneRects{ RECT{ 0, 0, 640, 1080 }, RECT{ 640, 0, 1280, 1080 }, RECT{ 1280, 0, 1920, 1080 } };
+            const auto key = ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Columns, m_monitor, 3, 1920, 1080, 0);
+            m_cache.Insert(key, zoneRects, m_cache.CustomLayoutsGeneration());
+
+            const auto cached = m_cache.Find(key);
+            Assert::IsTrue(cached.has_value());
+            Assert::IsTrue(AreEqual(zoneRects, *cached));
+
+            Assert::IsFalse(m_cache.Find(ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Columns, m_monitor, 3, 1920, 1080, 16)).has_value());
+            Assert::IsFalse(m_cache.Find(ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Columns, m_monitor, 3, 1280, 1080, 0)).has_value());
+            Assert::IsFalse(m_cache.Find(ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Rows, m_monitor, 3, 1920, 1080, 0)).has_value());
+        }
+
+        TEST_METHOD (TemplateLayoutsAreSharedBetweenZoneSets)
+        {
+            GUID otherId;
+            Assert::AreEqual(S_OK, CoCreateGuid(&otherId));
+
+            const auto key = ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Grid, m_monitor, 4, 1920, 1080, 16);
+            m_cache.Insert(key, { RECT{ 0, 0, 10, 10 } }, m_cache.CustomLayoutsGeneration());
+
+            Assert::IsTrue(m_cache.Find(ZoneGeometryCache::MakeKey(otherId, ZoneSetLayoutType::Grid, m_monitor, 4, 1920, 1080, 16)).has_value());
+            Assert::IsFalse(m_cache.Find(ZoneGeometryCache::MakeKey(otherId, ZoneSetLayoutType::Custom, m_monitor, 4, 1920, 1080, 16)).has_value());
+        }
+
+        TEST_METHOD (InvalidateCustomLayoutsKeepsTemplateLayouts)
+        {
+            const auto templateKey = ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Focus, m_monitor, 3, 1920, 1080, 0);
+            const auto customKey = ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Custom, m_monitor, 3, 1920, 1080, 0);
+            m_cache.Insert(templateKey, { RECT{ 0, 0, 10, 10 } }, m_cache.CustomLayoutsGeneration());
+            m_cache.Insert(customKey, { RECT{ 0, 0, 20, 20 } }, m_cache.CustomLayoutsGeneration());
+            Assert::AreEqual((size_t)2, m_cache.Size());
+
+            m_cache.InvalidateCustomLayouts();
+
+            Assert::IsTrue(m_cache.Find(templateKey).has_value());
+            Assert::IsFalse(m_cache.Find(customKey).has_value());
+        }
+
+        TEST_METHOD (CustomLayoutCalculatedBeforeInvalidationIsDropped)
+        {
+            const auto key = ZoneGeometryCache::MakeKey(m_id, ZoneSetLayoutType::Custom, m_monitor, 0, 1920, 1080, 0);
+            const auto generation = m_cache.CustomLayoutsGeneration();
+
+            m_cache.InvalidateCustomLayouts();
+            m_cache.Insert(key, { RECT{ 0, 0, 10, 10 } }, generation);
+            Assert::IsFalse(m_cache.Find(key).has_value());
+
+            m_cache.Insert(key, { RECT{ 0, 0, 10, 10 } }, m_cache.CustomLayoutsGeneration());
+            Assert::IsTrue(m_cache.Find(key).has_value());
+        }
+    };
+}
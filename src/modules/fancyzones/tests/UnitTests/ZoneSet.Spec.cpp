@@ -2,6 +2,8 @@
 #include "lib\FancyZonesData.h"
 #include "lib\FancyZonesDataTypes.h"
 #include "lib\JsonHelpers.h"
+#include "lib\Settings.h"
+#include "lib\ZoneGeometryCache.h"
 #include "lib\ZoneSet.h"
 
 #include <filesystem>
@@ -312,6 +314,22 @@ namespace FancyZonesUnitTests
                 Assert::AreEqual({}, actual);
             }
 
+            TEST_METHOD (PrepareWindowMove)
+            {
+                winrt::com_ptr<IZone> zone1 = MakeZone({ 0, 0, 100, 100 });
+                winrt::com_ptr<IZone> zone2 = MakeZone({ 100, 0, 200, 100 });
+                m_set->AddZone(zone1);
+                m_set->AddZone(zone2);
+
+                HWND window = Mocks::Window();
+                RECT rect{};
+                Assert::IsTrue(m_set->PrepareWindowMove(window, Mocks::Window(), { 1 }, rect));
+                Assert::AreEqual({ 1 }, m_set->GetZoneIndexSetFromWindow(window));
+                Assert::AreEqual(reinterpret_cast<size_t>(::GetProp(window, MULTI_ZONE_STAMP)), (size_t)2);
+
+                Assert::IsFalse(m_set->PrepareWindowMove(Mocks::Window(), Mocks::Window(), { 5 }, rect));
+            }
+
             TEST_METHOD (MoveWindowIntoZoneByIndex)
             {
                 winrt::com_ptr<IZone> zone1 = MakeZone({ 0, 0, 100, 100 });
@@ -747,11 +765,14 @@ namespace FancyZonesUnitTests
 
                 ZoneSetConfig m_config = ZoneSetConfig(m_id, m_layoutType, m_monitor);
                 m_set = MakeZoneSet(m_config);
+
+                ZoneGeometryCacheInstance().Clear();
             }
 
             TEST_METHOD_CLEANUP(Cleanup)
                 {
                     std::filesystem::remove(m_path);
+                    ZoneGeometryCacheInstance().Clear();
                 }
 
                 void checkZones(const winrt::com_ptr<IZoneSet>& set, size_t expectedCount, MONITORINFO monitorInfo)
@@ -1070,6 +1091,31 @@ namespace FancyZonesUnitTests
                     }
                 }
 
+                TEST_METHOD (CustomZoneEditInvalidatesCachedZones)
+                {
+                    wil::unique_cotaskmem_string uuid;
+                    Assert::AreEqual(S_OK, StringFromCLSID(m_id, &uuid));
+                    const CanvasLayoutInfo info{ 123, 321, { CanvasLayoutInfo::Rect{ 0, 0, 100, 100 } } };
+                    json::to_file(m_path, JSONHelpers::CustomZoneSetJSON::ToJson(JSONHelpers::CustomZoneSetJSON{ uuid.get(), CustomZoneSetData{ L"name", CustomLayoutType::Canvas, info } }));
+                    FancyZonesDataInstance().ParseCustomZoneSetFromTmpFile(m_path);
+
+                    const auto& monitorInfo = m_popularMonitors[0];
+                    ZoneSetConfig m_config = ZoneSetConfig(m_id, ZoneSetLayoutType::Custom, m_monitor);
+                    auto set = MakeZoneSet(m_config);
+                    Assert::IsTrue(set->CalculateZones(monitorInfo, 1, 0));
+                    checkZones(set, 1, monitorInfo);
+                    Assert::AreEqual((size_t)1, ZoneGeometryCacheInstance().Size());
+
+                    const CanvasLayoutInfo editedInfo{ 123, 321, { CanvasLayoutInfo::Rect{ 0, 0, 100, 100 }, CanvasLayoutInfo::Rect{ 50, 50, 150, 150 } } };
+                    json::to_file(m_path, JSONHelpers::CustomZoneSetJSON::ToJson(JSONHelpers::CustomZoneSetJSON{ uuid.get(), CustomZoneSetData{ L"name", CustomLayoutType::Canvas, editedInfo } }));
+                    FancyZonesDataInstance().ParseCustomZoneSetFromTmpFile(m_path);
+                    Assert::AreEqual((size_t)0, ZoneGeometryCacheInstance().Size());
+
+                    auto editedSet = MakeZoneSet(m_config);
+                    Assert::IsTrue(editedSet->CalculateZones(monitorInfo, 1, 0));
+                    checkZones(editedSet, 2, monitorInfo);
+                }
+
                 TEST_METHOD (CustomZoneFromValidGridFullLayoutInfo)
                 {
                     //prepare device data
@@ -0,0 +1,219 @@
+#include "pch.h"
+#include "lib\Zone.h"
+#include "lib\ZoneSpatialIndex.h"
+
+#include <chrono>
+#include <random>
+
+#include "Util.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FancyZonesUnitTests
+{
+    namespace
+    {
+        // Linear scan previously used by ZoneSet::ZonesFromPoint, kept as the reference behavior
+        std::vector<int> LinearZonesFromPoint(const std::vector<winrt::com_ptr<IZone>>& zones, POINT pt)
+        {
+            const int SENSITIVITY_RADIUS = 20;
+            std::vector<int> capturedZones;
+            std::vector<int> strictlyCapturedZones;
+            for (size_t i = 0; i < zones.size(); i++)
+            {
+                RECT newZoneRect = zones[i]->GetZoneRect();
+                if (newZoneRect.left < newZoneRect.right && newZoneRect.top < newZoneRect.bottom)
+                {
+                    if (newZoneRect.left - SENSITIVITY_RADIUS <= pt.x && pt.x <= newZoneRect.right + SENSITIVITY_RADIUS &&
+                        newZoneRect.top - SENSITIVITY_RADIUS <= pt.y && pt.y <= newZoneRect.bottom + SENSITIVITY_RADIUS)
+                    {
+                        capturedZones.emplace_back(static_cast<int>(i));
+                    }
+
+                    if (newZoneRect.left <= pt.x && pt.x < newZoneRect.right &&
+                        newZoneRect.top <= pt.y && pt.y < newZoneRect.bottom)
+                    {
+                        strictlyCapturedZones.emplace_back(static_cast<int>(i));
+                    }
+                }
+            }
+
+            if (capturedZones.size() == 1 && strictlyCapturedZones.size() == 0)
+            {
+                return {};
+            }
+
+            bool overlap = false;
+            for (size_t i = 0; i < capturedZones.size(); ++i)
+            {
+                for (size_t j = i + 1; j < capturedZones.size(); ++j)
+                {
+                    auto rectI = zones[capturedZones[i]]->GetZoneRect();
+                    auto rectJ = zones[capturedZones[j]]->GetZoneRect();
+                    if (max(rectI.top, rectJ.top) + SENSITIVITY_RADIUS < min(rectI.bottom, rectJ.bottom) &&
+                        max(rectI.left, rectJ.left) + SENSITIVITY_RADIUS < min(rectI.right, rectJ.right))
+                    {
+                        overlap = true;
+                        i = capturedZones.size() - 1;
+                        break;
+                    }
+                }
+            }
+
+            if (overlap)
+            {
+                size_t smallestIdx = 0;
+                for (size_t i = 1; i < capturedZones.size(); ++i)
+                {
+                    auto rectS = zones[capturedZones[smallestIdx]]->GetZoneRect();
+                    auto rectI = zones[capturedZones[i]]->GetZoneRect();
+                    int smallestSize = (rectS.bottom - rectS.top) * (rectS.right - rectS.left);
+                    int iSize = (rectI.bottom - rectI.top) * (rectI.right - rectI.left);
+
+                    if (iSize <= smallestSize)
+                    {
+                        smallestIdx = i;
+                    }
+                }
+
+                capturedZones = { capturedZones[smallestIdx] };
+            }
+
+            return capturedZones;
+        }
+
+        std::vector<winrt::com_ptr<IZone>> MakeRandomZones(std::mt19937& generator, int count)
+        {
+            std::uniform_int_distribution<LONG> x(-500, 5000);
+            std::uniform_int_distribution<LONG> y(-300, 2000);
+            std::uniform_int_distribution<LONG> width(-50, 800);
+            std::uniform_int_distribution<LONG> height(-50, 600);
+
+            std::vector<winrt::com_ptr<IZone>> zones;
+            for (int i = 0; i < count; i++)
+            {
+                const LONG left = x(generator);
+                const LONG top = y(generator);
+                zones.emplace_back(MakeZone(RECT{ left, top, left + width(generator), top + height(generator) }));
+            }
+
+            return zones;
+        }
+
+        std::vector<RECT> ZoneRects(const std::vector<winrt::com_ptr<IZone>>& zones)
+        {
+            std::vector<RECT> rects;
+            for (const auto& zone : zones)
+            {
+                rects.emplace_back(zone->GetZoneRect());
+            }
+            return rects;
+        }
+    }
+
+    TEST_CLASS (ZoneSpatialIndexUnitTests)
+    {
+    public:
+        TEST_METHOD (EmptyIndex)
+        {
+            ZoneSpatialIndex index;
+            Assert::AreEqual(size_t{ 0 }, index.ZoneCount());
+            Assert::IsTrue(index.ZonesFromPoint(POINT{ 0, 0 }).empty());
+        }
+
+        TEST_METHOD (OnlyImproperZones)
+        {
+            ZoneSpatialIndex index;
+            index.Build({ RECT{ 100, 100, 0, 0 }, RECT{ 0, 0, 0, 0 } });
+            Assert::AreEqual(size_t{ 2 }, index.ZoneCount());
+            Assert::IsTrue(index.ZonesFromPoint(POINT{ 0, 0 }).empty());
+            Assert::IsTrue(index.ZonesFromPoint(POINT{ 50, 50 }).empty());
+        }
+
+        TEST_METHOD (ClearRemovesZones)
+        {
+            ZoneSpatialIndex index;
+            index.Build({ RECT{ 0, 0, 100, 100 } });
+            Assert::AreEqual(std::vector<int>{ 0 }, index.ZonesFromPoint(POINT{ 50, 50 }));
+
+            index.Clear();
+            Assert::AreEqual(size_t{ 0 }, index.ZoneCount());
+            Assert::IsTrue(index.ZonesFromPoint(POINT{ 50, 50 }).empty());
+        }
+
+        TEST_METHOD (SameResultsAsLinearScan)
+        {
+            std::mt19937 generator(42);
+            std::uniform_int_distribution<LONG> x(-700, 5800);
+            std::uniform_int_distribution<LONG> y(-500, 2700);
+
+            for (int count : { 1, 2, 5, 16, 50, 70 })
+            {
+                auto zones = MakeRandomZones(generator, count);
+                ZoneSpatialIndex index;
+                index.Build(ZoneRects(zones));
+
+                for (int i = 0; i < 2000; i++)
+                {
+                    POINT pt{ x(generator), y(generator) };
+                    Assert::AreEqual(LinearZonesFromPoint(zones, pt), index.ZonesFromPoint(pt));
+                }
+
+                // Points around zone borders, where the sensitivity radius matters
+                for (const auto& zone : zones)
+                {
+                    const RECT rect = zone->GetZoneRect();
+                    for (LONG delta = -ZoneSpatialIndex::SENSITIVITY_RADIUS - 2; delta <= ZoneSpatialIndex::SENSITIVITY_RADIUS + 2; delta++)
+                    {
+                        POINT topLeft{ rect.left + delta, rect.top + delta };
+                        Assert::AreEqual(LinearZonesFromPoint(zones, topLeft), index.ZonesFromPoint(topLeft));
+                        POINT bottomRight{ rect.right + delta, rect.bottom - delta };
+                        Assert::AreEqual(LinearZonesFromPoint(zones, bottomRight), index.ZonesFromPoint(bottomRight));
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD (BenchmarkAgainstLinearScan)
+        {
+            constexpr int zoneCount = 50;
+            constexpr int iterations = 200000;
+
+            std::mt19937 generator(7);
+            auto zones = MakeRandomZones(generator, zoneCount);
+            ZoneSpatialIndex index;
+            index.Build(ZoneRects(zones));
+
+            std::uniform_int_distribution<LONG> x(-500, 5500);
+            std::uniform_int_distribution<LONG> y(-300, 2500);
+            std::vector<POINT> points(iterations);
+            for (auto& pt : points)
+            {
+                pt = POINT{ x(generator), y(generator) };
+            }
+
+            size_t linearHits = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const auto& pt : points)
+            {
+                linearHits += LinearZonesFromPoint(zones, pt).size();
+            }
+            const auto linear = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+            size_t indexHits = 0;
+            start = std::chrono::high_resolution_clock::now();
+            for (const auto& pt : points)
+            {
+                indexHits += index.ZonesFromPoint(pt).size();
+            }
+            const auto indexed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+            Assert::AreEqual(linearHits, indexHits);
+
+            const std::wstring message = L"ZonesFromPoint, " + std::to_wstring(zoneCount) + L" zones, " + std::to_wstring(iterations) +
+                                         L" lookups: linear scan " + std::to_wstring(linear.count()) + L" us, spatial index " +
+                                         std::to_wstring(indexed.count()) + L" us\n";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "lowlevel_keyboard_event_data.h"
+#include "win_hook_event_data.h"
+#include <cwchar>
+
+/*
+  Ids of the events the PowerToys runner can signal.
+
+  The runner interns the event names returned by get_events() into these ids
+  when the PowerToy is loaded, and signals the events through the id-based
+  signal_event() overload, so no string is compared or copied per event.
+  A PowerToy that handles the events on a hot path (e.g. every keystroke for
+  ll_keyboard) should override that overload instead of comparing names.
+*/
+enum class PowertoyEventId : int {
+  ll_keyboard,
+  win_hook_event,
+  count
+};
+
+/* Returns the name of the event id, or nullptr if the id is unknown. */
+inline const wchar_t* powertoy_event_name(PowertoyEventId id) {
+  switch (id) {
+  case PowertoyEventId::ll_keyboard:
+    return ll_keyboard;
+  case PowertoyEventId::win_hook_event:
+    return win_hook_event;
+  default:
+    return nullptr;
+  }
+}
+
+/* Sets the id of the event name. Returns false if the event name is unknown. */
+inline bool powertoy_event_id_from_name(const wchar_t* name, PowertoyEventId& id) {
+  for (int i = 0; i < static_cast<int>(PowertoyEventId::count); ++i) {
+    if (wcscmp(name, powertoy_event_name(static_cast<PowertoyEventId>(i))) == 0) {
+      id = static_cast<PowertoyEventId>(i);
+      return true;
+    }
+  }
+  return false;
+}
@@ -21,13 +21,16 @@
     - get_config() to get the available configuration settings,
     - set_config() to set various settings,
     - call_custom_action() when the user selects clicks a custom action in settings,
-    - signal_event() to send an event the PowerToy registered to.
+    - signal_event() to send an event the PowerToy registered to. The runner
+      calls the overload taking the PowertoyEventId, see powertoy_event_id.h.
 
   When terminating, the runner will:
     - call destroy() which should free all the memory and delete the PowerToy object,
     - unload the DLL.
  */
 
+#include "powertoy_event_id.h"
+
 class PowertoySystemMenuIface;
 
 class PowertoyModuleIface {
@@ -43,6 +46,13 @@ public:
      to any event.
   */
   virtual const wchar_t** get_events() = 0;
+  /* Returns a table of the ranges of the win_hook_event events the PowerToy wants
+     to be signaled, terminated by a range with min equal to 0. Only used when the
+     PowerToy subscribes to win_hook_event.
+
+     A nullptr means the PowerToy wants all the events.
+  */
+  virtual const WinHookEventRange* get_win_hook_event_ranges() { return nullptr; }
   /* Fills a buffer with the available configuration settings.
    * If 'buffer' is a null ptr or the buffer size is not large enough
    * sets the required buffer size in 'buffer_size' and return false.
@@ -65,6 +75,12 @@ public:
        * win_hook_event: see win_hook_event_data.h
   */
   virtual intptr_t signal_event(const wchar_t* name, intptr_t data) = 0;
+  /* Handle event by its id, which is how the runner signals the events.
+     The default implementation forwards the event name to the method above.
+  */
+  virtual intptr_t signal_event(PowertoyEventId event, intptr_t data) {
+    return signal_event(powertoy_event_name(event), data);
+  }
 
   /* Register helper class to handle system menu items related actions. */
   virtual void register_system_menu_helper(PowertoySystemMenuIface* helper) = 0;
@@ -34,12 +34,34 @@
   Taking too long to process the events has negative impact on the whole system
   performance. To address this, the events are signaled from a different
   thread, not from the event hook callback itself.
+
+  A PowerToy should also limit the events it receives to the ones it handles,
+  by returning their ranges from get_win_hook_event_ranges(), e.g.:
+
+  virtual const WinHookEventRange* get_win_hook_event_ranges() override {
+    static const WinHookEventRange ranges[] = {
+      { EVENT_SYSTEM_MOVESIZESTART, EVENT_SYSTEM_MOVESIZEEND },
+      { 0, 0 }
+    };
+    return ranges;
+  }
+
+  The runner hooks only the union of the ranges of all the subscribed PowerToys,
+  and signals each event only to the PowerToys whose ranges contain it. No hook
+  is installed while no PowerToy subscribes and no PowerToy customizes the
+  system menu.
 */
 
 namespace {
   const wchar_t* win_hook_event = L"win_hook_event";
 }
 
+/* Inclusive range of event constants, see SetWinEventHook eventMin and eventMax. */
+struct WinHookEventRange {
+  DWORD min;
+  DWORD max;
+};
+
 struct WinHookEvent {
   DWORD event;
   HWND hwnd;
@@ -1,5 +1,25 @@
 #pragma once
 
+class KeyStateTracker;
+
+// Name of a process as used to look up app-specific shortcut remaps
+struct ProcessName
+{
+    // Lower case name of the process, e.g. notepad.exe
+    std::wstring name;
+
+    // Lower case name of the process without its file extension, e.g. notepad
+    std::wstring nameWithoutExtension;
+
+    // Function to set both names from the name of a process
+    void Set(const std::wstring& processName)
+    {
+        name.resize(processName.length());
+        std::transform(processName.begin(), processName.end(), name.begin(), towlower);
+        nameWithoutExtension.assign(name, 0, name.find_last_of(L"."));
+    }
+};
+
 // Interface used to wrap keyboard input library methods
 class InputInterface
 {
@@ -10,6 +30,9 @@ public:
     // Function to get the state of a particular key
     virtual bool GetVirtualKeyState(int key) = 0;
 
-    // Function to get the foreground process name
-    virtual void GetForegroundProcess(_Out_ std::wstring& foregroundProcess) = 0;
+    // Function to get the state of all the keys as seen by the keyboard hook
+    virtual const KeyStateTracker& GetKeyStateTracker() = 0;
+
+    // Function to get the name of the foreground process
+    virtual const ProcessName& GetForegroundProcess() = 0;
 };
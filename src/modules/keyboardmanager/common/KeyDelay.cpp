@@ -1,165 +1,250 @@
 #include "pch.h"
 #include "KeyDelay.h"
 
-KeyDelay::~KeyDelay()
+DWORD KeyDelay::KeyEvent(const KeyTimedEvent& ev)
 {
-    std::unique_lock<std::mutex> l(_queueMutex);
-    _quit = true;
-    _cv.notify_all();
-    l.unlock();
-    _delayThread.join();
+    bool isKeyDown = ev.message == WM_KEYDOWN || ev.message == WM_SYSKEYDOWN;
+    switch (_state)
+    {
+    case KeyDelayState::RELEASED:
+        if (isKeyDown)
+        {
+            _state = KeyDelayState::ON_HOLD;
+            _initialHoldKeyDown = ev.time;
+        }
+        break;
+    case KeyDelayState::ON_HOLD:
+        // Repeated key down events are ignored
+        if (!isKeyDown)
+        {
+            _state = KeyDelayState::RELEASED;
+            if (ev.time > _initialHoldKeyDown + LONG_PRESS_DELAY_MILLIS)
+            {
+                return KEY_DELAY_LONG_PRESS_DETECTED | KEY_DELAY_LONG_PRESS_RELEASED;
+            }
+
+            return KEY_DELAY_SHORT_PRESS;
+        }
+        break;
+    case KeyDelayState::ON_HOLD_TIMEOUT:
+        if (!isKeyDown)
+        {
+            _state = KeyDelayState::RELEASED;
+            return KEY_DELAY_LONG_PRESS_RELEASED;
+        }
+        break;
+    }
+
+    return KEY_DELAY_NONE;
 }
 
-void KeyDelay::KeyEvent(LowlevelKeyboardEvent* ev)
+DWORD KeyDelay::LongPressTimeout(DWORD64 deadline)
 {
-    std::lock_guard guard(_queueMutex);
-    _queue.push({ ev->lParam->time, ev->wParam });
-    _cv.notify_all();
+    DWORD64 currentDeadline;
+    if (!GetLongPressDeadline(currentDeadline) || currentDeadline != deadline)
+    {
+        return KEY_DELAY_NONE;
+    }
+
+    _state = KeyDelayState::ON_HOLD_TIMEOUT;
+    return KEY_DELAY_LONG_PRESS_DETECTED;
 }
 
-KeyTimedEvent KeyDelay::NextEvent()
+bool KeyDelay::GetLongPressDeadline(DWORD64& deadline) const
 {
-    auto ev = _queue.front();
-    _queue.pop();
-    return ev;
+    if (_state != KeyDelayState::ON_HOLD)
+    {
+        return false;
+    }
+
+    deadline = _initialHoldKeyDown + LONG_PRESS_DELAY_MILLIS;
+    return true;
 }
 
-bool KeyDelay::CheckIfMillisHaveElapsed(DWORD64 first, DWORD64 last, DWORD64 duration)
+void KeyDelay::TriggerCallbacks(DWORD callbacks) const
 {
-    if (first < last && first <= first + duration)
+    if ((callbacks & KEY_DELAY_SHORT_PRESS) && _onShortPress != nullptr)
+    {
+        _onShortPress(_key);
+    }
+    if ((callbacks & KEY_DELAY_LONG_PRESS_DETECTED) && _onLongPressDetected != nullptr)
     {
-        return first + duration < last;
+        _onLongPressDetected(_key);
     }
-    else
+    if ((callbacks & KEY_DELAY_LONG_PRESS_RELEASED) && _onLongPressReleased != nullptr)
     {
-        first += ULLONG_MAX / 2;
-        last += ULLONG_MAX / 2;
-        return first + duration < last;
+        _onLongPressReleased(_key);
     }
 }
 
-bool KeyDelay::HasNextEvent()
+KeyDelayScheduler::KeyDelayScheduler(Clock clock, bool useDispatchThread) :
+    _clock(clock),
+    _useDispatchThread(useDispatchThread),
+    _quit(false),
+    _dispatching(false)
 {
-    return !_queue.empty();
 }
 
-bool KeyDelay::HandleRelease()
+KeyDelayScheduler::~KeyDelayScheduler()
 {
-    while (HasNextEvent())
+    std::unique_lock<std::mutex> l(_mutex);
+    _quit = true;
+    _cv.notify_all();
+    l.unlock();
+    if (_dispatchThread.joinable())
     {
-        auto ev = NextEvent();
-        switch (ev.message)
-        {
-        case WM_KEYDOWN:
-        case WM_SYSKEYDOWN:
-            _state = KeyDelayState::ON_HOLD;
-            _initialHoldKeyDown = ev.time;
-            return false;
-        case WM_KEYUP:
-        case WM_SYSKEYUP:
-            break;
-        }
+        _dispatchThread.join();
     }
-
-    return true;
 }
 
-bool KeyDelay::HandleOnHold(std::unique_lock<std::mutex>& cvLock)
+void KeyDelayScheduler::Register(
+    DWORD key,
+    std::function<void(DWORD)> onShortPress,
+    std::function<void(DWORD)> onLongPressDetected,
+    std::function<void(DWORD)> onLongPressReleased)
 {
-    while (HasNextEvent())
+    std::lock_guard l(_mutex);
+
+    if (_keyDelays.find(key) != _keyDelays.end())
     {
-        auto ev = NextEvent();
-        switch (ev.message)
-        {
-        case WM_KEYDOWN:
-        case WM_SYSKEYDOWN:
-            break;
-        case WM_KEYUP:
-        case WM_SYSKEYUP:
-            if (CheckIfMillisHaveElapsed(_initialHoldKeyDown, ev.time, LONG_PRESS_DELAY_MILLIS))
-            {
-                if (_onLongPressDetected != nullptr)
-                {
-                    _onLongPressDetected(_key);
-                }
-                if (_onLongPressReleased != nullptr)
-                {
-                    _onLongPressReleased(_key);
-                }
-            }
-            else
-            {
-                if (_onShortPress != nullptr)
-                {
-                    _onShortPress(_key);
-                }
-            }
-            _state = KeyDelayState::RELEASED;
-            return false;
-        }
+        throw std::invalid_argument("This key was already registered.");
     }
+    _keyDelays[key] = std::make_shared<KeyDelay>(key, onShortPress, onLongPressDetected, onLongPressReleased);
 
-    if (CheckIfMillisHaveElapsed(_initialHoldKeyDown, GetTickCount64(), LONG_PRESS_DELAY_MILLIS))
+    if (_useDispatchThread && !_dispatchThread.joinable())
     {
-        if (_onLongPressDetected != nullptr)
-        {
-            _onLongPressDetected(_key);
-        }
-        _state = KeyDelayState::ON_HOLD_TIMEOUT;
+        _dispatchThread = std::thread(&KeyDelayScheduler::DispatchThread, this);
     }
-    else
+}
+
+void KeyDelayScheduler::Unregister(DWORD key)
+{
+    std::unique_lock l(_mutex);
+
+    auto deleted = _keyDelays.erase(key);
+    if (deleted == 0)
     {
-        _cv.wait_for(cvLock, std::chrono::milliseconds(ON_HOLD_WAIT_TIMEOUT_MILLIS));
+        throw std::invalid_argument("The key was not previously registered.");
     }
-    return false;
+
+    // Wait for the callbacks being triggered, which could belong to the removed key. This is skipped when called from a callback since it would never return
+    _dispatchCv.wait(l, [this] { return !_dispatching || _dispatchingThreadId == std::this_thread::get_id(); });
 }
 
-bool KeyDelay::HandleOnHoldTimeout()
+bool KeyDelayScheduler::KeyEvent(LowlevelKeyboardEvent* ev)
 {
-    while (HasNextEvent())
+    std::lock_guard guard(_mutex);
+
+    if (_keyDelays.find(ev->lParam->vkCode) == _keyDelays.end())
     {
-        auto ev = NextEvent();
-        switch (ev.message)
+        return false;
+    }
+
+    _events.push_back({ ev->lParam->vkCode, { ToClockTime(ev->lParam->time), ev->wParam } });
+    _cv.notify_all();
+    return true;
+}
+
+DWORD64 KeyDelayScheduler::ToClockTime(DWORD eventTime)
+{
+    // The event time is a 32 bit tick count which wraps around every 49.7 days, so it is converted using the time elapsed since the event
+    DWORD64 now = _clock();
+    return now - (DWORD)((DWORD)now - eventTime);
+}
+
+void KeyDelayScheduler::Dispatch()
+{
+    std::unique_lock<std::mutex> l(_mutex);
+    DWORD64 now = _clock();
+
+    while (true)
+    {
+        std::shared_ptr<KeyDelay> keyDelay;
+        DWORD callbacks = KEY_DELAY_NONE;
+
+        // Key events are processed before the deadlines, since a key up event which arrived after the deadline decides on its own whether the press was long
+        if (!_events.empty())
         {
-        case WM_KEYDOWN:
-        case WM_SYSKEYDOWN:
-            break;
-        case WM_KEYUP:
-        case WM_SYSKEYUP:
-            if (_onLongPressReleased != nullptr)
+            auto [key, ev] = _events.front();
+            _events.pop_front();
+
+            auto it = _keyDelays.find(key);
+            if (it == _keyDelays.end())
             {
-                _onLongPressReleased(_key);
+                continue;
+            }
+
+            keyDelay = it->second;
+            DWORD64 deadline;
+            bool wasOnHold = keyDelay->GetLongPressDeadline(deadline);
+            callbacks = keyDelay->KeyEvent(ev);
+
+            // Schedule the long press detection when the key starts being held down
+            if (!wasOnHold && keyDelay->GetLongPressDeadline(deadline))
+            {
+                _deadlines.push({ deadline, key });
             }
-            _state = KeyDelayState::RELEASED;
-            return false;
         }
-    }
+        else if (!_deadlines.empty() && _deadlines.top().first < now)
+        {
+            auto [deadline, key] = _deadlines.top();
+            _deadlines.pop();
 
-    return true;
+            auto it = _keyDelays.find(key);
+            if (it == _keyDelays.end())
+            {
+                continue;
+            }
+
+            keyDelay = it->second;
+            callbacks = keyDelay->LongPressTimeout(deadline);
+        }
+        else
+        {
+            break;
+        }
+
+        if (callbacks != KEY_DELAY_NONE)
+        {
+            _dispatching = true;
+            _dispatchingThreadId = std::this_thread::get_id();
+            l.unlock();
+
+            keyDelay->TriggerCallbacks(callbacks);
+
+            l.lock();
+            _dispatching = false;
+            _dispatchingThreadId = std::thread::id();
+            _dispatchCv.notify_all();
+        }
+    }
 }
 
-void KeyDelay::DelayThread()
+void KeyDelayScheduler::DispatchThread()
 {
-    std::unique_lock<std::mutex> qLock(_queueMutex);
-    bool shouldWait = true;
+    std::unique_lock<std::mutex> l(_mutex);
     while (!_quit)
     {
-        if (shouldWait)
+        l.unlock();
+        Dispatch();
+        l.lock();
+
+        if (_quit || !_events.empty())
         {
-            _cv.wait(qLock);
+            continue;
         }
 
-        switch (_state)
+        // Sleep until a key event arrives or the earliest deadline passes
+        if (_deadlines.empty())
         {
-        case KeyDelayState::RELEASED:
-            shouldWait = HandleRelease();
-            break;
-        case KeyDelayState::ON_HOLD:
-            shouldWait = HandleOnHold(qLock);
-            break;
-        case KeyDelayState::ON_HOLD_TIMEOUT:
-            shouldWait = HandleOnHoldTimeout();
-            break;
+            _cv.wait(l, [this] { return _quit || !_events.empty(); });
+        }
+        else
+        {
+            DWORD64 now = _clock();
+            DWORD64 deadline = _deadlines.top().first;
+            DWORD64 timeout = deadline >= now ? deadline - now + 1 : 0;
+            _cv.wait_for(l, std::chrono::milliseconds(timeout), [this] { return _quit || !_events.empty(); });
         }
     }
-}
\ No newline at end of file
+}
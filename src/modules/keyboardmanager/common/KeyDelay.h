@@ -1,8 +1,12 @@
 #pragma once
 #include <functional>
 #include <thread>
-#include <queue>
+#include <deque>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <queue>
+#include <vector>
 #include <interface/lowlevel_keyboard_event_data.h>
 
 // Available states for the KeyDelay state machine.
@@ -13,16 +17,24 @@ enum class KeyDelayState
     ON_HOLD_TIMEOUT,
 };
 
-// Virtual key + timestamp (in millis since Windows startup)
+// Callbacks to be triggered after a state transition, in the order of the values.
+enum KeyDelayCallback : DWORD
+{
+    KEY_DELAY_NONE = 0,
+    KEY_DELAY_SHORT_PRESS = 1 << 0,
+    KEY_DELAY_LONG_PRESS_DETECTED = 1 << 1,
+    KEY_DELAY_LONG_PRESS_RELEASED = 1 << 2,
+};
+
+// Virtual key + timestamp (in millis of the KeyDelayScheduler clock)
 struct KeyTimedEvent
 {
     DWORD64 time;
     WPARAM message;
 };
 
-// Handles delayed key inputs.
-// Implemented as a state machine running on its own thread.
-// Thread stops on destruction.
+// Handles delayed key inputs for a single key.
+// Implemented as a state machine which is driven by a KeyDelayScheduler. It does not own a thread.
 class KeyDelay
 {
 public:
@@ -31,40 +43,30 @@ public:
         std::function<void(DWORD)> onShortPress,
         std::function<void(DWORD)> onLongPressDetected,
         std::function<void(DWORD)> onLongPressReleased) :
-        _quit(false),
         _state(KeyDelayState::RELEASED),
         _initialHoldKeyDown(0),
         _key(key),
         _onShortPress(onShortPress),
         _onLongPressDetected(onLongPressDetected),
-        _onLongPressReleased(onLongPressReleased),
-        _delayThread(&KeyDelay::DelayThread, this){};
+        _onLongPressReleased(onLongPressReleased){};
 
-    // Enque new KeyTimedEvent and notify the condition variable.
-    void KeyEvent(LowlevelKeyboardEvent* ev);
-    ~KeyDelay();
+    // Manage state transitions on a key event.
+    // Returns the callbacks to be triggered.
+    DWORD KeyEvent(const KeyTimedEvent& ev);
 
-private:
-    // Runs the state machine, waits if there is no events to process.
-    // Checks for _quit condition.
-    void DelayThread();
+    // Manage the state transition when a long press deadline returned by GetLongPressDeadline has passed.
+    // Returns the callbacks to be triggered. Deadlines of previous key presses are ignored.
+    DWORD LongPressTimeout(DWORD64 deadline);
 
-    // Manage state transitions and trigger callbacks on certain events.
-    // Returns whether or not the thread should wait on new events.
-    bool HandleRelease();
-    bool HandleOnHold(std::unique_lock<std::mutex>& cvLock);
-    bool HandleOnHoldTimeout();
+    // Returns whether the key is held down and waiting for a long press, along with the time at which the long press is detected.
+    bool GetLongPressDeadline(DWORD64& deadline) const;
 
-    // Get next key event in queue.
-    KeyTimedEvent NextEvent();
-    bool HasNextEvent();
+    // Trigger the callbacks returned by KeyEvent or LongPressTimeout.
+    void TriggerCallbacks(DWORD callbacks) const;
 
-    // Check if <duration> milliseconds passed since <first> millisecond.
-    // Also checks for overflow conditions.
-    bool CheckIfMillisHaveElapsed(DWORD64 first, DWORD64 last, DWORD64 duration);
+    static const DWORD64 LONG_PRESS_DELAY_MILLIS = 900;
 
-    std::thread _delayThread;
-    bool _quit;
+private:
     KeyDelayState _state;
 
     // Callback functions, the key provided in the constructor is passed as an argument.
@@ -72,20 +74,72 @@ private:
     std::function<void(DWORD)> _onLongPressReleased;
     std::function<void(DWORD)> _onShortPress;
 
-    // Queue holding key events that are not processed yet. Should be kept synchronized
-    // using _queueMutex
-    std::queue<KeyTimedEvent> _queue;
-    std::mutex _queueMutex;
-
-    // DelayThread waits on this condition variable when there is no events to process.
-    std::condition_variable _cv;
-
     // Keeps track of the time at which the initial KEY_DOWN event happened.
     DWORD64 _initialHoldKeyDown;
 
     // Virtual Key provided in the constructor. Passed to callback functions.
     DWORD _key;
+};
 
-    static const DWORD64 LONG_PRESS_DELAY_MILLIS = 900;
-    static const DWORD64 ON_HOLD_WAIT_TIMEOUT_MILLIS = 50;
+// Runs the KeyDelay state machines of all the registered keys on a single thread.
+// Key events are queued by the keyboard hook, and long press deadlines are kept in a min-heap so that the thread only wakes up when an event arrives or the earliest deadline passes.
+// Callbacks are triggered on the scheduler thread, without holding the scheduler lock.
+class KeyDelayScheduler
+{
+public:
+    // Returns the current time in milliseconds. The low 32 bits must match the time of the keyboard hook events, like GetTickCount64.
+    using Clock = std::function<DWORD64()>;
+
+    // If useDispatchThread is false no thread is created, and Dispatch has to be called to process the events. Used for testing with an injected clock.
+    KeyDelayScheduler(Clock clock = GetTickCount64, bool useDispatchThread = true);
+    ~KeyDelayScheduler();
+
+    // Add a KeyDelay for a virtual key. The scheduler thread is started on the first registration.
+    // NOTE: this will throw an exception if a virtual key is registered twice.
+    void Register(
+        DWORD key,
+        std::function<void(DWORD)> onShortPress,
+        std::function<void(DWORD)> onLongPressDetected,
+        std::function<void(DWORD)> onLongPressReleased);
+
+    // Remove a KeyDelay. No callback of the key runs after this returns, unless it is called from one of the callbacks.
+    // NOTE: this method will throw if the virtual key is not registered beforehand.
+    void Unregister(DWORD key);
+
+    // Enqueue a key event if its key is registered. Returns whether the key is registered.
+    bool KeyEvent(LowlevelKeyboardEvent* ev);
+
+    // Process the queued key events and the long press deadlines which have passed, on the calling thread.
+    void Dispatch();
+
+private:
+    // Waits for key events and deadlines and dispatches them until the scheduler is destroyed.
+    void DispatchThread();
+
+    // Convert the time of a keyboard hook event to the clock time.
+    DWORD64 ToClockTime(DWORD eventTime);
+
+    Clock _clock;
+    bool _useDispatchThread;
+    std::thread _dispatchThread;
+    bool _quit;
+
+    // Should be held when accessing the members below.
+    std::mutex _mutex;
+
+    // The dispatch thread waits on this condition variable for events and deadlines.
+    std::condition_variable _cv;
+
+    std::map<DWORD, std::shared_ptr<KeyDelay>> _keyDelays;
+
+    // Key events which are not processed yet, along with their key
+    std::deque<std::pair<DWORD, KeyTimedEvent>> _events;
+
+    // Long press deadlines along with their key, earliest first. Entries for keys which were released or unregistered are skipped when they are reached.
+    std::priority_queue<std::pair<DWORD64, DWORD>, std::vector<std::pair<DWORD64, DWORD>>, std::greater<std::pair<DWORD64, DWORD>>> _deadlines;
+
+    // Set while callbacks are triggered, so that Unregister can wait for them to finish.
+    bool _dispatching;
+    std::thread::id _dispatchingThreadId;
+    std::condition_variable _dispatchCv;
 };
@@ -0,0 +1,54 @@
+#include "pch.h"
+#include "KeyEventBatch.h"
+#include "Helpers.h"
+#include "InputInterface.h"
+
+// Function to add a key event with KeyboardManagerHelper::SetKeyEvent. Events added when the batch is full are dropped
+void KeyEventBatch::AddKeyEvent(WORD keyCode, DWORD flags, ULONG_PTR extraInfo)
+{
+    if (size == Capacity)
+    {
+        return;
+    }
+
+    // SetKeyEvent doesn't set every field, so the event is cleared first
+    inputs[size] = {};
+    KeyboardManagerHelper::SetKeyEvent(inputs, size, INPUT_KEYBOARD, keyCode, flags, extraInfo);
+    size++;
+}
+
+// Function to add the key events of the modifier keys of a shortcut with KeyboardManagerHelper::SetModifierKeyEvents
+void KeyEventBatch::AddModifierKeyEvents(const Shortcut& shortcutToBeSent, const ModifierKey& winKeyInvoked, bool isKeyDown, ULONG_PTR extraInfoFlag, const Shortcut& shortcutToCompare, const DWORD& keyToBeReleased)
+{
+    // The events are set in a separate array since SetModifierKeyEvents doesn't check the capacity
+    INPUT modifierInputs[MaxModifierCount] = {};
+    int modifierCount = 0;
+    KeyboardManagerHelper::SetModifierKeyEvents(shortcutToBeSent, winKeyInvoked, modifierInputs, modifierCount, isKeyDown, extraInfoFlag, shortcutToCompare, keyToBeReleased);
+    for (int i = 0; i < modifierCount && size < Capacity; i++)
+    {
+        inputs[size] = modifierInputs[i];
+        size++;
+    }
+}
+
+// Function to get the number of key events in the batch
+int KeyEventBatch::Size() const
+{
+    return size;
+}
+
+// Function to get a key event of the batch
+const INPUT& KeyEventBatch::operator[](int index) const
+{
+    return inputs[index];
+}
+
+// Function to send the key events with a single SendVirtualInput call. Nothing is sent if the batch is empty
+UINT KeyEventBatch::Send(InputInterface& ii)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    return ii.SendVirtualInput((UINT)size, inputs, sizeof(INPUT));
+}
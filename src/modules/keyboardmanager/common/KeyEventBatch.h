@@ -0,0 +1,35 @@
+#pragma once
+#include "Shortcut.h"
+
+class InputInterface;
+
+// Fixed capacity list of key events which are sent together with a single SendVirtualInput call.
+// It is meant to be a local variable of the keyboard hook, so that remapping a key event doesn't allocate.
+class KeyEventBatch
+{
+public:
+    // Number of modifier keys of a shortcut: Win, Ctrl, Alt and Shift
+    static const int MaxModifierCount = 4;
+
+    // The largest batch is sent when a key is pressed while a shortcut remapped to a shortcut is invoked: the target action key and modifiers are released, the original modifiers and action key are pressed, and the current key and the dummy key are sent
+    static const int Capacity = 1 + MaxModifierCount + MaxModifierCount + 1 + 2;
+
+    // Function to add a key event with KeyboardManagerHelper::SetKeyEvent. Events added when the batch is full are dropped
+    void AddKeyEvent(WORD keyCode, DWORD flags, ULONG_PTR extraInfo);
+
+    // Function to add the key events of the modifier keys of a shortcut with KeyboardManagerHelper::SetModifierKeyEvents
+    void AddModifierKeyEvents(const Shortcut& shortcutToBeSent, const ModifierKey& winKeyInvoked, bool isKeyDown, ULONG_PTR extraInfoFlag, const Shortcut& shortcutToCompare = Shortcut(), const DWORD& keyToBeReleased = NULL);
+
+    // Function to get the number of key events in the batch
+    int Size() const;
+
+    // Function to get a key event of the batch
+    const INPUT& operator[](int index) const;
+
+    // Function to send the key events with a single SendVirtualInput call. Nothing is sent if the batch is empty
+    UINT Send(InputInterface& ii);
+
+private:
+    INPUT inputs[Capacity];
+    int size = 0;
+};
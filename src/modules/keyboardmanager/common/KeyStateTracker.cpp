@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "KeyStateTracker.h"
+#include "../common/shared_constants.h"
+
+namespace
+{
+    // Function to return the key mask of the keys which are never considered by AreOnlyKeysDown
+    KeyStateTracker::KeyMask GetIgnoredKeys()
+    {
+        const DWORD keys[] = { 0x00, VK_LBUTTON, VK_RBUTTON, VK_MBUTTON, VK_XBUTTON1, VK_XBUTTON2, 0xFF };
+        KeyStateTracker::KeyMask mask = {};
+        for (DWORD key : keys)
+        {
+            KeyStateTracker::AddKey(mask, key);
+        }
+        return mask;
+    }
+
+    const KeyStateTracker::KeyMask ignoredKeys = GetIgnoredKeys();
+}
+
+// Function to set the state of a single key
+void KeyStateTracker::SetKey(DWORD key, bool isKeyDown)
+{
+    if (key >= 256)
+    {
+        return;
+    }
+
+    if (isKeyDown)
+    {
+        keys[key / 64] |= 1ULL << (key % 64);
+    }
+    else
+    {
+        keys[key / 64] &= ~(1ULL << (key % 64));
+    }
+
+    DWORD modifierBit = GetModifierBit(key);
+    if (modifierBit != 0)
+    {
+        if (isKeyDown)
+        {
+            modifierState |= modifierBit;
+        }
+        else
+        {
+            modifierState &= ~modifierBit;
+        }
+
+        // Since VK_WIN does not exist, the summary word has a bit for either win key being pressed
+        if (modifierState & (LeftWin | RightWin))
+        {
+            modifierState |= EitherWin;
+        }
+        else
+        {
+            modifierState &= ~EitherWin;
+        }
+    }
+}
+
+// Function to update the state with a key event. Releasing a generic modifier (e.g. VK_CONTROL) releases both its left and right keys, and the generic key is down while either the left or the right modifier key is down
+void KeyStateTracker::ApplyKeyEvent(DWORD key, bool isKeyDown)
+{
+    SetKey(key, isKeyDown);
+
+    switch (key)
+    {
+    case VK_CONTROL:
+        if (!isKeyDown)
+        {
+            SetKey(VK_LCONTROL, false);
+            SetKey(VK_RCONTROL, false);
+        }
+        break;
+    case VK_LCONTROL:
+    case VK_RCONTROL:
+        SetKey(VK_CONTROL, IsKeyDown(VK_LCONTROL) || IsKeyDown(VK_RCONTROL));
+        break;
+    case VK_MENU:
+        if (!isKeyDown)
+        {
+            SetKey(VK_LMENU, false);
+            SetKey(VK_RMENU, false);
+        }
+        break;
+    case VK_LMENU:
+    case VK_RMENU:
+        SetKey(VK_MENU, IsKeyDown(VK_LMENU) || IsKeyDown(VK_RMENU));
+        break;
+    case VK_SHIFT:
+        if (!isKeyDown)
+        {
+            SetKey(VK_LSHIFT, false);
+            SetKey(VK_RSHIFT, false);
+        }
+        break;
+    case VK_LSHIFT:
+    case VK_RSHIFT:
+        SetKey(VK_SHIFT, IsKeyDown(VK_LSHIFT) || IsKeyDown(VK_RSHIFT));
+        break;
+    }
+}
+
+// Function to release all the keys
+void KeyStateTracker::Reset()
+{
+    keys.fill(0);
+    modifierState = 0;
+}
+
+// Function to check if no key is pressed down apart from the keys of the mask. Mouse buttons and key codes 0 and 0xFF are not taken into account
+bool KeyStateTracker::AreOnlyKeysDown(const KeyMask& allowedKeys) const
+{
+    ULONG64 otherKeys = 0;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        otherKeys |= keys[i] & ~(allowedKeys[i] | ignoredKeys[i]);
+    }
+
+    return otherKeys == 0;
+}
+
+// Function to return the modifier bit of a key code as returned by the Shortcut::Get*Key functions. Returns 0 if the key is not a modifier
+DWORD KeyStateTracker::GetModifierBit(DWORD key)
+{
+    switch (key)
+    {
+    case VK_LWIN:
+        return LeftWin;
+    case VK_RWIN:
+        return RightWin;
+    case VK_LCONTROL:
+        return LeftCtrl;
+    case VK_RCONTROL:
+        return RightCtrl;
+    case VK_CONTROL:
+        return Ctrl;
+    case VK_LMENU:
+        return LeftAlt;
+    case VK_RMENU:
+        return RightAlt;
+    case VK_MENU:
+        return Alt;
+    case VK_LSHIFT:
+        return LeftShift;
+    case VK_RSHIFT:
+        return RightShift;
+    case VK_SHIFT:
+        return Shift;
+    default:
+        if (key == CommonSharedConstants::VK_WIN_BOTH)
+        {
+            return EitherWin;
+        }
+        return 0;
+    }
+}
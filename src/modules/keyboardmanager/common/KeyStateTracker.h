@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+
+// Stores which virtual keys are pressed down as a 256-bit bitset, along with a summary word of the modifier keys.
+// The keyboard hook updates it on every key event it lets through, so that checking the keyboard state inside the hook doesn't have to query each key.
+class KeyStateTracker
+{
+public:
+    // Set of virtual keys, one bit per key code
+    using KeyMask = std::array<ULONG64, 4>;
+
+    // Bits of the modifier summary word. Each bit corresponds to one of the key checks done by Shortcut::CheckModifiersKeyboardState
+    enum ModifierBit : DWORD
+    {
+        LeftWin = 1 << 0,
+        RightWin = 1 << 1,
+        EitherWin = 1 << 2,
+        LeftCtrl = 1 << 3,
+        RightCtrl = 1 << 4,
+        Ctrl = 1 << 5,
+        LeftAlt = 1 << 6,
+        RightAlt = 1 << 7,
+        Alt = 1 << 8,
+        LeftShift = 1 << 9,
+        RightShift = 1 << 10,
+        Shift = 1 << 11,
+    };
+
+    // Function to return the state of a key
+    bool IsKeyDown(DWORD key) const
+    {
+        return key < 256 && (keys[key / 64] & (1ULL << (key % 64))) != 0;
+    }
+
+    // Function to set the state of a single key
+    void SetKey(DWORD key, bool isKeyDown);
+
+    // Function to update the state with a key event. Releasing a generic modifier (e.g. VK_CONTROL) releases both its left and right keys, and pressing or releasing a left or right modifier key sets the generic key to the same state
+    void ApplyKeyEvent(DWORD key, bool isKeyDown);
+
+    // Function to release all the keys
+    void Reset();
+
+    // Function to return the bits of the modifier keys which are pressed down
+    DWORD GetModifierState() const
+    {
+        return modifierState;
+    }
+
+    // Function to check if all the modifier bits of a mask are pressed down
+    bool AreModifiersDown(DWORD modifierMask) const
+    {
+        return (modifierState & modifierMask) == modifierMask;
+    }
+
+    // Function to check if no key is pressed down apart from the keys of the mask. Mouse buttons and key codes 0 and 0xFF are not taken into account
+    bool AreOnlyKeysDown(const KeyMask& allowedKeys) const;
+
+    // Function to add a key to a key mask
+    static void AddKey(KeyMask& mask, DWORD key)
+    {
+        if (key < 256)
+        {
+            mask[key / 64] |= 1ULL << (key % 64);
+        }
+    }
+
+    // Function to return the modifier bit of a key code as returned by the Shortcut::Get*Key functions. Returns 0 if the key is not a modifier
+    static DWORD GetModifierBit(DWORD key);
+
+private:
+    KeyMask keys = {};
+    DWORD modifierState = 0;
+};
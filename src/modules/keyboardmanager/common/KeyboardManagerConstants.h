@@ -40,6 +40,9 @@ namespace KeyboardManagerConstants
     // Name of the named mutex used for configuration file.
     inline const std::wstring ConfigFileMutexName = L"PowerToys.KeyboardManager.ConfigMutex";
 
+    // Extension of the compiled remap image, which is saved next to the configuration file and loaded instead of it if it is up to date.
+    inline const std::wstring RemapImageFileExtension = L".remaps";
+
     // Name of the dummy update file.
     inline const std::wstring DummyUpdateFileName = L"settings-updated.json";
 
@@ -91,6 +94,9 @@ namespace KeyboardManagerConstants
     inline const ULONG_PTR KEYBOARDMANAGER_SHORTCUT_FLAG = 0x101; // Shortcut remaps
     inline const ULONG_PTR KEYBOARDMANAGER_SUPPRESS_FLAG = 0x111; // Key events which must be suppressed
 
+    // Time without key events, in ms, after which the keyboard hook reads the key state from the system again
+    inline const DWORD KeyStateSyncIdleTime = 1000;
+
     // Dummy key event used in between key up and down events to prevent certain global events from happening
     inline const DWORD DUMMY_KEY = 0xFF;
 
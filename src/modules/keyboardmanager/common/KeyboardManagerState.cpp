@@ -4,11 +4,12 @@
 #include "RemapShortcut.h"
 #include <../common/settings_helpers.h>
 #include "KeyDelay.h"
+#include "RemapImage.h"
 #include "Helpers.h"
 
 // Constructor
 KeyboardManagerState::KeyboardManagerState() :
-    uiState(KeyboardManagerUIState::Deactivated), currentUIWindow(nullptr), currentShortcutUI1(nullptr), currentShortcutUI2(nullptr), currentSingleKeyUI(nullptr), detectedRemapKey(NULL)
+    uiState(KeyboardManagerUIState::Deactivated), currentUIWindow(nullptr), currentShortcutUI1(nullptr), currentShortcutUI2(nullptr), currentSingleKeyUI(nullptr), detectedRemapKey(NULL), keyDelayScheduler(std::make_unique<KeyDelayScheduler>())
 {
     configFile_mutex = CreateMutex(
         NULL, // default security descriptor
@@ -107,6 +108,7 @@ void KeyboardManagerState::ClearOSLevelShortcuts()
     std::lock_guard<std::mutex> lock(osLevelShortcutReMap_mutex);
     osLevelShortcutReMap.clear();
     osLevelShortcutReMapSortedKeys.clear();
+    osLevelShortcutReMapSnapshot.Publish(std::make_shared<ShortcutRemapSnapshot>());
 }
 
 // Function to clear the Keys remapping table.
@@ -114,6 +116,7 @@ void KeyboardManagerState::ClearSingleKeyRemaps()
 {
     std::lock_guard<std::mutex> lock(singleKeyReMap_mutex);
     singleKeyReMap.clear();
+    singleKeyReMapSnapshot.Publish(std::make_shared<SingleKeyRemapSnapshot>());
 }
 
 // Function to clear the App specific shortcut remapping table
@@ -122,6 +125,7 @@ void KeyboardManagerState::ClearAppSpecificShortcuts()
     std::lock_guard<std::mutex> lock(appSpecificShortcutReMap_mutex);
     appSpecificShortcutReMap.clear();
     appSpecificShortcutReMapSortedKeys.clear();
+    appSpecificShortcutReMapSnapshot.Publish(std::make_shared<AppSpecificShortcutRemapSnapshot>());
 }
 
 // Function to add a new OS level shortcut remapping
@@ -139,6 +143,7 @@ bool KeyboardManagerState::AddOSLevelShortcut(const Shortcut& originalSC, const
     osLevelShortcutReMap[originalSC] = RemapShortcut(newSC);
     osLevelShortcutReMapSortedKeys.push_back(originalSC);
     KeyboardManagerHelper::SortShortcutVectorBasedOnSize(osLevelShortcutReMapSortedKeys);
+    osLevelShortcutReMapSnapshot.Publish(ShortcutRemapSnapshot::Create(osLevelShortcutReMap, osLevelShortcutReMapSortedKeys));
 
     return true;
 }
@@ -156,6 +161,7 @@ bool KeyboardManagerState::AddSingleKeyRemap(const DWORD& originalKey, const std
     }
 
     singleKeyReMap[originalKey] = newRemapKey;
+    singleKeyReMapSnapshot.Publish(std::make_shared<SingleKeyRemapSnapshot>(singleKeyReMap));
     return true;
 }
 
@@ -188,9 +194,88 @@ bool KeyboardManagerState::AddAppSpecificShortcut(const std::wstring& app, const
     appSpecificShortcutReMap[process_name][originalSC] = RemapShortcut(newSC);
     appSpecificShortcutReMapSortedKeys[process_name].push_back(originalSC);
     KeyboardManagerHelper::SortShortcutVectorBasedOnSize(appSpecificShortcutReMapSortedKeys[process_name]);
+
+    // Only the snapshot of this app is rebuilt, the other apps share their snapshots with the previous one
+    auto snapshot = std::make_shared<AppSpecificShortcutRemapSnapshot>(*appSpecificShortcutReMapSnapshot.Get());
+    (*snapshot)[process_name] = ShortcutRemapSnapshot::Create(appSpecificShortcutReMap[process_name], appSpecificShortcutReMapSortedKeys[process_name]);
+    appSpecificShortcutReMapSnapshot.Publish(snapshot);
     return true;
 }
 
+// Function to replace all the remappings and publish them to the keyboard hook. The sorted keys and snapshots are built before the remap mutexes are taken, so the UI is only blocked while the containers are swapped
+void KeyboardManagerState::ReplaceRemaps(RemapConfiguration&& config)
+{
+    auto singleKeySnapshot = std::make_shared<SingleKeyRemapSnapshot>(config.singleKeyReMap);
+
+    std::vector<Shortcut> osLevelSortedKeys;
+    for (const auto& it : config.osLevelShortcutReMap)
+    {
+        osLevelSortedKeys.push_back(it.first);
+    }
+    KeyboardManagerHelper::SortShortcutVectorBasedOnSize(osLevelSortedKeys);
+    auto osLevelSnapshot = ShortcutRemapSnapshot::Create(config.osLevelShortcutReMap, osLevelSortedKeys);
+
+    std::map<std::wstring, std::vector<Shortcut>> appSpecificSortedKeys;
+    auto appSpecificSnapshot = std::make_shared<AppSpecificShortcutRemapSnapshot>();
+    for (const auto& itApp : config.appSpecificShortcutReMap)
+    {
+        std::vector<Shortcut>& sortedKeys = appSpecificSortedKeys[itApp.first];
+        for (const auto& it : itApp.second)
+        {
+            sortedKeys.push_back(it.first);
+        }
+        KeyboardManagerHelper::SortShortcutVectorBasedOnSize(sortedKeys);
+        (*appSpecificSnapshot)[itApp.first] = ShortcutRemapSnapshot::Create(itApp.second, sortedKeys);
+    }
+
+    // The maps are swapped under all three mutexes, so the UI never reads a mix of the old and new configuration.
+    // The hook doesn't take the mutexes, it reads every table from its own snapshot, so it can see a new table along with an old one while the snapshots are published. Each table it reads is complete
+    {
+        std::scoped_lock lock(singleKeyReMap_mutex, osLevelShortcutReMap_mutex, appSpecificShortcutReMap_mutex);
+        singleKeyReMap.swap(config.singleKeyReMap);
+        osLevelShortcutReMap.swap(config.osLevelShortcutReMap);
+        osLevelShortcutReMapSortedKeys.swap(osLevelSortedKeys);
+        appSpecificShortcutReMap.swap(config.appSpecificShortcutReMap);
+        appSpecificShortcutReMapSortedKeys.swap(appSpecificSortedKeys);
+
+        singleKeyReMapSnapshot.Publish(singleKeySnapshot);
+        osLevelShortcutReMapSnapshot.Publish(osLevelSnapshot);
+        appSpecificShortcutReMapSnapshot.Publish(appSpecificSnapshot);
+    }
+
+    // The previous remappings are destroyed here, outside of the locks
+}
+
+// Function to get a copy of all the remappings, so that an editor can replace some of the tables and keep the other ones with ReplaceRemaps
+RemapConfiguration KeyboardManagerState::GetRemaps()
+{
+    std::scoped_lock lock(singleKeyReMap_mutex, osLevelShortcutReMap_mutex, appSpecificShortcutReMap_mutex);
+    return RemapConfiguration{ singleKeyReMap, osLevelShortcutReMap, appSpecificShortcutReMap };
+}
+
+// Function to add a new single key to key/shortcut remapping
+bool RemapConfiguration::AddSingleKeyRemap(const DWORD& originalKey, const std::variant<DWORD, Shortcut>& newRemapKey)
+{
+    return singleKeyReMap.insert({ originalKey, newRemapKey }).second;
+}
+
+// Function to add a new OS level shortcut remapping
+bool RemapConfiguration::AddOSLevelShortcut(const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC)
+{
+    return osLevelShortcutReMap.insert({ originalSC, RemapShortcut(newSC) }).second;
+}
+
+// Function to add a new App specific shortcut remapping
+bool RemapConfiguration::AddAppSpecificShortcut(const std::wstring& app, const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC)
+{
+    // Convert app name to lower case
+    std::wstring process_name;
+    process_name.resize(app.length());
+    std::transform(app.begin(), app.end(), process_name.begin(), towlower);
+
+    return appSpecificShortcutReMap[process_name].insert({ originalSC, RemapShortcut(newSC) }).second;
+}
+
 // Function to set the textblock of the detect shortcut UI so that it can be accessed by the hook
 void KeyboardManagerState::ConfigureDetectShortcutUI(const StackPanel& textBlock1, const StackPanel& textBlock2)
 {
@@ -413,24 +498,12 @@ void KeyboardManagerState::RegisterKeyDelay(
     std::function<void(DWORD)> onLongPressDetected,
     std::function<void(DWORD)> onLongPressReleased)
 {
-    std::lock_guard l(keyDelays_mutex);
-
-    if (keyDelays.find(key) != keyDelays.end())
-    {
-        throw std::invalid_argument("This key was already registered.");
-    }
-    keyDelays[key] = std::make_unique<KeyDelay>(key, onShortPress, onLongPressDetected, onLongPressReleased);
+    keyDelayScheduler->Register(key, onShortPress, onLongPressDetected, onLongPressReleased);
 }
 
 void KeyboardManagerState::UnregisterKeyDelay(DWORD key)
 {
-    std::lock_guard l(keyDelays_mutex);
-
-    auto deleted = keyDelays.erase(key);
-    if (deleted == 0)
-    {
-        throw std::invalid_argument("The key was not previously registered.");
-    }
+    keyDelayScheduler->Unregister(key);
 }
 
 bool KeyboardManagerState::HandleKeyDelayEvent(LowlevelKeyboardEvent* ev)
@@ -440,15 +513,7 @@ bool KeyboardManagerState::HandleKeyDelayEvent(LowlevelKeyboardEvent* ev)
         return false;
     }
 
-    std::lock_guard l(keyDelays_mutex);
-
-    if (keyDelays.find(ev->lParam->vkCode) == keyDelays.end())
-    {
-        return false;
-    }
-
-    keyDelays[ev->lParam->vkCode]->KeyEvent(ev);
-    return true;
+    return keyDelayScheduler->KeyEvent(ev);
 }
 
 // Save the updated configuration.
@@ -461,6 +526,7 @@ bool KeyboardManagerState::SaveConfigToFile()
     json::JsonArray inProcessRemapKeysArray;
     json::JsonArray appSpecificRemapShortcutsArray;
     json::JsonArray globalRemapShortcutsArray;
+    RemapImage image;
     std::unique_lock<std::mutex> lockSingleKeyReMap(singleKeyReMap_mutex);
     for (const auto& it : singleKeyReMap)
     {
@@ -480,6 +546,7 @@ bool KeyboardManagerState::SaveConfigToFile()
         }
 
         inProcessRemapKeysArray.Append(keys);
+        image.AddSingleKeyRemap(it.first, it.second);
     }
     lockSingleKeyReMap.unlock();
 
@@ -502,6 +569,7 @@ bool KeyboardManagerState::SaveConfigToFile()
         }
 
         globalRemapShortcutsArray.Append(keys);
+        image.AddOSLevelShortcut(it.first, it.second.targetShortcut);
     }
     lockOsLevelShortcutReMap.unlock();
 
@@ -529,6 +597,7 @@ bool KeyboardManagerState::SaveConfigToFile()
             keys.SetNamedValue(KeyboardManagerConstants::TargetAppSettingName, json::value(itApp.first));
 
             appSpecificRemapShortcutsArray.Append(keys);
+            image.AddAppSpecificShortcut(itApp.first, itKeys.first, itKeys.second.targetShortcut);
         }
     }
     lockAppSpecificShortcutReMap.unlock();
@@ -546,15 +615,24 @@ bool KeyboardManagerState::SaveConfigToFile()
         timeout);
     if (dwWaitResult == WAIT_OBJECT_0)
     {
+        std::wstring configPath = PTSettingsHelper::get_module_save_folder_location(KeyboardManagerConstants::ModuleName) + L"\\" + GetCurrentConfigName();
         try
         {
-            json::to_file((PTSettingsHelper::get_module_save_folder_location(KeyboardManagerConstants::ModuleName) + L"\\" + GetCurrentConfigName() + L".json"), configJson);
+            json::to_file(configPath + L".json", configJson);
         }
         catch (...)
         {
             result = false;
         }
 
+        // Compile the remaps along with the stamp of the written file. The image is only a cache which is rebuilt from the JSON file when it is missing or out of date, so failures are ignored
+        ULONG64 sourceWriteTime;
+        ULONG64 sourceSize;
+        if (result && RemapImage::GetSourceStamp(configPath + L".json", sourceWriteTime, sourceSize))
+        {
+            image.Save(configPath + KeyboardManagerConstants::RemapImageFileExtension, sourceWriteTime, sourceSize);
+        }
+
         // Make sure to release the Mutex.
         ReleaseMutex(configFile_mutex);
     }
@@ -585,7 +663,7 @@ void KeyboardManagerState::SetActivatedApp(const std::wstring& appName)
 }
 
 // Gets the activated target application in app-specfic shortcut
-std::wstring KeyboardManagerState::GetActivatedApp()
+const std::wstring& KeyboardManagerState::GetActivatedApp()
 {
     return activatedAppSpecificShortcutTarget;
 }
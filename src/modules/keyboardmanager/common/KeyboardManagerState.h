@@ -5,16 +5,48 @@
 #include <functional>
 #include <interface/lowlevel_keyboard_event_data.h>
 #include <variant>
+#include <unordered_map>
 #include "Shortcut.h"
 #include "RemapShortcut.h"
+#include "RemapSnapshot.h"
 
-class KeyDelay;
+class KeyDelayScheduler;
 
 namespace KeyboardManagerHelper
 {
     enum class KeyboardHookDecision;
 }
 
+// Stores all the remappings of a configuration, so that they can be loaded into KeyboardManagerState at once
+struct RemapConfiguration
+{
+    std::unordered_map<DWORD, std::variant<DWORD, Shortcut>> singleKeyReMap;
+    std::map<Shortcut, RemapShortcut> osLevelShortcutReMap;
+    std::map<std::wstring, std::map<Shortcut, RemapShortcut>> appSpecificShortcutReMap;
+
+    // Function to add a new single key to key/shortcut remapping. Returns false if the key is already remapped
+    bool AddSingleKeyRemap(const DWORD& originalKey, const std::variant<DWORD, Shortcut>& newRemapKey);
+
+    // Function to add a new OS level shortcut remapping. Returns false if the shortcut is already remapped
+    bool AddOSLevelShortcut(const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC);
+
+    // Function to add a new App specific shortcut remapping. Returns false if the shortcut is already remapped for the app
+    bool AddAppSpecificShortcut(const std::wstring& app, const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC);
+};
+
+// State of the keyboard hook. It is only accessed from the hook thread, so it doesn't need to be guarded by a mutex
+struct RemapHookState
+{
+    // Snapshots of the remappings last read by the hook
+    SnapshotReader<SingleKeyRemapSnapshot> singleKeyReMap;
+    SnapshotReader<ShortcutRemapSnapshot> osLevelShortcutReMap;
+    SnapshotReader<AppSpecificShortcutRemapSnapshot> appSpecificShortcutReMap;
+
+    // Shortcuts which are currently invoked. App-specific shortcuts share one state since only the shortcuts of the activated app can be invoked until it is reset
+    ShortcutInvokeState osLevelShortcutInvokeState;
+    ShortcutInvokeState appSpecificShortcutInvokeState;
+};
+
 namespace winrt::Windows::UI::Xaml::Controls
 {
     struct StackPanel;
@@ -77,9 +109,8 @@ private:
     // Handle of named mutex used for configuration file.
     HANDLE configFile_mutex;
 
-    // Registered KeyDelay objects, used to notify delayed key events.
-    std::map<DWORD, std::unique_ptr<KeyDelay>> keyDelays;
-    std::mutex keyDelays_mutex;
+    // Scheduler of the registered KeyDelay objects, used to notify delayed key events. All the keys share its thread.
+    std::unique_ptr<KeyDelayScheduler> keyDelayScheduler;
 
     // Stores the activated target application in app-specfic shortcut
     std::wstring activatedAppSpecificShortcutTarget;
@@ -88,8 +119,8 @@ private:
     void AddKeyToLayout(const winrt::Windows::UI::Xaml::Controls::StackPanel& panel, const winrt::hstring& key);
 
 public:
-    // The map members and their mutexes are left as public since the maps are used extensively in dllmain.cpp.
-    // Maps which store the remappings for each of the features. The bool fields should be initialized to false. They are used to check the current state of the shortcut (i.e is that particular shortcut currently pressed down or not).
+    // The map members and their mutexes are left as public since the maps are used extensively in dllmain.cpp and the UI.
+    // Maps which store the remappings for each of the features. The keyboard hook doesn't read them, it reads the snapshots which are published whenever they change.
     // Stores single key remappings
     std::unordered_map<DWORD, std::variant<DWORD, Shortcut>> singleKeyReMap;
     std::mutex singleKeyReMap_mutex;
@@ -108,6 +139,15 @@ public:
     std::map<std::wstring, std::vector<Shortcut>> appSpecificShortcutReMapSortedKeys;
     std::mutex appSpecificShortcutReMap_mutex;
 
+    // Immutable snapshots of the remappings which are read by the keyboard hook without taking the mutexes above, so the UI never blocks the hook and the hook can send input while it reads them.
+    // The app-specific snapshot is keyed by the lower case application name so that the hook can find the remappings of the foreground process with a hash lookup
+    SnapshotPublisher<SingleKeyRemapSnapshot> singleKeyReMapSnapshot;
+    SnapshotPublisher<ShortcutRemapSnapshot> osLevelShortcutReMapSnapshot;
+    SnapshotPublisher<AppSpecificShortcutRemapSnapshot> appSpecificShortcutReMapSnapshot;
+
+    // State of the keyboard hook, along with the snapshots it is reading
+    RemapHookState hookState;
+
     // Stores the keyboard layout
     LayoutMap keyboardMap;
 
@@ -147,6 +187,12 @@ public:
     // Function to add a new App specific level shortcut remapping
     bool AddAppSpecificShortcut(const std::wstring& app, const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC);
 
+    // Function to replace all the remappings under one lock and publish them to the keyboard hook, each table as one snapshot
+    void ReplaceRemaps(RemapConfiguration&& config);
+
+    // Function to get a copy of all the remappings, so that an editor can replace some of the tables and keep the other ones with ReplaceRemaps
+    RemapConfiguration GetRemaps();
+
     // Function to set the textblock of the detect shortcut UI so that it can be accessed by the hook
     void ConfigureDetectShortcutUI(const winrt::Windows::UI::Xaml::Controls::StackPanel& textBlock1, const winrt::Windows::UI::Xaml::Controls::StackPanel& textBlock2);
 
@@ -210,5 +256,5 @@ public:
     void SetActivatedApp(const std::wstring& appName);
 
     // Gets the activated target application in app-specfic shortcut
-    std::wstring GetActivatedApp();
+    const std::wstring& GetActivatedApp();
 };
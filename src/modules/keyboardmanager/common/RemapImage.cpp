@@ -0,0 +1,223 @@
+#include "pch.h"
+#include "RemapImage.h"
+#include "KeyboardManagerState.h"
+#include <fstream>
+
+namespace
+{
+    // Function to store the key codes of a key or shortcut in a record field
+    void SetRecordKeys(DWORD (&recordKeys)[5], const std::variant<DWORD, Shortcut>& keys)
+    {
+        if (keys.index() == 0)
+        {
+            recordKeys[0] = std::get<DWORD>(keys);
+            return;
+        }
+
+        std::vector<DWORD> keyCodes = std::get<Shortcut>(keys).GetKeyCodes();
+        for (size_t i = 0; i < keyCodes.size() && i < ARRAYSIZE(recordKeys); i++)
+        {
+            recordKeys[i] = keyCodes[i];
+        }
+    }
+
+    // Function to create a shortcut from the key codes of a record field
+    Shortcut GetRecordShortcut(const DWORD (&recordKeys)[5])
+    {
+        Shortcut shortcut;
+        for (DWORD key : recordKeys)
+        {
+            if (key != 0)
+            {
+                shortcut.SetKey(key);
+            }
+        }
+        return shortcut;
+    }
+
+    // Function to get the new key or shortcut of a record
+    std::variant<DWORD, Shortcut> GetRecordTarget(const RemapImageRecord& record)
+    {
+        if (record.isNewKeyShortcut)
+        {
+            return GetRecordShortcut(record.newKeys);
+        }
+        return record.newKeys[0];
+    }
+
+    // Function to create a record from the new key or shortcut
+    RemapImageRecord CreateRecord(const std::variant<DWORD, Shortcut>& newKeys)
+    {
+        RemapImageRecord record = {};
+        SetRecordKeys(record.newKeys, newKeys);
+        record.isNewKeyShortcut = newKeys.index() == 1;
+        return record;
+    }
+}
+
+void RemapImage::AddSingleKeyRemap(DWORD originalKey, const std::variant<DWORD, Shortcut>& newRemapKey)
+{
+    RemapImageRecord record = CreateRecord(newRemapKey);
+    record.originalKeys[0] = originalKey;
+    singleKeyRecords.push_back(record);
+}
+
+void RemapImage::AddOSLevelShortcut(const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC)
+{
+    RemapImageRecord record = CreateRecord(newSC);
+    SetRecordKeys(record.originalKeys, originalSC);
+    osLevelRecords.push_back(record);
+}
+
+void RemapImage::AddAppSpecificShortcut(const std::wstring& app, const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC)
+{
+    RemapImageRecord record = CreateRecord(newSC);
+    SetRecordKeys(record.originalKeys, originalSC);
+
+    // Consecutive shortcuts of the same app share the name in the table
+    if (appSpecificRecords.empty() || appNameTable.compare(appSpecificRecords.back().appNameOffset, appSpecificRecords.back().appNameLength, app) != 0)
+    {
+        record.appNameOffset = (DWORD)appNameTable.length();
+        appNameTable += app;
+    }
+    else
+    {
+        record.appNameOffset = appSpecificRecords.back().appNameOffset;
+    }
+    record.appNameLength = (DWORD)app.length();
+    appSpecificRecords.push_back(record);
+}
+
+void RemapImage::AddConfiguration(const RemapConfiguration& config)
+{
+    for (const auto& it : config.singleKeyReMap)
+    {
+        AddSingleKeyRemap(it.first, it.second);
+    }
+    for (const auto& it : config.osLevelShortcutReMap)
+    {
+        AddOSLevelShortcut(it.first, it.second.targetShortcut);
+    }
+    for (const auto& itApp : config.appSpecificShortcutReMap)
+    {
+        for (const auto& it : itApp.second)
+        {
+            AddAppSpecificShortcut(itApp.first, it.first, it.second.targetShortcut);
+        }
+    }
+}
+
+bool RemapImage::Save(const std::wstring& imagePath, ULONG64 sourceWriteTime, ULONG64 sourceSize) const
+{
+    RemapImageHeader header = {};
+    header.magic = Magic;
+    header.version = Version;
+    header.sourceWriteTime = sourceWriteTime;
+    header.sourceSize = sourceSize;
+    header.singleKeyRemapCount = (DWORD)singleKeyRecords.size();
+    header.osLevelShortcutCount = (DWORD)osLevelRecords.size();
+    header.appSpecificShortcutCount = (DWORD)appSpecificRecords.size();
+    header.appNameTableLength = (DWORD)appNameTable.length();
+
+    // Write to a temporary file which replaces the image, so that a partially written image is never loaded
+    std::wstring tempPath = imagePath + L".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto* records : { &singleKeyRecords, &osLevelRecords, &appSpecificRecords })
+        {
+            file.write(reinterpret_cast<const char*>(records->data()), records->size() * sizeof(RemapImageRecord));
+        }
+        file.write(reinterpret_cast<const char*>(appNameTable.data()), appNameTable.length() * sizeof(wchar_t));
+        if (!file.good())
+        {
+            return false;
+        }
+    }
+
+    return MoveFileEx(tempPath.c_str(), imagePath.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+}
+
+bool RemapImage::GetSourceStamp(const std::wstring& sourcePath, ULONG64& sourceWriteTime, ULONG64& sourceSize)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesEx(sourcePath.c_str(), GetFileExInfoStandard, &attributes))
+    {
+        return false;
+    }
+
+    sourceWriteTime = ((ULONG64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+    sourceSize = ((ULONG64)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+    return true;
+}
+
+bool RemapImage::Load(const std::wstring& imagePath, const std::wstring& sourcePath, RemapConfiguration& config)
+{
+    ULONG64 sourceWriteTime;
+    ULONG64 sourceSize;
+    if (!GetSourceStamp(sourcePath, sourceWriteTime, sourceSize))
+    {
+        return false;
+    }
+
+    HANDLE file = CreateFile(imagePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    bool result = false;
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = nullptr;
+    const BYTE* view = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && (ULONG64)fileSize.QuadPart >= sizeof(RemapImageHeader))
+    {
+        mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+            view = reinterpret_cast<const BYTE*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+
+    if (view)
+    {
+        const RemapImageHeader* header = reinterpret_cast<const RemapImageHeader*>(view);
+        ULONG64 recordCount = (ULONG64)header->singleKeyRemapCount + header->osLevelShortcutCount + header->appSpecificShortcutCount;
+        ULONG64 expectedSize = sizeof(RemapImageHeader) + recordCount * sizeof(RemapImageRecord) + (ULONG64)header->appNameTableLength * sizeof(wchar_t);
+        if (header->magic == Magic && header->version == Version && header->sourceWriteTime == sourceWriteTime && header->sourceSize == sourceSize && expectedSize == (ULONG64)fileSize.QuadPart)
+        {
+            const RemapImageRecord* records = reinterpret_cast<const RemapImageRecord*>(view + sizeof(RemapImageHeader));
+            const wchar_t* appNameTable = reinterpret_cast<const wchar_t*>(records + (size_t)recordCount);
+            result = true;
+
+            const RemapImageRecord* record = records;
+            for (DWORD i = 0; i < header->singleKeyRemapCount; i++, record++)
+            {
+                config.AddSingleKeyRemap(record->originalKeys[0], GetRecordTarget(*record));
+            }
+            for (DWORD i = 0; i < header->osLevelShortcutCount; i++, record++)
+            {
+                config.AddOSLevelShortcut(GetRecordShortcut(record->originalKeys), GetRecordTarget(*record));
+            }
+            for (DWORD i = 0; i < header->appSpecificShortcutCount; i++, record++)
+            {
+                if ((ULONG64)record->appNameOffset + record->appNameLength > header->appNameTableLength)
+                {
+                    result = false;
+                    break;
+                }
+                config.AddAppSpecificShortcut(std::wstring(appNameTable + record->appNameOffset, record->appNameLength), GetRecordShortcut(record->originalKeys), GetRecordTarget(*record));
+            }
+        }
+
+        UnmapViewOfFile(view);
+    }
+
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+
+    return result;
+}
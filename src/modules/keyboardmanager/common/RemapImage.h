@@ -0,0 +1,67 @@
+#pragma once
+#include <variant>
+#include <vector>
+#include "Shortcut.h"
+
+struct RemapConfiguration;
+
+// Header of a compiled remap image. It is followed by the single key remap records, the OS level shortcut records, the app-specific shortcut records and the app name table.
+struct RemapImageHeader
+{
+    DWORD magic;
+    DWORD version;
+
+    // Last write time and size of the configuration file the image was compiled from
+    ULONG64 sourceWriteTime;
+    ULONG64 sourceSize;
+
+    DWORD singleKeyRemapCount;
+    DWORD osLevelShortcutCount;
+    DWORD appSpecificShortcutCount;
+
+    // Number of characters in the app name table
+    DWORD appNameTableLength;
+};
+
+// Fixed size record of a remapping in a compiled remap image
+struct RemapImageRecord
+{
+    // Key codes of the original key or shortcut and of the new key or shortcut, in the order of Shortcut::GetKeyCodes. Unused entries are 0
+    DWORD originalKeys[5];
+    DWORD newKeys[5];
+    DWORD isNewKeyShortcut;
+
+    // Position of the app name in the app name table, for app-specific shortcuts
+    DWORD appNameOffset;
+    DWORD appNameLength;
+};
+
+// Flat binary version of a remap configuration, which is saved next to the JSON configuration file.
+// Loading it memory-maps the file and reads fixed size records, instead of parsing the JSON and the key code strings.
+class RemapImage
+{
+public:
+    static const DWORD Magic = 0x494D524B; // "KRMI"
+    static const DWORD Version = 1;
+
+    // Function to add the remappings to the image
+    void AddSingleKeyRemap(DWORD originalKey, const std::variant<DWORD, Shortcut>& newRemapKey);
+    void AddOSLevelShortcut(const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC);
+    void AddAppSpecificShortcut(const std::wstring& app, const Shortcut& originalSC, const std::variant<DWORD, Shortcut>& newSC);
+    void AddConfiguration(const RemapConfiguration& config);
+
+    // Function to write the image. The last write time and size of the configuration file it was compiled from are stored to detect when the image is out of date
+    bool Save(const std::wstring& imagePath, ULONG64 sourceWriteTime, ULONG64 sourceSize) const;
+
+    // Function to get the last write time and size of a configuration file
+    static bool GetSourceStamp(const std::wstring& sourcePath, ULONG64& sourceWriteTime, ULONG64& sourceSize);
+
+    // Function to load the remappings of an image into config. Returns false if the image is missing, invalid or does not match the configuration file, in which case the configuration file should be parsed instead
+    static bool Load(const std::wstring& imagePath, const std::wstring& sourcePath, RemapConfiguration& config);
+
+private:
+    std::vector<RemapImageRecord> singleKeyRecords;
+    std::vector<RemapImageRecord> osLevelRecords;
+    std::vector<RemapImageRecord> appSpecificRecords;
+    std::wstring appNameTable;
+};
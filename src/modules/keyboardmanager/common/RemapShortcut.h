@@ -2,21 +2,19 @@
 #include "Shortcut.h"
 #include <variant>
 
-// This class stores all the variables associated with each shortcut remapping
+// This class stores all the variables associated with each shortcut remapping. The state of an invoked shortcut is kept by the keyboard hook in a ShortcutInvokeState, so that the remappings can be shared with the hook as immutable snapshots
 class RemapShortcut
 {
 public:
     std::variant<DWORD, Shortcut> targetShortcut;
-    bool isShortcutInvoked;
-    ModifierKey winKeyInvoked;
 
     RemapShortcut(const std::variant<DWORD, Shortcut>& sc) :
-        targetShortcut(sc), isShortcutInvoked(false), winKeyInvoked(ModifierKey::Disabled)
+        targetShortcut(sc)
     {
     }
 
     RemapShortcut() :
-        targetShortcut(Shortcut()), isShortcutInvoked(false), winKeyInvoked(ModifierKey::Disabled)
+        targetShortcut(Shortcut())
     {
     }
 };
@@ -0,0 +1,11 @@
+#include "pch.h"
+#include "RemapSnapshot.h"
+
+// Function to create a snapshot of the remappings. The entries of each action key are kept in the order of sortedKeys
+std::shared_ptr<const ShortcutRemapSnapshot> ShortcutRemapSnapshot::Create(std::map<Shortcut, RemapShortcut> reMap, const std::vector<Shortcut>& sortedKeys)
+{
+    auto snapshot = std::make_shared<ShortcutRemapSnapshot>();
+    snapshot->reMap = std::move(reMap);
+    snapshot->table.Build(snapshot->reMap, sortedKeys);
+    return snapshot;
+}
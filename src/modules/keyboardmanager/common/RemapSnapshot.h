@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <variant>
+#include "Shortcut.h"
+#include "RemapShortcut.h"
+#include "ShortcutRemapTable.h"
+
+// Immutable shortcut remappings along with their lookup table. The table points into the map, so a snapshot cannot be copied.
+struct ShortcutRemapSnapshot
+{
+    std::map<Shortcut, RemapShortcut> reMap;
+    ShortcutRemapTable table;
+
+    ShortcutRemapSnapshot() = default;
+    ShortcutRemapSnapshot(const ShortcutRemapSnapshot&) = delete;
+    ShortcutRemapSnapshot& operator=(const ShortcutRemapSnapshot&) = delete;
+
+    // Function to create a snapshot of the remappings. The entries of each action key are kept in the order of sortedKeys
+    static std::shared_ptr<const ShortcutRemapSnapshot> Create(std::map<Shortcut, RemapShortcut> reMap, const std::vector<Shortcut>& sortedKeys);
+};
+
+// Immutable single key remappings
+using SingleKeyRemapSnapshot = std::unordered_map<DWORD, std::variant<DWORD, Shortcut>>;
+
+// Immutable app-specific shortcut remappings, keyed by the lower case application name. The snapshots of the apps which did not change are shared between successive snapshots
+using AppSpecificShortcutRemapSnapshot = std::unordered_map<std::wstring, std::shared_ptr<const ShortcutRemapSnapshot>>;
+
+// Publishes immutable snapshots from the writers to the keyboard hook.
+// Writers replace the snapshot instead of modifying it, and the hook keeps a reference to the snapshot it read in a SnapshotReader. The hook only takes the publisher lock, for a pointer copy, on the first event after a snapshot is published.
+template<typename T>
+class SnapshotPublisher
+{
+public:
+    SnapshotPublisher() :
+        current(std::make_shared<T>()), generation(1)
+    {
+    }
+
+    // Function to replace the published snapshot
+    void Publish(std::shared_ptr<const T> snapshot)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // The previous snapshot is kept until the next one is published, so that it is usually released here rather than by the hook when it moves to the new snapshot
+        std::shared_ptr<const T> released = std::move(retired);
+        retired = std::move(current);
+        current = std::move(snapshot);
+        generation.fetch_add(1, std::memory_order_release);
+        lock.unlock();
+    }
+
+    // Function to return the published snapshot
+    std::shared_ptr<const T> Get() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return current;
+    }
+
+    // Function to return the published snapshot along with its generation
+    std::shared_ptr<const T> Get(DWORD64& snapshotGeneration) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshotGeneration = generation.load(std::memory_order_relaxed);
+        return current;
+    }
+
+    // Function to return the generation of the published snapshot, which changes whenever a snapshot is published
+    DWORD64 GetGeneration() const
+    {
+        return generation.load(std::memory_order_acquire);
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::shared_ptr<const T> current;
+    std::shared_ptr<const T> retired;
+    std::atomic<DWORD64> generation;
+};
+
+// Reference to the snapshot last read from a SnapshotPublisher. It is owned by the thread which reads it.
+template<typename T>
+class SnapshotReader
+{
+public:
+    // Function to return the latest published snapshot. Reading the same snapshot again only costs an atomic load.
+    // The returned pointer should be copied by callers which can be re-entered, like the keyboard hook when it sends input, since a nested read can move to a newer snapshot.
+    const std::shared_ptr<const T>& Read(const SnapshotPublisher<T>& publisher)
+    {
+        if (publisher.GetGeneration() != readGeneration)
+        {
+            snapshot = publisher.Get(readGeneration);
+        }
+        return snapshot;
+    }
+
+private:
+    std::shared_ptr<const T> snapshot;
+    DWORD64 readGeneration = 0;
+};
@@ -5,6 +5,7 @@
 #include <interface/lowlevel_keyboard_event_data.h>
 #include "Helpers.h"
 #include "InputInterface.h"
+#include "KeyStateTracker.h"
 
 // Constructor to initialize Shortcut from it's virtual key code string representation.
 Shortcut::Shortcut(const std::wstring& shortcutVK) :
@@ -473,7 +474,7 @@ winrt::hstring Shortcut::ToHstringVK() const
 }
 
 // Function to return a vector of key codes in the display order
-std::vector<DWORD> Shortcut::GetKeyCodes()
+std::vector<DWORD> Shortcut::GetKeyCodes() const
 {
     std::vector<DWORD> keys;
     if (winKey != ModifierKey::Disabled)
@@ -509,253 +510,72 @@ void Shortcut::SetKeyCodes(const std::vector<DWORD>& keys)
     }
 }
 
-// Function to check if all the modifiers in the shortcut have been pressed down
-bool Shortcut::CheckModifiersKeyboardState(InputInterface& ii) const
+// Function to return the bits of the key state modifier summary word which have to be set for the modifiers of the shortcut to be pressed
+DWORD Shortcut::GetModifierMask() const
 {
-    // Check the win key state
-    if (winKey == ModifierKey::Both)
-    {
-        // Since VK_WIN does not exist, we check both VK_LWIN and VK_RWIN
-        if ((!(ii.GetVirtualKeyState(VK_LWIN))) && (!(ii.GetVirtualKeyState(VK_RWIN))))
-        {
-            return false;
-        }
-    }
-    else if (winKey == ModifierKey::Left)
-    {
-        if (!(ii.GetVirtualKeyState(VK_LWIN)))
-        {
-            return false;
-        }
-    }
-    else if (winKey == ModifierKey::Right)
-    {
-        if (!(ii.GetVirtualKeyState(VK_RWIN)))
-        {
-            return false;
-        }
-    }
+    // Passing Both returns VK_WIN_BOTH if either win key can be pressed
+    return KeyStateTracker::GetModifierBit(GetWinKey(ModifierKey::Both)) | KeyStateTracker::GetModifierBit(GetCtrlKey()) | KeyStateTracker::GetModifierBit(GetAltKey()) | KeyStateTracker::GetModifierBit(GetShiftKey());
+}
 
-    // Check the ctrl key state
-    if (ctrlKey == ModifierKey::Left)
-    {
-        if (!(ii.GetVirtualKeyState(VK_LCONTROL)))
-        {
-            return false;
-        }
-    }
-    else if (ctrlKey == ModifierKey::Right)
+// Function to return the set of keys which can be pressed down while the shortcut is pressed
+KeyStateTracker::KeyMask Shortcut::GetKeyMask() const
+{
+    KeyStateTracker::KeyMask mask = {};
+    KeyStateTracker::AddKey(mask, actionKey);
+
+    // A modifier set to Both allows both the left and right keys. The generic key code (e.g. VK_CONTROL) is allowed whenever the modifier is part of the shortcut
+    if (winKey == ModifierKey::Left || winKey == ModifierKey::Both)
     {
-        if (!(ii.GetVirtualKeyState(VK_RCONTROL)))
-        {
-            return false;
-        }
+        KeyStateTracker::AddKey(mask, VK_LWIN);
     }
-    else if (ctrlKey == ModifierKey::Both)
+    if (winKey == ModifierKey::Right || winKey == ModifierKey::Both)
     {
-        if (!(ii.GetVirtualKeyState(VK_CONTROL)))
-        {
-            return false;
-        }
+        KeyStateTracker::AddKey(mask, VK_RWIN);
     }
 
-    // Check the alt key state
-    if (altKey == ModifierKey::Left)
+    const struct
     {
-        if (!(ii.GetVirtualKeyState(VK_LMENU)))
-        {
-            return false;
-        }
-    }
-    else if (altKey == ModifierKey::Right)
+        ModifierKey modifier;
+        DWORD leftKey;
+        DWORD rightKey;
+        DWORD genericKey;
+    } modifiers[] = {
+        { ctrlKey, VK_LCONTROL, VK_RCONTROL, VK_CONTROL },
+        { altKey, VK_LMENU, VK_RMENU, VK_MENU },
+        { shiftKey, VK_LSHIFT, VK_RSHIFT, VK_SHIFT },
+    };
+    for (const auto& it : modifiers)
     {
-        if (!(ii.GetVirtualKeyState(VK_RMENU)))
+        if (it.modifier == ModifierKey::Disabled)
         {
-            return false;
-        }
-    }
-    else if (altKey == ModifierKey::Both)
-    {
-        if (!(ii.GetVirtualKeyState(VK_MENU)))
-        {
-            return false;
+            continue;
         }
-    }
 
-    // Check the shift key state
-    if (shiftKey == ModifierKey::Left)
-    {
-        if (!(ii.GetVirtualKeyState(VK_LSHIFT)))
+        KeyStateTracker::AddKey(mask, it.genericKey);
+        if (it.modifier == ModifierKey::Left || it.modifier == ModifierKey::Both)
         {
-            return false;
+            KeyStateTracker::AddKey(mask, it.leftKey);
         }
-    }
-    else if (shiftKey == ModifierKey::Right)
-    {
-        if (!(ii.GetVirtualKeyState(VK_RSHIFT)))
+        if (it.modifier == ModifierKey::Right || it.modifier == ModifierKey::Both)
         {
-            return false;
-        }
-    }
-    else if (shiftKey == ModifierKey::Both)
-    {
-        if (!(ii.GetVirtualKeyState(VK_SHIFT)))
-        {
-            return false;
+            KeyStateTracker::AddKey(mask, it.rightKey);
         }
     }
 
-    return true;
+    return mask;
+}
+
+// Function to check if all the modifiers in the shortcut have been pressed down
+bool Shortcut::CheckModifiersKeyboardState(InputInterface& ii) const
+{
+    return ii.GetKeyStateTracker().AreModifiersDown(GetModifierMask());
 }
 
 // Function to check if any keys are pressed down except those in the shortcut
 bool Shortcut::IsKeyboardStateClearExceptShortcut(InputInterface& ii) const
 {
-    // Iterate through all the virtual key codes - 0xFF is set to key down because of the Num Lock
-    for (int keyVal = 1; keyVal < 0xFF; keyVal++)
-    {
-        // Skip mouse buttons. Keeping this could cause a remapping to fail if a mouse button is also pressed at the same time
-        if (keyVal == VK_LBUTTON || keyVal == VK_RBUTTON || keyVal == VK_MBUTTON || keyVal == VK_XBUTTON1 || keyVal == VK_XBUTTON2)
-        {
-            continue;
-        }
-        // Check state of the key. If the key is pressed down but it is not part of the shortcut then the keyboard state is not clear
-        if (ii.GetVirtualKeyState(keyVal))
-        {
-            // If one of the win keys is pressed check if it is part of the shortcut
-            if (keyVal == VK_LWIN)
-            {
-                if (winKey != ModifierKey::Left && winKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RWIN)
-            {
-                if (winKey != ModifierKey::Right && winKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the ctrl keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LCONTROL)
-            {
-                if (ctrlKey != ModifierKey::Left && ctrlKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RCONTROL)
-            {
-                if (ctrlKey != ModifierKey::Right && ctrlKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_CONTROL)
-            {
-                if (ctrlKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the alt keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LMENU)
-            {
-                if (altKey != ModifierKey::Left && altKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RMENU)
-            {
-                if (altKey != ModifierKey::Right && altKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_MENU)
-            {
-                if (altKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If one of the shift keys is pressed check if it is part of the shortcut
-            else if (keyVal == VK_LSHIFT)
-            {
-                if (shiftKey != ModifierKey::Left && shiftKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_RSHIFT)
-            {
-                if (shiftKey != ModifierKey::Right && shiftKey != ModifierKey::Both)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            else if (keyVal == VK_SHIFT)
-            {
-                if (shiftKey == ModifierKey::Disabled)
-                {
-                    return false;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            // If any other key is pressed check if it is the action key
-            else if (keyVal != actionKey)
-            {
-                return false;
-            }
-        }
-    }
-
-    return true;
+    // Mouse buttons are not taken into account. Keeping them could cause a remapping to fail if a mouse button is also pressed at the same time
+    return ii.GetKeyStateTracker().AreOnlyKeysDown(GetKeyMask());
 }
 
 // Function to get the number of modifiers that are common between the current shortcut and the shortcut in the argument
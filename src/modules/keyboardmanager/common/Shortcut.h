@@ -1,5 +1,6 @@
 #pragma once
 #include "ModifierKey.h"
+#include "KeyStateTracker.h"
 class InputInterface;
 class LayoutMap;
 namespace KeyboardManagerHelper
@@ -146,11 +147,17 @@ public:
     std::vector<winrt::hstring> GetKeyVector(LayoutMap& keyboardMap) const;
 
     // Function to return a vector of key codes in the display order
-    std::vector<DWORD> GetKeyCodes();
+    std::vector<DWORD> GetKeyCodes() const;
 
     // Function to set a shortcut from a vector of key codes
     void SetKeyCodes(const std::vector<DWORD>& keys);
 
+    // Function to return the bits of the key state modifier summary word which have to be set for the modifiers of the shortcut to be pressed
+    DWORD GetModifierMask() const;
+
+    // Function to return the set of keys which can be pressed down while the shortcut is pressed
+    KeyStateTracker::KeyMask GetKeyMask() const;
+
     // Function to check if all the modifiers in the shortcut have been pressed down
     bool CheckModifiersKeyboardState(InputInterface& ii) const;
 
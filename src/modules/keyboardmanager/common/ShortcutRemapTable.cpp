@@ -0,0 +1,115 @@
+#include "pch.h"
+#include "ShortcutRemapTable.h"
+
+// Function to rebuild the table from the remap map. The entries of each action key are kept in the order of sortedKeys
+void ShortcutRemapTable::Build(const std::map<Shortcut, RemapShortcut>& reMap, const std::vector<Shortcut>& sortedKeys)
+{
+    Clear();
+
+    // Count the shortcuts of each action key. Action keys outside the virtual key range can never match a key event
+    std::array<UINT, 256> counts = {};
+    for (const auto& shortcut : sortedKeys)
+    {
+        DWORD actionKey = shortcut.GetActionKey();
+        if (actionKey < counts.size())
+        {
+            counts[actionKey]++;
+        }
+    }
+
+    std::array<UINT, 256> next;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        next[i] = bucketOffsets[i];
+        bucketOffsets[i + 1] = bucketOffsets[i] + counts[i];
+    }
+
+    // Place each shortcut after the ones of the same action key which precede it in sortedKeys
+    entries.resize(bucketOffsets.back());
+    for (const auto& shortcut : sortedKeys)
+    {
+        DWORD actionKey = shortcut.GetActionKey();
+        auto it = reMap.find(shortcut);
+        if (actionKey >= counts.size() || it == reMap.end())
+        {
+            continue;
+        }
+
+        size_t index = next[actionKey]++;
+        entries[index] = { &*it, shortcut.GetModifierMask() };
+    }
+}
+
+// Function to remove all the entries
+void ShortcutRemapTable::Clear()
+{
+    entries.clear();
+    bucketOffsets.fill(0);
+}
+
+// Function to return the number of shortcuts in the table
+size_t ShortcutRemapTable::Size() const
+{
+    return entries.size();
+}
+
+// Function to return the entries whose original shortcut has vkCode as the action key
+ShortcutRemapTable::EntryRange ShortcutRemapTable::GetCandidates(DWORD vkCode) const
+{
+    if (vkCode >= bucketOffsets.size() - 1)
+    {
+        return { nullptr, nullptr };
+    }
+
+    const Entry* data = entries.data();
+    return { data + bucketOffsets[vkCode], data + bucketOffsets[vkCode + 1] };
+}
+
+// Function to return the entry of the invoked shortcut in the table, if any. The state is reset if the shortcut is not remapped to the same target in the table anymore
+ShortcutRemapTable::EntryRange ShortcutInvokeState::GetInvokedEntry(const ShortcutRemapTable& table)
+{
+    if (!isShortcutInvoked)
+    {
+        return { nullptr, nullptr };
+    }
+
+    // The candidates of an action key are only the few shortcuts sharing it, so this is cheaper than keeping an entry pointer in sync with the published tables
+    for (const auto& entry : table.GetCandidates(invokedShortcut.GetActionKey()))
+    {
+        if (entry.remap->first == invokedShortcut && entry.remap->second.targetShortcut == invokedTarget)
+        {
+            return { &entry, &entry + 1 };
+        }
+    }
+
+    ResetInvokedEntry();
+    return { nullptr, nullptr };
+}
+
+// Function to mark the shortcut of the entry as invoked, along with the win key which was pressed when it was invoked
+void ShortcutInvokeState::SetInvokedEntry(const ShortcutRemapTable::Entry& entry, ModifierKey winKey)
+{
+    isShortcutInvoked = true;
+    invokedShortcut = entry.remap->first;
+    invokedTarget = entry.remap->second.targetShortcut;
+    winKeyInvoked = winKey;
+}
+
+// Function to reset the invoked shortcut, if any
+void ShortcutInvokeState::ResetInvokedEntry()
+{
+    isShortcutInvoked = false;
+    winKeyInvoked = ModifierKey::Disabled;
+}
+
+// Function to check if a shortcut is invoked
+bool ShortcutInvokeState::IsShortcutInvoked() const
+{
+    return isShortcutInvoked;
+}
+
+// Function to return the win key which was pressed when the shortcut was invoked
+ModifierKey ShortcutInvokeState::GetWinKeyInvoked() const
+{
+    return winKeyInvoked;
+}
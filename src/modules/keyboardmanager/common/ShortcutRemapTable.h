@@ -0,0 +1,87 @@
+#pragma once
+#include <array>
+#include <map>
+#include <variant>
+#include <vector>
+#include "Shortcut.h"
+#include "RemapShortcut.h"
+
+// Lookup table used by the keyboard hook to find the shortcut remaps which can apply to a key event.
+// The remaps are stored in one flat array grouped by action key, so that a key event only visits the shortcuts whose action key is the pressed key.
+// The table points into the remap map it was built from, so it has to be rebuilt whenever that map changes. It is not modified once built, which allows the hook to read it from a published snapshot without locks.
+class ShortcutRemapTable
+{
+public:
+    // Remap entry with the modifiers of the original shortcut precomputed as a KeyStateTracker modifier mask
+    struct Entry
+    {
+        const std::pair<const Shortcut, RemapShortcut>* remap;
+        DWORD modifierMask;
+    };
+
+    // Range of entries which can be used in a range based for loop
+    struct EntryRange
+    {
+        const Entry* first;
+        const Entry* last;
+
+        const Entry* begin() const
+        {
+            return first;
+        }
+
+        const Entry* end() const
+        {
+            return last;
+        }
+
+        bool empty() const
+        {
+            return first == last;
+        }
+    };
+
+    // Function to rebuild the table from the remap map. The entries of each action key are kept in the order of sortedKeys
+    void Build(const std::map<Shortcut, RemapShortcut>& reMap, const std::vector<Shortcut>& sortedKeys);
+
+    // Function to remove all the entries
+    void Clear();
+
+    // Function to return the number of shortcuts in the table
+    size_t Size() const;
+
+    // Function to return the entries whose original shortcut has vkCode as the action key
+    EntryRange GetCandidates(DWORD vkCode) const;
+
+private:
+    // Entries sorted by action key. The entries of action key vk are in [bucketOffsets[vk], bucketOffsets[vk + 1])
+    std::vector<Entry> entries;
+    std::array<UINT, 257> bucketOffsets = {};
+};
+
+// State of the shortcut remap which is currently invoked in a remap table. Only one shortcut of a table can be invoked at a time.
+// It is owned by the keyboard hook. The invoked shortcut is stored by value rather than as an entry, so the state stays valid when the hook moves to a new snapshot of the table.
+class ShortcutInvokeState
+{
+public:
+    // Function to return the entry of the invoked shortcut in the table, if any. The state is reset if the shortcut is not remapped to the same target in the table anymore
+    ShortcutRemapTable::EntryRange GetInvokedEntry(const ShortcutRemapTable& table);
+
+    // Function to mark the shortcut of the entry as invoked, along with the win key which was pressed when it was invoked
+    void SetInvokedEntry(const ShortcutRemapTable::Entry& entry, ModifierKey winKeyInvoked);
+
+    // Function to reset the invoked shortcut, if any
+    void ResetInvokedEntry();
+
+    // Function to check if a shortcut is invoked
+    bool IsShortcutInvoked() const;
+
+    // Function to return the win key which was pressed when the shortcut was invoked
+    ModifierKey GetWinKeyInvoked() const;
+
+private:
+    bool isShortcutInvoked = false;
+    Shortcut invokedShortcut;
+    std::variant<DWORD, Shortcut> invokedTarget;
+    ModifierKey winKeyInvoked = ModifierKey::Disabled;
+};
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "Input.h"
 #include <keyboardmanager/common/Helpers.h>
+#include <keyboardmanager/common/KeyboardManagerConstants.h>
 
 // Function to simulate input
 UINT Input::SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
@@ -14,8 +15,54 @@ bool Input::GetVirtualKeyState(int key)
     return (GetAsyncKeyState(key) & 0x8000);
 }
 
-// Function to get the foreground process name
-void Input::GetForegroundProcess(_Out_ std::wstring& foregroundProcess)
+// Function to get the state of all the keys as seen by the keyboard hook
+const KeyStateTracker& Input::GetKeyStateTracker()
 {
-    foregroundProcess = KeyboardManagerHelper::GetCurrentApplication(false);
+    return keyStateTracker;
+}
+
+// Function to get the name of the foreground process
+const ProcessName& Input::GetForegroundProcess()
+{
+    // Getting the process name opens the process, so it is only done when the foreground window is different or a foreground change was notified since the last call
+    HWND window = GetForegroundWindow();
+    if (foregroundChanged.exchange(false) || window != foregroundWindow)
+    {
+        foregroundWindow = window;
+        foregroundProcess.Set(KeyboardManagerHelper::GetCurrentApplication(false));
+    }
+
+    return foregroundProcess;
+}
+
+// Function to be called when the foreground window changes so that the foreground process name is resolved again
+void Input::InvalidateForegroundProcess()
+{
+    foregroundChanged = true;
+}
+
+// Function to read the state of all the keys from the system
+void Input::SyncKeyState()
+{
+    for (DWORD key = 1; key < 0xFF; key++)
+    {
+        keyStateTracker.SetKey(key, GetAsyncKeyState(key) & 0x8000);
+    }
+}
+
+// Function to be called by the hook before handling a key event. Reads the key state from the system again if the hook could have missed key events
+void Input::BeginKeyEvent(LowlevelKeyboardEvent* data)
+{
+    // Low level hooks don't get the key events sent to the secure desktop (e.g. the Ctrl+Alt+Del screen or UAC prompts), so the key state can be stale after a pause in the key events
+    if (data->lParam->time - lastKeyEventTime > KeyboardManagerConstants::KeyStateSyncIdleTime)
+    {
+        SyncKeyState();
+    }
+    lastKeyEventTime = data->lParam->time;
+}
+
+// Function to be called by the hook with the key events which are not suppressed
+void Input::UpdateKeyState(LowlevelKeyboardEvent* data)
+{
+    keyStateTracker.ApplyKeyEvent(data->lParam->vkCode, data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN);
 }
@@ -1,10 +1,29 @@
 #pragma once
 #include <keyboardmanager/common/InputInterface.h>
+#include <keyboardmanager/common/KeyStateTracker.h>
+#include <interface/lowlevel_keyboard_event_data.h>
+#include <atomic>
 
 // Class used to wrap keyboard input library methods
 class Input :
     public InputInterface
 {
+private:
+    // State of the keys, updated by the keyboard hook
+    KeyStateTracker keyStateTracker;
+
+    // Time of the last key event seen by the keyboard hook
+    DWORD lastKeyEventTime = 0;
+
+    // Foreground window whose process name is stored in foregroundProcess
+    HWND foregroundWindow = nullptr;
+
+    // Set when the foreground changes, since the process shown in a window can change without the window changing (e.g. UWP apps hosted by ApplicationFrameHost)
+    std::atomic_bool foregroundChanged = true;
+
+    // Name of the foreground process, only resolved again when the foreground changes
+    ProcessName foregroundProcess;
+
 public:
     // Function to simulate input
     UINT SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize);
@@ -12,6 +31,21 @@ public:
     // Function to get the state of a particular key
     bool GetVirtualKeyState(int key);
 
-    // Function to get the foreground process name
-    void GetForegroundProcess(_Out_ std::wstring& foregroundProcess);
+    // Function to get the state of all the keys as seen by the keyboard hook
+    const KeyStateTracker& GetKeyStateTracker();
+
+    // Function to get the name of the foreground process
+    const ProcessName& GetForegroundProcess();
+
+    // Function to be called when the foreground window changes so that the foreground process name is resolved again
+    void InvalidateForegroundProcess();
+
+    // Function to read the state of all the keys from the system
+    void SyncKeyState();
+
+    // Function to be called by the hook before handling a key event. Reads the key state from the system again if the hook could have missed key events
+    void BeginKeyEvent(LowlevelKeyboardEvent* data);
+
+    // Function to be called by the hook with the key events which are not suppressed
+    void UpdateKeyState(LowlevelKeyboardEvent* data);
 };
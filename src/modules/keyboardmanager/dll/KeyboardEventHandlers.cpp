@@ -2,9 +2,13 @@
 #include "KeyboardEventHandlers.h"
 #include "keyboardmanager/common/Shortcut.h"
 #include "keyboardmanager/common/RemapShortcut.h"
+#include "keyboardmanager/common/ShortcutRemapTable.h"
+#include "keyboardmanager/common/RemapSnapshot.h"
 #include "../common/shared_constants.h"
 #include <keyboardmanager/common/KeyboardManagerState.h>
 #include <keyboardmanager/common/InputInterface.h>
+#include <keyboardmanager/common/KeyStateTracker.h>
+#include <keyboardmanager/common/KeyEventBatch.h>
 #include <keyboardmanager/common/Helpers.h>
 
 namespace KeyboardEventHandlers
@@ -15,11 +19,14 @@ namespace KeyboardEventHandlers
         // Check if the key event was generated by KeyboardManager to avoid remapping events generated by us.
         if (!(data->lParam->dwExtraInfo & CommonSharedConstants::KEYBOARDMANAGER_INJECTED_FLAG))
         {
-            // The mutex should be unlocked before SendInput is called to avoid re-entry into the same mutex. More details can be found at https://github.com/microsoft/PowerToys/pull/1789#issuecomment-607555837
-            std::unique_lock<std::mutex> lock(keyboardManagerState.singleKeyReMap_mutex);
-            auto it = keyboardManagerState.singleKeyReMap.find(data->lParam->vkCode);
-            if (it != keyboardManagerState.singleKeyReMap.end())
+            // The remappings are read from the published snapshot, so no lock is held while the input is sent
+            const auto& singleKeyReMap = keyboardManagerState.hookState.singleKeyReMap.Read(keyboardManagerState.singleKeyReMapSnapshot);
+            auto it = singleKeyReMap->find(data->lParam->vkCode);
+            if (it != singleKeyReMap->end())
             {
+                // Sending input can re-enter the hook and move it to a newer snapshot, so the remapping is kept alive until the event is handled
+                std::shared_ptr<const SingleKeyRemapSnapshot> pinnedSnapshot = singleKeyReMap;
+
                 // Check if the remap is to a key or a shortcut
                 bool remapToKey = (it->second.index() == 0);
 
@@ -32,17 +39,7 @@ namespace KeyboardEventHandlers
                     }
                 }
 
-                int key_count;
-                if (remapToKey)
-                {
-                    key_count = 1;
-                }
-                else
-                {
-                    key_count = std::get<Shortcut>(it->second).Size() + 1;
-                }
-                LPINPUT keyEventList = new INPUT[size_t(key_count)]();
-                memset(keyEventList, 0, sizeof(keyEventList));
+                KeyEventBatch keyEventList;
 
                 // Handle remaps to VK_WIN_BOTH
                 DWORD target;
@@ -65,38 +62,31 @@ namespace KeyboardEventHandlers
                 {
                     if (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP)
                     {
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)target, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEventList.AddKeyEvent((WORD)target, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
                     }
                     else
                     {
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)target, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEventList.AddKeyEvent((WORD)target, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
                     }
                 }
                 else
                 {
-                    int i = 0;
                     Shortcut targetShortcut = std::get<Shortcut>(it->second);
                     if (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP)
                     {
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)targetShortcut.GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        i++;
-                        KeyboardManagerHelper::SetModifierKeyEvents(targetShortcut, ModifierKey::Disabled, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        i++;
+                        keyEventList.AddKeyEvent((WORD)targetShortcut.GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEventList.AddModifierKeyEvents(targetShortcut, ModifierKey::Disabled, false, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEventList.AddKeyEvent((WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
                     }
                     else
                     {
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        i++;
-                        KeyboardManagerHelper::SetModifierKeyEvents(targetShortcut, ModifierKey::Disabled, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)targetShortcut.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                        i++;
+                        keyEventList.AddKeyEvent((WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEventList.AddModifierKeyEvents(targetShortcut, ModifierKey::Disabled, true, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                        keyEventList.AddKeyEvent((WORD)targetShortcut.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
                     }
                 }
 
-                lock.unlock();
-                UINT res = ii.SendVirtualInput(key_count, keyEventList, sizeof(INPUT));
-                delete[] keyEventList;
+                keyEventList.Send(ii);
 
                 // If Caps Lock is being remapped to Ctrl/Alt/Shift, then reset the modifier key state to fix issues in certain IME keyboards where the IME shortcut gets invoked since it detects that the modifier and Caps Lock is pressed even though it is suppressed by the hook - More information at the GitHub issue https://github.com/microsoft/PowerToys/issues/3397
                 if (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN)
@@ -107,11 +97,7 @@ namespace KeyboardEventHandlers
                     }
                     else
                     {
-                        std::vector<DWORD> shortcutKeys = std::get<Shortcut>(it->second).GetKeyCodes();
-                        for (auto& itSk : shortcutKeys)
-                        {
-                            ResetIfModifierKeyForLowerLevelKeyHandlers(ii, itSk, it->first);
-                        }
+                        ResetIfModifierKeyForLowerLevelKeyHandlers(ii, std::get<Shortcut>(it->second), it->first);
                     }
                 }
 
@@ -146,15 +132,12 @@ namespace KeyboardEventHandlers
                         return 1;
                     }
                 }
-                int key_count = 2;
-                LPINPUT keyEventList = new INPUT[size_t(key_count)]();
-                memset(keyEventList, 0, sizeof(keyEventList));
-                KeyboardManagerHelper::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)data->lParam->vkCode, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
-                KeyboardManagerHelper::SetKeyEvent(keyEventList, 1, INPUT_KEYBOARD, (WORD)data->lParam->vkCode, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                KeyEventBatch keyEventList;
+                keyEventList.AddKeyEvent((WORD)data->lParam->vkCode, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
+                keyEventList.AddKeyEvent((WORD)data->lParam->vkCode, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SINGLEKEY_FLAG);
 
                 lock.unlock();
-                UINT res = ii.SendVirtualInput(key_count, keyEventList, sizeof(INPUT));
-                delete[] keyEventList;
+                keyEventList.Send(ii);
 
                 // Reset the long press flag when the key has been lifted.
                 if (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP)
@@ -172,40 +155,36 @@ namespace KeyboardEventHandlers
     }
 
     // Function to a handle a shortcut remap
-    __declspec(dllexport) intptr_t HandleShortcutRemapEvent(InputInterface& ii, LowlevelKeyboardEvent* data, std::map<Shortcut, RemapShortcut>& reMap, std::vector<Shortcut>& sortedReMapKeys, std::mutex& map_mutex, KeyboardManagerState& keyboardManagerState, const std::wstring& activatedApp) noexcept
+    __declspec(dllexport) intptr_t HandleShortcutRemapEvent(InputInterface& ii, LowlevelKeyboardEvent* data, const std::shared_ptr<const ShortcutRemapSnapshot>& reMapSnapshot, ShortcutInvokeState& invokeState, KeyboardManagerState& keyboardManagerState, const std::wstring& activatedApp) noexcept
     {
-        // The mutex should be unlocked before SendInput is called to avoid re-entry into the same mutex. More details can be found at https://github.com/microsoft/PowerToys/pull/1789#issuecomment-607555837
-        std::unique_lock<std::mutex> lock(map_mutex);
-
-        // Check if any shortcut is currently in the invoked state
-        bool isShortcutInvoked = false;
-        for (auto& it : reMap)
+        // If a shortcut is currently in the invoked state then only that shortcut can handle the event. Otherwise only the shortcuts with the pressed key as action key can be invoked
+        const ShortcutRemapTable& reMapTable = reMapSnapshot->table;
+        ShortcutRemapTable::EntryRange candidates = invokeState.GetInvokedEntry(reMapTable);
+        bool isShortcutInvoked = !candidates.empty();
+        if (!isShortcutInvoked)
         {
-            if (it.second.isShortcutInvoked)
+            if (data->wParam != WM_KEYDOWN && data->wParam != WM_SYSKEYDOWN)
             {
-                isShortcutInvoked = true;
-                break;
+                return 0;
             }
+
+            candidates = reMapTable.GetCandidates(data->lParam->vkCode);
         }
 
-        // Iterate through the shortcut remaps and apply whichever has been pressed
-        for (auto& itShortcut : sortedReMapKeys)
+        const KeyStateTracker& keyState = ii.GetKeyStateTracker();
+
+        // Iterate through the candidate shortcut remaps and apply whichever has been pressed
+        for (auto& entry : candidates)
         {
-            auto& it = reMap.find(itShortcut);
+            auto it = entry.remap;
 
-            // If a shortcut is currently in the invoked state then skip till the shortcut that is currently invoked
-            if (isShortcutInvoked && !it->second.isShortcutInvoked)
-            {
-                continue;
-            }
             // Check if the remap is to a key or a shortcut
             bool remapToShortcut = (it->second.targetShortcut.index() == 1);
 
             const size_t src_size = it->first.Size();
-            const size_t dest_size = remapToShortcut ? std::get<Shortcut>(it->second.targetShortcut).Size() : 1;
 
             // If the shortcut has been pressed down
-            if (!it->second.isShortcutInvoked && it->first.CheckModifiersKeyboardState(ii))
+            if (!isShortcutInvoked && keyState.AreModifiersDown(entry.modifierMask))
             {
                 if (data->lParam->vkCode == it->first.GetActionKey() && (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN))
                 {
@@ -215,17 +194,19 @@ namespace KeyboardEventHandlers
                         continue;
                     }
 
-                    size_t key_count;
-                    LPINPUT keyEventList;
+                    // Sending input can re-enter the hook and move it to a newer snapshot, so the remappings are kept alive until the event is handled
+                    std::shared_ptr<const ShortcutRemapSnapshot> pinnedSnapshot = reMapSnapshot;
+                    KeyEventBatch keyEventList;
 
                     // Remember which win key was pressed initially
-                    if (ii.GetVirtualKeyState(VK_RWIN))
+                    ModifierKey winKeyInvoked = ModifierKey::Disabled;
+                    if (keyState.IsKeyDown(VK_RWIN))
                     {
-                        it->second.winKeyInvoked = ModifierKey::Right;
+                        winKeyInvoked = ModifierKey::Right;
                     }
-                    else if (ii.GetVirtualKeyState(VK_LWIN))
+                    else if (keyState.IsKeyDown(VK_LWIN))
                     {
-                        it->second.winKeyInvoked = ModifierKey::Left;
+                        winKeyInvoked = ModifierKey::Left;
                     }
 
                     if (remapToShortcut)
@@ -237,63 +218,40 @@ namespace KeyboardEventHandlers
                         if (commonKeys == src_size - 1)
                         {
                             // key down for all new shortcut keys except the common modifiers
-                            key_count = dest_size - commonKeys;
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
-                            int i = 0;
-                            KeyboardManagerHelper::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEventList.AddModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
+                            keyEventList.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
                         else
                         {
                             // Dummy key, key up for all the original shortcut modifier keys and key down for all the new shortcut keys but common keys in each are not repeated
-                            key_count = 1 + (src_size - 1) + (dest_size) - (2 * (size_t)commonKeys);
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
-
                             // Send dummy key
-                            int i = 0;
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEventList.AddKeyEvent((WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                             // Release original shortcut state (release in reverse order of shortcut to be accurate)
-                            KeyboardManagerHelper::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut));
+                            keyEventList.AddModifierKeyEvents(it->first, winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut));
 
                             // Set new shortcut key down state
-                            KeyboardManagerHelper::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEventList.AddModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
+                            keyEventList.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
 
                         // Modifier state reset might be required for this key depending on the shortcut's action and target modifiers - ex: Win+Caps -> Ctrl+A
                         if (it->first.GetCtrlKey() == NULL && it->first.GetAltKey() == NULL && it->first.GetShiftKey() == NULL)
                         {
-                            Shortcut temp = std::get<Shortcut>(it->second.targetShortcut);
-                            for (auto keys : temp.GetKeyCodes())
-                            {
-                                ResetIfModifierKeyForLowerLevelKeyHandlers(ii, keys, data->lParam->vkCode);
-                            }
+                            ResetIfModifierKeyForLowerLevelKeyHandlers(ii, std::get<Shortcut>(it->second.targetShortcut), data->lParam->vkCode);
                         }
                     }
                     else
                     {
                         // Dummy key, key up for all the original shortcut modifier keys and key down for remapped key
-                        key_count = 1 + (src_size - 1) + dest_size;
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
                         // Send dummy key
-                        int i = 0;
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                        i++;
+                        keyEventList.AddKeyEvent((WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                         // Release original shortcut state (release in reverse order of shortcut to be accurate)
-                        KeyboardManagerHelper::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                        keyEventList.AddModifierKeyEvents(it->first, winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                         // Set target key down state
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerHelper::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                        i++;
+                        keyEventList.AddKeyEvent((WORD)KeyboardManagerHelper::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                         // Modifier state reset might be required for this key depending on the shortcut's action and target modifier - ex: Win+Caps -> Ctrl
                         if (it->first.GetCtrlKey() == NULL && it->first.GetAltKey() == NULL && it->first.GetShiftKey() == NULL)
@@ -302,15 +260,13 @@ namespace KeyboardEventHandlers
                         }
                     }
 
-                    it->second.isShortcutInvoked = true;
+                    invokeState.SetInvokedEntry(entry, winKeyInvoked);
                     // If app specific shortcut is invoked, store the target application
                     if (activatedApp != KeyboardManagerConstants::NoActivatedApp)
                     {
                         keyboardManagerState.SetActivatedApp(activatedApp);
                     }
-                    lock.unlock();
-                    UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                    delete[] keyEventList;
+                    keyEventList.Send(ii);
                     return 1;
                 }
             }
@@ -322,8 +278,12 @@ namespace KeyboardEventHandlers
             // 4. The user presses a modifier key in the original shortcut - suppress that key event since the original shortcut is already held down physically (This case can occur only if a user has a duplicated modifier key (possibly by remapping) or if user presses both L/R versions of a modifier remapped with "Both")
             // 5. The user presses any key apart from the action key or a modifier key in the original shortcut - revert the keyboard state to just the original modifiers being held down along with the current key press
             // 6. The user releases any key apart from original modifier or original action key - This can't happen since the key down would have to happen first, which is handled above
-            else if (it->second.isShortcutInvoked)
+            else if (isShortcutInvoked)
             {
+                // Sending input can re-enter the hook and move it to a newer snapshot, so the remappings are kept alive until the event is handled
+                std::shared_ptr<const ShortcutRemapSnapshot> pinnedSnapshot = reMapSnapshot;
+                ModifierKey winKeyInvoked = invokeState.GetWinKeyInvoked();
+
                 // Get the common keys between the two shortcuts
                 int commonKeys = remapToShortcut ? it->first.GetCommonModifiersCount(std::get<Shortcut>(it->second.targetShortcut)) : 0;
 
@@ -331,76 +291,44 @@ namespace KeyboardEventHandlers
                 if ((it->first.CheckWinKey(data->lParam->vkCode) || it->first.CheckCtrlKey(data->lParam->vkCode) || it->first.CheckAltKey(data->lParam->vkCode) || it->first.CheckShiftKey(data->lParam->vkCode)) && (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP))
                 {
                     // Release new shortcut, and set original shortcut keys except the one released
-                    size_t key_count;
-                    LPINPUT keyEventList;
+                    KeyEventBatch keyEventList;
                     if (remapToShortcut)
                     {
-                        // if the released key is present in both shortcuts' modifiers (i.e part of the common modifiers)
-                        if (std::get<Shortcut>(it->second.targetShortcut).CheckWinKey(data->lParam->vkCode) || std::get<Shortcut>(it->second.targetShortcut).CheckCtrlKey(data->lParam->vkCode) || std::get<Shortcut>(it->second.targetShortcut).CheckAltKey(data->lParam->vkCode) || std::get<Shortcut>(it->second.targetShortcut).CheckShiftKey(data->lParam->vkCode))
-                        {
-                            // release all new shortcut keys and the common released modifier except the other common modifiers, and add all original shortcut modifiers except the common ones
-                            key_count = (dest_size - commonKeys) + (src_size - 1 - commonKeys);
-                        }
-                        else
-                        {
-                            // release all new shortcut keys except the common modifiers and add all original shortcut modifiers except the common ones
-                            key_count = (dest_size - 1) + (src_size - 2) - (2 * (size_t)commonKeys);
-                        }
-
                         // If the target shortcut's action key is pressed, then it should be released
                         bool isActionKeyPressed = false;
                         if (GetAsyncKeyState(std::get<Shortcut>(it->second.targetShortcut).GetActionKey()) & 0x8000)
                         {
                             isActionKeyPressed = true;
-                            key_count += 1;
                         }
 
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
                         // Release new shortcut state (release in reverse order of shortcut to be accurate)
-                        int i = 0;
                         if (isActionKeyPressed)
                         {
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEventList.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
-                        KeyboardManagerHelper::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first, data->lParam->vkCode);
+                        keyEventList.AddModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first, data->lParam->vkCode);
 
                         // Set original shortcut key down state except the action key and the released modifier since the original action key may or may not be held down. If it is held down it will generate it's own key message
-                        KeyboardManagerHelper::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut), data->lParam->vkCode);
+                        keyEventList.AddModifierKeyEvents(it->first, winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut), data->lParam->vkCode);
                     }
                     else
                     {
-                        // 1 for releasing new key and original shortcut modifiers except the one released
-                        key_count = dest_size + src_size - 2;
-                        keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
-
                         // Release new key state
-                        int i = 0;
-                        KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerHelper::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                        i++;
+                        keyEventList.AddKeyEvent((WORD)KeyboardManagerHelper::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                         // Set original shortcut key down state except the action key and the released modifier since the original action key may or may not be held down. If it is held down it will generate it's own key message
-                        KeyboardManagerHelper::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, Shortcut(), data->lParam->vkCode);
+                        keyEventList.AddModifierKeyEvents(it->first, winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, Shortcut(), data->lParam->vkCode);
                     }
 
-                    it->second.isShortcutInvoked = false;
-                    it->second.winKeyInvoked = ModifierKey::Disabled;
+                    invokeState.ResetInvokedEntry();
                     // If app specific shortcut has finished invoking, reset the target application
                     if (activatedApp != KeyboardManagerConstants::NoActivatedApp)
                     {
                         keyboardManagerState.SetActivatedApp(KeyboardManagerConstants::NoActivatedApp);
                     }
-                    lock.unlock();
 
-                    // key count can be 0 if both shortcuts have same modifiers and the action key is not held down. delete will throw an error if keyEventList is empty
-                    if (key_count > 0)
-                    {
-                        UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
-                    }
+                    // The batch can be empty if both shortcuts have same modifiers and the action key is not held down, in which case nothing is sent
+                    keyEventList.Send(ii);
                     return 1;
                 }
 
@@ -410,60 +338,42 @@ namespace KeyboardEventHandlers
                     // Case 2: If the original shortcut is still held down the keyboard will get a key down message of the action key in the original shortcut and the new shortcut's modifiers will be held down (keys held down send repeated keydown messages)
                     if (data->lParam->vkCode == it->first.GetActionKey() && (data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN))
                     {
-                        size_t key_count = 1;
-                        LPINPUT keyEventList = new INPUT[key_count]();
-                        memset(keyEventList, 0, sizeof(keyEventList));
+                        KeyEventBatch keyEventList;
                         if (remapToShortcut)
                         {
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                            keyEventList.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
                         else
                         {
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)KeyboardManagerHelper::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                            keyEventList.AddKeyEvent((WORD)KeyboardManagerHelper::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
 
-                        it->second.isShortcutInvoked = true;
-                        lock.unlock();
-                        UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
+                        keyEventList.Send(ii);
                         return 1;
                     }
 
                     // Case 3: If the action key is released from the original shortcut keep modifiers of the new shortcut until some other key event which doesn't apply to the original shortcut
                     if (data->lParam->vkCode == it->first.GetActionKey() && (data->wParam == WM_KEYUP || data->wParam == WM_SYSKEYUP))
                     {
-                        size_t key_count = 1;
-                        LPINPUT keyEventList;
+                        KeyEventBatch keyEventList;
                         if (remapToShortcut)
                         {
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            it->second.isShortcutInvoked = true;
+                            keyEventList.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                         }
 
                         // for remap from shortcut to key, when the action key is released, the remap invoke is completed so revert to original shortcut state
                         else
                         {
-                            // 1 for releasing new key and original shortcut modifiers, and dummy key
-                            key_count = dest_size + src_size;
-                            keyEventList = new INPUT[key_count]();
-                            memset(keyEventList, 0, sizeof(keyEventList));
-
                             // Release new key state
-                            int i = 0;
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerHelper::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEventList.AddKeyEvent((WORD)KeyboardManagerHelper::FilterArtificialKeys(std::get<DWORD>(it->second.targetShortcut)), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                             // Set original shortcut key down state except the action key and the released modifier
-                            KeyboardManagerHelper::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+                            keyEventList.AddModifierKeyEvents(it->first, winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
                             // Send dummy key
-                            KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                            i++;
+                            keyEventList.AddKeyEvent((WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
 
-                            it->second.isShortcutInvoked = false;
-                            it->second.winKeyInvoked = ModifierKey::Disabled;
+                            invokeState.ResetInvokedEntry();
                             // If app specific shortcut has finished invoking, reset the target application
                             if (activatedApp != KeyboardManagerConstants::NoActivatedApp)
                             {
@@ -471,9 +381,7 @@ namespace KeyboardEventHandlers
                             }
                         }
 
-                        lock.unlock();
-                        UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                        delete[] keyEventList;
+                        keyEventList.Send(ii);
                         return 1;
                     }
 
@@ -482,8 +390,6 @@ namespace KeyboardEventHandlers
                     {
                         if (remapToShortcut)
                         {
-                            it->second.isShortcutInvoked = true;
-
                             // Modifier state reset might be required for this key depending on the target shortcut action key - ex: Ctrl+A -> Win+Caps
                             if (std::get<Shortcut>(it->second.targetShortcut).GetCtrlKey() == NULL && std::get<Shortcut>(it->second.targetShortcut).GetAltKey() == NULL && std::get<Shortcut>(it->second.targetShortcut).GetShiftKey() == NULL)
                             {
@@ -504,102 +410,77 @@ namespace KeyboardEventHandlers
                                 ResetIfModifierKeyForLowerLevelKeyHandlers(ii, data->lParam->vkCode, std::get<Shortcut>(it->second.targetShortcut).GetActionKey());
                             }
 
-                            size_t key_count;
-                            LPINPUT keyEventList;
+                            KeyEventBatch keyEventList;
 
                             // If the original shortcut is a subset of the new shortcut
                             if (commonKeys == src_size - 1)
                             {
-                                key_count = dest_size - commonKeys + 1;
-
                                 // If the target shortcut's action key is pressed, then it should be released and original shortcut's action key should be set
                                 bool isActionKeyPressed = false;
                                 if (GetAsyncKeyState(std::get<Shortcut>(it->second.targetShortcut).GetActionKey()) & 0x8000)
                                 {
                                     isActionKeyPressed = true;
-                                    key_count += 2;
                                 }
 
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-
-                                int i = 0;
                                 if (isActionKeyPressed)
                                 {
-                                    KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
+                                    keyEventList.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
-                                KeyboardManagerHelper::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
+                                keyEventList.AddModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
 
                                 // key down for original shortcut action key with shortcut flag so that we don't invoke the same shortcut remap again
                                 if (isActionKeyPressed)
                                 {
-                                    KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
+                                    keyEventList.AddKeyEvent((WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
 
                                 // Send current key pressed without shortcut flag so that it can be reprocessed in case the physical keys pressed are a different remapped shortcut
-                                KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)data->lParam->vkCode, 0, 0);
-                                i++;
+                                keyEventList.AddKeyEvent((WORD)data->lParam->vkCode, 0, 0);
 
                                 // Send dummy key since the current key pressed could be a modifier
-                                KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                i++;
+                                keyEventList.AddKeyEvent((WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                             }
                             else
                             {
                                 // Key up for all new shortcut keys, key down for original shortcut modifiers, dummy key and current key press but common keys aren't repeated
-                                key_count = (dest_size) + (src_size - 1) + 1 - (2 * (size_t)commonKeys);
 
                                 // If the target shortcut's action key is pressed, then it should be released and original shortcut's action key should be set
                                 bool isActionKeyPressed = false;
                                 if (GetAsyncKeyState(std::get<Shortcut>(it->second.targetShortcut).GetActionKey()) & 0x8000)
                                 {
                                     isActionKeyPressed = true;
-                                    key_count += 2;
                                 }
 
-                                keyEventList = new INPUT[key_count]();
-                                memset(keyEventList, 0, sizeof(keyEventList));
-
                                 // Release new shortcut state (release in reverse order of shortcut to be accurate)
-                                int i = 0;
                                 if (isActionKeyPressed)
                                 {
-                                    KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
+                                    keyEventList.AddKeyEvent((WORD)std::get<Shortcut>(it->second.targetShortcut).GetActionKey(), KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
-                                KeyboardManagerHelper::SetModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), it->second.winKeyInvoked, keyEventList, i, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
+                                keyEventList.AddModifierKeyEvents(std::get<Shortcut>(it->second.targetShortcut), winKeyInvoked, false, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, it->first);
 
                                 // Set old shortcut key down state
-                                KeyboardManagerHelper::SetModifierKeyEvents(it->first, it->second.winKeyInvoked, keyEventList, i, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut));
+                                keyEventList.AddModifierKeyEvents(it->first, winKeyInvoked, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, std::get<Shortcut>(it->second.targetShortcut));
 
                                 // key down for original shortcut action key with shortcut flag so that we don't invoke the same shortcut remap again
                                 if (isActionKeyPressed)
                                 {
-                                    KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                    i++;
+                                    keyEventList.AddKeyEvent((WORD)it->first.GetActionKey(), 0, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                                 }
 
                                 // Send current key pressed without shortcut flag so that it can be reprocessed in case the physical keys pressed are a different remapped shortcut
-                                KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)data->lParam->vkCode, 0, 0);
-                                i++;
+                                keyEventList.AddKeyEvent((WORD)data->lParam->vkCode, 0, 0);
 
                                 // Send dummy key
-                                KeyboardManagerHelper::SetKeyEvent(keyEventList, i, INPUT_KEYBOARD, (WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
-                                i++;
+                                keyEventList.AddKeyEvent((WORD)KeyboardManagerConstants::DUMMY_KEY, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
                             }
 
-                            it->second.isShortcutInvoked = false;
-                            it->second.winKeyInvoked = ModifierKey::Disabled;
+                            invokeState.ResetInvokedEntry();
                             // If app specific shortcut has finished invoking, reset the target application
                             if (activatedApp != KeyboardManagerConstants::NoActivatedApp)
                             {
                                 keyboardManagerState.SetActivatedApp(KeyboardManagerConstants::NoActivatedApp);
                             }
-                            lock.unlock();
-                            UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                            delete[] keyEventList;
+                            keyEventList.Send(ii);
                             return 1;
                         }
                     }
@@ -618,7 +499,8 @@ namespace KeyboardEventHandlers
         // Check if the key event was generated by KeyboardManager to avoid remapping events generated by us.
         if (data->lParam->dwExtraInfo != KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG)
         {
-            bool result = HandleShortcutRemapEvent(ii, data, keyboardManagerState.osLevelShortcutReMap, keyboardManagerState.osLevelShortcutReMapSortedKeys, keyboardManagerState.osLevelShortcutReMap_mutex, keyboardManagerState);
+            const auto& reMapSnapshot = keyboardManagerState.hookState.osLevelShortcutReMap.Read(keyboardManagerState.osLevelShortcutReMapSnapshot);
+            bool result = HandleShortcutRemapEvent(ii, data, reMapSnapshot, keyboardManagerState.hookState.osLevelShortcutInvokeState, keyboardManagerState);
             return result;
         }
 
@@ -631,52 +513,38 @@ namespace KeyboardEventHandlers
         // Check if the key event was generated by KeyboardManager to avoid remapping events generated by us.
         if (data->lParam->dwExtraInfo != KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG)
         {
-            std::wstring process_name;
-
-            // Allocate MAX_PATH amount of memory
-            process_name.resize(MAX_PATH);
-            ii.GetForegroundProcess(process_name);
-
-            // Remove elements after null character
-            process_name.erase(std::find(process_name.begin(), process_name.end(), L'\0'), process_name.end());
-
-            if (process_name.empty())
+            // The name of the foreground process is cached until the foreground changes, so this doesn't allocate or query the process on every key event
+            const ProcessName& process = ii.GetForegroundProcess();
+            if (process.name.empty())
             {
                 return 0;
             }
 
-            // Convert process name to lower case
-            std::transform(process_name.begin(), process_name.end(), process_name.begin(), towlower);
-
-            std::unique_lock<std::mutex> lock(keyboardManagerState.appSpecificShortcutReMap_mutex);
-            std::wstring query_string;
+            const auto& reMapSnapshots = keyboardManagerState.hookState.appSpecificShortcutReMap.Read(keyboardManagerState.appSpecificShortcutReMapSnapshot);
+            AppSpecificShortcutRemapSnapshot::const_iterator it;
 
-            std::map<std::wstring, std::map<Shortcut, RemapShortcut>>::iterator it;
             // Check if an app-specific shortcut is already activated
-            if (keyboardManagerState.GetActivatedApp() == KeyboardManagerConstants::NoActivatedApp)
+            const std::wstring& activatedApp = keyboardManagerState.GetActivatedApp();
+            if (activatedApp == KeyboardManagerConstants::NoActivatedApp)
             {
-                query_string = process_name;
-                it = keyboardManagerState.appSpecificShortcutReMap.find(query_string);
+                it = reMapSnapshots->find(process.name);
 
                 // If no entry is found, search for the process name without it's file extension
-                if (it == keyboardManagerState.appSpecificShortcutReMap.end())
+                if (it == reMapSnapshots->end())
                 {
-                    // Find index of the file extension
-                    size_t extensionIndex = process_name.find_last_of(L".");
-                    query_string = process_name.substr(0, extensionIndex);
-                    it = keyboardManagerState.appSpecificShortcutReMap.find(query_string);
+                    it = reMapSnapshots->find(process.nameWithoutExtension);
                 }
             }
             else
             {
-                query_string = keyboardManagerState.GetActivatedApp();
-                it = keyboardManagerState.appSpecificShortcutReMap.find(query_string);
+                it = reMapSnapshots->find(activatedApp);
             }
 
-            if (it != keyboardManagerState.appSpecificShortcutReMap.end())
+            if (it != reMapSnapshots->end())
             {
-                lock.unlock();
-                bool result = HandleShortcutRemapEvent(ii, data, keyboardManagerState.appSpecificShortcutReMap[query_string], keyboardManagerState.appSpecificShortcutReMapSortedKeys[query_string], keyboardManagerState.appSpecificShortcutReMap_mutex, keyboardManagerState, query_string);
+                // The app name is used after input is sent, which can re-enter the hook and move it to a newer snapshot
+                std::shared_ptr<const AppSpecificShortcutRemapSnapshot> pinnedSnapshots = reMapSnapshots;
+                bool result = HandleShortcutRemapEvent(ii, data, it->second, keyboardManagerState.hookState.appSpecificShortcutInvokeState, keyboardManagerState, it->first);
                 return result;
             }
         }
@@ -684,20 +552,84 @@ namespace KeyboardEventHandlers
         return 0;
     }
 
+    // Function to handle a keyboard hook event by running the remap handlers in order of priority. This is the starting point function for remapping
+    __declspec(dllexport) intptr_t HandleKeyboardHookEvent(InputInterface& ii, LowlevelKeyboardEvent* data, KeyboardManagerState& keyboardManagerState) noexcept
+    {
+        // If key has suppress flag, then suppress it
+        if (data->lParam->dwExtraInfo == KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG)
+        {
+            return 1;
+        }
+
+        // If the Detect Key Window is currently activated, then suppress the keyboard event
+        KeyboardManagerHelper::KeyboardHookDecision singleKeyRemapUIDetected = keyboardManagerState.DetectSingleRemapKeyUIBackend(data);
+        if (singleKeyRemapUIDetected == KeyboardManagerHelper::KeyboardHookDecision::Suppress)
+        {
+            return 1;
+        }
+        else if (singleKeyRemapUIDetected == KeyboardManagerHelper::KeyboardHookDecision::SkipHook)
+        {
+            return 0;
+        }
+
+        // If the Detect Shortcut Window from Remap Keys is currently activated, then suppress the keyboard event
+        KeyboardManagerHelper::KeyboardHookDecision remapKeyShortcutUIDetected = keyboardManagerState.DetectShortcutUIBackend(data, true);
+        if (remapKeyShortcutUIDetected == KeyboardManagerHelper::KeyboardHookDecision::Suppress)
+        {
+            return 1;
+        }
+        else if (remapKeyShortcutUIDetected == KeyboardManagerHelper::KeyboardHookDecision::SkipHook)
+        {
+            return 0;
+        }
+
+        // Remap a key
+        intptr_t SingleKeyRemapResult = HandleSingleKeyRemapEvent(ii, data, keyboardManagerState);
+
+        // Single key remaps have priority. If a key is remapped, only the remapped version should be visible to the shortcuts and hence the event should be suppressed here.
+        if (SingleKeyRemapResult == 1)
+        {
+            return 1;
+        }
+
+        // If the Detect Shortcut Window is currently activated, then suppress the keyboard event
+        KeyboardManagerHelper::KeyboardHookDecision shortcutUIDetected = keyboardManagerState.DetectShortcutUIBackend(data, false);
+        if (shortcutUIDetected == KeyboardManagerHelper::KeyboardHookDecision::Suppress)
+        {
+            return 1;
+        }
+        else if (shortcutUIDetected == KeyboardManagerHelper::KeyboardHookDecision::SkipHook)
+        {
+            return 0;
+        }
+
+        //// Remap a key to behave like a modifier instead of a toggle
+        //intptr_t SingleKeyToggleToModResult = HandleSingleKeyToggleToModEvent(ii, data, keyboardManagerState);
+
+        // Handle an app-specific shortcut remapping
+        intptr_t AppSpecificShortcutRemapResult = HandleAppSpecificShortcutRemapEvent(ii, data, keyboardManagerState);
+
+        // If an app-specific shortcut is remapped then the os-level shortcut remapping should be suppressed.
+        if (AppSpecificShortcutRemapResult == 1)
+        {
+            return 1;
+        }
+
+        // Handle an os-level shortcut remapping
+        return HandleOSLevelShortcutRemapEvent(ii, data, keyboardManagerState);
+    }
+
     // Function to ensure Num Lock state does not change when it is suppressed by the low level hook
     void SetNumLockToPreviousState(InputInterface& ii)
     {
         // Num Lock's key state is applied before it is intercepted by low level keyboard hooks, so we have to manually set back the state when we suppress the key. This is done by sending an additional key up, key down set of messages.
         // We need 2 key events because after Num Lock is suppressed, key up to release num lock key and key down to revert the num lock state
-        int key_count = 2;
-        LPINPUT keyEventList = new INPUT[size_t(key_count)]();
-        memset(keyEventList, 0, sizeof(keyEventList));
+        KeyEventBatch keyEventList;
 
         // Use the suppress flag to ensure these are not intercepted by any remapped keys or shortcuts
-        KeyboardManagerHelper::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, VK_NUMLOCK, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
-        KeyboardManagerHelper::SetKeyEvent(keyEventList, 1, INPUT_KEYBOARD, VK_NUMLOCK, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
-        UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-        delete[] keyEventList;
+        keyEventList.AddKeyEvent(VK_NUMLOCK, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
+        keyEventList.AddKeyEvent(VK_NUMLOCK, 0, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
+        keyEventList.Send(ii);
     }
 
     // Function to ensure Ctrl/Shift/Alt modifier key state is not detected as pressed down by applications which detect keys at a lower level than hooks when it is remapped for scenarios where its required
@@ -709,14 +641,24 @@ namespace KeyboardEventHandlers
             // If the argument is either of the Ctrl/Shift/Alt modifier key codes
             if (KeyboardManagerHelper::IsModifierKey(key) && !(key == VK_LWIN || key == VK_RWIN || key == CommonSharedConstants::VK_WIN_BOTH))
             {
-                int key_count = 1;
-                LPINPUT keyEventList = new INPUT[size_t(key_count)]();
-                memset(keyEventList, 0, sizeof(keyEventList));
+                KeyEventBatch keyEventList;
 
                 // Use the suppress flag to ensure these are not intercepted by any remapped keys or shortcuts
-                KeyboardManagerHelper::SetKeyEvent(keyEventList, 0, INPUT_KEYBOARD, (WORD)key, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
-                UINT res = ii.SendVirtualInput((UINT)key_count, keyEventList, sizeof(INPUT));
-                delete[] keyEventList;
+                keyEventList.AddKeyEvent((WORD)key, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG);
+                keyEventList.Send(ii);
+            }
+        }
+    }
+
+    // Function to reset the state of each Ctrl/Shift/Alt modifier key of a shortcut for lower level key handlers, in the order of Shortcut::GetKeyCodes
+    void ResetIfModifierKeyForLowerLevelKeyHandlers(InputInterface& ii, const Shortcut& shortcut, DWORD target)
+    {
+        // The keys are checked one by one instead of calling GetKeyCodes, which allocates a vector on every key event
+        for (DWORD key : { shortcut.GetCtrlKey(), shortcut.GetAltKey(), shortcut.GetShiftKey(), shortcut.GetActionKey() })
+        {
+            if (key != NULL)
+            {
+                ResetIfModifierKeyForLowerLevelKeyHandlers(ii, key, target);
             }
         }
     }
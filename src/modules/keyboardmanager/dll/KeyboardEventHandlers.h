@@ -1,13 +1,15 @@
 #pragma once
 #include <interface/lowlevel_keyboard_event_data.h>
 #include <map>
-#include <mutex>
+#include <memory>
 #include "keyboardmanager/common/KeyboardManagerConstants.h"
 
 class InputInterface;
 class KeyboardManagerState;
 class Shortcut;
 class RemapShortcut;
+class ShortcutInvokeState;
+struct ShortcutRemapSnapshot;
 
 namespace KeyboardEventHandlers
 {
@@ -17,8 +19,8 @@ namespace KeyboardEventHandlers
     // Function to a change a key's behavior from toggle to modifier
     __declspec(dllexport) intptr_t HandleSingleKeyToggleToModEvent(InputInterface& ii, LowlevelKeyboardEvent* data, KeyboardManagerState& keyboardManagerState) noexcept;
 
-    // Function to a handle a shortcut remap
-    __declspec(dllexport) intptr_t HandleShortcutRemapEvent(InputInterface& ii, LowlevelKeyboardEvent* data, std::map<Shortcut, RemapShortcut>& reMap, std::vector<Shortcut>& sortedReMapKeys, std::mutex& map_mutex, KeyboardManagerState& keyboardManagerState, const std::wstring& activatedApp = KeyboardManagerConstants::NoActivatedApp) noexcept;
+    // Function to a handle a shortcut remap. The remappings are read from a snapshot, and the invoked shortcut is tracked in invokeState
+    __declspec(dllexport) intptr_t HandleShortcutRemapEvent(InputInterface& ii, LowlevelKeyboardEvent* data, const std::shared_ptr<const ShortcutRemapSnapshot>& reMapSnapshot, ShortcutInvokeState& invokeState, KeyboardManagerState& keyboardManagerState, const std::wstring& activatedApp = KeyboardManagerConstants::NoActivatedApp) noexcept;
 
     // Function to a handle an os-level shortcut remap
     __declspec(dllexport) intptr_t HandleOSLevelShortcutRemapEvent(InputInterface& ii, LowlevelKeyboardEvent* data, KeyboardManagerState& keyboardManagerState) noexcept;
@@ -26,9 +28,15 @@ namespace KeyboardEventHandlers
     // Function to a handle an app-specific shortcut remap
     __declspec(dllexport) intptr_t HandleAppSpecificShortcutRemapEvent(InputInterface& ii, LowlevelKeyboardEvent* data, KeyboardManagerState& keyboardManagerState) noexcept;
 
+    // Function to handle a keyboard hook event by running the remap handlers in order of priority. This is the starting point function for remapping
+    __declspec(dllexport) intptr_t HandleKeyboardHookEvent(InputInterface& ii, LowlevelKeyboardEvent* data, KeyboardManagerState& keyboardManagerState) noexcept;
+
     // Function to ensure Num Lock state does not change when it is suppressed by the low level hook
     void SetNumLockToPreviousState(InputInterface& ii);
 
     // Function to ensure Ctrl/Shift/Alt modifier key state is not detected as pressed down by applications which detect keys at a lower level than hooks when it is remapped for scenarios where its required
     void ResetIfModifierKeyForLowerLevelKeyHandlers(InputInterface& ii, DWORD key, DWORD target);
+
+    // Function to reset the state of each Ctrl/Shift/Alt modifier key of a shortcut for lower level key handlers, in the order of Shortcut::GetKeyCodes
+    void ResetIfModifierKeyForLowerLevelKeyHandlers(InputInterface& ii, const Shortcut& shortcut, DWORD target);
 };
@@ -10,6 +10,7 @@
 #include <keyboardmanager/common/KeyboardManagerState.h>
 #include <keyboardmanager/common/Shortcut.h>
 #include <keyboardmanager/common/RemapShortcut.h>
+#include <keyboardmanager/common/RemapImage.h>
 #include <keyboardmanager/common/KeyboardManagerConstants.h>
 #include <common/settings_helpers.h>
 #include <common/debug_control.h>
@@ -53,6 +54,9 @@ private:
     // Required for Unhook in old versions of Windows
     static HHOOK hook_handle_copy;
 
+    // Event hook handle used to be notified when the foreground window changes
+    static HWINEVENTHOOK foreground_hook_handle;
+
     // Static pointer to the current keyboardmanager object required for accessing the HandleKeyboardHookEvent function in the hook procedure (Only global or static variables can be accessed in a hook procedure CALLBACK)
     static KeyboardManager* keyboardmanager_object_ptr;
 
@@ -85,8 +89,27 @@ public:
             if (current_config)
             {
                 keyboardManagerState.SetCurrentConfigName(*current_config);
-                // Read the config file and load the remaps.
-                auto configFile = json::from_file(PTSettingsHelper::get_module_save_folder_location(KeyboardManagerConstants::ModuleName) + L"\\" + *current_config + L".json");
+                std::wstring configFolder = PTSettingsHelper::get_module_save_folder_location(KeyboardManagerConstants::ModuleName);
+                std::wstring configPath = configFolder + L"\\" + *current_config + L".json";
+                std::wstring imagePath = configFolder + L"\\" + *current_config + KeyboardManagerConstants::RemapImageFileExtension;
+
+                // Load the compiled remap image if it is up to date with the config file, otherwise read the config file and load the remaps.
+                RemapConfiguration config;
+                bool imageLoaded = RemapImage::Load(imagePath, configPath, config);
+                std::optional<json::JsonObject> configFile;
+                ULONG64 sourceWriteTime = 0;
+                ULONG64 sourceSize = 0;
+                bool hasSourceStamp = false;
+                if (!imageLoaded)
+                {
+                    // The image could have been partially loaded
+                    config = RemapConfiguration();
+
+                    // The stamp is read before the file so that the image is rejected if the file changes in between
+                    hasSourceStamp = RemapImage::GetSourceStamp(configPath, sourceWriteTime, sourceSize);
+                    configFile = json::from_file(configPath);
+                }
+
                 if (configFile)
                 {
                     auto jsonData = *configFile;
@@ -95,7 +118,6 @@ public:
                     try
                     {
                         auto remapKeysData = jsonData.GetNamedObject(KeyboardManagerConstants::RemapKeysSettingName);
-                        keyboardManagerState.ClearSingleKeyRemaps();
 
                         if (remapKeysData)
                         {
@@ -110,13 +132,13 @@ public:
                                     // If remapped to a shortcut
                                     if (std::wstring(newRemapKey).find(L";") != std::string::npos)
                                     {
-                                        keyboardManagerState.AddSingleKeyRemap(std::stoul(originalKey.c_str()), Shortcut(newRemapKey.c_str()));
+                                        config.AddSingleKeyRemap(std::stoul(originalKey.c_str()), Shortcut(newRemapKey.c_str()));
                                     }
 
                                     // If remapped to a key
                                     else
                                     {
-                                        keyboardManagerState.AddSingleKeyRemap(std::stoul(originalKey.c_str()), std::stoul(newRemapKey.c_str()));
+                                        config.AddSingleKeyRemap(std::stoul(originalKey.c_str()), std::stoul(newRemapKey.c_str()));
                                     }
                                 }
                                 catch (...)
@@ -135,8 +157,6 @@ public:
                     try
                     {
                         auto remapShortcutsData = jsonData.GetNamedObject(KeyboardManagerConstants::RemapShortcutsSettingName);
-                        keyboardManagerState.ClearOSLevelShortcuts();
-                        keyboardManagerState.ClearAppSpecificShortcuts();
                         if (remapShortcutsData)
                         {
                             // Load os level shortcut remaps
@@ -153,13 +173,13 @@ public:
                                         // If remapped to a shortcut
                                         if (std::wstring(newRemapKeys).find(L";") != std::string::npos)
                                         {
-                                            keyboardManagerState.AddOSLevelShortcut(Shortcut(originalKeys.c_str()), Shortcut(newRemapKeys.c_str()));
+                                            config.AddOSLevelShortcut(Shortcut(originalKeys.c_str()), Shortcut(newRemapKeys.c_str()));
                                         }
 
                                         // If remapped to a key
                                         else
                                         {
-                                            keyboardManagerState.AddOSLevelShortcut(Shortcut(originalKeys.c_str()), std::stoul(newRemapKeys.c_str()));
+                                            config.AddOSLevelShortcut(Shortcut(originalKeys.c_str()), std::stoul(newRemapKeys.c_str()));
                                         }
                                     }
                                     catch (...)
@@ -188,13 +208,13 @@ public:
                                         // If remapped to a shortcut
                                         if (std::wstring(newRemapKeys).find(L";") != std::string::npos)
                                         {
-                                            keyboardManagerState.AddAppSpecificShortcut(targetApp.c_str(), Shortcut(originalKeys.c_str()), Shortcut(newRemapKeys.c_str()));
+                                            config.AddAppSpecificShortcut(targetApp.c_str(), Shortcut(originalKeys.c_str()), Shortcut(newRemapKeys.c_str()));
                                         }
 
                                         // If remapped to a key
                                         else
                                         {
-                                            keyboardManagerState.AddAppSpecificShortcut(targetApp.c_str(), Shortcut(originalKeys.c_str()), std::stoul(newRemapKeys.c_str()));
+                                            config.AddAppSpecificShortcut(targetApp.c_str(), Shortcut(originalKeys.c_str()), std::stoul(newRemapKeys.c_str()));
                                         }
                                     }
                                     catch (...)
@@ -213,6 +233,20 @@ public:
                     {
                         // Improper JSON format for shortcut remaps. Skip to next remap type
                     }
+
+                    // Compile the remaps so that the next launch does not have to parse the config file. The image is only a cache, so failures are ignored
+                    if (hasSourceStamp)
+                    {
+                        RemapImage image;
+                        image.AddConfiguration(config);
+                        image.Save(imagePath, sourceWriteTime, sourceSize);
+                    }
+                }
+
+                // Replace the remaps only once the whole configuration is loaded. Each remap table is published to the hook as one snapshot, so the hook never reads a partially loaded table
+                if (imageLoaded || configFile)
+                {
+                    keyboardManagerState.ReplaceRemaps(std::move(config));
                 }
             }
         }
@@ -345,6 +379,12 @@ public:
         return 0;
     }
 
+    // Handle the events signaled by the runner by id, so that the runner doesn't convert the ids to names for every keystroke
+    virtual intptr_t signal_event(PowertoyEventId event, intptr_t data) override
+    {
+        return 0;
+    }
+
     virtual void register_system_menu_helper(PowertoySystemMenuIface* helper) override {}
 
     virtual void signal_system_menu_action(const wchar_t* name) override {}
@@ -357,6 +397,7 @@ public:
         {
             event.lParam = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
             event.wParam = wParam;
+            keyboardmanager_object_ptr->inputHandler.BeginKeyEvent(&event);
             if (keyboardmanager_object_ptr->HandleKeyboardHookEvent(&event) == 1)
             {
                 // Reset Num Lock whenever a NumLock key down event is suppressed since Num Lock key state change occurs before it is intercepted by low level hooks
@@ -366,10 +407,19 @@ public:
                 }
                 return 1;
             }
+
+            // The key state only changes for the events which are not suppressed
+            keyboardmanager_object_ptr->inputHandler.UpdateKeyState(&event);
         }
         return CallNextHookEx(hook_handle_copy, nCode, wParam, lParam);
     }
 
+    // Event hook procedure called when the foreground window changes
+    static void CALLBACK foreground_hook_proc(HWINEVENTHOOK winEventHook, DWORD event, HWND window, LONG object, LONG child, DWORD eventThread, DWORD eventTime)
+    {
+        keyboardmanager_object_ptr->inputHandler.InvalidateForegroundProcess();
+    }
+
     void start_lowlevel_keyboard_hook()
     {
 #if defined(DISABLE_LOWLEVEL_HOOKS_WHEN_DEBUGGED)
@@ -381,6 +431,8 @@ public:
 
         if (!hook_handle)
         {
+            // Keys could have been pressed or released while the hook was not running
+            inputHandler.SyncKeyState();
             hook_handle = SetWindowsHookEx(WH_KEYBOARD_LL, hook_proc, GetModuleHandle(NULL), NULL);
             hook_handle_copy = hook_handle;
             if (!hook_handle)
@@ -388,6 +440,13 @@ public:
                 throw std::runtime_error("Cannot install keyboard listener");
             }
         }
+
+        // The event hook is installed on the same thread as the keyboard hook and also receives the events of the runner windows, unlike win_hook_event
+        if (!foreground_hook_handle)
+        {
+            inputHandler.InvalidateForegroundProcess();
+            foreground_hook_handle = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, foreground_hook_proc, 0, 0, WINEVENT_OUTOFCONTEXT);
+        }
     }
 
     // Function to terminate the low level hook
@@ -398,78 +457,24 @@ public:
             UnhookWindowsHookEx(hook_handle);
             hook_handle = nullptr;
         }
+
+        if (foreground_hook_handle)
+        {
+            UnhookWinEvent(foreground_hook_handle);
+            foreground_hook_handle = nullptr;
+        }
     }
 
     // Function called by the hook procedure to handle the events. This is the starting point function for remapping
     intptr_t HandleKeyboardHookEvent(LowlevelKeyboardEvent* data) noexcept
     {
-        // If key has suppress flag, then suppress it
-        if (data->lParam->dwExtraInfo == KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG)
-        {
-            return 1;
-        }
-
-        // If the Detect Key Window is currently activated, then suppress the keyboard event
-        KeyboardManagerHelper::KeyboardHookDecision singleKeyRemapUIDetected = keyboardManagerState.DetectSingleRemapKeyUIBackend(data);
-        if (singleKeyRemapUIDetected == KeyboardManagerHelper::KeyboardHookDecision::Suppress)
-        {
-            return 1;
-        }
-        else if (singleKeyRemapUIDetected == KeyboardManagerHelper::KeyboardHookDecision::SkipHook)
-        {
-            return 0;
-        }
-
-        // If the Detect Shortcut Window from Remap Keys is currently activated, then suppress the keyboard event
-        KeyboardManagerHelper::KeyboardHookDecision remapKeyShortcutUIDetected = keyboardManagerState.DetectShortcutUIBackend(data, true);
-        if (remapKeyShortcutUIDetected == KeyboardManagerHelper::KeyboardHookDecision::Suppress)
-        {
-            return 1;
-        }
-        else if (remapKeyShortcutUIDetected == KeyboardManagerHelper::KeyboardHookDecision::SkipHook)
-        {
-            return 0;
-        }
-
-        // Remap a key
-        intptr_t SingleKeyRemapResult = KeyboardEventHandlers::HandleSingleKeyRemapEvent(inputHandler, data, keyboardManagerState);
-
-        // Single key remaps have priority. If a key is remapped, only the remapped version should be visible to the shortcuts and hence the event should be suppressed here.
-        if (SingleKeyRemapResult == 1)
-        {
-            return 1;
-        }
-
-        // If the Detect Shortcut Window is currently activated, then suppress the keyboard event
-        KeyboardManagerHelper::KeyboardHookDecision shortcutUIDetected = keyboardManagerState.DetectShortcutUIBackend(data, false);
-        if (shortcutUIDetected == KeyboardManagerHelper::KeyboardHookDecision::Suppress)
-        {
-            return 1;
-        }
-        else if (shortcutUIDetected == KeyboardManagerHelper::KeyboardHookDecision::SkipHook)
-        {
-            return 0;
-        }
-
-        //// Remap a key to behave like a modifier instead of a toggle
-        //intptr_t SingleKeyToggleToModResult = KeyboardEventHandlers::HandleSingleKeyToggleToModEvent(inputHandler, data, keyboardManagerState);
-
-        // Handle an app-specific shortcut remapping
-        intptr_t AppSpecificShortcutRemapResult = KeyboardEventHandlers::HandleAppSpecificShortcutRemapEvent(inputHandler, data, keyboardManagerState);
-
-        // If an app-specific shortcut is remapped then the os-level shortcut remapping should be suppressed.
-        if (AppSpecificShortcutRemapResult == 1)
-        {
-            return 1;
-        }
-
-        // Handle an os-level shortcut remapping
-        return KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent(inputHandler, data, keyboardManagerState);
+        return KeyboardEventHandlers::HandleKeyboardHookEvent(inputHandler, data, keyboardManagerState);
     }
 };
 
 HHOOK KeyboardManager::hook_handle = nullptr;
 HHOOK KeyboardManager::hook_handle_copy = nullptr;
+HWINEVENTHOOK KeyboardManager::foreground_hook_handle = nullptr;
 KeyboardManager* KeyboardManager::keyboardmanager_object_ptr = nullptr;
 
 extern "C" __declspec(dllexport) PowertoyModuleIface* __cdecl powertoy_create()
@@ -312,5 +312,34 @@ namespace RemappingLogicTests
             Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(0x41), false);
             Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(0x56), false);
         }
+
+        // Test if the app specific remap takes place when the app name differs from the foreground process name in case or file extension
+        TEST_METHOD (AppSpecificShortcut_ShouldGetRemapped_WhenForegroundProcessNameMatchesAppNameIgnoringCaseAndExtension)
+        {
+            // Remap Ctrl+A to V for the test app without its file extension
+            Shortcut src;
+            src.SetKey(VK_CONTROL);
+            src.SetKey(0x41);
+            testState.AddAppSpecificShortcut(L"TestProcess1", src, 0x56);
+
+            // Set the testApp as the foreground process, in upper case
+            mockedInputHandler.SetForegroundProcess(L"TESTPROCESS1.EXE");
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+
+            // Send Ctrl+A keydown
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            // Ctrl and A key states should be unchanged, V key state should be true
+            Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(VK_CONTROL), false);
+            Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(0x41), false);
+            Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(0x56), true);
+            Assert::AreEqual(std::wstring(L"testprocess1"), testState.GetActivatedApp());
+        }
     };
 }
@@ -0,0 +1,168 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <keyboardmanager/common/KeyDelay.h>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for the KeyDelay state machines run by a KeyDelayScheduler without a dispatch thread, using an injected clock
+    TEST_CLASS (KeyDelayTests)
+    {
+    private:
+        DWORD64 currentTime = 0;
+        std::unique_ptr<KeyDelayScheduler> scheduler;
+
+        // Callbacks triggered by the scheduler, e.g. "short 65"
+        std::vector<std::wstring> triggeredCallbacks;
+
+        // Function to register a key which records its callbacks in triggeredCallbacks
+        void RegisterKey(DWORD key)
+        {
+            scheduler->Register(
+                key,
+                [this](DWORD key) { triggeredCallbacks.push_back(L"short " + std::to_wstring(key)); },
+                [this](DWORD key) { triggeredCallbacks.push_back(L"detected " + std::to_wstring(key)); },
+                [this](DWORD key) { triggeredCallbacks.push_back(L"released " + std::to_wstring(key)); });
+        }
+
+        // Function to send a key event at the current time
+        bool SendKeyEvent(DWORD key, WPARAM message)
+        {
+            KBDLLHOOKSTRUCT lParam = {};
+            lParam.vkCode = key;
+            lParam.time = (DWORD)currentTime;
+            LowlevelKeyboardEvent ev;
+            ev.lParam = &lParam;
+            ev.wParam = message;
+            return scheduler->KeyEvent(&ev);
+        }
+
+        // Function to advance the clock and process the pending events and deadlines
+        void AdvanceTime(DWORD64 millis)
+        {
+            currentTime += millis;
+            scheduler->Dispatch();
+        }
+
+        void AssertCallbacks(const std::vector<std::wstring>& expected)
+        {
+            Assert::AreEqual(expected.size(), triggeredCallbacks.size());
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                Assert::AreEqual(expected[i], triggeredCallbacks[i]);
+            }
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            currentTime = 1000;
+            triggeredCallbacks.clear();
+            scheduler = std::make_unique<KeyDelayScheduler>([this] { return currentTime; }, false);
+        }
+
+        // Test if releasing a key before the long press delay triggers the short press callback
+        TEST_METHOD (KeyDelay_ShouldTriggerShortPress_WhenKeyIsReleasedBeforeDelay)
+        {
+            RegisterKey(VK_RETURN);
+
+            Assert::IsTrue(SendKeyEvent(VK_RETURN, WM_KEYDOWN));
+            AdvanceTime(100);
+            Assert::IsTrue(SendKeyEvent(VK_RETURN, WM_KEYUP));
+            AdvanceTime(0);
+
+            AssertCallbacks({ L"short 13" });
+
+            // The deadline of the released key should not trigger a long press
+            AdvanceTime(KeyDelay::LONG_PRESS_DELAY_MILLIS * 2);
+            AssertCallbacks({ L"short 13" });
+        }
+
+        // Test if holding a key past the long press delay triggers the long press callbacks, ignoring the repeated key down events
+        TEST_METHOD (KeyDelay_ShouldTriggerLongPress_WhenKeyIsHeldPastDelay)
+        {
+            RegisterKey(VK_ESCAPE);
+
+            SendKeyEvent(VK_ESCAPE, WM_KEYDOWN);
+            for (int i = 0; i < 9; i++)
+            {
+                AdvanceTime(100);
+                SendKeyEvent(VK_ESCAPE, WM_KEYDOWN);
+            }
+            AdvanceTime(0);
+            Assert::IsTrue(triggeredCallbacks.empty());
+
+            AdvanceTime(1);
+            AssertCallbacks({ L"detected 27" });
+
+            AdvanceTime(500);
+            SendKeyEvent(VK_ESCAPE, WM_KEYUP);
+            AdvanceTime(0);
+            AssertCallbacks({ L"detected 27", L"released 27" });
+        }
+
+        // Test if a key up event which is processed after the long press delay triggers both long press callbacks
+        TEST_METHOD (KeyDelay_ShouldTriggerBothLongPressCallbacks_WhenKeyUpIsProcessedAfterDelay)
+        {
+            RegisterKey(VK_RETURN);
+
+            SendKeyEvent(VK_RETURN, WM_KEYDOWN);
+            currentTime += KeyDelay::LONG_PRESS_DELAY_MILLIS + 1;
+            SendKeyEvent(VK_RETURN, WM_KEYUP);
+            AdvanceTime(0);
+
+            AssertCallbacks({ L"detected 13", L"released 13" });
+        }
+
+        // Test if the state machines of several keys run independently on the same scheduler
+        TEST_METHOD (KeyDelayScheduler_ShouldDispatchEachKeyIndependently_WhenKeysOverlap)
+        {
+            RegisterKey(VK_RETURN);
+            RegisterKey(VK_ESCAPE);
+
+            SendKeyEvent(VK_RETURN, WM_KEYDOWN);
+            AdvanceTime(400);
+            SendKeyEvent(VK_ESCAPE, WM_KEYDOWN);
+            AdvanceTime(501);
+            AssertCallbacks({ L"detected 13" });
+
+            SendKeyEvent(VK_ESCAPE, WM_KEYUP);
+            SendKeyEvent(VK_RETURN, WM_KEYUP);
+            AdvanceTime(0);
+            AssertCallbacks({ L"detected 13", L"short 27", L"released 13" });
+        }
+
+        // Test if events of unregistered keys are not handled and if a key can be unregistered from its own callback
+        TEST_METHOD (KeyDelayScheduler_ShouldStopHandlingKey_WhenKeyIsUnregistered)
+        {
+            Assert::IsFalse(SendKeyEvent(VK_RETURN, WM_KEYDOWN));
+
+            scheduler->Register(
+                VK_RETURN,
+                [this](DWORD key) {
+                    triggeredCallbacks.push_back(L"short " + std::to_wstring(key));
+                    scheduler->Unregister(key);
+                },
+                nullptr,
+                nullptr);
+
+            SendKeyEvent(VK_RETURN, WM_KEYDOWN);
+            SendKeyEvent(VK_RETURN, WM_KEYUP);
+            AdvanceTime(0);
+            AssertCallbacks({ L"short 13" });
+
+            Assert::IsFalse(SendKeyEvent(VK_RETURN, WM_KEYDOWN));
+            Assert::ExpectException<std::invalid_argument>([this] { scheduler->Unregister(VK_RETURN); });
+        }
+
+        // Test if registering a key twice throws
+        TEST_METHOD (KeyDelayScheduler_ShouldThrow_WhenKeyIsRegisteredTwice)
+        {
+            RegisterKey(VK_RETURN);
+            Assert::ExpectException<std::invalid_argument>([this] { RegisterKey(VK_RETURN); });
+        }
+    };
+}
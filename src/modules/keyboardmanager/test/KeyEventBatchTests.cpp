@@ -0,0 +1,87 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/common/KeyboardManagerState.h>
+#include <keyboardmanager/common/KeyEventBatch.h>
+#include "KeyTraceReplay.h"
+#include "TestHelpers.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for the key event batch used by the keyboard hook to send input
+    TEST_CLASS (KeyEventBatchTests)
+    {
+    private:
+        MockedInput mockedInputHandler;
+        KeyboardManagerState testState;
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+        }
+
+        // Test if the added key events are set like SetKeyEvent and SetModifierKeyEvents, with the other fields cleared
+        TEST_METHOD (KeyEventBatch_ShouldSetKeyEvents_WhenEventsAreAdded)
+        {
+            KeyEventBatch batch;
+            batch.AddKeyEvent(VK_RCONTROL, KEYEVENTF_KEYUP, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+            batch.AddModifierKeyEvents(TestHelpers::CreateShortcut({ VK_LWIN, VK_CONTROL, VK_SHIFT, 0x41 }), ModifierKey::Left, true, KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG, TestHelpers::CreateShortcut({ VK_CONTROL, 0x42 }));
+
+            Assert::AreEqual(3, batch.Size());
+            Assert::AreEqual((DWORD)INPUT_KEYBOARD, batch[0].type);
+            Assert::AreEqual((WORD)VK_RCONTROL, batch[0].ki.wVk);
+            Assert::AreEqual((DWORD)(KEYEVENTF_KEYUP | KEYEVENTF_EXTENDEDKEY), batch[0].ki.dwFlags);
+            Assert::IsTrue(batch[0].ki.dwExtraInfo == KeyboardManagerConstants::KEYBOARDMANAGER_SHORTCUT_FLAG);
+            Assert::AreEqual((WORD)0, batch[0].ki.wScan);
+            Assert::AreEqual((DWORD)0, batch[0].ki.time);
+
+            // Ctrl is common to both shortcuts so only Win and Shift are pressed
+            Assert::AreEqual((WORD)VK_LWIN, batch[1].ki.wVk);
+            Assert::AreEqual((WORD)VK_SHIFT, batch[2].ki.wVk);
+        }
+
+        // Test if an empty batch is not sent and if the events added past the capacity are dropped
+        TEST_METHOD (KeyEventBatch_ShouldSendUpToCapacity_WhenBatchIsSent)
+        {
+            KeyEventBatch batch;
+            Assert::AreEqual((UINT)0, batch.Send(mockedInputHandler));
+            Assert::AreEqual(0, mockedInputHandler.GetSendVirtualInputCallCount());
+
+            for (int i = 0; i < KeyEventBatch::Capacity + 2; i++)
+            {
+                batch.AddKeyEvent(0x41, (i % 2) ? KEYEVENTF_KEYUP : 0, 0);
+            }
+
+            Assert::AreEqual(KeyEventBatch::Capacity, batch.Size());
+            Assert::AreEqual((UINT)KeyEventBatch::Capacity, batch.Send(mockedInputHandler));
+            Assert::AreEqual(KeyEventBatch::Capacity, mockedInputHandler.GetSendVirtualInputCallCount());
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+        }
+
+        // Test if remapping keys and shortcuts doesn't allocate in the keyboard hook
+        TEST_METHOD (HandleKeyboardHookEvent_ShouldNotAllocate_WhenKeysAndShortcutsAreRemapped)
+        {
+            testState.AddSingleKeyRemap(0x41, 0x42);
+            testState.AddSingleKeyRemap(VK_CAPITAL, TestHelpers::CreateShortcut({ VK_CONTROL, 0x56 }));
+            testState.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x43 }), TestHelpers::CreateShortcut({ VK_LWIN, VK_MENU, VK_SHIFT, 0x44 }));
+            testState.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_MENU, 0x58 }), (DWORD)VK_F13);
+
+            std::vector<KeyTraceEvent> trace;
+            KeyTraceReplay::AppendTyping(trace, { 0x41, VK_CAPITAL, 0x45 }, 10);
+            KeyTraceReplay::AppendShortcut(trace, { VK_LCONTROL, 0x43 }, 10);
+            KeyTraceReplay::AppendShortcut(trace, { VK_LCONTROL, 0x43, 0x45 }, 10);
+            KeyTraceReplay::AppendShortcut(trace, { VK_LMENU, 0x58 }, 10);
+
+            // The first replay is not counted, in case anything is allocated lazily
+            KeyTraceReplay::Replay(mockedInputHandler, testState, trace, 1);
+            KeyTraceReplayResult result = KeyTraceReplay::Replay(mockedInputHandler, testState, trace, 10);
+
+            Assert::IsTrue(result.injectedEventCount > 0);
+            Assert::AreEqual(0.0, result.allocationsPerEvent);
+        }
+    };
+}
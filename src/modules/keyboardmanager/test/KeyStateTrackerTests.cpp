@@ -0,0 +1,264 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/common/KeyboardManagerState.h>
+#include <keyboardmanager/common/KeyStateTracker.h>
+#include <keyboardmanager/dll/KeyboardEventHandlers.h>
+#include "TestHelpers.h"
+#include "../common/shared_constants.h"
+#include <chrono>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for the key state used by the keyboard hook
+    TEST_CLASS (KeyStateTrackerTests)
+    {
+    private:
+        MockedInput mockedInputHandler;
+        KeyboardManagerState testState;
+
+        // Function to press the keys whose bit is set in state, after releasing all the keys
+        void SetKeyboardState(const DWORD* keys, int keyCount, int state)
+        {
+            mockedInputHandler.ResetKeyboardState();
+            for (int i = 0; i < keyCount; i++)
+            {
+                if (state & (1 << i))
+                {
+                    INPUT input = {};
+                    input.type = INPUT_KEYBOARD;
+                    input.ki.wVk = (WORD)keys[i];
+                    mockedInputHandler.SendVirtualInput(1, &input, sizeof(INPUT));
+                }
+            }
+        }
+
+        // Reference implementation of Shortcut::CheckModifiersKeyboardState which queries each modifier key
+        static bool CheckModifiersByKey(const Shortcut& shortcut, InputInterface& ii)
+        {
+            DWORD winKey = shortcut.GetWinKey(ModifierKey::Both);
+            if (winKey == CommonSharedConstants::VK_WIN_BOTH)
+            {
+                if (!ii.GetVirtualKeyState(VK_LWIN) && !ii.GetVirtualKeyState(VK_RWIN))
+                {
+                    return false;
+                }
+            }
+            else if (winKey != NULL && !ii.GetVirtualKeyState(winKey))
+            {
+                return false;
+            }
+
+            for (DWORD key : { shortcut.GetCtrlKey(), shortcut.GetAltKey(), shortcut.GetShiftKey() })
+            {
+                if (key != NULL && !ii.GetVirtualKeyState(key))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Reference implementation of Shortcut::IsKeyboardStateClearExceptShortcut which queries each key
+        static bool IsKeyboardStateClearByKey(const Shortcut& shortcut, InputInterface& ii)
+        {
+            for (int key = 1; key < 0xFF; key++)
+            {
+                if (key == VK_LBUTTON || key == VK_RBUTTON || key == VK_MBUTTON || key == VK_XBUTTON1 || key == VK_XBUTTON2 || !ii.GetVirtualKeyState(key))
+                {
+                    continue;
+                }
+
+                // The generic modifier key codes are part of the shortcut if the modifier is used, whether it is left, right or both
+                bool isGenericModifier = (key == VK_CONTROL && shortcut.GetCtrlKey() != NULL) || (key == VK_MENU && shortcut.GetAltKey() != NULL) || (key == VK_SHIFT && shortcut.GetShiftKey() != NULL);
+                if (key != (int)shortcut.GetActionKey() && !isGenericModifier && !shortcut.CheckWinKey(key) && !shortcut.CheckCtrlKey(key) && !shortcut.CheckAltKey(key) && !shortcut.CheckShiftKey(key))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Function to send key events through the mocked hook and return the average time per event in microseconds
+        double TimeKeyEvents(INPUT* input, int nInputs, int iterations)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+            }
+            auto elapsed = std::chrono::high_resolution_clock::now() - start;
+            return std::chrono::duration<double, std::micro>(elapsed).count() / ((double)iterations * nInputs);
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+        }
+
+        // Test if the generic and left/right modifier key codes are updated together
+        TEST_METHOD (ApplyKeyEvent_ShouldUpdateGenericModifierKeys_OnModifierKeyEvents)
+        {
+            KeyStateTracker tracker;
+            tracker.ApplyKeyEvent(VK_LCONTROL, true);
+            Assert::IsTrue(tracker.IsKeyDown(VK_LCONTROL));
+            Assert::IsTrue(tracker.IsKeyDown(VK_CONTROL));
+            Assert::IsTrue(tracker.AreModifiersDown(KeyStateTracker::LeftCtrl | KeyStateTracker::Ctrl));
+            Assert::IsFalse(tracker.AreModifiersDown(KeyStateTracker::RightCtrl));
+
+            // Releasing the generic key code releases both the left and right keys
+            tracker.ApplyKeyEvent(VK_RCONTROL, true);
+            tracker.ApplyKeyEvent(VK_CONTROL, false);
+            Assert::IsFalse(tracker.IsKeyDown(VK_LCONTROL));
+            Assert::IsFalse(tracker.IsKeyDown(VK_RCONTROL));
+            Assert::AreEqual((DWORD)0, tracker.GetModifierState());
+
+            // Either win key sets the bit used by shortcuts with both win keys
+            tracker.ApplyKeyEvent(VK_RWIN, true);
+            Assert::IsTrue(tracker.AreModifiersDown(KeyStateTracker::EitherWin));
+            tracker.ApplyKeyEvent(VK_RWIN, false);
+            Assert::IsFalse(tracker.AreModifiersDown(KeyStateTracker::EitherWin));
+
+            tracker.ApplyKeyEvent(0x41, true);
+            Assert::IsTrue(tracker.IsKeyDown(0x41));
+            Assert::AreEqual((DWORD)0, tracker.GetModifierState());
+            tracker.Reset();
+            Assert::IsFalse(tracker.IsKeyDown(0x41));
+        }
+
+        // Test if the shortcut checks done with the key state give the same results as querying each key
+        // Test if the generic modifier key code stays down while the other side of the modifier is still held
+        TEST_METHOD (ApplyKeyEvent_ShouldKeepGenericModifierKeyDown_WhenOneOfBothSidesIsReleased)
+        {
+            const DWORD modifiers[][3] = {
+                { VK_CONTROL, VK_LCONTROL, VK_RCONTROL },
+                { VK_MENU, VK_LMENU, VK_RMENU },
+                { VK_SHIFT, VK_LSHIFT, VK_RSHIFT },
+            };
+
+            for (const auto& modifier : modifiers)
+            {
+                KeyStateTracker tracker;
+                tracker.ApplyKeyEvent(modifier[1], true);
+                tracker.ApplyKeyEvent(modifier[2], true);
+
+                tracker.ApplyKeyEvent(modifier[2], false);
+                Assert::IsTrue(tracker.IsKeyDown(modifier[0]));
+                Assert::IsTrue(tracker.IsKeyDown(modifier[1]));
+                Assert::IsFalse(tracker.IsKeyDown(modifier[2]));
+
+                tracker.ApplyKeyEvent(modifier[1], false);
+                Assert::IsFalse(tracker.IsKeyDown(modifier[0]));
+                Assert::AreEqual((DWORD)0, tracker.GetModifierState());
+            }
+        }
+
+        TEST_METHOD (ShortcutKeyboardStateChecks_ShouldMatchQueryingEachKey_ForAllKeyboardStates)
+        {
+            const DWORD keys[] = { VK_LWIN, VK_RWIN, VK_LCONTROL, VK_RCONTROL, VK_LMENU, VK_RMENU, VK_LSHIFT, VK_RSHIFT, VK_CONTROL, 0x41, 0x42 };
+            const Shortcut shortcuts[] = {
+                TestHelpers::CreateShortcut({ CommonSharedConstants::VK_WIN_BOTH, 0x41 }),
+                TestHelpers::CreateShortcut({ VK_LWIN, VK_CONTROL, 0x41 }),
+                TestHelpers::CreateShortcut({ VK_RWIN, VK_LMENU, 0x42 }),
+                TestHelpers::CreateShortcut({ VK_LCONTROL, VK_RSHIFT, 0x41 }),
+                TestHelpers::CreateShortcut({ VK_RCONTROL, VK_MENU, VK_SHIFT, 0x41 }),
+                TestHelpers::CreateShortcut({ VK_LCONTROL, VK_RMENU, VK_LSHIFT, 0x42 }),
+            };
+
+            // Try every combination of the keys
+            for (int state = 0; state < (1 << (int)ARRAYSIZE(keys)); state++)
+            {
+                SetKeyboardState(keys, (int)ARRAYSIZE(keys), state);
+                for (const auto& shortcut : shortcuts)
+                {
+                    Assert::AreEqual(CheckModifiersByKey(shortcut, mockedInputHandler), shortcut.CheckModifiersKeyboardState(mockedInputHandler));
+                    Assert::AreEqual(IsKeyboardStateClearByKey(shortcut, mockedInputHandler), shortcut.IsKeyboardStateClearExceptShortcut(mockedInputHandler));
+                }
+            }
+        }
+
+        // Benchmark of the keyboard hook with the handlers in the same order as the Keyboard Manager hook
+        TEST_METHOD (KeyboardHook_Benchmark_LatencyPerEvent)
+        {
+            const int shortcutCount = 600;
+            const int iterations = 2000;
+            Assert::IsTrue(TestHelpers::AddOSLevelShortcuts(testState, shortcutCount, TestHelpers::CreateShortcut({ VK_LWIN, VK_F13 })));
+            testState.AddSingleKeyRemap(VK_CAPITAL, (DWORD)VK_ESCAPE);
+
+            mockedInputHandler.SetHookProc([this](LowlevelKeyboardEvent* data) {
+                if (data->lParam->dwExtraInfo == KeyboardManagerConstants::KEYBOARDMANAGER_SUPPRESS_FLAG)
+                {
+                    return (intptr_t)1;
+                }
+                if (KeyboardEventHandlers::HandleSingleKeyRemapEvent(mockedInputHandler, data, testState) == 1)
+                {
+                    return (intptr_t)1;
+                }
+                if (KeyboardEventHandlers::HandleAppSpecificShortcutRemapEvent(mockedInputHandler, data, testState) == 1)
+                {
+                    return (intptr_t)1;
+                }
+                return KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent(mockedInputHandler, data, testState);
+            });
+
+            // Typing without modifiers
+            INPUT typing[4] = {};
+            for (int i = 0; i < (int)ARRAYSIZE(typing); i++)
+            {
+                typing[i].type = INPUT_KEYBOARD;
+                typing[i].ki.wVk = (WORD)((i < 2) ? 0x41 : 0x42);
+                typing[i].ki.dwFlags = (i % 2) ? KEYEVENTF_KEYUP : 0;
+            }
+            double typingTime = TimeKeyEvents(typing, (int)ARRAYSIZE(typing), iterations);
+
+            // Pressing and releasing Ctrl+Shift+Z which is remapped to a shortcut, so the keyboard state is checked for other keys
+            INPUT remap[6] = {};
+            const WORD remapKeys[] = { VK_LCONTROL, VK_LSHIFT, 0x5A };
+            for (int i = 0; i < 3; i++)
+            {
+                remap[i].type = INPUT_KEYBOARD;
+                remap[i].ki.wVk = remapKeys[i];
+                remap[5 - i].type = INPUT_KEYBOARD;
+                remap[5 - i].ki.wVk = remapKeys[i];
+                remap[5 - i].ki.dwFlags = KEYEVENTF_KEYUP;
+            }
+            mockedInputHandler.SetSendVirtualInputTestHandler([](LowlevelKeyboardEvent* data) {
+                return data->lParam->vkCode == VK_F13 && data->wParam == WM_KEYDOWN;
+            });
+            double remapTime = TimeKeyEvents(remap, (int)ARRAYSIZE(remap), iterations);
+            Assert::AreEqual(iterations, mockedInputHandler.GetSendVirtualInputCallCount());
+
+            // Compare the keyboard state check used by the hook with querying each key, while the shortcut is pressed
+            mockedInputHandler.SetHookProc(nullptr);
+            const DWORD pressedKeys[] = { VK_LCONTROL, VK_LSHIFT, 0x5A };
+            SetKeyboardState(pressedKeys, (int)ARRAYSIZE(pressedKeys), 0x7);
+            Shortcut shortcut = TestHelpers::CreateShortcut({ VK_CONTROL, VK_SHIFT, 0x5A });
+            auto start = std::chrono::high_resolution_clock::now();
+            bool isClear = true;
+            for (int i = 0; i < iterations; i++)
+            {
+                isClear &= shortcut.IsKeyboardStateClearExceptShortcut(mockedInputHandler);
+            }
+            double keyStateTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+            start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                isClear &= IsKeyboardStateClearByKey(shortcut, mockedInputHandler);
+            }
+            double queryTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+            Assert::IsTrue(isClear);
+
+            Logger::WriteMessage((L"Shortcuts: " + std::to_wstring(shortcutCount) + L"\n").c_str());
+            Logger::WriteMessage((L"Hook, typing: " + std::to_wstring(typingTime) + L" us per event\n").c_str());
+            Logger::WriteMessage((L"Hook, remapped shortcut: " + std::to_wstring(remapTime) + L" us per event\n").c_str());
+            Logger::WriteMessage((L"IsKeyboardStateClearExceptShortcut: " + std::to_wstring(keyStateTime) + L" us with the key state, " + std::to_wstring(queryTime) + L" us querying each key\n").c_str());
+        }
+    };
+}
@@ -0,0 +1,255 @@
+#include "pch.h"
+#include "KeyTraceReplay.h"
+#include "MockedInput.h"
+#include <keyboardmanager/common/KeyboardManagerState.h>
+#include <keyboardmanager/dll/KeyboardEventHandlers.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    std::atomic<size_t> allocationCount = 0;
+    decltype(&HeapAlloc) originalHeapAlloc = nullptr;
+
+    LPVOID WINAPI CountingHeapAlloc(HANDLE heap, DWORD flags, SIZE_T bytes)
+    {
+        allocationCount++;
+        return originalHeapAlloc(heap, flags, bytes);
+    }
+
+    // Function to replace the entries of a function imported by name in the import address table of a module
+    void ReplaceImport(HMODULE module, const char* functionName, const void* newFunction)
+    {
+        BYTE* base = reinterpret_cast<BYTE*>(module);
+        PIMAGE_NT_HEADERS ntHeaders = reinterpret_cast<PIMAGE_NT_HEADERS>(base + reinterpret_cast<PIMAGE_DOS_HEADER>(base)->e_lfanew);
+        const IMAGE_DATA_DIRECTORY& importDirectory = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+        if (importDirectory.VirtualAddress == 0)
+        {
+            return;
+        }
+
+        for (PIMAGE_IMPORT_DESCRIPTOR descriptor = reinterpret_cast<PIMAGE_IMPORT_DESCRIPTOR>(base + importDirectory.VirtualAddress); descriptor->Name != 0; descriptor++)
+        {
+            if (descriptor->OriginalFirstThunk == 0)
+            {
+                continue;
+            }
+
+            // The function can be imported from kernel32 or from an API set, so every module is checked
+            PIMAGE_THUNK_DATA nameThunk = reinterpret_cast<PIMAGE_THUNK_DATA>(base + descriptor->OriginalFirstThunk);
+            PIMAGE_THUNK_DATA addressThunk = reinterpret_cast<PIMAGE_THUNK_DATA>(base + descriptor->FirstThunk);
+            for (; nameThunk->u1.AddressOfData != 0; nameThunk++, addressThunk++)
+            {
+                if (IMAGE_SNAP_BY_ORDINAL(nameThunk->u1.Ordinal))
+                {
+                    continue;
+                }
+
+                PIMAGE_IMPORT_BY_NAME importName = reinterpret_cast<PIMAGE_IMPORT_BY_NAME>(base + nameThunk->u1.AddressOfData);
+                if (strcmp(importName->Name, functionName) == 0)
+                {
+                    DWORD oldProtect;
+                    VirtualProtect(&addressThunk->u1.Function, sizeof(addressThunk->u1.Function), PAGE_READWRITE, &oldProtect);
+                    addressThunk->u1.Function = reinterpret_cast<ULONG_PTR>(newFunction);
+                    VirtualProtect(&addressThunk->u1.Function, sizeof(addressThunk->u1.Function), oldProtect, &oldProtect);
+                }
+            }
+        }
+    }
+
+    // Function to get the modules whose allocations are counted
+    std::vector<HMODULE> GetCountedModules()
+    {
+        std::vector<HMODULE> modules;
+        HMODULE testModule = nullptr;
+        GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, reinterpret_cast<LPCWSTR>(&CountingHeapAlloc), &testModule);
+        if (testModule)
+        {
+            modules.push_back(testModule);
+        }
+
+        HMODULE keyboardManagerModule = GetModuleHandle(L"KeyboardManager.dll");
+        if (keyboardManagerModule)
+        {
+            modules.push_back(keyboardManagerModule);
+        }
+        return modules;
+    }
+
+    // Function to get the percentile of sorted latencies
+    double GetPercentile(const std::vector<double>& sortedLatencies, int percentile)
+    {
+        if (sortedLatencies.empty())
+        {
+            return 0;
+        }
+        return sortedLatencies[(sortedLatencies.size() - 1) * percentile / 100];
+    }
+
+    // Function to append a key event to a synthetic trace, after the interval since the previous event. Like MockedInput, the SYSKEY messages are used while Alt is held down
+    void AppendKeyEvent(std::vector<KeyTraceEvent>& trace, DWORD key, bool isKeyDown, bool isAltDown, DWORD intervalMillis)
+    {
+        KeyTraceEvent traceEvent = {};
+        traceEvent.vkCode = key;
+        if (isAltDown)
+        {
+            traceEvent.message = isKeyDown ? WM_SYSKEYDOWN : WM_SYSKEYUP;
+        }
+        else
+        {
+            traceEvent.message = isKeyDown ? WM_KEYDOWN : WM_KEYUP;
+        }
+        traceEvent.time = trace.empty() ? 0 : trace.back().time + intervalMillis;
+        trace.push_back(traceEvent);
+    }
+}
+
+AllocationCounter::AllocationCounter()
+{
+    originalHeapAlloc = reinterpret_cast<decltype(&HeapAlloc)>(GetProcAddress(GetModuleHandle(L"kernel32.dll"), "HeapAlloc"));
+    initialCount = allocationCount;
+    for (HMODULE module : GetCountedModules())
+    {
+        ReplaceImport(module, "HeapAlloc", reinterpret_cast<const void*>(&CountingHeapAlloc));
+    }
+}
+
+AllocationCounter::~AllocationCounter()
+{
+    for (HMODULE module : GetCountedModules())
+    {
+        ReplaceImport(module, "HeapAlloc", reinterpret_cast<const void*>(originalHeapAlloc));
+    }
+}
+
+// Function to get the number of allocations made since the counter was created
+size_t AllocationCounter::GetCount() const
+{
+    return allocationCount - initialCount;
+}
+
+// Function to format the results for the test log
+std::wstring KeyTraceReplayResult::ToString(const std::wstring& name) const
+{
+    std::wstringstream stream;
+    stream << std::fixed << std::setprecision(2);
+    stream << name << L": " << eventCount << L" events, p50 " << p50LatencyMicros << L" us, p99 " << p99LatencyMicros << L" us, max " << maxLatencyMicros << L" us, ";
+    stream << injectedEventCount << L" injected events, " << allocationsPerEvent << L" allocations per event\n";
+    return stream.str();
+}
+
+namespace KeyTraceReplay
+{
+    // Function to parse a captured trace with one "vkCode message time extraInfo" event per line. Values can be decimal or hexadecimal with the 0x prefix, and empty lines or lines starting with # are skipped
+    std::vector<KeyTraceEvent> ParseTrace(std::istream& stream)
+    {
+        std::vector<KeyTraceEvent> trace;
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            std::istringstream lineStream(line);
+            std::string fields[4];
+            if (!(lineStream >> fields[0]) || fields[0][0] == '#')
+            {
+                continue;
+            }
+            if (!(lineStream >> fields[1] >> fields[2] >> fields[3]))
+            {
+                throw std::invalid_argument("Key trace event must have four fields");
+            }
+
+            KeyTraceEvent traceEvent;
+            traceEvent.vkCode = (DWORD)std::stoul(fields[0], nullptr, 0);
+            traceEvent.message = (WPARAM)std::stoul(fields[1], nullptr, 0);
+            traceEvent.time = (DWORD)std::stoul(fields[2], nullptr, 0);
+            traceEvent.extraInfo = (ULONG_PTR)std::stoull(fields[3], nullptr, 0);
+            trace.push_back(traceEvent);
+        }
+
+        return trace;
+    }
+
+    // Function to load a captured trace file
+    std::vector<KeyTraceEvent> LoadTrace(const std::wstring& path)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            throw std::invalid_argument("Key trace file could not be opened");
+        }
+        return ParseTrace(file);
+    }
+
+    // Function to append the key down and key up events of typing each key one after the other
+    void AppendTyping(std::vector<KeyTraceEvent>& trace, const std::vector<DWORD>& keys, DWORD intervalMillis)
+    {
+        for (DWORD key : keys)
+        {
+            AppendKeyEvent(trace, key, true, false, intervalMillis);
+            AppendKeyEvent(trace, key, false, false, intervalMillis);
+        }
+    }
+
+    // Function to append the events of pressing the keys of a shortcut in order and releasing them in reverse order
+    void AppendShortcut(std::vector<KeyTraceEvent>& trace, const std::vector<DWORD>& keys, DWORD intervalMillis)
+    {
+        bool isAltDown = false;
+        for (DWORD key : keys)
+        {
+            AppendKeyEvent(trace, key, true, isAltDown, intervalMillis);
+            isAltDown |= (key == VK_MENU || key == VK_LMENU || key == VK_RMENU);
+        }
+        for (auto it = keys.rbegin(); it != keys.rend(); it++)
+        {
+            AppendKeyEvent(trace, *it, false, isAltDown, intervalMillis);
+            isAltDown &= !(*it == VK_MENU || *it == VK_LMENU || *it == VK_RMENU);
+        }
+    }
+
+    // Function to replay a trace iterations times through KeyboardEventHandlers::HandleKeyboardHookEvent with the remappings of state. The injected events go through the hook as well, like with the real hook
+    KeyTraceReplayResult Replay(MockedInput& input, KeyboardManagerState& state, const std::vector<KeyTraceEvent>& trace, int iterations)
+    {
+        input.SetHookProc(std::bind(&KeyboardEventHandlers::HandleKeyboardHookEvent, std::ref(input), std::placeholders::_1, std::ref(state)));
+
+        // The latencies are reserved up front so that the replay loop only counts the allocations of the hook
+        std::vector<double> latencies;
+        latencies.reserve(trace.size() * iterations);
+        int initialInjectedEventCount = input.GetSendVirtualInputCallCount();
+        size_t allocations;
+        {
+            AllocationCounter allocationCounter;
+            for (int i = 0; i < iterations; i++)
+            {
+                for (const KeyTraceEvent& traceEvent : trace)
+                {
+                    KBDLLHOOKSTRUCT lParam = {};
+                    lParam.vkCode = traceEvent.vkCode;
+                    lParam.time = traceEvent.time;
+                    lParam.dwExtraInfo = traceEvent.extraInfo;
+                    LowlevelKeyboardEvent keyEvent;
+                    keyEvent.lParam = &lParam;
+                    keyEvent.wParam = traceEvent.message;
+
+                    auto start = std::chrono::high_resolution_clock::now();
+                    input.SendLowlevelKeyEvent(&keyEvent);
+                    latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+                }
+            }
+            allocations = allocationCounter.GetCount();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        KeyTraceReplayResult result;
+        result.eventCount = latencies.size();
+        result.p50LatencyMicros = GetPercentile(latencies, 50);
+        result.p99LatencyMicros = GetPercentile(latencies, 99);
+        result.maxLatencyMicros = latencies.empty() ? 0 : latencies.back();
+        result.injectedEventCount = input.GetSendVirtualInputCallCount() - initialInjectedEventCount;
+        result.allocationsPerEvent = latencies.empty() ? 0 : (double)allocations / latencies.size();
+        return result;
+    }
+}
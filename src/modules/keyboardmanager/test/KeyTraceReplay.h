@@ -0,0 +1,70 @@
+#pragma once
+#include <istream>
+#include <string>
+#include <vector>
+
+class MockedInput;
+class KeyboardManagerState;
+
+// Key event of a keystroke trace, with the fields of KBDLLHOOKSTRUCT used by the keyboard hook
+struct KeyTraceEvent
+{
+    DWORD vkCode;
+    WPARAM message;
+    DWORD time;
+    ULONG_PTR extraInfo;
+};
+
+// Results of replaying a keystroke trace through the keyboard hook
+struct KeyTraceReplayResult
+{
+    size_t eventCount = 0;
+
+    // Latency of the hook per trace event, including the handling of the events it injects
+    double p50LatencyMicros = 0;
+    double p99LatencyMicros = 0;
+    double maxLatencyMicros = 0;
+
+    // Number of events sent with SendVirtualInput by the hook, which satisfy the condition set with MockedInput::SetSendVirtualInputTestHandler
+    int injectedEventCount = 0;
+
+    double allocationsPerEvent = 0;
+
+    // Function to format the results for the test log
+    std::wstring ToString(const std::wstring& name) const;
+};
+
+// Counts the heap allocations made by the test module and by the Keyboard Manager dll while it is alive.
+// Both link the CRT statically, so their allocations call HeapAlloc through their own import address table, which is redirected to a counting function.
+class AllocationCounter
+{
+public:
+    AllocationCounter();
+    ~AllocationCounter();
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+    // Function to get the number of allocations made since the counter was created
+    size_t GetCount() const;
+
+private:
+    size_t initialCount;
+};
+
+namespace KeyTraceReplay
+{
+    // Function to parse a captured trace with one "vkCode message time extraInfo" event per line. Values can be decimal or hexadecimal with the 0x prefix, and empty lines or lines starting with # are skipped
+    std::vector<KeyTraceEvent> ParseTrace(std::istream& stream);
+
+    // Function to load a captured trace file
+    std::vector<KeyTraceEvent> LoadTrace(const std::wstring& path);
+
+    // Function to append the key down and key up events of typing each key one after the other
+    void AppendTyping(std::vector<KeyTraceEvent>& trace, const std::vector<DWORD>& keys, DWORD intervalMillis);
+
+    // Function to append the events of pressing the keys of a shortcut in order and releasing them in reverse order
+    void AppendShortcut(std::vector<KeyTraceEvent>& trace, const std::vector<DWORD>& keys, DWORD intervalMillis);
+
+    // Function to replay a trace iterations times through KeyboardEventHandlers::HandleKeyboardHookEvent with the remappings of state. The injected events go through the hook as well, like with the real hook
+    KeyTraceReplayResult Replay(MockedInput& input, KeyboardManagerState& state, const std::vector<KeyTraceEvent>& trace, int iterations);
+}
@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/common/KeyboardManagerState.h>
+#include "KeyTraceReplay.h"
+#include "TestHelpers.h"
+#include <fstream>
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for replaying keystroke traces through the keyboard hook, and benchmarks of the hook with different remap sets
+    TEST_CLASS (KeyTraceReplayTests)
+    {
+    private:
+        MockedInput mockedInputHandler;
+        KeyboardManagerState testState;
+
+        // Latency budget of the hook per event. The system skips a low level hook which takes longer than LowLevelHooksTimeout, which is at most 1 second
+        static constexpr double HookLatencyBudgetMicros = 10000;
+
+        // Function to create a trace of typing a sentence with a few shortcuts in between
+        static std::vector<KeyTraceEvent> CreateTypingTrace()
+        {
+            std::vector<KeyTraceEvent> trace;
+            const DWORD interval = 30;
+            KeyTraceReplay::AppendTyping(trace, { 0x54, 0x48, 0x45, VK_SPACE, 0x51, 0x55, 0x49, 0x43, 0x4B, VK_SPACE }, interval);
+            KeyTraceReplay::AppendShortcut(trace, { VK_LCONTROL, 0x43 }, interval);
+            KeyTraceReplay::AppendTyping(trace, { 0x42, 0x52, 0x4F, 0x57, 0x4E, VK_CAPITAL, VK_CAPITAL }, interval);
+            KeyTraceReplay::AppendShortcut(trace, { VK_LCONTROL, VK_LSHIFT, 0x5A }, interval);
+            KeyTraceReplay::AppendShortcut(trace, { VK_LMENU, VK_TAB }, interval);
+            return trace;
+        }
+
+        // Function to replay a trace and log the results
+        KeyTraceReplayResult ReplayAndLog(const std::wstring& name, const std::vector<KeyTraceEvent>& trace, int iterations)
+        {
+            KeyTraceReplayResult result = KeyTraceReplay::Replay(mockedInputHandler, testState, trace, iterations);
+            Logger::WriteMessage(result.ToString(name).c_str());
+
+            // Every key pressed by the trace should be released when the trace was replayed
+            for (int key = 1; key < 256; key++)
+            {
+                Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(key));
+            }
+            return result;
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+        }
+
+        // Test if a captured trace file is loaded, skipping comments and reading decimal and hexadecimal values
+        TEST_METHOD (LoadTrace_ShouldLoadEvents_WhenTraceHasCommentsAndHexadecimalValues)
+        {
+            wchar_t tempFolder[MAX_PATH];
+            GetTempPath(MAX_PATH, tempFolder);
+            std::wstring tracePath = std::wstring(tempFolder) + L"KeyTraceReplayTests.txt";
+            {
+                std::ofstream file(tracePath, std::ios::trunc);
+                file << "# vkCode message time extraInfo\n";
+                file << "0x41 256 1000 0\n";
+                file << "\n";
+                file << "65 0x101 1030 0x101\n";
+            }
+
+            std::vector<KeyTraceEvent> trace = KeyTraceReplay::LoadTrace(tracePath);
+            DeleteFile(tracePath.c_str());
+
+            Assert::AreEqual((size_t)2, trace.size());
+            Assert::AreEqual((DWORD)0x41, trace[0].vkCode);
+            Assert::IsTrue(trace[0].message == WM_KEYDOWN);
+            Assert::AreEqual((DWORD)1000, trace[0].time);
+            Assert::AreEqual((DWORD)0x41, trace[1].vkCode);
+            Assert::IsTrue(trace[1].message == WM_KEYUP);
+            Assert::AreEqual((DWORD)1030, trace[1].time);
+            Assert::IsTrue(trace[1].extraInfo == 0x101);
+
+            std::istringstream invalidTrace("0x41 256\n");
+            Assert::ExpectException<std::invalid_argument>([&invalidTrace] { KeyTraceReplay::ParseTrace(invalidTrace); });
+        }
+
+        // Test if replaying a trace runs the whole hook and counts the events it injects
+        TEST_METHOD (Replay_ShouldCountInjectedEvents_WhenTraceHasRemappedKeys)
+        {
+            // Remap A to B and Ctrl+C to Ctrl+V
+            testState.AddSingleKeyRemap(0x41, 0x42);
+            testState.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x43 }), TestHelpers::CreateShortcut({ VK_CONTROL, 0x56 }));
+
+            std::vector<KeyTraceEvent> trace;
+            KeyTraceReplay::AppendTyping(trace, { 0x41, 0x44 }, 10);
+            KeyTraceReplayResult result = KeyTraceReplay::Replay(mockedInputHandler, testState, trace, 1);
+
+            // The A events are replaced by B events, and the D events are not remapped
+            Assert::AreEqual((size_t)4, result.eventCount);
+            Assert::AreEqual(2, result.injectedEventCount);
+
+            trace.clear();
+            KeyTraceReplay::AppendShortcut(trace, { VK_LCONTROL, 0x43 }, 10);
+            mockedInputHandler.SetSendVirtualInputTestHandler([](LowlevelKeyboardEvent* data) {
+                return data->lParam->vkCode == 0x56 && data->wParam == WM_KEYDOWN;
+            });
+            result = KeyTraceReplay::Replay(mockedInputHandler, testState, trace, 3);
+
+            Assert::AreEqual((size_t)12, result.eventCount);
+            Assert::AreEqual(3, result.injectedEventCount);
+            Assert::IsFalse(mockedInputHandler.GetVirtualKeyState(VK_CONTROL));
+            Assert::IsFalse(mockedInputHandler.GetVirtualKeyState(0x56));
+        }
+
+        // Benchmark of the keyboard hook replaying a typing trace with an empty, a small and a large remap set
+        TEST_METHOD (Replay_Benchmark_WithRemapSets)
+        {
+            const int iterations = 500;
+            std::vector<KeyTraceEvent> trace = CreateTypingTrace();
+
+            KeyTraceReplayResult noRemaps = ReplayAndLog(L"No remappings", trace, iterations);
+
+            testState.AddSingleKeyRemap(VK_CAPITAL, (DWORD)VK_ESCAPE);
+            testState.AddSingleKeyRemap(0x51, TestHelpers::CreateShortcut({ VK_CONTROL, 0x57 }));
+            testState.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x43 }), TestHelpers::CreateShortcut({ VK_CONTROL, 0x56 }));
+            KeyTraceReplayResult smallRemaps = ReplayAndLog(L"Small remap set", trace, iterations);
+
+            const int shortcutCount = 600;
+            Assert::IsTrue(TestHelpers::AddOSLevelShortcuts(testState, shortcutCount, TestHelpers::CreateShortcut({ VK_LWIN, VK_F13 })));
+            for (int i = 0; i < 50; i++)
+            {
+                testState.AddAppSpecificShortcut(L"app" + std::to_wstring(i) + L".exe", TestHelpers::CreateShortcut({ VK_CONTROL, 0x43 }), (DWORD)VK_F14);
+            }
+            mockedInputHandler.SetForegroundProcess(L"app25.exe");
+            KeyTraceReplayResult largeRemaps = ReplayAndLog(L"Large remap set", trace, iterations);
+
+            for (const KeyTraceReplayResult* result : { &noRemaps, &smallRemaps, &largeRemaps })
+            {
+                Assert::IsTrue(result->p99LatencyMicros < HookLatencyBudgetMicros);
+            }
+        }
+    };
+}
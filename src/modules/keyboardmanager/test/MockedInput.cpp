@@ -18,7 +18,7 @@ UINT MockedInput::SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
         // Distinguish between key and sys key by checking if the key is either F10 (for syskeydown) or if the key message is sent while Alt is held down. SYSKEY messages are also sent if there is no window in focus, but that has not been mocked since it would require many changes. More details on key messages at https://docs.microsoft.com/en-us/windows/win32/inputdev/wm-syskeydown
         if (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP)
         {
-            if (keyboardState[VK_MENU] == true)
+            if (keyboardState.IsKeyDown(VK_MENU))
             {
                 keyEvent.wParam = WM_SYSKEYUP;
             }
@@ -29,7 +29,7 @@ UINT MockedInput::SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
         }
         else
         {
-            if (pInputs[i].ki.wVk == VK_F10 || keyboardState[VK_MENU] == true)
+            if (pInputs[i].ki.wVk == VK_F10 || keyboardState.IsKeyDown(VK_MENU))
             {
                 keyEvent.wParam = WM_SYSKEYDOWN;
             }
@@ -57,58 +57,28 @@ UINT MockedInput::SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize)
         // Set keyboard state if the hook does not suppress the input
         if (result == 0)
         {
-            // If key up flag is set, then set keyboard state to false
-            keyboardState[pInputs[i].ki.wVk] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
-
-            // Handling modifier key codes
-            switch (pInputs[i].ki.wVk)
-            {
-            case VK_CONTROL:
-                if (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP)
-                {
-                    keyboardState[VK_LCONTROL] = false;
-                    keyboardState[VK_RCONTROL] = false;
-                    break;
-                }
-            case VK_LCONTROL:
-                keyboardState[VK_CONTROL] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
-                break;
-            case VK_RCONTROL:
-                keyboardState[VK_CONTROL] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
-                break;
-            case VK_MENU:
-                if (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP)
-                {
-                    keyboardState[VK_LMENU] = false;
-                    keyboardState[VK_RMENU] = false;
-                    break;
-                }
-            case VK_LMENU:
-                keyboardState[VK_MENU] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
-                break;
-            case VK_RMENU:
-                keyboardState[VK_MENU] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
-                break;
-            case VK_SHIFT:
-                if (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP)
-                {
-                    keyboardState[VK_LSHIFT] = false;
-                    keyboardState[VK_RSHIFT] = false;
-                    break;
-                }
-            case VK_LSHIFT:
-                keyboardState[VK_SHIFT] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
-                break;
-            case VK_RSHIFT:
-                keyboardState[VK_SHIFT] = (pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP) ? false : true;
-                break;
-            }
+            // If key up flag is set, then set keyboard state to false. The generic and left/right modifier key codes are updated together
+            keyboardState.ApplyKeyEvent(pInputs[i].ki.wVk, !(pInputs[i].ki.dwFlags & KEYEVENTF_KEYUP));
         }
     }
 
     return cInputs;
 }
 
+// Function to simulate a key event which is not injected by SendVirtualInput, such as an event of a recorded key trace. Returns the result of the hook
+intptr_t MockedInput::SendLowlevelKeyEvent(LowlevelKeyboardEvent* data)
+{
+    intptr_t result = MockedKeyboardHook(data);
+
+    // Set keyboard state if the hook does not suppress the input
+    if (result == 0)
+    {
+        keyboardState.ApplyKeyEvent(data->lParam->vkCode, data->wParam == WM_KEYDOWN || data->wParam == WM_SYSKEYDOWN);
+    }
+
+    return result;
+}
+
 // Function to simulate keyboard hook behavior
 intptr_t MockedInput::MockedKeyboardHook(LowlevelKeyboardEvent* data)
 {
@@ -126,13 +96,19 @@ intptr_t MockedInput::MockedKeyboardHook(LowlevelKeyboardEvent* data)
 // Function to get the state of a particular key
 bool MockedInput::GetVirtualKeyState(int key)
 {
-    return keyboardState[key];
+    return keyboardState.IsKeyDown(key);
+}
+
+// Function to get the state of all the keys
+const KeyStateTracker& MockedInput::GetKeyStateTracker()
+{
+    return keyboardState;
 }
 
 // Function to reset the mocked keyboard state
 void MockedInput::ResetKeyboardState()
 {
-    std::fill(keyboardState.begin(), keyboardState.end(), false);
+    keyboardState.Reset();
 }
 
 // Function to set SendVirtualInput call count condition
@@ -151,11 +127,11 @@ int MockedInput::GetSendVirtualInputCallCount()
 // Function to get the foreground process name
 void MockedInput::SetForegroundProcess(std::wstring process)
 {
-    currentProcess = process;
+    currentProcess.Set(process);
 }
 
-// Function to get the foreground process name
-void MockedInput::GetForegroundProcess(_Out_ std::wstring& foregroundProcess)
+// Function to get the name of the foreground process
+const ProcessName& MockedInput::GetForegroundProcess()
 {
-    foregroundProcess = currentProcess;
+    return currentProcess;
 }
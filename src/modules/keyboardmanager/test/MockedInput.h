@@ -1,5 +1,6 @@
 #pragma once
 #include <keyboardmanager/common/InputInterface.h>
+#include <keyboardmanager/common/KeyStateTracker.h>
 #include <vector>
 #include <functional>
 #include <interface/lowlevel_keyboard_event_data.h>
@@ -9,8 +10,8 @@ class MockedInput :
     public InputInterface
 {
 private:
-    // Stores the states for all the keys - false for key up, and true for key down
-    std::vector<bool> keyboardState;
+    // Stores the states for all the keys
+    KeyStateTracker keyboardState;
 
     // Function to be executed as a low level hook. By default it is nullptr so the hook is skipped
     std::function<intptr_t(LowlevelKeyboardEvent*)> hookProc;
@@ -19,26 +20,27 @@ private:
     int sendVirtualInputCallCount = 0;
     std::function<bool(LowlevelKeyboardEvent*)> sendVirtualInputCallCondition;
 
-    std::wstring currentProcess;
+    ProcessName currentProcess;
 
 public:
-    MockedInput()
-    {
-        keyboardState.resize(256, false);
-    }
-
     // Set the keyboard hook procedure to be tested
     void SetHookProc(std::function<intptr_t(LowlevelKeyboardEvent*)> hookProcedure);
 
     // Function to simulate keyboard input
     UINT SendVirtualInput(UINT cInputs, LPINPUT pInputs, int cbSize);
 
+    // Function to simulate a key event which is not injected by SendVirtualInput, such as an event of a recorded key trace. Returns the result of the hook
+    intptr_t SendLowlevelKeyEvent(LowlevelKeyboardEvent* data);
+
     // Function to simulate keyboard hook behavior
     intptr_t MockedKeyboardHook(LowlevelKeyboardEvent* data);
 
     // Function to get the state of a particular key
     bool GetVirtualKeyState(int key);
 
+    // Function to get the state of all the keys
+    const KeyStateTracker& GetKeyStateTracker();
+
     // Function to reset the mocked keyboard state
     void ResetKeyboardState();
 
@@ -51,6 +53,6 @@ public:
     // Function to get the foreground process name
     void SetForegroundProcess(std::wstring process);
 
-    // Function to get the foreground process name
-    void GetForegroundProcess(_Out_ std::wstring& foregroundProcess);
+    // Function to get the name of the foreground process
+    const ProcessName& GetForegroundProcess();
 };
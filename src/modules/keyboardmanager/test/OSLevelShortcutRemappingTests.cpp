@@ -2002,7 +2002,7 @@ namespace RemappingLogicTests
             Assert::AreEqual(mockedInputHandler.GetVirtualKeyState(0x56), true);
 
             // Shortcut invoked state should be true
-            Assert::AreEqual(true, testState.osLevelShortcutReMap[src].isShortcutInvoked);
+            Assert::AreEqual(true, testState.hookState.osLevelShortcutInvokeState.IsShortcutInvoked());
         }
     };
 }
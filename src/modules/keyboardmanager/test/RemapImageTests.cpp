@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/common/KeyboardManagerState.h>
+#include <keyboardmanager/common/RemapImage.h>
+#include <keyboardmanager/dll/KeyboardEventHandlers.h>
+#include "TestHelpers.h"
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for the compiled remap image and the bulk replacement of the remappings
+    TEST_CLASS (RemapImageTests)
+    {
+    private:
+        MockedInput mockedInputHandler;
+        KeyboardManagerState testState;
+        std::wstring sourcePath;
+        std::wstring imagePath;
+
+        // Function to write the source file the image is compiled from
+        void WriteSource(const std::string& content)
+        {
+            std::ofstream file(sourcePath, std::ios::binary | std::ios::trunc);
+            file << content;
+        }
+
+        // Function to save an image of the configuration, stamped with the current source file
+        void SaveImage(const RemapConfiguration& config)
+        {
+            ULONG64 sourceWriteTime;
+            ULONG64 sourceSize;
+            Assert::IsTrue(RemapImage::GetSourceStamp(sourcePath, sourceWriteTime, sourceSize));
+
+            RemapImage image;
+            image.AddConfiguration(config);
+            Assert::IsTrue(image.Save(imagePath, sourceWriteTime, sourceSize));
+        }
+
+        static RemapConfiguration CreateConfiguration()
+        {
+            RemapConfiguration config;
+            config.AddSingleKeyRemap(0x41, 0x42);
+            config.AddSingleKeyRemap(0x43, TestHelpers::CreateShortcut({ VK_CONTROL, 0x56 }));
+            config.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x41 }), TestHelpers::CreateShortcut({ VK_MENU, VK_SHIFT, 0x56 }));
+            config.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_LWIN, VK_CONTROL, VK_MENU, VK_SHIFT, 0x42 }), (DWORD)VK_ESCAPE);
+            config.AddAppSpecificShortcut(L"Notepad.exe", TestHelpers::CreateShortcut({ VK_CONTROL, 0x41 }), (DWORD)0x44);
+            config.AddAppSpecificShortcut(L"notepad.exe", TestHelpers::CreateShortcut({ VK_CONTROL, 0x42 }), (DWORD)0x45);
+            config.AddAppSpecificShortcut(L"msedge.exe", TestHelpers::CreateShortcut({ VK_CONTROL, 0x41 }), TestHelpers::CreateShortcut({ VK_CONTROL, 0x46 }));
+            return config;
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+
+            wchar_t tempFolder[MAX_PATH];
+            GetTempPath(MAX_PATH, tempFolder);
+            sourcePath = std::wstring(tempFolder) + L"RemapImageTests.json";
+            imagePath = std::wstring(tempFolder) + L"RemapImageTests" + KeyboardManagerConstants::RemapImageFileExtension;
+            WriteSource("{}");
+        }
+
+        TEST_METHOD_CLEANUP(CleanupTestEnv)
+        {
+            DeleteFile(sourcePath.c_str());
+            DeleteFile(imagePath.c_str());
+        }
+
+        // Test if all the remappings of a configuration are loaded back from its image
+        TEST_METHOD (RemapImage_ShouldLoadSameRemaps_WhenSavedAndLoaded)
+        {
+            RemapConfiguration config = CreateConfiguration();
+            SaveImage(config);
+
+            RemapConfiguration loadedConfig;
+            Assert::IsTrue(RemapImage::Load(imagePath, sourcePath, loadedConfig));
+
+            Assert::IsTrue(loadedConfig.singleKeyReMap == config.singleKeyReMap);
+            Assert::AreEqual(config.osLevelShortcutReMap.size(), loadedConfig.osLevelShortcutReMap.size());
+            for (const auto& it : config.osLevelShortcutReMap)
+            {
+                auto loaded = loadedConfig.osLevelShortcutReMap.find(it.first);
+                Assert::IsTrue(loaded != loadedConfig.osLevelShortcutReMap.end());
+                Assert::IsTrue(loaded->second.targetShortcut == it.second.targetShortcut);
+            }
+
+            Assert::AreEqual(config.appSpecificShortcutReMap.size(), loadedConfig.appSpecificShortcutReMap.size());
+            for (const auto& itApp : config.appSpecificShortcutReMap)
+            {
+                const auto& loadedApp = loadedConfig.appSpecificShortcutReMap[itApp.first];
+                Assert::AreEqual(itApp.second.size(), loadedApp.size());
+                for (const auto& it : itApp.second)
+                {
+                    auto loaded = loadedApp.find(it.first);
+                    Assert::IsTrue(loaded != loadedApp.end());
+                    Assert::IsTrue(loaded->second.targetShortcut == it.second.targetShortcut);
+                }
+            }
+        }
+
+        // Test if an image is rejected when the configuration file changed after it was compiled
+        TEST_METHOD (RemapImage_ShouldNotLoad_WhenSourceFileChanged)
+        {
+            SaveImage(CreateConfiguration());
+            WriteSource("{ \"remapKeys\": {} }");
+
+            RemapConfiguration loadedConfig;
+            Assert::IsFalse(RemapImage::Load(imagePath, sourcePath, loadedConfig));
+        }
+
+        // Test if a missing or truncated image is rejected
+        TEST_METHOD (RemapImage_ShouldNotLoad_WhenImageIsMissingOrTruncated)
+        {
+            RemapConfiguration loadedConfig;
+            Assert::IsFalse(RemapImage::Load(imagePath, sourcePath, loadedConfig));
+
+            SaveImage(CreateConfiguration());
+            HANDLE file = CreateFile(imagePath.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            Assert::IsTrue(file != INVALID_HANDLE_VALUE);
+            SetFilePointer(file, -4, nullptr, FILE_END);
+            SetEndOfFile(file);
+            CloseHandle(file);
+
+            Assert::IsFalse(RemapImage::Load(imagePath, sourcePath, loadedConfig));
+        }
+
+        // Test if replacing the remappings removes the previous ones and makes the new shortcuts available to the hook
+        TEST_METHOD (ReplaceRemaps_ShouldReplaceAllRemaps_WhenCalled)
+        {
+            testState.AddSingleKeyRemap(0x44, 0x45);
+            testState.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x43 }), (DWORD)0x44);
+
+            testState.ReplaceRemaps(CreateConfiguration());
+
+            Assert::IsTrue(testState.singleKeyReMap.find(0x44) == testState.singleKeyReMap.end());
+            Assert::AreEqual((size_t)2, testState.singleKeyReMap.size());
+            Assert::AreEqual((size_t)2, testState.osLevelShortcutReMap.size());
+            Assert::AreEqual((size_t)2, testState.osLevelShortcutReMapSnapshot.Get()->table.Size());
+            Assert::AreEqual((size_t)2, testState.appSpecificShortcutReMapSnapshot.Get()->at(L"notepad.exe")->table.Size());
+
+            // Ctrl+A should be remapped to Alt+Shift+V by the new table
+            std::function<intptr_t(LowlevelKeyboardEvent*)> currentHookProc = std::bind(&KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent, std::ref(mockedInputHandler), std::placeholders::_1, std::ref(testState));
+            mockedInputHandler.SetHookProc(currentHookProc);
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(VK_CONTROL));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_MENU));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(VK_SHIFT));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x56));
+        }
+    };
+}
@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/common/KeyboardManagerState.h>
+#include <keyboardmanager/common/RemapSnapshot.h>
+#include <keyboardmanager/dll/KeyboardEventHandlers.h>
+#include "TestHelpers.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for the remap snapshots read by the keyboard hook
+    TEST_CLASS (RemapSnapshotTests)
+    {
+    private:
+        MockedInput mockedInputHandler;
+        KeyboardManagerState testState;
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+        }
+
+        // Test if a reader keeps the snapshot it read until a new one is published, and if the previous snapshot stays valid for its holders
+        TEST_METHOD (SnapshotReader_ShouldReadNewSnapshot_OnlyWhenPublished)
+        {
+            SnapshotPublisher<SingleKeyRemapSnapshot> publisher;
+            SnapshotReader<SingleKeyRemapSnapshot> reader;
+
+            auto first = std::make_shared<SingleKeyRemapSnapshot>();
+            (*first)[0x41] = (DWORD)0x42;
+            publisher.Publish(first);
+
+            std::shared_ptr<const SingleKeyRemapSnapshot> held = reader.Read(publisher);
+            Assert::IsTrue(held.get() == first.get());
+            Assert::IsTrue(reader.Read(publisher).get() == first.get());
+
+            auto second = std::make_shared<SingleKeyRemapSnapshot>();
+            (*second)[0x41] = (DWORD)0x43;
+            publisher.Publish(second);
+            first.reset();
+
+            Assert::IsTrue(reader.Read(publisher).get() == second.get());
+            Assert::IsTrue(std::get<DWORD>(held->at(0x41)) == 0x42);
+        }
+
+        // Test if the single key remap hook doesn't take the remap mutex, which is held by the UI while it edits the remappings
+        TEST_METHOD (HandleSingleKeyRemapEvent_ShouldRemap_WhenRemapMutexIsHeld)
+        {
+            std::function<intptr_t(LowlevelKeyboardEvent*)> currentHookProc = std::bind(&KeyboardEventHandlers::HandleSingleKeyRemapEvent, std::ref(mockedInputHandler), std::placeholders::_1, std::ref(testState));
+            mockedInputHandler.SetHookProc(currentHookProc);
+
+            // Remap A to B
+            testState.AddSingleKeyRemap(0x41, 0x42);
+            std::lock_guard<std::mutex> lock(testState.singleKeyReMap_mutex);
+
+            INPUT input[1] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = 0x41;
+            mockedInputHandler.SendVirtualInput(1, input, sizeof(INPUT));
+
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x42));
+        }
+
+        // Test if the shortcut remap hook doesn't take the remap mutex, and if a remapping added by the UI is used by the next key event
+        TEST_METHOD (HandleOSLevelShortcutRemapEvent_ShouldUsePublishedRemap_WhenRemapMutexIsHeld)
+        {
+            std::function<intptr_t(LowlevelKeyboardEvent*)> currentHookProc = std::bind(&KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent, std::ref(mockedInputHandler), std::placeholders::_1, std::ref(testState));
+            mockedInputHandler.SetHookProc(currentHookProc);
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+
+            // Send Ctrl+A keydown before and after remapping Ctrl+A to B
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x41));
+
+            input[0].ki.dwFlags = KEYEVENTF_KEYUP;
+            input[1].ki.dwFlags = KEYEVENTF_KEYUP;
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            testState.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x41 }), (DWORD)0x42);
+            std::lock_guard<std::mutex> lock(testState.osLevelShortcutReMap_mutex);
+
+            input[0].ki.dwFlags = 0;
+            input[1].ki.dwFlags = 0;
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(VK_CONTROL));
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x41));
+            Assert::AreEqual(true, mockedInputHandler.GetVirtualKeyState(0x42));
+            Assert::IsTrue(testState.hookState.osLevelShortcutInvokeState.IsShortcutInvoked());
+        }
+
+        // Test if the invoked shortcut is reset when a new snapshot remaps it to a different target
+        TEST_METHOD (InvokeState_ShouldBeReset_WhenInvokedShortcutIsRemappedToAnotherTarget)
+        {
+            std::function<intptr_t(LowlevelKeyboardEvent*)> currentHookProc = std::bind(&KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent, std::ref(mockedInputHandler), std::placeholders::_1, std::ref(testState));
+            mockedInputHandler.SetHookProc(currentHookProc);
+
+            Shortcut src = TestHelpers::CreateShortcut({ VK_CONTROL, 0x41 });
+            testState.AddOSLevelShortcut(src, (DWORD)0x42);
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            ShortcutInvokeState& invokeState = testState.hookState.osLevelShortcutInvokeState;
+            Assert::IsTrue(invokeState.IsShortcutInvoked());
+
+            // The same shortcut remapped to the same target keeps the invoked state, while a different target resets it
+            RemapConfiguration sameTarget;
+            sameTarget.AddOSLevelShortcut(src, (DWORD)0x42);
+            testState.ReplaceRemaps(std::move(sameTarget));
+            auto snapshot = testState.osLevelShortcutReMapSnapshot.Get();
+            Assert::IsFalse(invokeState.GetInvokedEntry(snapshot->table).empty());
+
+            RemapConfiguration otherTarget;
+            otherTarget.AddOSLevelShortcut(src, (DWORD)0x43);
+            testState.ReplaceRemaps(std::move(otherTarget));
+            snapshot = testState.osLevelShortcutReMapSnapshot.Get();
+            Assert::IsTrue(invokeState.GetInvokedEntry(snapshot->table).empty());
+            Assert::IsFalse(invokeState.IsShortcutInvoked());
+        }
+
+        // Test if an editor replacing the shortcut tables keeps the key remaps, and if the hook sees the new table only once it is complete
+        TEST_METHOD (ReplaceRemaps_ShouldKeepOtherTables_WhenEditorReplacesShortcuts)
+        {
+            testState.AddSingleKeyRemap(0x41, (DWORD)0x42);
+            testState.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x43 }), (DWORD)0x44);
+            auto previousSnapshot = testState.osLevelShortcutReMapSnapshot.Get();
+
+            RemapConfiguration config = testState.GetRemaps();
+            config.osLevelShortcutReMap.clear();
+            config.appSpecificShortcutReMap.clear();
+            Assert::IsTrue(config.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x45 }), (DWORD)0x46));
+            Assert::IsTrue(config.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_MENU, 0x45 }), (DWORD)0x47));
+            Assert::IsTrue(config.AddAppSpecificShortcut(L"Notepad.exe", TestHelpers::CreateShortcut({ VK_CONTROL, 0x45 }), (DWORD)0x48));
+
+            // Nothing is published before the configuration is replaced
+            Assert::IsTrue(testState.osLevelShortcutReMapSnapshot.Get().get() == previousSnapshot.get());
+            testState.ReplaceRemaps(std::move(config));
+
+            Assert::AreEqual((size_t)1, testState.singleKeyReMap.size());
+            Assert::AreEqual((size_t)2, testState.osLevelShortcutReMap.size());
+            Assert::AreEqual((size_t)2, testState.osLevelShortcutReMapSortedKeys.size());
+            Assert::AreEqual((size_t)1, testState.appSpecificShortcutReMap.at(L"notepad.exe").size());
+            Assert::IsTrue(testState.osLevelShortcutReMap.find(TestHelpers::CreateShortcut({ VK_CONTROL, 0x43 })) == testState.osLevelShortcutReMap.end());
+            Assert::IsTrue(std::get<DWORD>(testState.singleKeyReMapSnapshot.Get()->at(0x41)) == 0x42);
+        }
+    };
+}
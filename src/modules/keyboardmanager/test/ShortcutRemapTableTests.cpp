@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MockedInput.h"
+#include <keyboardmanager/common/KeyboardManagerState.h>
+#include <keyboardmanager/common/ShortcutRemapTable.h>
+#include <keyboardmanager/dll/KeyboardEventHandlers.h>
+#include "TestHelpers.h"
+#include <chrono>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RemappingLogicTests
+{
+    // Tests for the lookup table used by the shortcut remap handlers
+    TEST_CLASS (ShortcutRemapTableTests)
+    {
+    private:
+        MockedInput mockedInputHandler;
+        KeyboardManagerState testState;
+
+        // Function to send key events through the mocked hook and return the average time per event in microseconds
+        double TimeKeyEvents(INPUT* input, int nInputs, int iterations)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+            }
+            auto elapsed = std::chrono::high_resolution_clock::now() - start;
+            return std::chrono::duration<double, std::micro>(elapsed).count() / ((double)iterations * nInputs);
+        }
+
+    public:
+        TEST_METHOD_INITIALIZE(InitializeTestEnv)
+        {
+            // Reset test environment
+            TestHelpers::ResetTestEnv(mockedInputHandler, testState);
+
+            // Set HandleOSLevelShortcutRemapEvent as the hook procedure
+            std::function<intptr_t(LowlevelKeyboardEvent*)> currentHookProc = std::bind(&KeyboardEventHandlers::HandleOSLevelShortcutRemapEvent, std::ref(mockedInputHandler), std::placeholders::_1, std::ref(testState));
+            mockedInputHandler.SetHookProc(currentHookProc);
+        }
+
+        // Test if the candidates of an action key are the shortcuts with that action key in the sorted order
+        TEST_METHOD (GetCandidates_ShouldReturnShortcutsWithActionKeyInSortedOrder)
+        {
+            Shortcut ctrlA = TestHelpers::CreateShortcut({ VK_CONTROL, 0x41 });
+            Shortcut ctrlShiftA = TestHelpers::CreateShortcut({ VK_CONTROL, VK_SHIFT, 0x41 });
+            Shortcut ctrlB = TestHelpers::CreateShortcut({ VK_CONTROL, 0x42 });
+            testState.AddOSLevelShortcut(ctrlA, (DWORD)0x43);
+            testState.AddOSLevelShortcut(ctrlB, (DWORD)0x43);
+            testState.AddOSLevelShortcut(ctrlShiftA, (DWORD)0x43);
+
+            auto snapshot = testState.osLevelShortcutReMapSnapshot.Get();
+            const ShortcutRemapTable& table = snapshot->table;
+            Assert::AreEqual((size_t)3, table.Size());
+
+            // Larger shortcuts come first, as in osLevelShortcutReMapSortedKeys
+            auto candidates = table.GetCandidates(0x41);
+            Assert::AreEqual((ptrdiff_t)2, candidates.end() - candidates.begin());
+            Assert::IsTrue(candidates.begin()[0].remap->first == ctrlShiftA);
+            Assert::IsTrue(candidates.begin()[1].remap->first == ctrlA);
+
+            candidates = table.GetCandidates(0x42);
+            Assert::AreEqual((ptrdiff_t)1, candidates.end() - candidates.begin());
+            Assert::IsTrue(candidates.begin()[0].remap->first == ctrlB);
+
+            Assert::IsTrue(table.GetCandidates(0x43).empty());
+            Assert::IsTrue(table.GetCandidates(0x1000).empty());
+        }
+
+        // Test if the invoked shortcut is kept when a new snapshot of the table is published and cleared when it is released
+        TEST_METHOD (InvokedEntry_ShouldBeKeptOnRebuildAndReset_OnRelease)
+        {
+            // Remap Ctrl+A to B
+            Shortcut src = TestHelpers::CreateShortcut({ VK_CONTROL, 0x41 });
+            testState.AddOSLevelShortcut(src, (DWORD)0x42);
+
+            const int nInputs = 2;
+            INPUT input[nInputs] = {};
+            input[0].type = INPUT_KEYBOARD;
+            input[0].ki.wVk = VK_CONTROL;
+            input[1].type = INPUT_KEYBOARD;
+            input[1].ki.wVk = 0x41;
+
+            // Send Ctrl+A keydown
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+            ShortcutInvokeState& invokeState = testState.hookState.osLevelShortcutInvokeState;
+            Assert::IsTrue(invokeState.IsShortcutInvoked());
+
+            // Adding a remap publishes a new snapshot, in which the invoked shortcut is found again
+            testState.AddOSLevelShortcut(TestHelpers::CreateShortcut({ VK_CONTROL, 0x43 }), (DWORD)0x44);
+            auto snapshot = testState.osLevelShortcutReMapSnapshot.Get();
+            auto invoked = invokeState.GetInvokedEntry(snapshot->table);
+            Assert::IsFalse(invoked.empty());
+            Assert::IsTrue(invoked.begin()->remap->first == src);
+
+            // Release A then Ctrl
+            input[0].ki.wVk = 0x41;
+            input[0].ki.dwFlags = KEYEVENTF_KEYUP;
+            input[1].ki.wVk = VK_CONTROL;
+            input[1].ki.dwFlags = KEYEVENTF_KEYUP;
+            mockedInputHandler.SendVirtualInput(nInputs, input, sizeof(INPUT));
+
+            Assert::IsFalse(invokeState.IsShortcutInvoked());
+            Assert::AreEqual(false, mockedInputHandler.GetVirtualKeyState(0x42));
+        }
+
+        // Benchmark of the shortcut remap hook with a large configuration
+        TEST_METHOD (HandleOSLevelShortcutRemapEvent_Benchmark_With600Shortcuts)
+        {
+            const int shortcutCount = 600;
+            const int iterations = 2000;
+            Assert::IsTrue(TestHelpers::AddOSLevelShortcuts(testState, shortcutCount, (DWORD)VK_F13));
+            Assert::AreEqual((size_t)shortcutCount, testState.osLevelShortcutReMapSnapshot.Get()->table.Size());
+
+            // Typing without modifiers, which is the most common key event and doesn't match any shortcut
+            INPUT typing[4] = {};
+            for (int i = 0; i < (int)ARRAYSIZE(typing); i++)
+            {
+                typing[i].type = INPUT_KEYBOARD;
+                typing[i].ki.wVk = (WORD)((i < 2) ? 0x41 : 0x42);
+                typing[i].ki.dwFlags = (i % 2) ? KEYEVENTF_KEYUP : 0;
+            }
+            double typingTime = TimeKeyEvents(typing, ARRAYSIZE(typing), iterations);
+
+            // Pressing and releasing Ctrl+Alt+Shift+Z with the left modifier keys. Of the shortcuts added by AddOSLevelShortcuts with Z as action key it is the only one with four keys
+            INPUT remap[8] = {};
+            const WORD remapKeys[] = { VK_LCONTROL, VK_LMENU, VK_LSHIFT, 0x5A };
+            for (int i = 0; i < 4; i++)
+            {
+                remap[i].type = INPUT_KEYBOARD;
+                remap[i].ki.wVk = remapKeys[i];
+                remap[7 - i].type = INPUT_KEYBOARD;
+                remap[7 - i].ki.wVk = remapKeys[i];
+                remap[7 - i].ki.dwFlags = KEYEVENTF_KEYUP;
+            }
+            mockedInputHandler.SetSendVirtualInputTestHandler([](LowlevelKeyboardEvent* data) {
+                return data->lParam->vkCode == VK_F13 && data->wParam == WM_KEYDOWN;
+            });
+            double remapTime = TimeKeyEvents(remap, ARRAYSIZE(remap), iterations);
+
+            // Every press of the shortcut should have been remapped
+            Assert::AreEqual(iterations, mockedInputHandler.GetSendVirtualInputCallCount());
+            Assert::IsFalse(testState.hookState.osLevelShortcutInvokeState.IsShortcutInvoked());
+
+            Logger::WriteMessage((L"Shortcuts: " + std::to_wstring(shortcutCount) + L"\n").c_str());
+            Logger::WriteMessage((L"Typing: " + std::to_wstring(typingTime) + L" us per event\n").c_str());
+            Logger::WriteMessage((L"Remapped shortcut: " + std::to_wstring(remapTime) + L" us per event\n").c_str());
+        }
+    };
+}
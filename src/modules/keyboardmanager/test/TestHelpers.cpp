@@ -15,6 +15,7 @@ namespace TestHelpers
         state.ClearSingleKeyRemaps();
         state.ClearOSLevelShortcuts();
         state.ClearAppSpecificShortcuts();
+        state.hookState = RemapHookState();
 
         // Allocate memory for the keyboardManagerState activatedApp member to avoid CRT assert errors
         std::wstring maxLengthString;
@@ -22,4 +23,54 @@ namespace TestHelpers
         state.SetActivatedApp(maxLengthString);
         state.SetActivatedApp(KeyboardManagerConstants::NoActivatedApp);
     }
+
+    // Function to create a shortcut from its key codes
+    Shortcut CreateShortcut(std::initializer_list<DWORD> keys)
+    {
+        Shortcut shortcut;
+        for (DWORD key : keys)
+        {
+            shortcut.SetKey(key);
+        }
+        return shortcut;
+    }
+
+    // Function to add count distinct os level shortcut remaps to the same target, cycling through the letter and digit action keys and the Ctrl/Alt/Shift combinations. Returns false if a shortcut could not be added
+    bool AddOSLevelShortcuts(KeyboardManagerState& state, int count, const std::variant<DWORD, Shortcut>& target)
+    {
+        const DWORD ctrlKeys[] = { VK_CONTROL, VK_LCONTROL, VK_RCONTROL };
+        const DWORD altKeys[] = { NULL, VK_MENU, VK_LMENU, VK_RMENU };
+        const DWORD shiftKeys[] = { NULL, VK_SHIFT, VK_LSHIFT, VK_RSHIFT };
+        std::vector<DWORD> actionKeys;
+        for (DWORD key = 0x41; key <= 0x5A; key++)
+        {
+            actionKeys.push_back(key);
+        }
+        for (DWORD key = 0x30; key <= 0x39; key++)
+        {
+            actionKeys.push_back(key);
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            int modifiers = i / (int)actionKeys.size();
+            Shortcut src;
+            src.SetKey(ctrlKeys[modifiers % 3]);
+            if (altKeys[(modifiers / 3) % 4] != NULL)
+            {
+                src.SetKey(altKeys[(modifiers / 3) % 4]);
+            }
+            if (shiftKeys[(modifiers / 12) % 4] != NULL)
+            {
+                src.SetKey(shiftKeys[(modifiers / 12) % 4]);
+            }
+            src.SetKey(actionKeys[i % actionKeys.size()]);
+            if (!state.AddOSLevelShortcut(src, target))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
 }
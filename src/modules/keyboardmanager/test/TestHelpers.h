@@ -1,9 +1,18 @@
 #pragma once
+#include <initializer_list>
+#include <variant>
 class MockedInput;
 class KeyboardManagerState;
+class Shortcut;
 
 namespace TestHelpers
 {
     // Function to reset the environment variables for tests
     void ResetTestEnv(MockedInput& input, KeyboardManagerState& state);
+
+    // Function to create a shortcut from its key codes
+    Shortcut CreateShortcut(std::initializer_list<DWORD> keys);
+
+    // Function to add count distinct os level shortcut remaps to the same target, cycling through the letter and digit action keys and the Ctrl/Alt/Shift combinations. Returns false if a shortcut could not be added
+    bool AddOSLevelShortcuts(KeyboardManagerState& state, int count, const std::variant<DWORD, Shortcut>& target);
 }
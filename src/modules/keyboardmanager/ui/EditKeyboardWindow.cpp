@@ -324,8 +324,9 @@ void createEditKeyboardWindow(HINSTANCE hInst, KeyboardManagerState& keyboardMan
 
     auto ApplyRemappings = [&keyboardManagerState, _hWndEditKeyboardWindow]() {
         KeyboardManagerHelper::ErrorType isSuccess = KeyboardManagerHelper::ErrorType::NoError;
-        // Clear existing Key Remaps
-        keyboardManagerState.ClearSingleKeyRemaps();
+        // Replace the existing Key Remaps and keep the shortcuts. The new table is published to the hook at once, once it is complete
+        RemapConfiguration config = keyboardManagerState.GetRemaps();
+        config.singleKeyReMap.clear();
         DWORD successfulKeyToKeyRemapCount = 0;
         DWORD successfulKeyToShortcutRemapCount = 0;
         for (int i = 0; i < SingleKeyRemapControl::singleKeyRemapBuffer.size(); i++)
@@ -341,27 +342,27 @@ void createEditKeyboardWindow(HINSTANCE hInst, KeyboardManagerState& keyboardMan
                 switch (originalKey)
                 {
                 case VK_CONTROL:
-                    res1 = keyboardManagerState.AddSingleKeyRemap(VK_LCONTROL, newKey);
-                    res2 = keyboardManagerState.AddSingleKeyRemap(VK_RCONTROL, newKey);
+                    res1 = config.AddSingleKeyRemap(VK_LCONTROL, newKey);
+                    res2 = config.AddSingleKeyRemap(VK_RCONTROL, newKey);
                     result = res1 && res2;
                     break;
                 case VK_MENU:
-                    res1 = keyboardManagerState.AddSingleKeyRemap(VK_LMENU, newKey);
-                    res2 = keyboardManagerState.AddSingleKeyRemap(VK_RMENU, newKey);
+                    res1 = config.AddSingleKeyRemap(VK_LMENU, newKey);
+                    res2 = config.AddSingleKeyRemap(VK_RMENU, newKey);
                     result = res1 && res2;
                     break;
                 case VK_SHIFT:
-                    res1 = keyboardManagerState.AddSingleKeyRemap(VK_LSHIFT, newKey);
-                    res2 = keyboardManagerState.AddSingleKeyRemap(VK_RSHIFT, newKey);
+                    res1 = config.AddSingleKeyRemap(VK_LSHIFT, newKey);
+                    res2 = config.AddSingleKeyRemap(VK_RSHIFT, newKey);
                     result = res1 && res2;
                     break;
                 case CommonSharedConstants::VK_WIN_BOTH:
-                    res1 = keyboardManagerState.AddSingleKeyRemap(VK_LWIN, newKey);
-                    res2 = keyboardManagerState.AddSingleKeyRemap(VK_RWIN, newKey);
+                    res1 = config.AddSingleKeyRemap(VK_LWIN, newKey);
+                    res2 = config.AddSingleKeyRemap(VK_RWIN, newKey);
                     result = res1 && res2;
                     break;
                 default:
-                    result = keyboardManagerState.AddSingleKeyRemap(originalKey, newKey);
+                    result = config.AddSingleKeyRemap(originalKey, newKey);
                 }
 
                 if (!result)
@@ -386,6 +387,7 @@ void createEditKeyboardWindow(HINSTANCE hInst, KeyboardManagerState& keyboardMan
                 isSuccess = KeyboardManagerHelper::ErrorType::RemapUnsuccessful;
             }
         }
+        keyboardManagerState.ReplaceRemaps(std::move(config));
 
         Trace::KeyRemapCount(successfulKeyToKeyRemapCount, successfulKeyToShortcutRemapCount);
         // Save the updated shortcuts remaps to file.
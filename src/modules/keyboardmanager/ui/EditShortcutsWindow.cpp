@@ -253,9 +253,10 @@ void createEditShortcutsWindow(HINSTANCE hInst, KeyboardManagerState& keyboardMa
 
     auto ApplyRemappings = [&keyboardManagerState, _hWndEditShortcutsWindow]() {
         KeyboardManagerHelper::ErrorType isSuccess = KeyboardManagerHelper::ErrorType::NoError;
-        // Clear existing shortcuts
-        keyboardManagerState.ClearOSLevelShortcuts();
-        keyboardManagerState.ClearAppSpecificShortcuts();
+        // Replace the existing shortcuts and keep the key remaps. The new tables are published to the hook at once, once they are complete
+        RemapConfiguration config = keyboardManagerState.GetRemaps();
+        config.osLevelShortcutReMap.clear();
+        config.appSpecificShortcutReMap.clear();
         DWORD successfulOSLevelShortcutToShortcutRemapCount = 0;
         DWORD successfulOSLevelShortcutToKeyRemapCount = 0;
         DWORD successfulAppSpecificShortcutToShortcutRemapCount = 0;
@@ -270,7 +271,7 @@ void createEditShortcutsWindow(HINSTANCE hInst, KeyboardManagerState& keyboardMa
             {
                 if (ShortcutControl::shortcutRemapBuffer[i].second == L"")
                 {
-                    bool result = keyboardManagerState.AddOSLevelShortcut(originalShortcut, newShortcut);
+                    bool result = config.AddOSLevelShortcut(originalShortcut, newShortcut);
                     if (!result)
                     {
                         isSuccess = KeyboardManagerHelper::ErrorType::RemapUnsuccessful;
@@ -289,7 +290,7 @@ void createEditShortcutsWindow(HINSTANCE hInst, KeyboardManagerState& keyboardMa
                 }
                 else
                 {
-                    bool result = keyboardManagerState.AddAppSpecificShortcut(ShortcutControl::shortcutRemapBuffer[i].second, originalShortcut, newShortcut);
+                    bool result = config.AddAppSpecificShortcut(ShortcutControl::shortcutRemapBuffer[i].second, originalShortcut, newShortcut);
                     if (!result)
                     {
                         isSuccess = KeyboardManagerHelper::ErrorType::RemapUnsuccessful;
@@ -312,6 +313,7 @@ void createEditShortcutsWindow(HINSTANCE hInst, KeyboardManagerState& keyboardMa
                 isSuccess = KeyboardManagerHelper::ErrorType::RemapUnsuccessful;
             }
         }
+        keyboardManagerState.ReplaceRemaps(std::move(config));
 
         // Telemetry events
         Trace::OSLevelShortcutRemapCount(successfulOSLevelShortcutToShortcutRemapCount, successfulOSLevelShortcutToKeyRemapCount);
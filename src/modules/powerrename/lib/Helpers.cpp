@@ -1,35 +1,18 @@
 #include "pch.h"
 #include "Helpers.h"
-#include <regex>
+#include "PowerRenameNameTransform.h"
 #include <ShlGuid.h>
 #include <cstring>
-#include <filesystem>
-
-namespace fs = std::filesystem;
+#include <vector>
 
 HRESULT GetTrimmedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source)
 {
     HRESULT hr = (source && wcslen(source) > 0) ? S_OK : E_INVALIDARG;
     if (SUCCEEDED(hr))
     {
-        PWSTR newName = nullptr;
-        hr = SHStrDup(source, &newName);
-        if (SUCCEEDED(hr))
-        {
-            size_t firstValidIndex = 0, lastValidIndex = wcslen(newName) - 1;
-            while (firstValidIndex <= lastValidIndex && iswspace(newName[firstValidIndex]))
-            {
-                firstValidIndex++;
-            }
-            while (firstValidIndex <= lastValidIndex && (iswspace(newName[lastValidIndex]) || newName[lastValidIndex] == L'.'))
-            {
-                lastValidIndex--;
-            }
-            newName[lastValidIndex + 1] = '\0';
-
-            hr = StringCchCopy(result, cchMax, newName + firstValidIndex);
-        }
-        CoTaskMemFree(newName);
+        std::wstring name(source);
+        TrimFileName(name);
+        hr = StringCchCopy(result, cchMax, name.c_str());
     }
 
     return hr;
@@ -37,213 +20,103 @@ HRESULT GetTrimmedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source)
 
 HRESULT GetTransformedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source, DWORD flags)
 {
-    std::locale::global(std::locale(""));
     HRESULT hr = (source && wcslen(source) > 0 && flags) ? S_OK : E_INVALIDARG;
     if (SUCCEEDED(hr))
     {
-        if (flags & Uppercase)
-        {
-            if (flags & NameOnly)
-            {
-                std::wstring stem = fs::path(source).stem().wstring();
-                std::transform(stem.begin(), stem.end(), stem.begin(), ::towupper);
-                hr = StringCchPrintf(result, cchMax, L"%s%s", stem.c_str(), fs::path(source).extension().c_str());
-            }
-            else if (flags & ExtensionOnly)
-            {
-                std::wstring extension = fs::path(source).extension().wstring();
-                if (!extension.empty())
-                {
-                    std::transform(extension.begin(), extension.end(), extension.begin(), ::towupper);
-                    hr = StringCchPrintf(result, cchMax, L"%s%s", fs::path(source).stem().c_str(), extension.c_str());
-                }
-                else
-                {
-                    hr = StringCchCopy(result, cchMax, source);
-                    if (SUCCEEDED(hr))
-                    {
-                        std::transform(result, result + wcslen(result), result, ::towupper);
-                    }
-                }
-            }
-            else
-            {
-                hr = StringCchCopy(result, cchMax, source);
-                if (SUCCEEDED(hr))
-                {
-                    std::transform(result, result + wcslen(result), result, ::towupper);
-                }
-            }
-        }
-        else if (flags & Lowercase)
-        {
-            if (flags & NameOnly)
-            {
-                std::wstring stem = fs::path(source).stem().wstring();
-                std::transform(stem.begin(), stem.end(), stem.begin(), ::towlower);
-                hr = StringCchPrintf(result, cchMax, L"%s%s", stem.c_str(), fs::path(source).extension().c_str());
-            }
-            else if (flags & ExtensionOnly)
-            {
-                std::wstring extension = fs::path(source).extension().wstring();
-                if (!extension.empty())
-                {
-                    std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
-                    hr = StringCchPrintf(result, cchMax, L"%s%s", fs::path(source).stem().c_str(), extension.c_str());
-                }
-                else
-                {
-                    hr = StringCchCopy(result, cchMax, source);
-                    if (SUCCEEDED(hr))
-                    {
-                        std::transform(result, result + wcslen(result), result, ::towlower);
-                    }
-                }
-            }
-            else
-            {
-                hr = StringCchCopy(result, cchMax, source);
-                if (SUCCEEDED(hr))
-                {
-                    std::transform(result, result + wcslen(result), result, ::towlower);
-                }
-            }
-        }
-        else if (flags & Titlecase)
-        {
-            if (!(flags & ExtensionOnly))
-            {
-                std::vector<std::wstring> exceptions = { L"a", L"an", L"to", L"the", L"at", L"by", L"for", L"in", L"of", L"on", L"up", L"and", L"as", L"but", L"or", L"nor" };
-                std::wstring stem = fs::path(source).stem().wstring();
-                std::wstring extension = fs::path(source).extension().wstring();
-
-                size_t stemLength = stem.length();
-                bool isFirstWord = true;
-
-                while (stemLength > 0 && (iswspace(stem[stemLength - 1]) || iswpunct(stem[stemLength - 1])))
-                {
-                    stemLength--;
-                }
-
-                for (size_t i = 0; i < stemLength; i++)
-                {
-                    if (!i || iswspace(stem[i - 1]) || iswpunct(stem[i - 1]))
-                    {
-                        if (iswspace(stem[i]) || iswpunct(stem[i]))
-                        {
-                            continue;
-                        }
-                        size_t wordLength = 0;
-                        while (i + wordLength < stemLength && !iswspace(stem[i + wordLength]) && !iswpunct(stem[i + wordLength]))
-                        {
-                            wordLength++;
-                        }
-                        if (isFirstWord || i + wordLength == stemLength || std::find(exceptions.begin(), exceptions.end(), stem.substr(i, wordLength)) == exceptions.end())
-                        {
-                            stem[i] = towupper(stem[i]);
-                            isFirstWord = false;
-                        }
-                        else
-                        {
-                            stem[i] = towlower(stem[i]);
-                        }
-                    }
-                    else
-                    {
-                        stem[i] = towlower(stem[i]);
-                    }
-                }
-                hr = StringCchPrintf(result, cchMax, L"%s%s", stem.c_str(), extension.c_str());
-            }
-            else
-            {
-                hr = StringCchCopy(result, cchMax, source);
-            }
-        }
-        else
-        {
-            hr = StringCchCopy(result, cchMax, source);
-        }
+        std::wstring name(source);
+        TransformFileNameCase(name, flags);
+        hr = StringCchCopy(result, cchMax, name.c_str());
     }
 
     return hr;
 }
 
-HRESULT GetDatedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source, SYSTEMTIME LocalTime)
+HRESULT GetShellItemArrayFromDataObject(_In_ IUnknown* dataSource, _COM_Outptr_ IShellItemArray** items)
 {
-    HRESULT hr = (source && wcslen(source) > 0) ? S_OK : E_INVALIDARG;     
-    if (SUCCEEDED(hr))
+    *items = nullptr;
+    CComPtr<IDataObject> dataObj;
+    HRESULT hr;
+    if (SUCCEEDED(dataSource->QueryInterface(IID_PPV_ARGS(&dataObj))))
     {
-        std::wregex pattern(L"\\$YYYY");
-        std::wstring res(source);
-        wchar_t replaceTerm[MAX_PATH] = {0};
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%d"),LocalTime.wYear);
-        res = regex_replace(res, pattern, replaceTerm);
-
-        pattern = L"\\$SSS";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%03d"), LocalTime.wMilliseconds);
-        res = regex_replace(res, pattern, replaceTerm);
-
-        pattern = L"\\$MMM";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%03d"), LocalTime.wMilliseconds);
-        res = regex_replace(res, pattern, replaceTerm);
-
-        pattern = L"\\$mmm";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%03d"), LocalTime.wMilliseconds);
-        res = regex_replace(res, pattern, replaceTerm);
-
-        pattern = L"\\$fff";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%03d"), LocalTime.wMilliseconds);
-        res = regex_replace(res, pattern, replaceTerm);
-
-        pattern = L"\\$FFF";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%03d"), LocalTime.wMilliseconds);
-        res = regex_replace(res, pattern, replaceTerm);
-
-        pattern = L"\\$MM" ;
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%02d"), LocalTime.wMonth);
-        res = regex_replace(res, pattern, replaceTerm);
-
-        pattern = L"\\$DD";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%02d"), LocalTime.wDay);
-        res = regex_replace(res, pattern, replaceTerm);
+        hr = SHCreateShellItemArrayFromDataObject(dataObj, IID_PPV_ARGS(items));
+    }
+    else
+    {
+        hr = dataSource->QueryInterface(IID_PPV_ARGS(items));
+    }
 
-        pattern = L"\\$hh";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%02d"), LocalTime.wHour);
-        res = regex_replace(res, pattern, replaceTerm);
+    return hr;
+}
 
-        pattern = L"\\$mm";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%02d"), LocalTime.wMinute);
-        res = regex_replace(res, pattern, replaceTerm);
+namespace
+{
+    // Number of shell items requested per IEnumShellItems::Next call
+    constexpr ULONG c_shellItemFetchCount = 64;
+    // Number of rename items handed to the callback at a time
+    constexpr size_t c_enumeratedItemBatchSize = 512;
 
-        pattern = L"\\$ss";
-        StringCchPrintf(replaceTerm, MAX_PATH, TEXT("%02d"), LocalTime.wSecond);
-        res = regex_replace(res, pattern, replaceTerm);
+    struct EnumerationContext
+    {
+        IPowerRenameItemFactory* itemFactory;
+        const EnumeratedItemsCallback& onItems;
+        std::vector<IPowerRenameItem*> batch;
 
-        hr = StringCchCopy(result, cchMax, res.c_str());
-    }
+        HRESULT Add(_In_ IPowerRenameItem* item)
+        {
+            item->AddRef();
+            batch.push_back(item);
+            return batch.size() < c_enumeratedItemBatchSize ? S_OK : Flush();
+        }
 
-    return hr;
+        HRESULT Flush()
+        {
+            HRESULT hr = S_OK;
+            if (!batch.empty())
+            {
+                hr = onItems(batch.data(), static_cast<UINT>(batch.size()));
+                for (auto item : batch)
+                {
+                    item->Release();
+                }
+                batch.clear();
+            }
+            return hr;
+        }
+    };
 }
 
-HRESULT _GetShellItemArrayFromDataOject(_In_ IUnknown* dataSource, _COM_Outptr_ IShellItemArray** items)
+HRESULT _ParseEnumItems(_In_ IEnumShellItems* pesi, _In_ EnumerationContext& context, _In_ int depth = 0);
+
+HRESULT _ParseShellItem(_In_ IShellItem* psi, _In_ EnumerationContext& context, _In_ int depth)
 {
-    *items = nullptr;
-    CComPtr<IDataObject> dataObj;
-    HRESULT hr;
-    if (SUCCEEDED(dataSource->QueryInterface(IID_PPV_ARGS(&dataObj))))
+    CComPtr<IPowerRenameItem> spNewItem;
+    HRESULT hr = context.itemFactory->Create(psi, &spNewItem);
+    if (SUCCEEDED(hr))
     {
-        hr = SHCreateShellItemArrayFromDataObject(dataObj, IID_PPV_ARGS(items));
+        spNewItem->put_depth(depth);
+        hr = context.Add(spNewItem);
     }
-    else
+
+    if (SUCCEEDED(hr))
     {
-        hr = dataSource->QueryInterface(IID_PPV_ARGS(items));
+        bool isFolder = false;
+        if (SUCCEEDED(spNewItem->get_isFolder(&isFolder)) && isFolder)
+        {
+            // Bind to the IShellItem for the IEnumShellItems interface
+            CComPtr<IEnumShellItems> spesiNext;
+            hr = psi->BindToHandler(nullptr, BHID_EnumItems, IID_PPV_ARGS(&spesiNext));
+            if (SUCCEEDED(hr))
+            {
+                // Parse the folder contents recursively
+                hr = _ParseEnumItems(spesiNext, context, depth + 1);
+            }
+        }
     }
 
     return hr;
 }
 
-HRESULT _ParseEnumItems(_In_ IEnumShellItems* pesi, _In_ IPowerRenameManager* psrm, _In_ int depth = 0)
+HRESULT _ParseEnumItems(_In_ IEnumShellItems* pesi, _In_ EnumerationContext& context, _In_ int depth)
 {
     HRESULT hr = E_INVALIDARG;
 
@@ -253,64 +126,65 @@ HRESULT _ParseEnumItems(_In_ IEnumShellItems* pesi, _In_ IPowerRenameManager* ps
     {
         hr = S_OK;
 
-        ULONG celtFetched;
-        CComPtr<IShellItem> spsi;
-        while ((S_OK == pesi->Next(1, &spsi, &celtFetched)) && (SUCCEEDED(hr)))
+        // Next returns S_FALSE along with the last, partial, set of items
+        IShellItem* shellItems[c_shellItemFetchCount];
+        ULONG celtFetched = 0;
+        while (SUCCEEDED(hr) && SUCCEEDED(pesi->Next(ARRAYSIZE(shellItems), shellItems, &celtFetched)) && celtFetched > 0)
         {
-            CComPtr<IPowerRenameItemFactory> spsrif;
-            hr = psrm->get_renameItemFactory(&spsrif);
-            if (SUCCEEDED(hr))
+            for (ULONG i = 0; i < celtFetched; i++)
             {
-                CComPtr<IPowerRenameItem> spNewItem;
-                hr = spsrif->Create(spsi, &spNewItem);
                 if (SUCCEEDED(hr))
                 {
-                    spNewItem->put_depth(depth);
-                    hr = psrm->AddItem(spNewItem);
-                }
-
-                if (SUCCEEDED(hr))
-                {
-                    bool isFolder = false;
-                    if (SUCCEEDED(spNewItem->get_isFolder(&isFolder)) && isFolder)
-                    {
-                        // Bind to the IShellItem for the IEnumShellItems interface
-                        CComPtr<IEnumShellItems> spesiNext;
-                        hr = spsi->BindToHandler(nullptr, BHID_EnumItems, IID_PPV_ARGS(&spesiNext));
-                        if (SUCCEEDED(hr))
-                        {
-                            // Parse the folder contents recursively
-                            hr = _ParseEnumItems(spesiNext, psrm, depth + 1);
-                        }
-                    }
+                    hr = _ParseShellItem(shellItems[i], context, depth);
                 }
+                shellItems[i]->Release();
             }
-
-            spsi = nullptr;
         }
     }
 
     return hr;
 }
 
-// Iterate through the data source and add paths to the rotation manager
-HRESULT EnumerateDataObject(_In_ IUnknown* dataSource, _In_ IPowerRenameManager* psrm)
+HRESULT EnumerateDataObjectItems(_In_ IUnknown* dataSource, _In_ IPowerRenameItemFactory* itemFactory, _In_ const EnumeratedItemsCallback& onItems)
 {
     CComPtr<IShellItemArray> spsia;
-    HRESULT hr = _GetShellItemArrayFromDataOject(dataSource, &spsia);
+    HRESULT hr = GetShellItemArrayFromDataObject(dataSource, &spsia);
     if (SUCCEEDED(hr))
     {
         CComPtr<IEnumShellItems> spesi;
         hr = spsia->EnumItems(&spesi);
         if (SUCCEEDED(hr))
         {
-            hr = _ParseEnumItems(spesi, psrm);
+            EnumerationContext context = { itemFactory, onItems };
+            hr = _ParseEnumItems(spesi, context);
+
+            // Hand over what was found so far even if the enumeration stopped early
+            HRESULT hrFlush = context.Flush();
+            if (SUCCEEDED(hr))
+            {
+                hr = hrFlush;
+            }
         }
     }
 
     return hr;
 }
 
+// Iterate through the data source and add paths to the rotation manager
+HRESULT EnumerateDataObject(_In_ IUnknown* dataSource, _In_ IPowerRenameManager* psrm)
+{
+    CComPtr<IPowerRenameItemFactory> spsrif;
+    HRESULT hr = psrm->get_renameItemFactory(&spsrif);
+    if (SUCCEEDED(hr))
+    {
+        hr = EnumerateDataObjectItems(dataSource, spsrif, [psrm](IPowerRenameItem** items, UINT count) {
+            return psrm->AddItems(items, count);
+        });
+    }
+
+    return hr;
+}
+
 BOOL GetEnumeratedFileName(__out_ecount(cchMax) PWSTR pszUniqueName, UINT cchMax, __in PCWSTR pszTemplate, __in_opt PCWSTR pszDir, unsigned long ulMinLong, __inout unsigned long* pulNumUsed)
 {
     PWSTR pszName = nullptr;
@@ -480,7 +354,7 @@ bool DataObjectContainsRenamableItem(_In_ IUnknown* dataSource)
 {
     bool hasRenamable = false;
     CComPtr<IShellItemArray> spsia;
-    if (SUCCEEDED(_GetShellItemArrayFromDataOject(dataSource, &spsia)))
+    if (SUCCEEDED(GetShellItemArrayFromDataObject(dataSource, &spsia)))
     {
         CComPtr<IEnumShellItems> spesi;
         if (SUCCEEDED(spsia->EnumItems(&spesi)))
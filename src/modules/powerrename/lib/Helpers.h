@@ -2,11 +2,17 @@
 
 #include <common.h>
 #include <lib/PowerRenameInterfaces.h>
+#include <functional>
+
+// Receives the items created while enumerating a data object, in the order they were found.
+// Returning a failure stops the enumeration.
+typedef std::function<HRESULT(_In_reads_(count) IPowerRenameItem** items, _In_ UINT count)> EnumeratedItemsCallback;
 
 HRESULT GetTrimmedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source);
 HRESULT GetTransformedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source, DWORD flags);
-HRESULT GetDatedFileName(_Out_ PWSTR result, UINT cchMax, _In_ PCWSTR source, SYSTEMTIME LocalTime);
 bool DataObjectContainsRenamableItem(_In_ IUnknown* dataSource);
+HRESULT GetShellItemArrayFromDataObject(_In_ IUnknown* dataSource, _COM_Outptr_ IShellItemArray** items);
+HRESULT EnumerateDataObjectItems(_In_ IUnknown* dataSource, _In_ IPowerRenameItemFactory* itemFactory, _In_ const EnumeratedItemsCallback& onItems);
 HRESULT EnumerateDataObject(_In_ IUnknown* pdo, _In_ IPowerRenameManager* psrm);
 BOOL GetEnumeratedFileName(
     __out_ecount(cchMax) PWSTR pszUniqueName,
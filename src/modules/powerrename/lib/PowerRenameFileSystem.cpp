@@ -0,0 +1,173 @@
+#include "pch.h"
+#include "PowerRenameFileSystem.h"
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+    bool FileTimeToLocalTime(_In_ const FILETIME& fileTime, _Out_ SYSTEMTIME* localTime)
+    {
+        SYSTEMTIME systemTime;
+        return FileTimeToSystemTime(&fileTime, &systemTime) && SystemTimeToTzSpecificLocalTime(nullptr, &systemTime, localTime);
+    }
+
+    // File names are compared case insensitively, like the file system does
+    std::wstring FoldName(_In_ PCWSTR name, _In_ size_t length)
+    {
+        std::wstring folded(name, length);
+        if (!folded.empty())
+        {
+            CharUpperBuffW(folded.data(), static_cast<DWORD>(folded.length()));
+        }
+        return folded;
+    }
+
+    struct FolderItems
+    {
+        std::wstring folder;
+        std::unordered_map<std::wstring, std::vector<IPowerRenameItem*>> itemsByName;
+        size_t count = 0;
+    };
+}
+
+HRESULT CPowerRenameFileSystem::EnumerateFolder(_In_ PCWSTR folder, _In_ const FolderEntryCallback& callback)
+{
+    std::wstring pattern(folder);
+    if (!pattern.empty() && pattern.back() != L'\\')
+    {
+        pattern += L'\\';
+    }
+    pattern += L'*';
+
+    WIN32_FIND_DATAW findData;
+    HANDLE findHandle = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (findHandle == INVALID_HANDLE_VALUE)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    do
+    {
+        if (lstrcmp(findData.cFileName, L".") == 0 || lstrcmp(findData.cFileName, L"..") == 0)
+        {
+            continue;
+        }
+
+        PowerRenameItemMetadata metadata;
+        ULONGLONG size = (static_cast<ULONGLONG>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+        if (SUCCEEDED(s_MetadataFromFileTimes(findData.ftCreationTime, findData.ftLastWriteTime, size, &metadata)) &&
+            !callback(findData.cFileName, metadata))
+        {
+            FindClose(findHandle);
+            return E_ABORT;
+        }
+    } while (FindNextFileW(findHandle, &findData));
+
+    FindClose(findHandle);
+    return S_OK;
+}
+
+HRESULT CPowerRenameFileSystem::GetMetadata(_In_ PCWSTR path, _Out_ PowerRenameItemMetadata* metadata)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &data))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    ULONGLONG size = (static_cast<ULONGLONG>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    return s_MetadataFromFileTimes(data.ftCreationTime, data.ftLastWriteTime, size, metadata);
+}
+
+HRESULT CPowerRenameFileSystem::s_MetadataFromFileTimes(_In_ const FILETIME& creationTime, _In_ const FILETIME& lastWriteTime, _In_ ULONGLONG size, _Out_ PowerRenameItemMetadata* metadata)
+{
+    if (!FileTimeToLocalTime(creationTime, &metadata->creationTime) || !FileTimeToLocalTime(lastWriteTime, &metadata->lastWriteTime))
+    {
+        return E_FAIL;
+    }
+
+    metadata->size = size;
+    return S_OK;
+}
+
+HRESULT PrefetchItemMetadata(_In_ const std::vector<CComPtr<IPowerRenameItem>>& items, _In_ CPowerRenameFileSystem& fileSystem, _In_opt_ const PrefetchCanceledCallback& isCanceled)
+{
+    auto canceled = [&isCanceled]() {
+        return isCanceled && isCanceled();
+    };
+
+    // Group the items which don't have metadata yet by parent folder
+    std::vector<FolderItems> folders;
+    std::unordered_map<std::wstring, size_t> folderIndices;
+    for (const auto& item : items)
+    {
+        bool cached = false;
+        PWSTR path = nullptr;
+        if (item == nullptr || FAILED(item->get_isMetadataCached(&cached)) || cached || FAILED(item->get_path(&path)))
+        {
+            continue;
+        }
+
+        PCWSTR name = PathFindFileName(path);
+        const size_t folderLength = name > path ? name - path - 1 : 0;
+        auto folderKey = FoldName(path, folderLength);
+        auto it = folderIndices.find(folderKey);
+        if (it == folderIndices.end())
+        {
+            it = folderIndices.emplace(std::move(folderKey), folders.size()).first;
+            folders.push_back({ std::wstring(path, folderLength) });
+        }
+
+        auto& folder = folders[it->second];
+        folder.itemsByName[FoldName(name, wcslen(name))].push_back(item);
+        folder.count++;
+        CoTaskMemFree(path);
+    }
+
+    for (auto& folder : folders)
+    {
+        if (canceled())
+        {
+            return E_ABORT;
+        }
+
+        if (folder.count > 1 && !folder.folder.empty())
+        {
+            // A listing of a large folder on a network share can take a while, keep checking
+            fileSystem.EnumerateFolder(folder.folder.c_str(), [&folder, &canceled](PCWSTR name, const PowerRenameItemMetadata& metadata) {
+                auto it = folder.itemsByName.find(FoldName(name, wcslen(name)));
+                if (it != folder.itemsByName.end())
+                {
+                    for (auto item : it->second)
+                    {
+                        item->put_metadata(&metadata);
+                    }
+                    folder.itemsByName.erase(it);
+                }
+                return !canceled();
+            });
+        }
+
+        // Single items, and items the listing didn't return, are read one by one
+        for (const auto& entry : folder.itemsByName)
+        {
+            for (auto item : entry.second)
+            {
+                if (canceled())
+                {
+                    return E_ABORT;
+                }
+
+                PWSTR path = nullptr;
+                PowerRenameItemMetadata metadata;
+                if (SUCCEEDED(item->get_path(&path)) && SUCCEEDED(fileSystem.GetMetadata(path, &metadata)))
+                {
+                    item->put_metadata(&metadata);
+                }
+                CoTaskMemFree(path);
+            }
+        }
+    }
+
+    return S_OK;
+}
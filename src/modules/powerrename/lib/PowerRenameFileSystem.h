@@ -0,0 +1,32 @@
+#pragma once
+#include "pch.h"
+#include "PowerRenameInterfaces.h"
+#include <functional>
+#include <vector>
+
+// Called for each entry of a folder listing, returns false to stop the listing
+typedef std::function<bool(_In_ PCWSTR name, _In_ const PowerRenameItemMetadata& metadata)> FolderEntryCallback;
+
+// Returns true once the caller no longer needs the metadata
+typedef std::function<bool()> PrefetchCanceledCallback;
+
+// Access to the file system used to read item metadata. The default implementation uses Win32,
+// derive from it to observe or replace file system access (e.g. in tests).
+class CPowerRenameFileSystem
+{
+public:
+    virtual ~CPowerRenameFileSystem() = default;
+
+    // Lists the entries of a folder with their metadata in a single pass over the folder
+    virtual HRESULT EnumerateFolder(_In_ PCWSTR folder, _In_ const FolderEntryCallback& callback);
+
+    // Reads the metadata of a single file or folder
+    virtual HRESULT GetMetadata(_In_ PCWSTR path, _Out_ PowerRenameItemMetadata* metadata);
+
+    static HRESULT s_MetadataFromFileTimes(_In_ const FILETIME& creationTime, _In_ const FILETIME& lastWriteTime, _In_ ULONGLONG size, _Out_ PowerRenameItemMetadata* metadata);
+};
+
+// Reads and caches the metadata of items that don't have it yet. Items are grouped by parent
+// folder and every folder with more than one item is listed once, instead of opening each item.
+// Cancellation is checked for every folder and item, and returns E_ABORT.
+HRESULT PrefetchItemMetadata(_In_ const std::vector<CComPtr<IPowerRenameItem>>& items, _In_ CPowerRenameFileSystem& fileSystem, _In_opt_ const PrefetchCanceledCallback& isCanceled = nullptr);
@@ -17,6 +17,23 @@ enum PowerRenameFlags
     Titlecase = 0x800
 };
 
+// File system attributes of an item used by the date and size tokens. Times are local.
+struct PowerRenameItemMetadata
+{
+    SYSTEMTIME creationTime;
+    SYSTEMTIME lastWriteTime;
+    ULONGLONG size;
+};
+
+// Summary of the renames that would be performed, computed before the user commits them
+struct PowerRenamePlanStats
+{
+    UINT renameCount;    // Items the rename operation will rename
+    UINT collisionCount; // Renames whose new name is used by another item of the same folder, so a number is added to it
+    UINT caseOnlyCount;  // Renames that only change the case of the name
+    UINT invalidCount;   // Items left out because their new name isn't a valid file name
+};
+
 interface __declspec(uuid("3ECBA62B-E0F0-4472-AA2E-DEE7A1AA46B9")) IPowerRenameRegExEvents : public IUnknown
 {
 public:
@@ -44,6 +61,9 @@ interface __declspec(uuid("C7F59201-4DE1-4855-A3A2-26FC3279C8A5")) IPowerRenameI
 public:
     IFACEMETHOD(get_path)(_Outptr_ PWSTR* path) = 0;
     IFACEMETHOD(get_date)(_Outptr_ SYSTEMTIME* date) = 0;
+    IFACEMETHOD(get_metadata)(_Out_ PowerRenameItemMetadata* metadata) = 0;
+    IFACEMETHOD(put_metadata)(_In_ const PowerRenameItemMetadata* metadata) = 0;
+    IFACEMETHOD(get_isMetadataCached)(_Out_ bool* cached) = 0;
     IFACEMETHOD(get_shellItem)(_Outptr_ IShellItem** ppsi) = 0;
     IFACEMETHOD(get_originalName)(_Outptr_ PWSTR* originalName) = 0;
     IFACEMETHOD(get_newName)(_Outptr_ PWSTR* newName) = 0;
@@ -70,7 +90,10 @@ interface __declspec(uuid("87FC43F9-7634-43D9-99A5-20876AFCE4AD")) IPowerRenameM
 {
 public:
     IFACEMETHOD(OnItemAdded)(_In_ IPowerRenameItem* renameItem) = 0;
-    IFACEMETHOD(OnUpdate)(_In_ IPowerRenameItem* renameItem) = 0;
+    IFACEMETHOD(OnItemsUpdated)(_In_ UINT firstIndex, _In_ UINT lastIndex) = 0;
+    IFACEMETHOD(OnItemsAdded)(_In_ UINT itemCount) = 0;
+    IFACEMETHOD(OnEnumerationCompleted)(_In_ UINT itemCount) = 0;
+    IFACEMETHOD(OnRenamePlanUpdated)(_In_ const PowerRenamePlanStats* stats) = 0;
     IFACEMETHOD(OnError)(_In_ IPowerRenameItem* renameItem) = 0;
     IFACEMETHOD(OnRegExStarted)(_In_ DWORD threadId) = 0;
     IFACEMETHOD(OnRegExCanceled)(_In_ DWORD threadId) = 0;
@@ -90,6 +113,8 @@ public:
     IFACEMETHOD(Shutdown)() = 0;
     IFACEMETHOD(Rename)(_In_ HWND hwndParent) = 0;
     IFACEMETHOD(AddItem)(_In_ IPowerRenameItem* pItem) = 0;
+    IFACEMETHOD(AddItems)(_In_reads_(count) IPowerRenameItem** items, _In_ UINT count) = 0;
+    IFACEMETHOD(StartEnumeration)(_In_ IUnknown* dataSource) = 0;
     IFACEMETHOD(GetItemByIndex)(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem) = 0;
     IFACEMETHOD(GetItemById)(_In_ int id, _COM_Outptr_ IPowerRenameItem** ppItem) = 0;
     IFACEMETHOD(GetItemCount)(_Out_ UINT* count) = 0;
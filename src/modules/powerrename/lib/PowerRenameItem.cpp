@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "PowerRenameItem.h"
+#include "PowerRenameFileSystem.h"
 #include "icon_helpers.h"
 
 int CPowerRenameItem::s_id = 0;
@@ -44,34 +45,66 @@ IFACEMETHODIMP CPowerRenameItem::get_path(_Outptr_ PWSTR* path)
 
 IFACEMETHODIMP CPowerRenameItem::get_date(_Outptr_ SYSTEMTIME* date)
 {
-    CSRWSharedAutoLock lock(&m_lock);
-    HRESULT hr = m_isDateParsed ? S_OK : E_FAIL ;
-    if (!m_isDateParsed)
+    PowerRenameItemMetadata metadata;
+    HRESULT hr = get_metadata(&metadata);
+    if (SUCCEEDED(hr))
     {
-        HANDLE hFile = CreateFileW(m_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
-        if (hFile != INVALID_HANDLE_VALUE)
+        *date = metadata.creationTime;
+    }
+    return hr;
+}
+
+IFACEMETHODIMP CPowerRenameItem::get_metadata(_Out_ PowerRenameItemMetadata* metadata)
+{
+    {
+        CSRWSharedAutoLock lock(&m_lock);
+        if (m_isMetadataCached)
         {
-            FILETIME CreationTime;
-            if (GetFileTime(hFile, &CreationTime, NULL, NULL))
+            *metadata = m_metadata;
+            return S_OK;
+        }
+    }
+
+    // Not prefetched with the other items of its folder, read it on its own. The file system is
+    // not accessed under the lock, so readers of the other properties don't wait on slow shares.
+    PWSTR path = nullptr;
+    HRESULT hr = get_path(&path);
+    if (SUCCEEDED(hr))
+    {
+        CPowerRenameFileSystem fileSystem;
+        PowerRenameItemMetadata read;
+        hr = fileSystem.GetMetadata(path, &read);
+        CoTaskMemFree(path);
+
+        if (SUCCEEDED(hr))
+        {
+            CSRWExclusiveAutoLock lock(&m_lock);
+            if (!m_isMetadataCached)
             {
-                SYSTEMTIME SystemTime, LocalTime;
-                if (FileTimeToSystemTime(&CreationTime, &SystemTime))
-                {
-                    if (SystemTimeToTzSpecificLocalTime(NULL, &SystemTime, &LocalTime))
-                    {
-                        m_date = LocalTime;
-                        m_isDateParsed = true;
-                        hr = S_OK;
-                    }
-                }
+                m_metadata = read;
+                m_isMetadataCached = true;
             }
+            *metadata = m_metadata;
         }
-        CloseHandle(hFile);
     }
-    *date = m_date;
     return hr;
 }
 
+IFACEMETHODIMP CPowerRenameItem::put_metadata(_In_ const PowerRenameItemMetadata* metadata)
+{
+    CSRWExclusiveAutoLock lock(&m_lock);
+    m_metadata = *metadata;
+    m_isMetadataCached = true;
+    return S_OK;
+}
+
+IFACEMETHODIMP CPowerRenameItem::get_isMetadataCached(_Out_ bool* cached)
+{
+    CSRWSharedAutoLock lock(&m_lock);
+    *cached = m_isMetadataCached;
+    return S_OK;
+}
+
 IFACEMETHODIMP CPowerRenameItem::get_shellItem(_Outptr_ IShellItem** ppsi)
 {
     return SHCreateItemFromParsingName(m_path, nullptr, IID_PPV_ARGS(ppsi));
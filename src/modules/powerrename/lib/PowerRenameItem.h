@@ -16,6 +16,9 @@ public:
     // IPowerRenameItem
     IFACEMETHODIMP get_path(_Outptr_ PWSTR* path);
     IFACEMETHODIMP get_date(_Outptr_ SYSTEMTIME* date);
+    IFACEMETHODIMP get_metadata(_Out_ PowerRenameItemMetadata* metadata);
+    IFACEMETHODIMP put_metadata(_In_ const PowerRenameItemMetadata* metadata);
+    IFACEMETHODIMP get_isMetadataCached(_Out_ bool* cached);
     IFACEMETHODIMP get_shellItem(_Outptr_ IShellItem** ppsi);
     IFACEMETHODIMP get_originalName(_Outptr_ PWSTR* originalName);
     IFACEMETHODIMP put_newName(_In_opt_ PCWSTR newName);
@@ -49,7 +52,7 @@ protected:
 
     bool        m_selected = true;
     bool        m_isFolder = false;
-    bool        m_isDateParsed = false;
+    bool        m_isMetadataCached = false;
     bool        m_canRename = true;
     int         m_id = -1;
     int         m_iconIndex = -1;
@@ -58,7 +61,7 @@ protected:
     PWSTR       m_path = nullptr;
     PWSTR       m_originalName = nullptr;
     PWSTR       m_newName = nullptr;
-    SYSTEMTIME  m_date;
+    PowerRenameItemMetadata m_metadata = {};
     CSRWLock    m_lock;
     long        m_refCount = 0;
 };
@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "PowerRenameItemQueue.h"
+
+CPowerRenameItemQueue::CPowerRenameItemQueue(_In_ size_t maxBatches) :
+    m_maxBatches(max(maxBatches, static_cast<size_t>(1)))
+{
+}
+
+bool CPowerRenameItemQueue::Push(_Inout_ std::vector<CComPtr<IPowerRenameItem>>&& items)
+{
+    std::unique_lock lock(m_mutex);
+    m_notFull.wait(lock, [this]() { return m_closed || m_batches.size() < m_maxBatches; });
+    if (m_closed)
+    {
+        return false;
+    }
+
+    m_batches.push_back(std::move(items));
+    return true;
+}
+
+bool CPowerRenameItemQueue::TryPopAll(_Inout_ std::vector<CComPtr<IPowerRenameItem>>& items)
+{
+    {
+        std::unique_lock lock(m_mutex);
+        if (m_batches.empty())
+        {
+            return false;
+        }
+
+        for (auto& batch : m_batches)
+        {
+            items.insert(items.end(), batch.begin(), batch.end());
+        }
+        m_batches.clear();
+    }
+
+    m_notFull.notify_all();
+    return true;
+}
+
+void CPowerRenameItemQueue::Close()
+{
+    {
+        std::unique_lock lock(m_mutex);
+        m_closed = true;
+    }
+
+    m_notFull.notify_all();
+}
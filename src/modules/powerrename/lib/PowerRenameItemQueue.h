@@ -0,0 +1,32 @@
+#pragma once
+#include "pch.h"
+#include "PowerRenameInterfaces.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Hands batches of enumerated items from the enumeration thread to the manager thread.
+// The queue is bounded so the enumeration can't run arbitrarily far ahead of the manager:
+// Push blocks while the queue is full and the manager drains it without blocking.
+class CPowerRenameItemQueue
+{
+public:
+    CPowerRenameItemQueue(_In_ size_t maxBatches);
+
+    // Blocks while the queue is full. Returns false, without queuing the items, once the queue is closed.
+    bool Push(_Inout_ std::vector<CComPtr<IPowerRenameItem>>&& items);
+
+    // Appends all queued items to items in the order they were pushed. Returns false if the queue was empty.
+    bool TryPopAll(_Inout_ std::vector<CComPtr<IPowerRenameItem>>& items);
+
+    // Releases a blocked producer and rejects any further Push. Items already queued can still be popped.
+    void Close();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::deque<std::vector<CComPtr<IPowerRenameItem>>> m_batches;
+    const size_t m_maxBatches;
+    bool m_closed = false;
+};
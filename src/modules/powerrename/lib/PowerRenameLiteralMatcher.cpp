@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "PowerRenameLiteralMatcher.h"
+#include <cwctype>
+
+void CPowerRenameLiteralMatcher::SetPattern(_In_ std::wstring_view pattern, _In_ bool caseInsensitive)
+{
+    m_caseInsensitive = caseInsensitive;
+    m_pattern.assign(pattern);
+    for (auto& c : m_pattern)
+    {
+        c = _Fold(c);
+    }
+
+    const size_t length = m_pattern.length();
+    m_shift.fill(length);
+    for (size_t i = 0; i + 1 < length; i++)
+    {
+        m_shift[m_pattern[i] & 0xFF] = length - 1 - i;
+    }
+}
+
+size_t CPowerRenameLiteralMatcher::Find(_In_ std::wstring_view text, _In_ size_t pos) const
+{
+    const size_t length = m_pattern.length();
+    if (length == 0 || pos > text.length() || text.length() - pos < length)
+    {
+        return std::wstring::npos;
+    }
+
+    const wchar_t lastPatternChar = m_pattern[length - 1];
+    for (size_t start = pos; start + length <= text.length();)
+    {
+        const wchar_t lastTextChar = _Fold(text[start + length - 1]);
+        if (lastTextChar == lastPatternChar)
+        {
+            size_t i = 0;
+            while (i + 1 < length && _Fold(text[start + i]) == m_pattern[i])
+            {
+                i++;
+            }
+
+            if (i + 1 == length)
+            {
+                return start;
+            }
+        }
+
+        start += m_shift[lastTextChar & 0xFF];
+    }
+
+    return std::wstring::npos;
+}
+
+std::wstring CPowerRenameLiteralMatcher::Replace(_In_ std::wstring_view text, _In_ std::wstring_view replacement, _In_ bool allOccurrences) const
+{
+    std::wstring result;
+    size_t copied = 0;
+    size_t pos = Find(text, 0);
+    if (pos == std::wstring::npos)
+    {
+        return std::wstring(text);
+    }
+
+    result.reserve(text.length() + replacement.length());
+    while (pos != std::wstring::npos)
+    {
+        result.append(text.substr(copied, pos - copied));
+        result.append(replacement);
+        copied = pos + m_pattern.length();
+
+        if (!allOccurrences)
+        {
+            break;
+        }
+
+        pos = Find(text, copied);
+    }
+
+    result.append(text.substr(copied));
+    return result;
+}
+
+wchar_t CPowerRenameLiteralMatcher::_Fold(_In_ wchar_t c) const
+{
+    if (!m_caseInsensitive)
+    {
+        return c;
+    }
+
+    if (c < 0x80)
+    {
+        return (c >= L'A' && c <= L'Z') ? c + (L'a' - L'A') : c;
+    }
+
+    return static_cast<wchar_t>(towlower(c));
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "pch.h"
+#include <array>
+#include <string>
+#include <string_view>
+
+// Plain text search and replace used when regular expressions are disabled.
+// The search term is preprocessed once (case folding and a Boyer-Moore-Horspool
+// shift table), so matching a name does not allocate and runs in linear time.
+class CPowerRenameLiteralMatcher
+{
+public:
+    void SetPattern(_In_ std::wstring_view pattern, _In_ bool caseInsensitive);
+
+    // Returns the position of the first match at or after pos, or std::wstring::npos
+    size_t Find(_In_ std::wstring_view text, _In_ size_t pos) const;
+
+    // Replaces the first match, or every non-overlapping match, of the pattern in text
+    std::wstring Replace(_In_ std::wstring_view text, _In_ std::wstring_view replacement, _In_ bool allOccurrences) const;
+
+    size_t PatternLength() const { return m_pattern.length(); }
+
+private:
+    wchar_t _Fold(_In_ wchar_t c) const;
+
+    std::wstring m_pattern;
+    bool m_caseInsensitive = false;
+    // Shift per low byte of a character, characters sharing a slot keep the smallest shift
+    std::array<size_t, 256> m_shift{};
+};
@@ -1,12 +1,20 @@
 #include "pch.h"
 #include "PowerRenameManager.h"
 #include "PowerRenameRegEx.h" // Default RegEx handler
+#include "PowerRenameNameTransform.h"
+#include "PowerRenameFileSystem.h"
+#include "PowerRenamePlan.h"
 #include <algorithm>
 #include <shlobj.h>
 #include <cstring>
 #include "helpers.h"
 #include "window_helpers.h"
 #include <filesystem>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include "trace.h"
 
 namespace fs = std::filesystem;
@@ -93,6 +101,8 @@ IFACEMETHODIMP CPowerRenameManager::Stop()
 IFACEMETHODIMP CPowerRenameManager::Rename(_In_ HWND hwndParent)
 {
     m_hwndParent = hwndParent;
+    // Make sure every item is in before renaming
+    _WaitForEnumWorkerThread();
     return _PerformFileOperation();
 }
 
@@ -105,6 +115,8 @@ IFACEMETHODIMP CPowerRenameManager::Reset()
 
 IFACEMETHODIMP CPowerRenameManager::Shutdown()
 {
+    _CancelEnumWorkerThread();
+    _CancelRegExWorkerThread();
     _ClearRegEx();
     _Cleanup();
     return S_OK;
@@ -116,25 +128,62 @@ IFACEMETHODIMP CPowerRenameManager::AddItem(_In_ IPowerRenameItem* pItem)
     // Scope lock
     {
         CSRWExclusiveAutoLock lock(&m_lockItems);
-        int id = 0;
-        pItem->get_id(&id);
-        // Verify the item isn't already added
-        if (m_renameItems.find(id) == m_renameItems.end())
+        if (_InsertItem(pItem))
         {
-            m_renameItems[id] = pItem;
-            pItem->AddRef();
             hr = S_OK;
         }
     }
 
     if (SUCCEEDED(hr))
     {
+        SetEvent(m_itemsAddedEvent);
         _OnItemAdded(pItem);
     }
 
     return hr;
 }
 
+IFACEMETHODIMP CPowerRenameManager::AddItems(_In_reads_(count) IPowerRenameItem** items, _In_ UINT count)
+{
+    UINT addedCount = 0;
+    // Scope lock
+    {
+        CSRWExclusiveAutoLock lock(&m_lockItems);
+        m_renameItems.reserve(m_renameItems.size() + count);
+        for (UINT i = 0; i < count; i++)
+        {
+            if (_InsertItem(items[i]))
+            {
+                addedCount++;
+            }
+        }
+    }
+
+    // A single notification for the whole batch
+    if (addedCount > 0)
+    {
+        SetEvent(m_itemsAddedEvent);
+        _OnItemsAdded(addedCount);
+    }
+
+    return S_OK;
+}
+
+IFACEMETHODIMP CPowerRenameManager::StartEnumeration(_In_ IUnknown* dataSource)
+{
+    // Only one enumeration runs at a time. The items of a previous one are all added first.
+    _WaitForEnumWorkerThread();
+
+    CComPtr<IShellItemArray> spsia;
+    HRESULT hr = GetShellItemArrayFromDataObject(dataSource, &spsia);
+    if (SUCCEEDED(hr))
+    {
+        hr = _CreateEnumWorkerThread(spsia);
+    }
+
+    return hr;
+}
+
 IFACEMETHODIMP CPowerRenameManager::GetItemByIndex(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem)
 {
     *ppItem = nullptr;
@@ -142,9 +191,7 @@ IFACEMETHODIMP CPowerRenameManager::GetItemByIndex(_In_ UINT index, _COM_Outptr_
     HRESULT hr = E_FAIL;
     if (index < m_renameItems.size())
     {
-        std::map<int, IPowerRenameItem*>::iterator it = m_renameItems.begin();
-        std::advance(it, index);
-        *ppItem = it->second;
+        *ppItem = m_renameItems[index].pItem;
         (*ppItem)->AddRef();
         hr = S_OK;
     }
@@ -158,11 +205,10 @@ IFACEMETHODIMP CPowerRenameManager::GetItemById(_In_ int id, _COM_Outptr_ IPower
 
     CSRWSharedAutoLock lock(&m_lockItems);
     HRESULT hr = E_FAIL;
-    std::map<int, IPowerRenameItem*>::iterator it;
-    it = m_renameItems.find(id);
-    if (it !=  m_renameItems.end())
+    auto it = m_renameItemIndices.find(id);
+    if (it != m_renameItemIndices.end())
     {
-        *ppItem = m_renameItems[id];
+        *ppItem = m_renameItems[it->second].pItem;
         (*ppItem)->AddRef();
         hr = S_OK;
     }
@@ -184,7 +230,7 @@ IFACEMETHODIMP CPowerRenameManager::GetSelectedItemCount(_Out_ UINT* count)
 
     for (auto it : m_renameItems)
     {
-        IPowerRenameItem* pItem = it.second;
+        IPowerRenameItem* pItem = it.pItem;
         bool selected = false;
         if (SUCCEEDED(pItem->get_selected(&selected)) && selected)
         {
@@ -202,7 +248,7 @@ IFACEMETHODIMP CPowerRenameManager::GetRenameItemCount(_Out_ UINT* count)
 
     for (auto it : m_renameItems)
     {
-        IPowerRenameItem* pItem = it.second;
+        IPowerRenameItem* pItem = it.pItem;
         bool shouldRename = false;
         if (SUCCEEDED(pItem->ShouldRenameItem(m_flags, &shouldRename)) && shouldRename)
         {
@@ -323,6 +369,9 @@ HRESULT CPowerRenameManager::_Init()
     m_startFileOpWorkerEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
     m_startRegExWorkerEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
     m_cancelRegExWorkerEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    m_cancelEnumWorkerEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    m_enumCompleteEvent = CreateEvent(nullptr, TRUE, TRUE, nullptr);
+    m_itemsAddedEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
 
     m_hwndMessage = CreateMsgWindow(g_hInst, s_msgWndProc, this);
 
@@ -332,11 +381,14 @@ HRESULT CPowerRenameManager::_Init()
 // Custom messages for worker threads
 enum
 {
-    SRM_REGEX_ITEM_UPDATED = (WM_APP + 1),  // Single rename item processed by regex worker thread
+    SRM_REGEX_ITEMS_UPDATED = (WM_APP + 1), // Range of rename items processed by regex worker thread
     SRM_REGEX_STARTED,                      // RegEx operation was started
     SRM_REGEX_CANCELED,                     // Regex operation was canceled
     SRM_REGEX_COMPLETE,                     // Regex worker thread completed
-    SRM_FILEOP_COMPLETE                     // File Operation worker thread completed
+    SRM_FILEOP_COMPLETE,                    // File Operation worker thread completed
+    SRM_ENUM_ITEMS_READY,                   // Enumeration worker thread queued items
+    SRM_ENUM_COMPLETE,                      // Enumeration worker thread completed
+    SRM_RENAME_PLAN_UPDATED                 // Regex worker thread computed the rename plan statistics
 };
 
 struct WorkerThreadData
@@ -344,10 +396,21 @@ struct WorkerThreadData
     HWND hwndManager = nullptr;
     HANDLE startEvent = nullptr;
     HANDLE cancelEvent = nullptr;
+    HANDLE itemsAddedEvent = nullptr;
+    HANDLE enumCompleteEvent = nullptr;
     HWND hwndParent = nullptr;
     CComPtr<IPowerRenameManager> spsrm;
 };
 
+struct EnumWorkerThreadData
+{
+    HWND hwndManager = nullptr;
+    HANDLE cancelEvent = nullptr;
+    IStream* shellItemArrayStream = nullptr;
+    CComPtr<IPowerRenameItemFactory> spItemFactory;
+    std::shared_ptr<CPowerRenameItemQueue> queue;
+};
+
 // Msg-only worker window proc for communication from our worker threads
 LRESULT CALLBACK CPowerRenameManager::s_msgWndProc(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
 {
@@ -379,16 +442,10 @@ LRESULT CPowerRenameManager::_WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM
 
     switch (msg)
     {
-    case SRM_REGEX_ITEM_UPDATED:
-    {
-        int id = static_cast<int>(lParam);
-        CComPtr<IPowerRenameItem> spItem;
-        if (SUCCEEDED(GetItemById(id, &spItem)))
-        {
-            _OnUpdate(spItem);
-        }
+    case SRM_REGEX_ITEMS_UPDATED:
+        _OnItemsUpdated(static_cast<UINT>(wParam), static_cast<UINT>(lParam));
         break;
-    }
+
     case SRM_REGEX_STARTED:
         _OnRegExStarted(static_cast<DWORD>(wParam));
         break;
@@ -401,6 +458,26 @@ LRESULT CPowerRenameManager::_WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM
         _OnRegExCompleted(static_cast<DWORD>(wParam));
         break;
 
+    case SRM_RENAME_PLAN_UPDATED:
+    {
+        PowerRenamePlanStats* stats = reinterpret_cast<PowerRenamePlanStats*>(lParam);
+        _OnRenamePlanUpdated(stats);
+        delete stats;
+        break;
+    }
+
+    case SRM_ENUM_ITEMS_READY:
+        _AddEnumeratedItems();
+        break;
+
+    case SRM_ENUM_COMPLETE:
+        // Ignore a late message from an enumeration we already waited for
+        if (static_cast<DWORD>(wParam) == m_enumWorkerThreadId)
+        {
+            _WaitForEnumWorkerThread();
+        }
+        break;
+
     default:
         lRes = DefWindowProc(hwnd, msg, wParam, lParam);
         break;
@@ -557,50 +634,12 @@ DWORD WINAPI CPowerRenameManager::s_fileOpWorkerThread(_In_ void* pv)
                         DWORD flags = 0;
                         spRenameRegEx->get_flags(&flags);
 
-                        UINT itemCount = 0;
-                        pwtd->spsrm->GetItemCount(&itemCount);
-
-                        // We add the items to the operation in depth-first order.  This allows child items to be
-                        // renamed before parent items.
-
-                        // Creating a vector of vectors of items of the same depth
-                        std::vector<std::vector<UINT>> matrix(itemCount);
-
-                        for (UINT u = 0; u < itemCount; u++)
+                        // Items are added to the operation from the greatest depth first. This allows
+                        // child items to be renamed before parent items.
+                        CPowerRenamePlan plan;
+                        if (SUCCEEDED(plan.Build(pwtd->spsrm, flags)))
                         {
-                            CComPtr<IPowerRenameItem> spItem;
-                            if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(u, &spItem)))
-                            {
-                                UINT depth = 0;
-                                spItem->get_depth(&depth);
-                                matrix[depth].push_back(u);
-                            }
-                        }
-
-                        // From the greatest depth first, add all items of that depth to the operation
-                        for (LONG v = itemCount - 1; v >= 0; v--)
-                        {
-                            for (auto it : matrix[v])
-                            {
-                                CComPtr<IPowerRenameItem> spItem;
-                                if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(it, &spItem)))
-                                {
-                                    bool shouldRename = false;
-                                    if (SUCCEEDED(spItem->ShouldRenameItem(flags, &shouldRename)) && shouldRename)
-                                    {
-                                        PWSTR newName = nullptr;
-                                        if (SUCCEEDED(spItem->get_newName(&newName)))
-                                        {
-                                            CComPtr<IShellItem> spShellItem;
-                                            if (SUCCEEDED(spItem->get_shellItem(&spShellItem)))
-                                            {
-                                                spFileOp->RenameItem(spShellItem, newName, nullptr);
-                                            }
-                                            CoTaskMemFree(newName);
-                                        }
-                                    }
-                                }
-                            }
+                            plan.AddToFileOperation(spFileOp);
                         }
 
                         // Set the operation flags
@@ -671,6 +710,8 @@ HRESULT CPowerRenameManager::_CreateRegExWorkerThread()
         pwtd->hwndManager = m_hwndMessage;
         pwtd->startEvent = m_startRegExWorkerEvent;
         pwtd->cancelEvent = m_cancelRegExWorkerEvent;
+        pwtd->itemsAddedEvent = m_itemsAddedEvent;
+        pwtd->enumCompleteEvent = m_enumCompleteEvent;
         pwtd->hwndParent = m_hwndParent;
         pwtd->spsrm = this;
         m_regExWorkerThreadHandle = CreateThread(nullptr, 0, s_regexWorkerThread, pwtd, 0, nullptr);
@@ -684,6 +725,83 @@ HRESULT CPowerRenameManager::_CreateRegExWorkerThread()
     return hr;
 }
 
+namespace
+{
+    // Number of items a preview worker evaluates before checking for cancellation. Progress is
+    // also reported to the UI once per chunk as a single range update.
+    constexpr UINT c_previewChunkSize = 256;
+    constexpr UINT c_maxPreviewWorkers = 8;
+
+    struct PreviewItemResult
+    {
+        CComPtr<IPowerRenameItem> spItem;
+        bool evaluated = false;
+        bool excluded = false;
+        bool hasNewName = false;
+        std::wstring newName;
+    };
+
+    struct PreviewChunk
+    {
+        UINT first = 0;
+        UINT last = 0;
+        std::vector<PreviewItemResult> results;
+        bool done = false;
+    };
+
+    // Computes the new name of a single item, except for the enumeration suffix which depends on
+    // the items before it and is applied when the results are committed in order.
+    void EvaluatePreviewItem(_In_ IPowerRenameRegEx* renameRegEx, _In_ DWORD flags, _Inout_ NameTransformBuffers& buffers, _Inout_ PreviewItemResult& result)
+    {
+        const CComPtr<IPowerRenameItem>& spItem = result.spItem;
+
+        bool isFolder = false;
+        bool isSubFolderContent = false;
+        spItem->get_isFolder(&isFolder);
+        spItem->get_isSubFolderContent(&isSubFolderContent);
+        if ((isFolder && (flags & PowerRenameFlags::ExcludeFolders)) ||
+            (!isFolder && (flags & PowerRenameFlags::ExcludeFiles)) ||
+            (isSubFolderContent && (flags & PowerRenameFlags::ExcludeSubfolders)))
+        {
+            // Exclude this item from renaming.  Ensure new name is cleared.
+            result.excluded = true;
+            return;
+        }
+
+        PWSTR originalName = nullptr;
+        if (SUCCEEDED(spItem->get_originalName(&originalName)))
+        {
+            result.evaluated = true;
+
+            // Failure here means we didn't match anything or had nothing to match
+            auto replace = [renameRegEx](PCWSTR source, std::wstring& replaced) {
+                PWSTR newName = nullptr;
+                renameRegEx->Replace(source, &newName);
+                if (newName == nullptr)
+                {
+                    return false;
+                }
+                replaced = newName;
+                CoTaskMemFree(newName);
+                return true;
+            };
+
+            auto getMetadata = [&spItem](PowerRenameItemMetadata& metadata) {
+                return SUCCEEDED(spItem->get_metadata(&metadata));
+            };
+
+            // No change from originalName leaves newName empty so we clear it from our UI as well.
+            if (TransformFileName(originalName, flags, replace, getMetadata, buffers))
+            {
+                result.hasNewName = true;
+                result.newName = buffers.name;
+            }
+
+            CoTaskMemFree(originalName);
+        }
+    }
+}
+
 DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
 {
     if (SUCCEEDED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE)))
@@ -702,185 +820,250 @@ DWORD WINAPI CPowerRenameManager::s_regexWorkerThread(_In_ void* pv)
                     DWORD flags = 0;
                     spRenameRegEx->get_flags(&flags);
 
-                    UINT itemCount = 0;
-                    unsigned long itemEnumIndex = 1;
-                    pwtd->spsrm->GetItemCount(&itemCount);
-                    for (UINT u = 0; u <= itemCount; u++)
+                    std::atomic<bool> stop = false;
+                    auto isCanceled = [&]() {
+                        return stop || WaitForSingleObject(pwtd->cancelEvent, 0) == WAIT_OBJECT_0;
+                    };
+
+                    // Date and size tokens need the file attributes of every item. Read them in one
+                    // listing per folder up front instead of one file system round trip per item,
+                    // which means waiting for the enumeration to add all the items first.
+                    PWSTR replaceTerm = nullptr;
+                    if (SUCCEEDED(spRenameRegEx->get_replaceTerm(&replaceTerm)) && replaceTerm && HasMetadataTokens(replaceTerm))
                     {
-                        // Check if cancel event is signaled
-                        if (WaitForSingleObject(pwtd->cancelEvent, 0) == WAIT_OBJECT_0)
+                        HANDLE waitHandles[] = { pwtd->cancelEvent, pwtd->enumCompleteEvent };
+                        if (WaitForMultipleObjects(ARRAYSIZE(waitHandles), waitHandles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1)
                         {
-                            // Canceled from manager
-                            // Send the manager thread the canceled message
-                            PostMessage(pwtd->hwndManager, SRM_REGEX_CANCELED, GetCurrentThreadId(), 0);
-                            break;
+                            UINT itemCount = 0;
+                            pwtd->spsrm->GetItemCount(&itemCount);
+                            std::vector<CComPtr<IPowerRenameItem>> items(itemCount);
+                            for (UINT u = 0; u < itemCount; u++)
+                            {
+                                pwtd->spsrm->GetItemByIndex(u, &items[u]);
+                            }
+
+                            CPowerRenameFileSystem fileSystem;
+                            PrefetchItemMetadata(items, fileSystem, isCanceled);
                         }
+                    }
+                    CoTaskMemFree(replaceTerm);
+
+                    // Items are split into chunks which are evaluated in parallel by a pool of workers.
+                    // Results are committed to the items on this thread in index order, which keeps
+                    // the enumeration numbering stable and lets us report one range per chunk.
+                    // Chunks are published as the enumeration adds items so the preview starts with
+                    // the first items instead of waiting for the whole selection.
+                    std::deque<PreviewChunk> chunks;
+                    bool allPublished = false;
+                    UINT nextChunk = 0;
+                    std::mutex chunksMutex;
+                    std::condition_variable chunkPublished;
+                    std::condition_variable chunkDone;
+
+                    auto publishChunks = [&]() {
+                        // Read the enumeration state before the count, the last partial chunk can only
+                        // be published once no more items are coming.
+                        const bool enumerationDone = WaitForSingleObject(pwtd->enumCompleteEvent, 0) == WAIT_OBJECT_0;
+                        UINT itemCount = 0;
+                        pwtd->spsrm->GetItemCount(&itemCount);
 
-                        CComPtr<IPowerRenameItem> spItem;
-                        if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(u, &spItem)))
                         {
-                            int id = -1;
-                            spItem->get_id(&id);
-
-                            bool isFolder = false;
-                            bool isSubFolderContent = false;
-                            spItem->get_isFolder(&isFolder);
-                            spItem->get_isSubFolderContent(&isSubFolderContent);
-                            if ((isFolder && (flags & PowerRenameFlags::ExcludeFolders)) ||
-                                (!isFolder && (flags & PowerRenameFlags::ExcludeFiles)) ||
-                                (isSubFolderContent && (flags & PowerRenameFlags::ExcludeSubfolders)))
+                            std::unique_lock lock(chunksMutex);
+                            UINT first = static_cast<UINT>(chunks.size()) * c_previewChunkSize;
+                            while (first < itemCount && (enumerationDone || itemCount - first >= c_previewChunkSize))
                             {
-                                // Exclude this item from renaming.  Ensure new name is cleared.
-                                spItem->put_newName(nullptr);
-
-                                // Send the manager thread the item processed message
-                                PostMessage(pwtd->hwndManager, SRM_REGEX_ITEM_UPDATED, GetCurrentThreadId(), id);
-
-                                continue;
+                                PreviewChunk chunk;
+                                chunk.first = first;
+                                chunk.last = min(first + c_previewChunkSize, itemCount);
+                                chunks.push_back(std::move(chunk));
+                                first += c_previewChunkSize;
                             }
+                            allPublished = enumerationDone;
+                        }
+                        chunkPublished.notify_all();
+                        return enumerationDone;
+                    };
 
-                            PWSTR originalName = nullptr;
-                            if (SUCCEEDED(spItem->get_originalName(&originalName)))
+                    auto previewWorker = [&]() {
+                        if (SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED)))
+                        {
+                            NameTransformBuffers buffers;
+                            while (!isCanceled())
                             {
-                                PWSTR currentNewName = nullptr;
-                                spItem->get_newName(&currentNewName);
-
-                                wchar_t sourceName[MAX_PATH] = { 0 };
-                                if (flags & NameOnly)
+                                UINT chunk = 0;
+                                UINT first = 0;
+                                UINT last = 0;
                                 {
-                                    StringCchCopy(sourceName, ARRAYSIZE(sourceName), fs::path(originalName).stem().c_str());
+                                    std::unique_lock lock(chunksMutex);
+                                    chunkPublished.wait(lock, [&]() { return stop || nextChunk < chunks.size() || allPublished; });
+                                    if (stop || nextChunk >= chunks.size())
+                                    {
+                                        break;
+                                    }
+                                    chunk = nextChunk++;
+                                    first = chunks[chunk].first;
+                                    last = chunks[chunk].last;
                                 }
-                                else if (flags & ExtensionOnly)
+
+                                std::vector<PreviewItemResult> results(last - first);
+                                for (UINT u = first; u < last; u++)
                                 {
-                                    std::wstring extension = fs::path(originalName).extension().wstring();
-                                    if (!extension.empty() && extension.front() == '.')
+                                    auto& result = results[u - first];
+                                    if (SUCCEEDED(pwtd->spsrm->GetItemByIndex(u, &result.spItem)))
                                     {
-                                        extension = extension.erase(0, 1);
+                                        EvaluatePreviewItem(spRenameRegEx, flags, buffers, result);
                                     }
-                                    StringCchCopy(sourceName, ARRAYSIZE(sourceName), extension.c_str());
                                 }
-                                else
+
                                 {
-                                    StringCchCopy(sourceName, ARRAYSIZE(sourceName), originalName);
+                                    std::unique_lock lock(chunksMutex);
+                                    chunks[chunk].results = std::move(results);
+                                    chunks[chunk].done = true;
                                 }
+                                chunkDone.notify_all();
+                            }
+                            CoUninitialize();
+                        }
+                    };
 
-                                PWSTR newName = nullptr;
-                                // Failure here means we didn't match anything or had nothing to match
-                                // Call put_newName with null in that case to reset it
-                                spRenameRegEx->Replace(sourceName, &newName);
-
-                                wchar_t resultName[MAX_PATH] = { 0 };
+                    // Without a running enumeration the number of chunks is known up front
+                    UINT workerCount = min(max(std::thread::hardware_concurrency(), 1u), c_maxPreviewWorkers);
+                    if (publishChunks())
+                    {
+                        workerCount = min(workerCount, static_cast<UINT>(chunks.size()));
+                    }
 
-                                PWSTR newNameToUse = nullptr;
+                    std::vector<std::thread> workers;
+                    for (UINT i = 0; i < workerCount; i++)
+                    {
+                        workers.emplace_back(previewWorker);
+                    }
 
-                                // newName == nullptr likely means we have an empty search string.  We should leave newNameToUse
-                                // as nullptr so we clear the renamed column
-                                // Except string transformation is selected.
-                                
-                                if (newName == nullptr && (flags & Uppercase || flags & Lowercase || flags & Titlecase))
+                    bool canceled = false;
+                    unsigned long itemEnumIndex = 1;
+                    std::vector<wchar_t> uniqueName;
+                    for (UINT chunk = 0; !canceled; chunk++)
+                    {
+                        // Wait for the enumeration to add enough items for the next chunk
+                        for (;;)
+                        {
+                            {
+                                std::unique_lock lock(chunksMutex);
+                                if (chunk < chunks.size() || allPublished)
                                 {
-                                    SHStrDup(sourceName, &newName);
+                                    break;
                                 }
+                            }
 
-                                if (newName != nullptr)
-                                {
-                                    newNameToUse = resultName;
-                                    if (flags & NameOnly)
-                                    {
-                                        StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s%s", newName, fs::path(originalName).extension().c_str());
-                                    }
-                                    else if (flags & ExtensionOnly)
-                                    {
-                                        std::wstring extension = fs::path(originalName).extension().wstring();
-                                        if (!extension.empty())
-                                        {
-                                            StringCchPrintf(resultName, ARRAYSIZE(resultName), L"%s.%s", fs::path(originalName).stem().c_str(), newName);
-                                        }
-                                        else
-                                        {
-                                            StringCchCopy(resultName, ARRAYSIZE(resultName), originalName);
-                                        }
-                                    }
-                                    else
-                                    {
-                                        StringCchCopy(resultName, ARRAYSIZE(resultName), newName);
-                                    }
-                                }
-                                
-                                wchar_t trimmedName[MAX_PATH] = { 0 };
-                                if (newNameToUse != nullptr && SUCCEEDED(GetTrimmedFileName(trimmedName, ARRAYSIZE(trimmedName), newNameToUse)))
-                                {
-                                    newNameToUse = trimmedName;
-                                }
-                                
-                                bool isDateAttributeUsed = false;
-                                wchar_t datedName[MAX_PATH] = { 0 };
-                                std::wstring patterns[] = { L"$YYYY", L"$SSS", L"$MMM", L"$mmm", L"$FFF", L"$fff", 
-                                    L"$MM", L"$DD", L"$hh", L"$mm", L"$ss" };
-                                size_t patternsLength = ARRAYSIZE(patterns);
-                                SYSTEMTIME LocalTime;
-
-                                if (newNameToUse != nullptr)
-                                {
-                                    for (size_t i = 0; !isDateAttributeUsed && i < patternsLength; i++)
-                                    {
-                                        std::wstring source(newNameToUse);
-                                        if (source.find(patterns[i]) != std::string::npos)
-                                        {
-                                            isDateAttributeUsed = true;
-                                        }
-                                    }
-                                    if (isDateAttributeUsed)
-                                    {
-                                        if (SUCCEEDED(spItem->get_date(&LocalTime)))
-                                        {
-                                            if (SUCCEEDED(GetDatedFileName(datedName, ARRAYSIZE(datedName), newNameToUse, LocalTime)))
-                                            {
-                                                newNameToUse = datedName;
-                                            }
-                                        }
-                                    }
-                                }
-                                                                
-                                wchar_t transformedName[MAX_PATH] = { 0 };
-                                if (newNameToUse != nullptr && (flags & Uppercase || flags & Lowercase || flags & Titlecase))
-                                {
-                                    if (SUCCEEDED(GetTransformedFileName(transformedName, ARRAYSIZE(transformedName), newNameToUse, flags)))
-                                    {
-                                        newNameToUse = transformedName;
-                                    }
-                                }
+                            HANDLE waitHandles[] = { pwtd->cancelEvent, pwtd->itemsAddedEvent, pwtd->enumCompleteEvent };
+                            if (WaitForMultipleObjects(ARRAYSIZE(waitHandles), waitHandles, FALSE, INFINITE) == WAIT_OBJECT_0)
+                            {
+                                canceled = true;
+                                break;
+                            }
+                            publishChunks();
+                        }
 
-                                // No change from originalName so set newName to
-                                // null so we clear it from our UI as well.
-                                if (lstrcmp(originalName, newNameToUse) == 0)
-                                {
-                                    newNameToUse = nullptr;
-                                }
+                        std::vector<PreviewItemResult> results;
+                        UINT first = 0;
+                        {
+                            std::unique_lock lock(chunksMutex);
+                            if (canceled || chunk >= chunks.size())
+                            {
+                                break;
+                            }
 
-                                wchar_t uniqueName[MAX_PATH] = { 0 };
+                            while (!chunks[chunk].done && !isCanceled())
+                            {
+                                chunkDone.wait_for(lock, std::chrono::milliseconds(20));
+                            }
+                            results = std::move(chunks[chunk].results);
+                            first = chunks[chunk].first;
+                        }
+
+                        // Check if cancel event is signaled
+                        if (isCanceled())
+                        {
+                            canceled = true;
+                            break;
+                        }
+
+                        UINT firstUpdated = UINT_MAX;
+                        UINT lastUpdated = 0;
+                        for (UINT i = 0; i < results.size(); i++)
+                        {
+                            auto& result = results[i];
+                            bool updated = false;
+                            if (result.excluded)
+                            {
+                                result.spItem->put_newName(nullptr);
+                                updated = true;
+                            }
+                            else if (result.evaluated)
+                            {
+                                PWSTR currentNewName = nullptr;
+                                result.spItem->get_newName(&currentNewName);
+
+                                PCWSTR newNameToUse = result.hasNewName ? result.newName.c_str() : nullptr;
                                 if (newNameToUse != nullptr && (flags & EnumerateItems))
                                 {
+                                    // Leave room for the " (n)" suffix, names may be longer than MAX_PATH
+                                    uniqueName.resize(max(result.newName.length() + 32, static_cast<size_t>(MAX_PATH)));
                                     unsigned long countUsed = 0;
-                                    if (GetEnumeratedFileName(uniqueName, ARRAYSIZE(uniqueName), newNameToUse, nullptr, itemEnumIndex, &countUsed))
+                                    if (GetEnumeratedFileName(uniqueName.data(), static_cast<UINT>(uniqueName.size()), newNameToUse, nullptr, itemEnumIndex, &countUsed))
                                     {
-                                        newNameToUse = uniqueName;
+                                        newNameToUse = uniqueName.data();
                                     }
                                     itemEnumIndex++;
                                 }
 
-                                spItem->put_newName(newNameToUse);
+                                result.spItem->put_newName(newNameToUse);
 
                                 // Was there a change?
-                                if (lstrcmp(currentNewName, newNameToUse) != 0)
-                                {
-                                    // Send the manager thread the item processed message
-                                    PostMessage(pwtd->hwndManager, SRM_REGEX_ITEM_UPDATED, GetCurrentThreadId(), id);
-                                }
-
-                                CoTaskMemFree(newName);
+                                updated = lstrcmp(currentNewName, newNameToUse) != 0;
                                 CoTaskMemFree(currentNewName);
-                                CoTaskMemFree(originalName);
+                            }
+
+                            if (updated)
+                            {
+                                firstUpdated = min(firstUpdated, first + i);
+                                lastUpdated = max(lastUpdated, first + i);
+                            }
+                        }
+
+                        if (firstUpdated != UINT_MAX)
+                        {
+                            // Send the manager thread the processed range
+                            PostMessage(pwtd->hwndManager, SRM_REGEX_ITEMS_UPDATED, firstUpdated, lastUpdated);
+                        }
+                    }
+
+                    {
+                        std::unique_lock lock(chunksMutex);
+                        stop = true;
+                    }
+                    chunkPublished.notify_all();
+                    for (auto& worker : workers)
+                    {
+                        worker.join();
+                    }
+
+                    if (canceled)
+                    {
+                        // Canceled from manager
+                        // Send the manager thread the canceled message
+                        PostMessage(pwtd->hwndManager, SRM_REGEX_CANCELED, GetCurrentThreadId(), 0);
+                    }
+                    else
+                    {
+                        // Let the UI know about name conflicts before the user commits the rename
+                        CPowerRenamePlan plan;
+                        if (SUCCEEDED(plan.Build(pwtd->spsrm, flags)))
+                        {
+                            PowerRenamePlanStats* stats = new PowerRenamePlanStats(plan.GetStats());
+                            if (!PostMessage(pwtd->hwndManager, SRM_RENAME_PLAN_UPDATED, 0, reinterpret_cast<LPARAM>(stats)))
+                            {
+                                delete stats;
                             }
                         }
                     }
@@ -923,6 +1106,146 @@ void CPowerRenameManager::_WaitForRegExWorkerThread()
     }
 }
 
+namespace
+{
+    // Batches of enumerated items the enumeration worker can queue before it waits for the
+    // manager thread to add them
+    constexpr size_t c_maxQueuedEnumBatches = 16;
+    // How often the queue is drained while the manager thread waits for the enumeration worker
+    constexpr DWORD c_enumDrainIntervalMs = 10;
+}
+
+HRESULT CPowerRenameManager::_CreateEnumWorkerThread(_In_ IShellItemArray* psia)
+{
+    EnumWorkerThreadData* pewtd = new EnumWorkerThreadData;
+    HRESULT hr = pewtd ? S_OK : E_OUTOFMEMORY;
+    if (SUCCEEDED(hr))
+    {
+        hr = get_renameItemFactory(&pewtd->spItemFactory);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // The shell item array belongs to this thread's apartment
+        hr = CoMarshalInterThreadInterfaceInStream(__uuidof(IShellItemArray), psia, &pewtd->shellItemArrayStream);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        m_enumQueue = std::make_shared<CPowerRenameItemQueue>(c_maxQueuedEnumBatches);
+        ResetEvent(m_cancelEnumWorkerEvent);
+        ResetEvent(m_enumCompleteEvent);
+
+        pewtd->hwndManager = m_hwndMessage;
+        pewtd->cancelEvent = m_cancelEnumWorkerEvent;
+        pewtd->queue = m_enumQueue;
+
+        IStream* shellItemArrayStream = pewtd->shellItemArrayStream;
+        m_enumWorkerThreadHandle = CreateThread(nullptr, 0, s_enumWorkerThread, pewtd, 0, &m_enumWorkerThreadId);
+        hr = (m_enumWorkerThreadHandle) ? S_OK : E_FAIL;
+        if (FAILED(hr))
+        {
+            CoReleaseMarshalData(shellItemArrayStream);
+            shellItemArrayStream->Release();
+            m_enumQueue = nullptr;
+            SetEvent(m_enumCompleteEvent);
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        delete pewtd;
+    }
+
+    return hr;
+}
+
+DWORD WINAPI CPowerRenameManager::s_enumWorkerThread(_In_ void* pv)
+{
+    EnumWorkerThreadData* pewtd = reinterpret_cast<EnumWorkerThreadData*>(pv);
+    if (SUCCEEDED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE)))
+    {
+        CComPtr<IShellItemArray> spsia;
+        if (SUCCEEDED(CoGetInterfaceAndReleaseStream(pewtd->shellItemArrayStream, IID_PPV_ARGS(&spsia))))
+        {
+            // Items are queued in batches and the manager thread is told to pick them up. The queue
+            // blocks us if the manager falls behind and is closed if the enumeration is canceled.
+            EnumerateDataObjectItems(spsia, pewtd->spItemFactory, [pewtd](IPowerRenameItem** items, UINT count) {
+                if (WaitForSingleObject(pewtd->cancelEvent, 0) == WAIT_OBJECT_0 ||
+                    !pewtd->queue->Push(std::vector<CComPtr<IPowerRenameItem>>(items, items + count)))
+                {
+                    return E_ABORT;
+                }
+
+                PostMessage(pewtd->hwndManager, SRM_ENUM_ITEMS_READY, 0, 0);
+                return S_OK;
+            });
+        }
+
+        CoUninitialize();
+    }
+    else
+    {
+        pewtd->shellItemArrayStream->Release();
+    }
+
+    PostMessage(pewtd->hwndManager, SRM_ENUM_COMPLETE, GetCurrentThreadId(), 0);
+
+    delete pewtd;
+
+    return 0;
+}
+
+void CPowerRenameManager::_AddEnumeratedItems()
+{
+    std::vector<CComPtr<IPowerRenameItem>> items;
+    if (m_enumQueue && m_enumQueue->TryPopAll(items))
+    {
+        std::vector<IPowerRenameItem*> batch(items.begin(), items.end());
+        AddItems(batch.data(), static_cast<UINT>(batch.size()));
+    }
+}
+
+void CPowerRenameManager::_CancelEnumWorkerThread()
+{
+    if (m_cancelEnumWorkerEvent)
+    {
+        SetEvent(m_cancelEnumWorkerEvent);
+    }
+
+    if (m_enumQueue)
+    {
+        m_enumQueue->Close();
+    }
+
+    _WaitForEnumWorkerThread();
+}
+
+void CPowerRenameManager::_WaitForEnumWorkerThread()
+{
+    if (m_enumWorkerThreadHandle)
+    {
+        // The worker blocks while the queue is full so keep adding items while we wait
+        while (WaitForSingleObject(m_enumWorkerThreadHandle, c_enumDrainIntervalMs) == WAIT_TIMEOUT)
+        {
+            _AddEnumeratedItems();
+        }
+        _AddEnumeratedItems();
+
+        CloseHandle(m_enumWorkerThreadHandle);
+        m_enumWorkerThreadHandle = nullptr;
+        m_enumWorkerThreadId = 0;
+        m_enumQueue = nullptr;
+
+        // Items are all in, let the regex worker finish the preview
+        SetEvent(m_enumCompleteEvent);
+
+        UINT itemCount = 0;
+        GetItemCount(&itemCount);
+        _OnEnumerationCompleted(itemCount);
+    }
+}
+
 void CPowerRenameManager::_Cancel()
 {
     SetEvent(m_startFileOpWorkerEvent);
@@ -982,7 +1305,20 @@ void CPowerRenameManager::_OnItemAdded(_In_ IPowerRenameItem* renameItem)
     }
 }
 
-void CPowerRenameManager::_OnUpdate(_In_ IPowerRenameItem* renameItem)
+void CPowerRenameManager::_OnItemsAdded(_In_ UINT itemCount)
+{
+    CSRWSharedAutoLock lock(&m_lockEvents);
+
+    for (auto it : m_powerRenameManagerEvents)
+    {
+        if (it.pEvents)
+        {
+            it.pEvents->OnItemsAdded(itemCount);
+        }
+    }
+}
+
+void CPowerRenameManager::_OnEnumerationCompleted(_In_ UINT itemCount)
 {
     CSRWSharedAutoLock lock(&m_lockEvents);
 
@@ -990,7 +1326,33 @@ void CPowerRenameManager::_OnUpdate(_In_ IPowerRenameItem* renameItem)
     {
         if (it.pEvents)
         {
-            it.pEvents->OnUpdate(renameItem);
+            it.pEvents->OnEnumerationCompleted(itemCount);
+        }
+    }
+}
+
+void CPowerRenameManager::_OnRenamePlanUpdated(_In_ const PowerRenamePlanStats* stats)
+{
+    CSRWSharedAutoLock lock(&m_lockEvents);
+
+    for (auto it : m_powerRenameManagerEvents)
+    {
+        if (it.pEvents)
+        {
+            it.pEvents->OnRenamePlanUpdated(stats);
+        }
+    }
+}
+
+void CPowerRenameManager::_OnItemsUpdated(_In_ UINT firstIndex, _In_ UINT lastIndex)
+{
+    CSRWSharedAutoLock lock(&m_lockEvents);
+
+    for (auto it : m_powerRenameManagerEvents)
+    {
+        if (it.pEvents)
+        {
+            it.pEvents->OnItemsUpdated(firstIndex, lastIndex);
         }
     }
 }
@@ -1091,22 +1453,54 @@ void CPowerRenameManager::_ClearEventHandlers()
     m_powerRenameManagerEvents.clear();
 }
 
+bool CPowerRenameManager::_InsertItem(_In_ IPowerRenameItem* pItem)
+{
+    int id = 0;
+    pItem->get_id(&id);
+    // Verify the item isn't already added
+    if (m_renameItemIndices.find(id) != m_renameItemIndices.end())
+    {
+        return false;
+    }
+
+    if (m_renameItems.empty() || m_renameItems.back().id < id)
+    {
+        // Items are normally added in id order so this is the common case
+        m_renameItemIndices[id] = static_cast<UINT>(m_renameItems.size());
+        m_renameItems.push_back({ id, pItem });
+    }
+    else
+    {
+        auto it = std::lower_bound(m_renameItems.begin(), m_renameItems.end(), id, [](const RENAME_ITEM& item, int id) {
+            return item.id < id;
+        });
+        it = m_renameItems.insert(it, { id, pItem });
+        for (size_t i = it - m_renameItems.begin(); i < m_renameItems.size(); i++)
+        {
+            m_renameItemIndices[m_renameItems[i].id] = static_cast<UINT>(i);
+        }
+    }
+    pItem->AddRef();
+    return true;
+}
+
 void CPowerRenameManager::_ClearPowerRenameItems()
 {
     CSRWExclusiveAutoLock lock(&m_lockItems);
 
     // Cleanup rename items
-    for (std::map<int, IPowerRenameItem*>::iterator it = m_renameItems.begin(); it != m_renameItems.end(); ++it)
+    for (std::vector<RENAME_ITEM>::iterator it = m_renameItems.begin(); it != m_renameItems.end(); ++it)
     {
-        IPowerRenameItem* pItem = it->second;
+        IPowerRenameItem* pItem = it->pItem;
         if (pItem)
         {
             pItem->Release();
-            it->second = nullptr;
+            it->pItem = nullptr;
         }
     }
 
     m_renameItems.clear();
+    m_renameItemIndices.clear();
 }
 
 void CPowerRenameManager::_Cleanup()
@@ -1126,6 +1520,15 @@ void CPowerRenameManager::_Cleanup()
     CloseHandle(m_cancelRegExWorkerEvent);
     m_cancelRegExWorkerEvent = nullptr;
 
+    CloseHandle(m_cancelEnumWorkerEvent);
+    m_cancelEnumWorkerEvent = nullptr;
+
+    CloseHandle(m_enumCompleteEvent);
+    m_enumCompleteEvent = nullptr;
+
+    CloseHandle(m_itemsAddedEvent);
+    m_itemsAddedEvent = nullptr;
+
     _ClearRegEx();
     _ClearEventHandlers();
     _ClearPowerRenameItems();
@@ -1,10 +1,13 @@
 #pragma once
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
 #include "srwlock.h"
 
 #include <lib/PowerRenameManager.h>
 #include <lib/PowerRenameInterfaces.h>
+#include <lib/PowerRenameItemQueue.h>
 
 class CPowerRenameManager :
     public IPowerRenameManager,
@@ -25,6 +28,8 @@ public:
     IFACEMETHODIMP Shutdown();
     IFACEMETHODIMP Rename(_In_ HWND hwndParent);
     IFACEMETHODIMP AddItem(_In_ IPowerRenameItem* pItem);
+    IFACEMETHODIMP AddItems(_In_reads_(count) IPowerRenameItem** items, _In_ UINT count);
+    IFACEMETHODIMP StartEnumeration(_In_ IUnknown* dataSource);
     IFACEMETHODIMP GetItemByIndex(_In_ UINT index, _COM_Outptr_ IPowerRenameItem** ppItem);
     IFACEMETHODIMP GetItemById(_In_ int id, _COM_Outptr_ IPowerRenameItem** ppItem);
     IFACEMETHODIMP GetItemCount(_Out_ UINT* count);
@@ -54,7 +59,10 @@ protected:
     void _Cancel();
 
     void _OnItemAdded(_In_ IPowerRenameItem* renameItem);
-    void _OnUpdate(_In_ IPowerRenameItem* renameItem);
+    void _OnItemsAdded(_In_ UINT itemCount);
+    void _OnEnumerationCompleted(_In_ UINT itemCount);
+    void _OnRenamePlanUpdated(_In_ const PowerRenamePlanStats* stats);
+    void _OnItemsUpdated(_In_ UINT firstIndex, _In_ UINT lastIndex);
     void _OnError(_In_ IPowerRenameItem* renameItem);
     void _OnRegExStarted(_In_ DWORD threadId);
     void _OnRegExCanceled(_In_ DWORD threadId);
@@ -65,6 +73,8 @@ protected:
     void _ClearEventHandlers();
     void _ClearPowerRenameItems();
 
+    bool _InsertItem(_In_ IPowerRenameItem* pItem);
+
     HRESULT _PerformRegExRename();
     HRESULT _PerformFileOperation();
 
@@ -73,6 +83,11 @@ protected:
     void _WaitForRegExWorkerThread();
     HRESULT _CreateFileOpWorkerThread();
 
+    HRESULT _CreateEnumWorkerThread(_In_ IShellItemArray* psia);
+    void _CancelEnumWorkerThread();
+    void _WaitForEnumWorkerThread();
+    void _AddEnumeratedItems();
+
     HRESULT _EnsureRegEx();
     HRESULT _InitRegEx();
     void _ClearRegEx();
@@ -81,6 +96,8 @@ protected:
     static DWORD WINAPI s_regexWorkerThread(_In_ void* pv);
     // Thread proc for performing the actual file operation that does the file rename
     static DWORD WINAPI s_fileOpWorkerThread(_In_ void* pv);
+    // Thread proc for enumerating the data source and creating the rename items
+    static DWORD WINAPI s_enumWorkerThread(_In_ void* pv);
 
     static LRESULT CALLBACK s_msgWndProc(_In_ HWND hwnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam);
     LRESULT _WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM wParam, _In_ LPARAM lParam);
@@ -94,6 +111,15 @@ protected:
     HANDLE m_fileOpWorkerThreadHandle = nullptr;
     HANDLE m_startFileOpWorkerEvent = nullptr;
 
+    HANDLE m_enumWorkerThreadHandle = nullptr;
+    DWORD m_enumWorkerThreadId = 0;
+    HANDLE m_cancelEnumWorkerEvent = nullptr;
+    // Signaled while no enumeration is running
+    HANDLE m_enumCompleteEvent = nullptr;
+    // Signaled when items are added so the regex worker can pick them up
+    HANDLE m_itemsAddedEvent = nullptr;
+    std::shared_ptr<CPowerRenameItemQueue> m_enumQueue;
+
     CSRWLock m_lockEvents;
     CSRWLock m_lockItems;
 
@@ -108,11 +134,19 @@ protected:
         DWORD cookie;
     };
 
+    struct RENAME_ITEM
+    {
+        int id;
+        IPowerRenameItem* pItem;
+    };
+
     CComPtr<IPowerRenameItemFactory> m_spItemFactory;
     CComPtr<IPowerRenameRegEx> m_spRegEx;
 
     _Guarded_by_(m_lockEvents) std::vector<RENAME_MGR_EVENT> m_powerRenameManagerEvents;
-    _Guarded_by_(m_lockItems) std::map<int, IPowerRenameItem*> m_renameItems;
+    // Items ordered by id so GetItemByIndex is a direct lookup, with an id to index side table for GetItemById
+    _Guarded_by_(m_lockItems) std::vector<RENAME_ITEM> m_renameItems;
+    _Guarded_by_(m_lockItems) std::unordered_map<int, UINT> m_renameItemIndices;
 
     // Parent HWND used by IFileOperation
     HWND m_hwndParent = nullptr;
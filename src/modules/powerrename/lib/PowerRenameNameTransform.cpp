@@ -0,0 +1,376 @@
+#include "pch.h"
+#include "PowerRenameNameTransform.h"
+#include <algorithm>
+#include <cwctype>
+#include <locale>
+
+namespace
+{
+    enum class MetadataToken
+    {
+        None,
+        ModifiedDate,
+        Size,
+        Year,
+        Milliseconds,
+        Month,
+        Day,
+        Hour,
+        Minute,
+        Second
+    };
+
+    // Returns the token starting at name[pos] (which must be a '$') and its length.
+    // Longer tokens take precedence, e.g. $MMM is milliseconds and not $MM followed by M.
+    MetadataToken MatchMetadataToken(std::wstring_view name, size_t pos, size_t& length)
+    {
+        std::wstring_view rest = name.substr(pos + 1);
+        auto startsWith = [&rest](std::wstring_view token) {
+            return rest.substr(0, token.length()) == token;
+        };
+
+        length = 9;
+        if (startsWith(L"MODIFIED"))
+        {
+            return MetadataToken::ModifiedDate;
+        }
+
+        length = 5;
+        if (startsWith(L"SIZE"))
+        {
+            return MetadataToken::Size;
+        }
+
+        if (startsWith(L"YYYY"))
+        {
+            return MetadataToken::Year;
+        }
+
+        length = 4;
+        if (startsWith(L"SSS") || startsWith(L"MMM") || startsWith(L"mmm") || startsWith(L"fff") || startsWith(L"FFF"))
+        {
+            return MetadataToken::Milliseconds;
+        }
+
+        length = 3;
+        if (startsWith(L"MM"))
+        {
+            return MetadataToken::Month;
+        }
+        if (startsWith(L"DD"))
+        {
+            return MetadataToken::Day;
+        }
+        if (startsWith(L"hh"))
+        {
+            return MetadataToken::Hour;
+        }
+        if (startsWith(L"mm"))
+        {
+            return MetadataToken::Minute;
+        }
+        if (startsWith(L"ss"))
+        {
+            return MetadataToken::Second;
+        }
+
+        length = 0;
+        return MetadataToken::None;
+    }
+
+    void AppendNumber(std::wstring& result, ULONGLONG value, size_t minDigits)
+    {
+        wchar_t digits[24];
+        size_t count = 0;
+        do
+        {
+            digits[count++] = static_cast<wchar_t>(L'0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+
+        for (; count < minDigits; minDigits--)
+        {
+            result.push_back(L'0');
+        }
+        while (count > 0)
+        {
+            result.push_back(digits[--count]);
+        }
+    }
+
+    void AppendMetadataToken(std::wstring& result, MetadataToken token, const PowerRenameItemMetadata& metadata)
+    {
+        const SYSTEMTIME& date = metadata.creationTime;
+        switch (token)
+        {
+        case MetadataToken::ModifiedDate:
+            AppendNumber(result, metadata.lastWriteTime.wYear, 1);
+            result.push_back(L'-');
+            AppendNumber(result, metadata.lastWriteTime.wMonth, 2);
+            result.push_back(L'-');
+            AppendNumber(result, metadata.lastWriteTime.wDay, 2);
+            break;
+        case MetadataToken::Size:
+            AppendNumber(result, metadata.size, 1);
+            break;
+        case MetadataToken::Year:
+            AppendNumber(result, date.wYear, 1);
+            break;
+        case MetadataToken::Milliseconds:
+            AppendNumber(result, date.wMilliseconds, 3);
+            break;
+        case MetadataToken::Month:
+            AppendNumber(result, date.wMonth, 2);
+            break;
+        case MetadataToken::Day:
+            AppendNumber(result, date.wDay, 2);
+            break;
+        case MetadataToken::Hour:
+            AppendNumber(result, date.wHour, 2);
+            break;
+        case MetadataToken::Minute:
+            AppendNumber(result, date.wMinute, 2);
+            break;
+        case MetadataToken::Second:
+            AppendNumber(result, date.wSecond, 2);
+            break;
+        }
+    }
+
+    void TransformRange(std::wstring& name, size_t first, size_t last, wint_t (*transform)(wint_t))
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            name[i] = static_cast<wchar_t>(transform(name[i]));
+        }
+    }
+
+    bool IsWordSeparator(wchar_t c)
+    {
+        return iswspace(c) || iswpunct(c);
+    }
+
+    void TitlecaseStem(std::wstring& name, size_t stemLength)
+    {
+        static const std::wstring_view exceptions[] = { L"a", L"an", L"to", L"the", L"at", L"by", L"for", L"in", L"of", L"on", L"up", L"and", L"as", L"but", L"or", L"nor" };
+
+        while (stemLength > 0 && IsWordSeparator(name[stemLength - 1]))
+        {
+            stemLength--;
+        }
+
+        bool isFirstWord = true;
+        for (size_t i = 0; i < stemLength; i++)
+        {
+            if (!i || IsWordSeparator(name[i - 1]))
+            {
+                if (IsWordSeparator(name[i]))
+                {
+                    continue;
+                }
+                size_t wordLength = 0;
+                while (i + wordLength < stemLength && !IsWordSeparator(name[i + wordLength]))
+                {
+                    wordLength++;
+                }
+                const std::wstring_view word(name.data() + i, wordLength);
+                if (isFirstWord || i + wordLength == stemLength || std::find(std::begin(exceptions), std::end(exceptions), word) == std::end(exceptions))
+                {
+                    name[i] = towupper(name[i]);
+                    isFirstWord = false;
+                }
+                else
+                {
+                    name[i] = towlower(name[i]);
+                }
+            }
+            else
+            {
+                name[i] = towlower(name[i]);
+            }
+        }
+    }
+}
+
+size_t GetFileStemLength(_In_ std::wstring_view name)
+{
+    if (name == L"." || name == L"..")
+    {
+        return name.length();
+    }
+
+    // A leading dot starts the stem, e.g. ".gitignore" has no extension
+    const size_t dot = name.rfind(L'.');
+    return (dot == std::wstring_view::npos || dot == 0) ? name.length() : dot;
+}
+
+void TrimFileName(_Inout_ std::wstring& name)
+{
+    size_t first = 0;
+    while (first < name.length() && iswspace(name[first]))
+    {
+        first++;
+    }
+
+    size_t last = name.length();
+    while (last > first && (iswspace(name[last - 1]) || name[last - 1] == L'.'))
+    {
+        last--;
+    }
+
+    name.erase(last);
+    name.erase(0, first);
+}
+
+bool HasMetadataTokens(_In_ std::wstring_view text)
+{
+    for (size_t pos = text.find(L'$'); pos != std::wstring_view::npos; pos = text.find(L'$', pos + 1))
+    {
+        size_t length = 0;
+        if (MatchMetadataToken(text, pos, length) != MetadataToken::None)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ReplaceMetadataTokens(_Inout_ std::wstring& name, _Inout_ std::wstring& scratch, _In_ const NameMetadataCallback& getMetadata)
+{
+    PowerRenameItemMetadata metadata;
+    bool hasMetadata = false;
+    size_t copied = 0;
+
+    scratch.clear();
+    for (size_t pos = name.find(L'$'); pos != std::wstring::npos; pos = name.find(L'$', pos + 1))
+    {
+        size_t length = 0;
+        const MetadataToken token = MatchMetadataToken(name, pos, length);
+        if (token == MetadataToken::None)
+        {
+            continue;
+        }
+
+        if (!hasMetadata)
+        {
+            if (!getMetadata(metadata))
+            {
+                return false;
+            }
+            hasMetadata = true;
+        }
+
+        scratch.append(name, copied, pos - copied);
+        AppendMetadataToken(scratch, token, metadata);
+        copied = pos + length;
+        pos = copied - 1;
+    }
+
+    if (!hasMetadata)
+    {
+        return false;
+    }
+
+    scratch.append(name, copied, std::wstring::npos);
+    name.swap(scratch);
+    return true;
+}
+
+void TransformFileNameCase(_Inout_ std::wstring& name, _In_ DWORD flags)
+{
+    // Case mapping of non ASCII characters depends on the user locale
+    static const bool localeInitialized = []() {
+        std::locale::global(std::locale(""));
+        return true;
+    }();
+    UNREFERENCED_PARAMETER(localeInitialized);
+
+    const size_t stemLength = GetFileStemLength(name);
+    const bool hasExtension = stemLength < name.length();
+
+    if (flags & (Uppercase | Lowercase))
+    {
+        auto transform = (flags & Uppercase) ? towupper : towlower;
+        if (flags & NameOnly)
+        {
+            TransformRange(name, 0, stemLength, transform);
+        }
+        else if ((flags & ExtensionOnly) && hasExtension)
+        {
+            TransformRange(name, stemLength, name.length(), transform);
+        }
+        else
+        {
+            TransformRange(name, 0, name.length(), transform);
+        }
+    }
+    else if ((flags & Titlecase) && !(flags & ExtensionOnly))
+    {
+        TitlecaseStem(name, stemLength);
+    }
+}
+
+bool TransformFileName(_In_ std::wstring_view originalName, _In_ DWORD flags, _In_ const NameReplaceCallback& replace, _In_ const NameMetadataCallback& getMetadata, _Inout_ NameTransformBuffers& buffers)
+{
+    const size_t stemLength = GetFileStemLength(originalName);
+    const std::wstring_view stem = originalName.substr(0, stemLength);
+    const std::wstring_view extension = originalName.substr(stemLength);
+    const bool transformCase = (flags & (Uppercase | Lowercase | Titlecase)) != 0;
+
+    // Pick the part of the name the search applies to
+    if (flags & NameOnly)
+    {
+        buffers.source.assign(stem);
+    }
+    else if (flags & ExtensionOnly)
+    {
+        buffers.source.assign(extension.empty() ? extension : extension.substr(1));
+    }
+    else
+    {
+        buffers.source.assign(originalName);
+    }
+
+    buffers.scratch.clear();
+    if (!replace(buffers.source.c_str(), buffers.scratch))
+    {
+        // Nothing to replace, the name only changes if a case transformation is selected
+        if (!transformCase)
+        {
+            buffers.name.clear();
+            return false;
+        }
+        buffers.scratch.assign(buffers.source);
+    }
+
+    // Put the replaced part back together with the rest of the name
+    std::wstring& name = buffers.name;
+    if (flags & NameOnly)
+    {
+        name.assign(buffers.scratch).append(extension);
+    }
+    else if (flags & ExtensionOnly)
+    {
+        if (!extension.empty())
+        {
+            name.assign(stem).append(L".").append(buffers.scratch);
+        }
+        else
+        {
+            name.assign(originalName);
+        }
+    }
+    else
+    {
+        name.assign(buffers.scratch);
+    }
+
+    TrimFileName(name);
+    ReplaceMetadataTokens(name, buffers.scratch, getMetadata);
+    if (transformCase)
+    {
+        TransformFileNameCase(name, flags);
+    }
+
+    return name != originalName;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "pch.h"
+#include "PowerRenameInterfaces.h"
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Scratch storage used while computing new names. Keep one per thread and reuse it for every
+// item so transforming a large selection does not reallocate for each name.
+struct NameTransformBuffers
+{
+    std::wstring source;
+    std::wstring name;
+    std::wstring scratch;
+};
+
+// Search and replace step. Returns false if nothing matched or there was nothing to match.
+typedef std::function<bool(_In_ PCWSTR source, _Inout_ std::wstring& result)> NameReplaceCallback;
+
+// Provides the file attributes for the date ($YYYY, $MM, $DD...), $MODIFIED and $SIZE tokens.
+// Only called if the name contains one of them.
+typedef std::function<bool(_Out_ PowerRenameItemMetadata& metadata)> NameMetadataCallback;
+
+// Computes the new name of an item from its original name by running, in order:
+// stem/extension split, replace, trim, metadata tokens and case transform.
+// Returns true and the new name in buffers.name if it differs from the original name.
+bool TransformFileName(_In_ std::wstring_view originalName, _In_ DWORD flags, _In_ const NameReplaceCallback& replace, _In_ const NameMetadataCallback& getMetadata, _Inout_ NameTransformBuffers& buffers);
+
+// Individual steps of the pipeline, all of them operate in place.
+
+// Returns the length of the stem of a file name, the rest of the name is the extension (including the dot)
+size_t GetFileStemLength(_In_ std::wstring_view name);
+
+// Removes leading whitespace and trailing whitespace and dots
+void TrimFileName(_Inout_ std::wstring& name);
+
+// Returns true if the text contains a date, $MODIFIED or $SIZE token. Other uses of '$', such as
+// regex backreferences ($1), are not tokens.
+bool HasMetadataTokens(_In_ std::wstring_view text);
+
+// Replaces all metadata tokens in a single scan. Returns false if there was no token, or if the
+// metadata could not be retrieved in which case the name is left unchanged.
+bool ReplaceMetadataTokens(_Inout_ std::wstring& name, _Inout_ std::wstring& scratch, _In_ const NameMetadataCallback& getMetadata);
+
+// Applies the Uppercase, Lowercase or Titlecase flag, taking NameOnly and ExtensionOnly into account
+void TransformFileNameCase(_Inout_ std::wstring& name, _In_ DWORD flags);
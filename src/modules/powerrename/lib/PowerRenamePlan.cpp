@@ -0,0 +1,306 @@
+#include "pch.h"
+#include "PowerRenamePlan.h"
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+    // File names are compared case insensitively, like the file system does
+    std::wstring FoldName(_In_ PCWSTR name, _In_ size_t length)
+    {
+        std::wstring folded(name, length);
+        if (!folded.empty())
+        {
+            CharUpperBuffW(folded.data(), static_cast<DWORD>(folded.length()));
+        }
+        return folded;
+    }
+
+    constexpr size_t c_unordered = SIZE_MAX;
+    constexpr size_t c_visiting = SIZE_MAX - 1;
+
+    struct PlanCandidate
+    {
+        CComPtr<IPowerRenameItem> spItem;
+        std::wstring newName;
+        // Folded current name, and folded name after the rename which is the same if the item keeps its name
+        std::wstring source;
+        std::wstring target;
+        UINT depth = 0;
+        bool renamed = false;
+        // Number of renames of the folder which have to run before this one
+        size_t order = c_unordered;
+
+        const std::wstring& FinalName() const { return renamed ? target : source; }
+    };
+
+    // Counts the renames of a folder to a name which is also the name of another item once the renames
+    // are done. The file operation renames them anyway, adding a number to the name, e.g. " (2)". Items
+    // keeping their name, or only changing its case, keep it, so every rename to their name collides.
+    // Otherwise the first rename to a name gets it and the other ones collide.
+    UINT CountCollisions(_In_ const std::vector<PlanCandidate>& candidates, _In_ const std::vector<size_t>& folder)
+    {
+        std::unordered_map<std::wstring_view, UINT> kept;
+        std::unordered_map<std::wstring_view, UINT> moved;
+        for (size_t i : folder)
+        {
+            const auto& candidate = candidates[i];
+            if (candidate.renamed && candidate.source != candidate.target)
+            {
+                moved[candidate.target]++;
+            }
+            else
+            {
+                kept[candidate.FinalName()]++;
+            }
+        }
+
+        UINT collisions = 0;
+        for (const auto& [name, count] : moved)
+        {
+            collisions += kept.count(name) ? count : count - 1;
+        }
+        return collisions;
+    }
+
+    // The file operation renames the items one at a time, so a rename to the current name of another
+    // renamed item has to run after that item is renamed. Renames forming a cycle, such as two items
+    // swapping their names, can't all be done one at a time: the first rename of a cycle collides with
+    // the current name of the next item and gets a number added to its name.
+    // Every item has one new name, so the renames waiting on each other form trees, whose roots are
+    // either free names or cycles. Returns the number of cycles.
+    UINT OrderRenames(_Inout_ std::vector<PlanCandidate>& candidates, _In_ const std::vector<size_t>& folder)
+    {
+        std::unordered_map<std::wstring_view, size_t> renamedSources;
+        for (size_t i : folder)
+        {
+            if (candidates[i].renamed && candidates[i].source != candidates[i].target)
+            {
+                renamedSources.emplace(candidates[i].source, i);
+            }
+        }
+
+        UINT cycles = 0;
+        std::vector<size_t> chain;
+        for (size_t i : folder)
+        {
+            if (!candidates[i].renamed || candidates[i].order != c_unordered)
+            {
+                continue;
+            }
+
+            // Follow the renames which free the new names until one is free or already ordered
+            chain.clear();
+            size_t order = 0;
+            bool cycle = false;
+            for (size_t current = i;;)
+            {
+                candidates[current].order = c_visiting;
+                chain.push_back(current);
+
+                auto it = renamedSources.find(candidates[current].target);
+                if (it == renamedSources.end())
+                {
+                    break;
+                }
+
+                const size_t next = it->second;
+                if (candidates[next].order == c_visiting)
+                {
+                    cycle = true;
+                    break;
+                }
+                if (candidates[next].order != c_unordered)
+                {
+                    order = candidates[next].order + 1;
+                    break;
+                }
+                current = next;
+            }
+
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+            {
+                candidates[*it].order = order++;
+            }
+            if (cycle)
+            {
+                cycles++;
+            }
+        }
+        return cycles;
+    }
+
+    bool IsReservedDeviceName(_In_ std::wstring_view name)
+    {
+        // The device names are reserved with any extension, and trailing spaces before it are ignored
+        name = name.substr(0, name.find(L'.'));
+        while (!name.empty() && name.back() == L' ')
+        {
+            name.remove_suffix(1);
+        }
+
+        static const PCWSTR reservedNames[] = { L"CON", L"PRN", L"AUX", L"NUL" };
+        for (PCWSTR reserved : reservedNames)
+        {
+            if (CompareStringOrdinal(name.data(), static_cast<int>(name.length()), reserved, -1, TRUE) == CSTR_EQUAL)
+            {
+                return true;
+            }
+        }
+
+        if (name.length() == 4 && name[3] >= L'1' && name[3] <= L'9')
+        {
+            return CompareStringOrdinal(name.data(), 3, L"COM", 3, TRUE) == CSTR_EQUAL ||
+                   CompareStringOrdinal(name.data(), 3, L"LPT", 3, TRUE) == CSTR_EQUAL;
+        }
+
+        return false;
+    }
+}
+
+bool CPowerRenamePlan::s_IsValidFileName(_In_ PCWSTR name)
+{
+    if (name == nullptr || *name == L'\0')
+    {
+        return false;
+    }
+
+    for (PCWSTR c = name; *c; c++)
+    {
+        if (*c < L' ' || wcschr(L"\\/:*?\"<>|", *c) != nullptr)
+        {
+            return false;
+        }
+    }
+
+    // Windows strips trailing dots and spaces, so the item would end up with another name
+    const std::wstring_view view(name);
+    if (view.back() == L'.' || view.back() == L' ')
+    {
+        return false;
+    }
+
+    return !IsReservedDeviceName(view);
+}
+
+HRESULT CPowerRenamePlan::Build(_In_ IPowerRenameManager* psrm, _In_ DWORD flags)
+{
+    m_buckets.clear();
+    m_stats = {};
+
+    UINT itemCount = 0;
+    HRESULT hr = psrm->GetItemCount(&itemCount);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // Items grouped by parent folder, since names only conflict within a folder. Items which are
+    // not renamed take part too as they keep their name.
+    std::vector<PlanCandidate> candidates;
+    candidates.reserve(itemCount);
+    std::vector<std::vector<size_t>> folders;
+    std::unordered_map<std::wstring, size_t> folderIndices;
+
+    for (UINT u = 0; u < itemCount; u++)
+    {
+        CComPtr<IPowerRenameItem> spItem;
+        PWSTR path = nullptr;
+        if (FAILED(psrm->GetItemByIndex(u, &spItem)) || FAILED(spItem->get_path(&path)))
+        {
+            continue;
+        }
+
+        PlanCandidate candidate;
+        candidate.spItem = spItem;
+
+        bool shouldRename = false;
+        PWSTR newName = nullptr;
+        if (SUCCEEDED(spItem->ShouldRenameItem(flags, &shouldRename)) && shouldRename)
+        {
+            spItem->get_newName(&newName);
+            if (s_IsValidFileName(newName))
+            {
+                candidate.newName = newName;
+                candidate.target = FoldName(newName, wcslen(newName));
+                candidate.renamed = true;
+            }
+            else
+            {
+                m_stats.invalidCount++;
+            }
+            CoTaskMemFree(newName);
+        }
+
+        PCWSTR name = PathFindFileName(path);
+        candidate.source = FoldName(name, wcslen(name));
+        spItem->get_depth(&candidate.depth);
+
+        auto folderKey = FoldName(path, name - path);
+        auto it = folderIndices.find(folderKey);
+        if (it == folderIndices.end())
+        {
+            it = folderIndices.emplace(std::move(folderKey), folders.size()).first;
+            folders.emplace_back();
+        }
+        folders[it->second].push_back(candidates.size());
+        candidates.push_back(std::move(candidate));
+
+        CoTaskMemFree(path);
+    }
+
+    std::vector<size_t> renames;
+    for (const auto& folder : folders)
+    {
+        m_stats.collisionCount += CountCollisions(candidates, folder);
+        m_stats.collisionCount += OrderRenames(candidates, folder);
+
+        renames.clear();
+        for (size_t i : folder)
+        {
+            if (candidates[i].renamed)
+            {
+                renames.push_back(i);
+            }
+        }
+        std::stable_sort(renames.begin(), renames.end(), [&candidates](size_t a, size_t b) {
+            return candidates[a].order < candidates[b].order;
+        });
+
+        for (size_t i : renames)
+        {
+            auto& candidate = candidates[i];
+            if (candidate.source == candidate.target)
+            {
+                m_stats.caseOnlyCount++;
+            }
+
+            if (candidate.depth >= m_buckets.size())
+            {
+                m_buckets.resize(candidate.depth + 1);
+            }
+            m_buckets[candidate.depth].push_back({ candidate.spItem, std::move(candidate.newName) });
+            m_stats.renameCount++;
+        }
+    }
+
+    return S_OK;
+}
+
+HRESULT CPowerRenamePlan::AddToFileOperation(_In_ IFileOperation* fileOp) const
+{
+    for (auto bucket = m_buckets.rbegin(); bucket != m_buckets.rend(); ++bucket)
+    {
+        for (const auto& entry : *bucket)
+        {
+            CComPtr<IShellItem> spShellItem;
+            if (SUCCEEDED(entry.spItem->get_shellItem(&spShellItem)))
+            {
+                fileOp->RenameItem(spShellItem, entry.newName.c_str(), nullptr);
+            }
+        }
+    }
+
+    return S_OK;
+}
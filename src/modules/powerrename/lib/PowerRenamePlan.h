@@ -0,0 +1,38 @@
+#pragma once
+#include "pch.h"
+#include "PowerRenameInterfaces.h"
+#include <string>
+#include <vector>
+
+struct RenamePlanEntry
+{
+    CComPtr<IPowerRenameItem> spItem;
+    std::wstring newName;
+};
+
+// The renames to perform, grouped by depth so the items of a folder are renamed before the
+// folder itself. The file operation renames the items one at a time, so within a folder a rename
+// to the current name of another renamed item is ordered after it. Renames which collide anyway
+// stay in the plan and get a number added to their name by the file operation: two items ending
+// up with the same name, an item taking the name of an item which keeps it, and cycles such as
+// two items swapping their names.
+class CPowerRenamePlan
+{
+public:
+    // Visits every item of the manager once
+    HRESULT Build(_In_ IPowerRenameManager* psrm, _In_ DWORD flags);
+
+    // Adds the renames to the operation, deepest items first
+    HRESULT AddToFileOperation(_In_ IFileOperation* fileOp) const;
+
+    const PowerRenamePlanStats& GetStats() const { return m_stats; }
+
+    // Renames by depth, in the order they run within a folder, and in item order otherwise
+    const std::vector<std::vector<RenamePlanEntry>>& GetBuckets() const { return m_buckets; }
+
+    static bool s_IsValidFileName(_In_ PCWSTR name);
+
+private:
+    std::vector<std::vector<RenamePlanEntry>> m_buckets;
+    PowerRenamePlanStats m_stats = {};
+};
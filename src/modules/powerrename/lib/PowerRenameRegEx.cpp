@@ -95,6 +95,7 @@ IFACEMETHODIMP CPowerRenameRegEx::put_searchTerm(_In_ PCWSTR searchTerm)
             changed = true;
             CoTaskMemFree(m_searchTerm);
             hr = SHStrDup(searchTerm, &m_searchTerm);
+            _CompileSearchPattern();
         }
     }
 
@@ -130,6 +131,7 @@ IFACEMETHODIMP CPowerRenameRegEx::put_replaceTerm(_In_ PCWSTR replaceTerm)
             changed = true;
             CoTaskMemFree(m_replaceTerm);
             hr = SHStrDup(replaceTerm, &m_replaceTerm);
+            _CompileReplaceTemplate();
         }
     }
 
@@ -151,7 +153,12 @@ IFACEMETHODIMP CPowerRenameRegEx::put_flags(_In_ DWORD flags)
 {
     if (m_flags != flags)
     {
-        m_flags = flags;
+        // Scope lock
+        {
+            CSRWExclusiveAutoLock lock(&m_lock);
+            m_flags = flags;
+            _CompileSearchPattern();
+        }
         _OnFlagsChanged();
     }
     return S_OK;
@@ -177,6 +184,7 @@ CPowerRenameRegEx::CPowerRenameRegEx() :
     // Init to empty strings
     SHStrDup(L"", &m_searchTerm);
     SHStrDup(L"", &m_replaceTerm);
+    _CompileReplaceTemplate();
 }
 
 CPowerRenameRegEx::~CPowerRenameRegEx()
@@ -196,44 +204,30 @@ HRESULT CPowerRenameRegEx::Replace(_In_ PCWSTR source, _Outptr_ PWSTR* result)
         wstring res = source;
         try
         {
-            // TODO: creating the regex could be costly.  May want to cache this.
             std::wstring sourceToUse(source);
-            std::wstring searchTerm(m_searchTerm);
-            std::wstring replaceTerm(m_replaceTerm ? wstring(m_replaceTerm) : wstring(L""));
-
-            replaceTerm = regex_replace(replaceTerm, std::wregex(L"(([^\\$]|^)(\\$\\$)*)\\$[0]"), L"$1$$$0");
-            replaceTerm = regex_replace(replaceTerm, std::wregex(L"(([^\\$]|^)(\\$\\$)*)\\$([1-9])"), L"$1$0$4");
+            const std::wstring& replaceTerm = m_replaceTemplate;
 
             if (m_flags & UseRegularExpressions)
             {
-                std::wregex pattern(m_searchTerm, (!(m_flags & CaseSensitive)) ? regex_constants::icase | regex_constants::ECMAScript : regex_constants::ECMAScript);
+                if (!m_searchPattern)
+                {
+                    // Search term is not a valid regular expression
+                    return E_FAIL;
+                }
+
                 if (m_flags & MatchAllOccurences)
                 {
-                    res = regex_replace(wstring(source), pattern, replaceTerm);
+                    res = regex_replace(sourceToUse, *m_searchPattern, replaceTerm);
                 }
                 else
                 {
-                    res = regex_replace(wstring(source), pattern, replaceTerm, regex_constants::format_first_only);
+                    res = regex_replace(sourceToUse, *m_searchPattern, replaceTerm, regex_constants::format_first_only);
                 }
             }
             else
             {
                 // Simple search and replace
-                size_t pos = 0;
-                do
-                {
-                    pos = _Find(sourceToUse, searchTerm, (!(m_flags & CaseSensitive)), pos);
-                    if (pos != std::string::npos)
-                    {
-                        res = sourceToUse.replace(pos, searchTerm.length(), replaceTerm);
-                        pos += replaceTerm.length();
-                    }
-
-                    if (!(m_flags & MatchAllOccurences))
-                    {
-                        break;
-                    }
-                } while (pos != std::string::npos);
+                res = m_literalMatcher.Replace(sourceToUse, replaceTerm, m_flags & MatchAllOccurences);
             }
 
             hr = SHStrDup(res.c_str(), result);
@@ -246,17 +240,31 @@ HRESULT CPowerRenameRegEx::Replace(_In_ PCWSTR source, _Outptr_ PWSTR* result)
     return hr;
 }
 
-size_t CPowerRenameRegEx::_Find(std::wstring data, std::wstring toSearch, bool caseInsensitive, size_t pos)
+void CPowerRenameRegEx::_CompileSearchPattern()
 {
-    if (caseInsensitive)
+    m_searchPattern.reset();
+    m_literalMatcher.SetPattern(m_searchTerm ? m_searchTerm : L"", !(m_flags & CaseSensitive));
+    if ((m_flags & UseRegularExpressions) && m_searchTerm && wcslen(m_searchTerm) > 0)
     {
-        // Convert to lower
-        std::transform(data.begin(), data.end(), data.begin(), ::towlower);
-        std::transform(toSearch.begin(), toSearch.end(), toSearch.begin(), ::towlower);
+        try
+        {
+            m_searchPattern.emplace(m_searchTerm, (!(m_flags & CaseSensitive)) ? regex_constants::icase | regex_constants::ECMAScript : regex_constants::ECMAScript);
+        }
+        catch (regex_error e)
+        {
+            // Leave the pattern empty, Replace will fail until the search term is fixed
+        }
     }
+}
+
+void CPowerRenameRegEx::_CompileReplaceTemplate()
+{
+    static const std::wregex zeroGroupReference(L"(([^\\$]|^)(\\$\\$)*)\\$[0]");
+    static const std::wregex groupReference(L"(([^\\$]|^)(\\$\\$)*)\\$([1-9])");
 
-    // Find sub string position in given string starting at position pos
-    return data.find(toSearch, pos);
+    m_replaceTemplate = m_replaceTerm ? wstring(m_replaceTerm) : wstring(L"");
+    m_replaceTemplate = regex_replace(m_replaceTemplate, zeroGroupReference, L"$1$$$0");
+    m_replaceTemplate = regex_replace(m_replaceTemplate, groupReference, L"$1$0$4");
 }
 
 void CPowerRenameRegEx::_OnSearchTermChanged()
@@ -2,7 +2,10 @@
 #include "pch.h"
 #include <vector>
 #include <string>
+#include <regex>
+#include <optional>
 #include "srwlock.h"
+#include "PowerRenameLiteralMatcher.h"
 
 #include "PowerRenameInterfaces.h"
 
@@ -37,12 +40,21 @@ protected:
     void _OnReplaceTermChanged();
     void _OnFlagsChanged();
 
-    size_t _Find(std::wstring data, std::wstring toSearch, bool caseInsensitive, size_t pos);
+    // Must be called with m_lock held exclusively
+    void _CompileSearchPattern();
+    void _CompileReplaceTemplate();
 
     DWORD m_flags = DEFAULT_FLAGS;
     PWSTR m_searchTerm = nullptr;
     PWSTR m_replaceTerm = nullptr;
 
+    // Compiled from m_searchTerm and m_flags, empty if regular expressions are not used or the pattern is invalid
+    _Guarded_by_(m_lock) std::optional<std::wregex> m_searchPattern;
+    // Used instead of m_searchPattern when regular expressions are not used
+    _Guarded_by_(m_lock) CPowerRenameLiteralMatcher m_literalMatcher;
+    // m_replaceTerm with $0/$N rewritten to the std::regex_replace format syntax
+    _Guarded_by_(m_lock) std::wstring m_replaceTemplate;
+
     CSRWLock m_lock;
     CSRWLock m_lockEvents;
 
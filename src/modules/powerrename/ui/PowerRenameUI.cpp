@@ -173,14 +173,36 @@ IFACEMETHODIMP CPowerRenameUI::OnItemAdded(_In_ IPowerRenameItem*)
     return S_OK;
 }
 
-IFACEMETHODIMP CPowerRenameUI::OnUpdate(_In_ IPowerRenameItem*)
+IFACEMETHODIMP CPowerRenameUI::OnItemsUpdated(_In_ UINT firstIndex, _In_ UINT lastIndex)
 {
+    m_listview.RedrawItems(firstIndex, lastIndex);
+    _UpdateCounts();
+    return S_OK;
+}
+
+IFACEMETHODIMP CPowerRenameUI::OnItemsAdded(_In_ UINT)
+{
+    // Show the items as they are found, the counts are updated once the enumeration completes
     UINT itemCount = 0;
     if (m_spsrm)
     {
         m_spsrm->GetItemCount(&itemCount);
     }
-    m_listview.RedrawItems(0, itemCount);
+    m_listview.SetItemCount(itemCount);
+    return S_OK;
+}
+
+IFACEMETHODIMP CPowerRenameUI::OnEnumerationCompleted(_In_ UINT itemCount)
+{
+    m_enumerating = false;
+    m_listview.SetItemCount(itemCount);
+    _UpdateCounts();
+    return S_OK;
+}
+
+IFACEMETHODIMP CPowerRenameUI::OnRenamePlanUpdated(_In_ const PowerRenamePlanStats* stats)
+{
+    m_conflictCount = stats->collisionCount;
     _UpdateCounts();
     return S_OK;
 }
@@ -377,18 +399,11 @@ void CPowerRenameUI::_Cleanup()
 
 void CPowerRenameUI::_EnumerateItems(_In_ IUnknown* pdtobj)
 {
-    // Enumerate the data object and populate the manager
-    if (m_spsrm)
+    // Enumerate the data object and populate the manager. Items are added in batches
+    // from a worker thread and show up in the list as they are found.
+    if (m_spsrm && SUCCEEDED(m_spsrm->StartEnumeration(pdtobj)))
     {
-        m_disableCountUpdate = true;
-        EnumerateDataObject(pdtobj, m_spsrm);
-        m_disableCountUpdate = false;
-
-        UINT itemCount = 0;
-        m_spsrm->GetItemCount(&itemCount);
-        m_listview.SetItemCount(itemCount);
-
-        _UpdateCounts();
+        m_enumerating = true;
     }
 }
 
@@ -941,7 +956,7 @@ void CPowerRenameUI::_UpdateCounts()
 {
     // This method is CPU intensive.  We disable it during certain operations
     // for performance reasons.
-    if (m_disableCountUpdate)
+    if (m_disableCountUpdate || m_enumerating)
     {
         return;
     }
@@ -955,17 +970,19 @@ void CPowerRenameUI::_UpdateCounts()
     }
 
     if (m_selectedCount != selectedCount ||
-        m_renamingCount != renamingCount)
+        m_renamingCount != renamingCount ||
+        m_shownConflictCount != m_conflictCount)
     {
         m_selectedCount = selectedCount;
         m_renamingCount = renamingCount;
+        m_shownConflictCount = m_conflictCount;
 
-        // Update selected and rename count label
+        // Update selected and rename count label, flagging items which would end up with the same name
         wchar_t countsLabelFormat[100] = { 0 };
-        LoadString(g_hInst, IDS_COUNTSLABELFMT, countsLabelFormat, ARRAYSIZE(countsLabelFormat));
+        LoadString(g_hInst, m_conflictCount > 0 ? IDS_COUNTSLABELCONFLICTSFMT : IDS_COUNTSLABELFMT, countsLabelFormat, ARRAYSIZE(countsLabelFormat));
 
         wchar_t countsLabel[100] = { 0 };
-        StringCchPrintf(countsLabel, ARRAYSIZE(countsLabel), countsLabelFormat, selectedCount, renamingCount);
+        StringCchPrintf(countsLabel, ARRAYSIZE(countsLabel), countsLabelFormat, selectedCount, renamingCount, m_conflictCount);
         SetDlgItemText(m_hwnd, IDC_STATUS_MESSAGE, countsLabel);
 
         // Update Rename button state
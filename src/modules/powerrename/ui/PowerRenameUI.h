@@ -56,7 +56,10 @@ public:
 
     // IPowerRenameManagerEvents
     IFACEMETHODIMP OnItemAdded(_In_ IPowerRenameItem* renameItem);
-    IFACEMETHODIMP OnUpdate(_In_ IPowerRenameItem* renameItem);
+    IFACEMETHODIMP OnItemsUpdated(_In_ UINT firstIndex, _In_ UINT lastIndex);
+    IFACEMETHODIMP OnItemsAdded(_In_ UINT itemCount);
+    IFACEMETHODIMP OnEnumerationCompleted(_In_ UINT itemCount);
+    IFACEMETHODIMP OnRenamePlanUpdated(_In_ const PowerRenamePlanStats* stats);
     IFACEMETHODIMP OnError(_In_ IPowerRenameItem* renameItem);
     IFACEMETHODIMP OnRegExStarted(_In_ DWORD threadId);
     IFACEMETHODIMP OnRegExCanceled(_In_ DWORD threadId);
@@ -145,6 +148,7 @@ private:
     bool m_initialized = false;
     bool m_enableDragDrop = false;
     bool m_disableCountUpdate = false;
+    bool m_enumerating = false;
     bool m_modeless = true;
     HWND m_hwnd = nullptr;
     HWND m_hwndLV = nullptr;
@@ -153,6 +157,8 @@ private:
     DWORD m_currentRegExId = 0;
     UINT m_selectedCount = 0;
     UINT m_renamingCount = 0;
+    UINT m_conflictCount = 0;
+    UINT m_shownConflictCount = 0;
     UINT m_initialDPI = 0;
     DialogItemsPositioning m_itemsPositioning {};
     int m_initialWidth = 0;
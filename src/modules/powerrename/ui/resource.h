@@ -14,6 +14,7 @@
 #define IDS_NAMEONLY                    108
 #define IDS_EXTENSIONONLY               109
 #define IDS_COUNTSLABELFMT              111
+#define IDS_COUNTSLABELCONFLICTSFMT     112
 #define IDR_MAINFRAME                   128
 #define IDD_MAIN                        129
 #define IDI_RENAME                      132
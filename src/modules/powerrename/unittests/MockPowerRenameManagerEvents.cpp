@@ -35,9 +35,30 @@ IFACEMETHODIMP CMockPowerRenameManagerEvents::OnItemAdded(_In_ IPowerRenameItem*
     return S_OK;
 }
 
-IFACEMETHODIMP CMockPowerRenameManagerEvents::OnUpdate(_In_ IPowerRenameItem* pItem)
+IFACEMETHODIMP CMockPowerRenameManagerEvents::OnItemsUpdated(_In_ UINT firstIndex, _In_ UINT lastIndex)
 {
-    m_itemUpdated = pItem;
+    m_itemsUpdatedCount += lastIndex - firstIndex + 1;
+    return S_OK;
+}
+
+IFACEMETHODIMP CMockPowerRenameManagerEvents::OnItemsAdded(_In_ UINT itemCount)
+{
+    m_itemsAddedCount += itemCount;
+    m_itemsAddedEventCount++;
+    return S_OK;
+}
+
+IFACEMETHODIMP CMockPowerRenameManagerEvents::OnEnumerationCompleted(_In_ UINT itemCount)
+{
+    m_enumeratedItemCount = itemCount;
+    m_enumerationCompleted = true;
+    return S_OK;
+}
+
+IFACEMETHODIMP CMockPowerRenameManagerEvents::OnRenamePlanUpdated(_In_ const PowerRenamePlanStats* stats)
+{
+    m_renamePlanStats = *stats;
+    m_renamePlanUpdated = true;
     return S_OK;
 }
 
@@ -62,6 +83,7 @@ IFACEMETHODIMP CMockPowerRenameManagerEvents::OnRegExCanceled(_In_ DWORD threadI
 IFACEMETHODIMP CMockPowerRenameManagerEvents::OnRegExCompleted(_In_ DWORD threadId)
 {
     m_regExCompleted = true;
+    SetEvent(m_regExCompletedEvent);
     return S_OK;
 }
 
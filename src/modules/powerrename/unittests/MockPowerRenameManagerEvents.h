@@ -8,6 +8,7 @@ public:
     CMockPowerRenameManagerEvents() :
         m_refCount(1)
     {
+        m_regExCompletedEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
     }
 
     // IUnknown
@@ -19,7 +20,10 @@ public:
 
     // IPowerRenameManagerEvents
     IFACEMETHODIMP OnItemAdded(_In_ IPowerRenameItem* renameItem);
-    IFACEMETHODIMP OnUpdate(_In_ IPowerRenameItem* renameItem);
+    IFACEMETHODIMP OnItemsUpdated(_In_ UINT firstIndex, _In_ UINT lastIndex);
+    IFACEMETHODIMP OnItemsAdded(_In_ UINT itemCount);
+    IFACEMETHODIMP OnEnumerationCompleted(_In_ UINT itemCount);
+    IFACEMETHODIMP OnRenamePlanUpdated(_In_ const PowerRenamePlanStats* stats);
     IFACEMETHODIMP OnError(_In_ IPowerRenameItem* renameItem);
     IFACEMETHODIMP OnRegExStarted(_In_ DWORD threadId);
     IFACEMETHODIMP OnRegExCanceled(_In_ DWORD threadId);
@@ -31,14 +35,23 @@ public:
 
     ~CMockPowerRenameManagerEvents()
     {
+        CloseHandle(m_regExCompletedEvent);
     }
 
     CComPtr<IPowerRenameItem> m_itemAdded;
-    CComPtr<IPowerRenameItem> m_itemUpdated;
+    UINT m_itemsUpdatedCount = 0;
+    UINT m_itemsAddedCount = 0;
+    UINT m_itemsAddedEventCount = 0;
+    UINT m_enumeratedItemCount = 0;
+    bool m_enumerationCompleted = false;
+    PowerRenamePlanStats m_renamePlanStats = {};
+    bool m_renamePlanUpdated = false;
     CComPtr<IPowerRenameItem> m_itemError;
     bool m_regExStarted = false;
     bool m_regExCanceled = false;
     bool m_regExCompleted = false;
+    // Signaled each time a regex worker completes
+    HANDLE m_regExCompletedEvent = nullptr;
     bool m_renameStarted = false;
     bool m_renameCompleted = false;
     long m_refCount = 0;
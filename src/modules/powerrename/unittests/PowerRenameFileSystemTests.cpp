@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameFileSystem.h>
+#include "MockPowerRenameItem.h"
+#include "TestFileHelper.h"
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameFileSystemTests
+{
+    // Counts the file system calls made by the prefetch stage
+    class CCountingFileSystem : public CPowerRenameFileSystem
+    {
+    public:
+        HRESULT EnumerateFolder(_In_ PCWSTR folder, _In_ const FolderEntryCallback& callback) override
+        {
+            enumerateCount++;
+            return CPowerRenameFileSystem::EnumerateFolder(folder, callback);
+        }
+
+        HRESULT GetMetadata(_In_ PCWSTR path, _Out_ PowerRenameItemMetadata* metadata) override
+        {
+            getMetadataCount++;
+            return CPowerRenameFileSystem::GetMetadata(path, metadata);
+        }
+
+        int enumerateCount = 0;
+        int getMetadataCount = 0;
+    };
+
+    void WriteFile(CTestFileHelper& helper, const std::wstring& name, size_t size)
+    {
+        std::ofstream file(helper.GetFullPath(name), std::ios::binary);
+        file << std::string(size, 'x');
+    }
+
+    CComPtr<IPowerRenameItem> CreateItem(CTestFileHelper& helper, const std::wstring& name)
+    {
+        CComPtr<IPowerRenameItem> item;
+        CMockPowerRenameItem::CreateInstance(helper.GetFullPath(name).c_str(), name.c_str(), 0, false, &item);
+        return item;
+    }
+
+    TEST_CLASS(PrefetchItemMetadataTests)
+    {
+    public:
+        TEST_METHOD(VerifyPrefetchListsEachFolderOnce)
+        {
+            CTestFileHelper helper;
+            helper.AddFolder(L"sub");
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            for (size_t i = 0; i < 5; i++)
+            {
+                const std::wstring name = L"file" + std::to_wstring(i) + L".txt";
+                WriteFile(helper, name, i * 10);
+                items.push_back(CreateItem(helper, name));
+            }
+            WriteFile(helper, L"sub\\single.txt", 3);
+            items.push_back(CreateItem(helper, L"sub\\single.txt"));
+
+            CCountingFileSystem fileSystem;
+            Assert::IsTrue(PrefetchItemMetadata(items, fileSystem) == S_OK);
+
+            // One listing for the folder with several items, the single item is read directly
+            Assert::AreEqual(1, fileSystem.enumerateCount);
+            Assert::AreEqual(1, fileSystem.getMetadataCount);
+
+            for (size_t i = 0; i < items.size(); i++)
+            {
+                bool cached = false;
+                Assert::IsTrue(items[i]->get_isMetadataCached(&cached) == S_OK);
+                Assert::IsTrue(cached);
+
+                PowerRenameItemMetadata metadata;
+                Assert::IsTrue(items[i]->get_metadata(&metadata) == S_OK);
+                Assert::AreEqual(static_cast<ULONGLONG>(i < 5 ? i * 10 : 3), metadata.size);
+
+                SYSTEMTIME date;
+                Assert::IsTrue(items[i]->get_date(&date) == S_OK);
+                Assert::AreEqual(metadata.creationTime.wYear, date.wYear);
+                Assert::AreEqual(metadata.creationTime.wSecond, date.wSecond);
+            }
+
+            // Nothing is read again once the metadata is cached
+            Assert::IsTrue(PrefetchItemMetadata(items, fileSystem) == S_OK);
+            Assert::AreEqual(1, fileSystem.enumerateCount);
+            Assert::AreEqual(1, fileSystem.getMetadataCount);
+        }
+
+        TEST_METHOD(VerifyPrefetchStopsWhenCanceled)
+        {
+            CTestFileHelper helper;
+            helper.AddFolder(L"a");
+            helper.AddFolder(L"b");
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            for (const auto& folder : { L"a\\", L"b\\" })
+            {
+                for (size_t i = 0; i < 3; i++)
+                {
+                    const std::wstring name = folder + std::wstring(L"file") + std::to_wstring(i) + L".txt";
+                    WriteFile(helper, name, 1);
+                    items.push_back(CreateItem(helper, name));
+                }
+            }
+
+            // Canceled while the first folder is listed
+            CCountingFileSystem fileSystem;
+            int checks = 0;
+            Assert::IsTrue(PrefetchItemMetadata(items, fileSystem, [&checks]() { return ++checks > 1; }) == E_ABORT);
+            Assert::AreEqual(1, fileSystem.enumerateCount);
+            Assert::AreEqual(0, fileSystem.getMetadataCount);
+
+            bool cached = false;
+            items.back()->get_isMetadataCached(&cached);
+            Assert::IsFalse(cached);
+
+            // Canceled before anything is read
+            Assert::IsTrue(PrefetchItemMetadata(items, fileSystem, []() { return true; }) == E_ABORT);
+            Assert::AreEqual(1, fileSystem.enumerateCount);
+        }
+
+        TEST_METHOD(VerifyMissingItemIsNotCached)
+        {
+            CTestFileHelper helper;
+            WriteFile(helper, L"exists.txt", 1);
+            std::vector<CComPtr<IPowerRenameItem>> items = { CreateItem(helper, L"exists.txt"), CreateItem(helper, L"missing.txt") };
+
+            CCountingFileSystem fileSystem;
+            Assert::IsTrue(PrefetchItemMetadata(items, fileSystem) == S_OK);
+            Assert::AreEqual(1, fileSystem.enumerateCount);
+            // The missing item wasn't in the listing so it is looked up on its own
+            Assert::AreEqual(1, fileSystem.getMetadataCount);
+
+            bool cached = false;
+            items[0]->get_isMetadataCached(&cached);
+            Assert::IsTrue(cached);
+            items[1]->get_isMetadataCached(&cached);
+            Assert::IsFalse(cached);
+
+            PowerRenameItemMetadata metadata;
+            Assert::IsTrue(FAILED(items[1]->get_metadata(&metadata)));
+        }
+    };
+}
@@ -6,6 +6,11 @@
 #include "MockPowerRenameItem.h"
 #include "MockPowerRenameManagerEvents.h"
 #include "TestFileHelper.h"
+#include <PowerRenameItemQueue.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
 
 #define DEFAULT_FLAGS MatchAllOccurences
 
@@ -281,5 +286,280 @@ namespace PowerRenameManagerTests
 
             RenameHelper(renamePairs, ARRAYSIZE(renamePairs), L"foo", L"bar", DEFAULT_FLAGS | Lowercase | ExtensionOnly);
         }
+
+        TEST_METHOD (VerifyItemLookupByIndexAndId)
+        {
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+
+            std::vector<CComPtr<IPowerRenameItem>> items(5);
+            for (auto& item : items)
+            {
+                CMockPowerRenameItem::CreateInstance(L"foo", L"foo", 0, false, &item);
+            }
+
+            // Add out of id order, index order must still follow ids
+            for (int i : { 3, 1, 4, 0, 2 })
+            {
+                Assert::IsTrue(mgr->AddItem(items[i]) == S_OK);
+            }
+            Assert::IsTrue(mgr->AddItem(items[0]) == E_FAIL);
+
+            UINT count = 0;
+            Assert::IsTrue(mgr->GetItemCount(&count) == S_OK);
+            Assert::AreEqual(5u, count);
+
+            for (UINT i = 0; i < count; i++)
+            {
+                CComPtr<IPowerRenameItem> itemByIndex;
+                Assert::IsTrue(mgr->GetItemByIndex(i, &itemByIndex) == S_OK);
+                Assert::IsTrue(itemByIndex == items[i]);
+
+                int id = 0;
+                items[i]->get_id(&id);
+                CComPtr<IPowerRenameItem> itemById;
+                Assert::IsTrue(mgr->GetItemById(id, &itemById) == S_OK);
+                Assert::IsTrue(itemById == items[i]);
+            }
+
+            CComPtr<IPowerRenameItem> missing;
+            Assert::IsTrue(mgr->GetItemByIndex(count, &missing) == E_FAIL);
+            Assert::IsTrue(mgr->GetItemById(-1, &missing) == E_FAIL);
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+        }
+
+        // Dispatches the messages the manager's worker threads post to it until the event is signaled
+        bool WaitForEventDispatchingMessages(_In_ HANDLE event, _In_ DWORD timeoutMs = 10000)
+        {
+            const ULONGLONG deadline = GetTickCount64() + timeoutMs;
+            for (;;)
+            {
+                const ULONGLONG now = GetTickCount64();
+                if (now >= deadline)
+                {
+                    return false;
+                }
+
+                DWORD result = MsgWaitForMultipleObjects(1, &event, FALSE, static_cast<DWORD>(deadline - now), QS_ALLINPUT);
+                if (result == WAIT_OBJECT_0)
+                {
+                    return true;
+                }
+                if (result != WAIT_OBJECT_0 + 1)
+                {
+                    return false;
+                }
+
+                MSG msg;
+                while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+                {
+                    TranslateMessage(&msg);
+                    DispatchMessage(&msg);
+                }
+            }
+        }
+
+        TEST_METHOD (VerifyPreviewEnumeratesItemsInOrder)
+        {
+            // The preview is evaluated in parallel chunks, enumeration must still follow item order
+            const UINT itemCount = 5000;
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+            CMockPowerRenameManagerEvents* mockMgrEvents = new CMockPowerRenameManagerEvents();
+            CComPtr<IPowerRenameManagerEvents> mgrEvents;
+            Assert::IsTrue(mockMgrEvents->QueryInterface(IID_PPV_ARGS(&mgrEvents)) == S_OK);
+            DWORD cookie = 0;
+            Assert::IsTrue(mgr->Advise(mgrEvents, &cookie) == S_OK);
+
+            std::vector<CComPtr<IPowerRenameItem>> items(itemCount);
+            for (auto& item : items)
+            {
+                CMockPowerRenameItem::CreateInstance(L"foo.txt", L"foo.txt", 0, false, &item);
+                mgr->AddItem(item);
+            }
+
+            CComPtr<IPowerRenameRegEx> renRegEx;
+            Assert::IsTrue(mgr->get_renameRegEx(&renRegEx) == S_OK);
+            renRegEx->put_flags(DEFAULT_FLAGS | EnumerateItems);
+            renRegEx->put_replaceTerm(L"bar");
+            renRegEx->put_searchTerm(L"foo");
+
+            // Every term change restarts the worker, only the last run names the items. Results are
+            // committed before the completion is posted, so the items are named once it completes.
+            PWSTR newName = nullptr;
+            while (FAILED(items.back()->get_newName(&newName)))
+            {
+                Assert::IsTrue(WaitForEventDispatchingMessages(mockMgrEvents->m_regExCompletedEvent));
+            }
+            CoTaskMemFree(newName);
+
+            for (UINT i = 0; i < itemCount; i++)
+            {
+                Assert::IsTrue(items[i]->get_newName(&newName) == S_OK);
+                std::wstring expected = L"bar (" + std::to_wstring(i + 1) + L").txt";
+                Assert::AreEqual(expected.c_str(), newName);
+                CoTaskMemFree(newName);
+            }
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+            mockMgrEvents->Release();
+        }
+
+        // Dispatches the messages the manager's worker threads post to it
+        bool PumpMessagesUntil(_In_ const std::function<bool()>& done)
+        {
+            for (int i = 0; i < 1000 && !done(); i++)
+            {
+                MSG msg;
+                while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+                {
+                    TranslateMessage(&msg);
+                    DispatchMessage(&msg);
+                }
+                Sleep(10);
+            }
+            return done();
+        }
+
+        TEST_METHOD (VerifyStartEnumerationAddsItemsInBatches)
+        {
+            const UINT fileCount = 1500;
+            HRESULT hrInit = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+
+            CTestFileHelper testFileHelper;
+            Assert::IsTrue(testFileHelper.AddFolder(L"folder"));
+            for (UINT i = 0; i < fileCount; i++)
+            {
+                Assert::IsTrue(testFileHelper.AddFile(L"folder\\file" + std::to_wstring(i) + L".txt"));
+            }
+
+            CComPtr<IShellItem> folder;
+            Assert::IsTrue(SHCreateItemFromParsingName(testFileHelper.GetFullPath(L"folder").c_str(), nullptr, IID_PPV_ARGS(&folder)) == S_OK);
+            CComPtr<IShellItemArray> selection;
+            Assert::IsTrue(SHCreateShellItemArrayFromShellItem(folder, IID_PPV_ARGS(&selection)) == S_OK);
+
+            CComPtr<IPowerRenameManager> mgr;
+            Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+            CComPtr<IPowerRenameItemFactory> itemFactory;
+            Assert::IsTrue(CPowerRenameItem::s_CreateInstance(nullptr, IID_PPV_ARGS(&itemFactory)) == S_OK);
+            Assert::IsTrue(mgr->put_renameItemFactory(itemFactory) == S_OK);
+
+            CMockPowerRenameManagerEvents* mockMgrEvents = new CMockPowerRenameManagerEvents();
+            CComPtr<IPowerRenameManagerEvents> mgrEvents;
+            Assert::IsTrue(mockMgrEvents->QueryInterface(IID_PPV_ARGS(&mgrEvents)) == S_OK);
+            DWORD cookie = 0;
+            Assert::IsTrue(mgr->Advise(mgrEvents, &cookie) == S_OK);
+
+            Assert::IsTrue(mgr->StartEnumeration(selection) == S_OK);
+            Assert::IsTrue(PumpMessagesUntil([mockMgrEvents]() { return mockMgrEvents->m_enumerationCompleted; }));
+
+            // The folder and its contents, added a batch at a time
+            UINT count = 0;
+            Assert::IsTrue(mgr->GetItemCount(&count) == S_OK);
+            Assert::AreEqual(fileCount + 1, count);
+            Assert::AreEqual(count, mockMgrEvents->m_enumeratedItemCount);
+            Assert::AreEqual(count, mockMgrEvents->m_itemsAddedCount);
+            Assert::IsTrue(mockMgrEvents->m_itemsAddedEventCount > 0 && mockMgrEvents->m_itemsAddedEventCount < count);
+            Assert::IsTrue(mockMgrEvents->m_itemAdded == nullptr);
+
+            CComPtr<IPowerRenameItem> first;
+            Assert::IsTrue(mgr->GetItemByIndex(0, &first) == S_OK);
+            bool isFolder = false;
+            UINT depth = 0;
+            first->get_isFolder(&isFolder);
+            first->get_depth(&depth);
+            Assert::IsTrue(isFolder);
+            Assert::AreEqual(0u, depth);
+
+            CComPtr<IPowerRenameItem> last;
+            Assert::IsTrue(mgr->GetItemByIndex(count - 1, &last) == S_OK);
+            last->get_depth(&depth);
+            Assert::AreEqual(1u, depth);
+
+            Assert::IsTrue(mgr->Shutdown() == S_OK);
+            mockMgrEvents->Release();
+
+            if (SUCCEEDED(hrInit))
+            {
+                CoUninitialize();
+            }
+        }
+
+        TEST_METHOD (VerifyItemQueueIsBounded)
+        {
+            CPowerRenameItemQueue queue(2);
+            auto makeBatch = [](UINT count) {
+                std::vector<CComPtr<IPowerRenameItem>> batch(count);
+                for (auto& item : batch)
+                {
+                    CMockPowerRenameItem::CreateInstance(L"foo", L"foo", 0, false, &item);
+                }
+                return batch;
+            };
+
+            Assert::IsTrue(queue.Push(makeBatch(3)));
+            Assert::IsTrue(queue.Push(makeBatch(4)));
+
+            // The queue is full, the producer waits until the consumer drains it
+            std::atomic<bool> pushed = false;
+            std::thread producer([&]() {
+                pushed = queue.Push(makeBatch(5));
+            });
+            Sleep(100);
+            Assert::IsFalse(pushed);
+
+            std::vector<CComPtr<IPowerRenameItem>> items;
+            Assert::IsTrue(queue.TryPopAll(items));
+            Assert::AreEqual(size_t{ 7 }, items.size());
+            producer.join();
+            Assert::IsTrue(pushed);
+
+            // Closing releases a waiting producer and rejects new items, queued items can still be read
+            Assert::IsTrue(queue.Push(makeBatch(1)));
+            std::thread blocked([&]() {
+                pushed = queue.Push(makeBatch(1));
+            });
+            Sleep(100);
+            queue.Close();
+            blocked.join();
+            Assert::IsFalse(pushed);
+            Assert::IsFalse(queue.Push(makeBatch(1)));
+
+            items.clear();
+            Assert::IsTrue(queue.TryPopAll(items));
+            Assert::AreEqual(size_t{ 6 }, items.size());
+            Assert::IsFalse(queue.TryPopAll(items));
+        }
+
+        TEST_METHOD (BenchmarkItemLookupByIndex)
+        {
+            // Worker threads visit every item by index, so a full pass has to scale linearly with item count
+            for (UINT itemCount : { 25000u, 50000u, 100000u })
+            {
+                CComPtr<IPowerRenameManager> mgr;
+                Assert::IsTrue(CPowerRenameManager::s_CreateInstance(&mgr) == S_OK);
+                for (UINT i = 0; i < itemCount; i++)
+                {
+                    CComPtr<IPowerRenameItem> item;
+                    CMockPowerRenameItem::CreateInstance(L"foo", L"foo", 0, false, &item);
+                    mgr->AddItem(item);
+                }
+
+                auto start = std::chrono::high_resolution_clock::now();
+                for (UINT i = 0; i < itemCount; i++)
+                {
+                    CComPtr<IPowerRenameItem> item;
+                    Assert::IsTrue(mgr->GetItemByIndex(i, &item) == S_OK);
+                }
+                auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+                std::wstring message = std::to_wstring(itemCount) + L" items: " + std::to_wstring(elapsed.count()) + L" us per pass, " +
+                                       std::to_wstring(static_cast<double>(elapsed.count()) * 1000 / itemCount) + L" ns per item\n";
+                Logger::WriteMessage(message.c_str());
+
+                Assert::IsTrue(mgr->Shutdown() == S_OK);
+            }
+        }
     };
 }
@@ -0,0 +1,185 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameNameTransform.h>
+#include <PowerRenameLiteralMatcher.h>
+#include <chrono>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenameNameTransformTests
+{
+    const PowerRenameItemMetadata testMetadata = { { 2020, 7, 0, 22, 15, 6, 42, 123 }, { 2021, 1, 0, 5, 8, 30, 0, 0 }, 1234567 };
+
+    bool ReplaceFoo(PCWSTR source, std::wstring& result)
+    {
+        CPowerRenameLiteralMatcher matcher;
+        matcher.SetPattern(L"foo", false);
+        if (*source == L'\0')
+        {
+            return false;
+        }
+        result = matcher.Replace(source, L"bar", true);
+        return true;
+    }
+
+    bool NoReplace(PCWSTR, std::wstring&)
+    {
+        return false;
+    }
+
+    bool GetTestMetadata(PowerRenameItemMetadata& metadata)
+    {
+        metadata = testMetadata;
+        return true;
+    }
+
+    TEST_CLASS(NameTransformTests)
+    {
+    public:
+        TEST_METHOD(VerifyStemLength)
+        {
+            Assert::AreEqual(size_t{ 3 }, GetFileStemLength(L"foo.txt"));
+            Assert::AreEqual(size_t{ 7 }, GetFileStemLength(L"foo.bar.txt"));
+            Assert::AreEqual(size_t{ 3 }, GetFileStemLength(L"foo"));
+            Assert::AreEqual(size_t{ 3 }, GetFileStemLength(L"foo."));
+            Assert::AreEqual(size_t{ 10 }, GetFileStemLength(L".gitignore"));
+            Assert::AreEqual(size_t{ 2 }, GetFileStemLength(L".."));
+        }
+
+        TEST_METHOD(VerifyTrim)
+        {
+            std::wstring name = L"  foo bar . ";
+            TrimFileName(name);
+            Assert::AreEqual(std::wstring(L"foo bar"), name);
+
+            name = L" . ";
+            TrimFileName(name);
+            Assert::AreEqual(std::wstring(), name);
+        }
+
+        TEST_METHOD(VerifyDateTokens)
+        {
+            std::wstring name = L"$YYYY-$MM-$DD $hh.$mm.$ss.$fff $MMM$$mmm $X";
+            std::wstring scratch;
+            Assert::IsTrue(ReplaceMetadataTokens(name, scratch, GetTestMetadata));
+            Assert::AreEqual(std::wstring(L"2020-07-22 15.06.42.123 123$123 $X"), name);
+        }
+
+        TEST_METHOD(VerifyModifiedDateAndSizeTokens)
+        {
+            std::wstring name = L"$MODIFIED ($SIZE bytes) $MM";
+            std::wstring scratch;
+            Assert::IsTrue(ReplaceMetadataTokens(name, scratch, GetTestMetadata));
+            Assert::AreEqual(std::wstring(L"2021-01-05 (1234567 bytes) 07"), name);
+        }
+
+        TEST_METHOD(VerifyHasMetadataTokens)
+        {
+            Assert::IsTrue(HasMetadataTokens(L"photo $YYYY-$MM-$DD"));
+            Assert::IsTrue(HasMetadataTokens(L"$SIZE"));
+            Assert::IsTrue(HasMetadataTokens(L"$1_$MODIFIED"));
+            Assert::IsFalse(HasMetadataTokens(L"$1 $2"));
+            Assert::IsFalse(HasMetadataTokens(L"cost $ $X"));
+            Assert::IsFalse(HasMetadataTokens(L""));
+        }
+
+        TEST_METHOD(VerifyMetadataOnlyRetrievedWhenNeeded)
+        {
+            int calls = 0;
+            auto getMetadata = [&calls](PowerRenameItemMetadata& metadata) {
+                calls++;
+                metadata = testMetadata;
+                return true;
+            };
+
+            std::wstring name = L"foo $ bar";
+            std::wstring scratch;
+            Assert::IsFalse(ReplaceMetadataTokens(name, scratch, getMetadata));
+            Assert::AreEqual(0, calls);
+
+            name = L"$DD $DD";
+            Assert::IsTrue(ReplaceMetadataTokens(name, scratch, getMetadata));
+            Assert::AreEqual(1, calls);
+            Assert::AreEqual(std::wstring(L"22 22"), name);
+
+            name = L"$DD";
+            Assert::IsFalse(ReplaceMetadataTokens(name, scratch, [](PowerRenameItemMetadata&) { return false; }));
+            Assert::AreEqual(std::wstring(L"$DD"), name);
+        }
+
+        TEST_METHOD(VerifyPipeline)
+        {
+            NameTransformBuffers buffers;
+            Assert::IsTrue(TransformFileName(L"foo.foo", 0, ReplaceFoo, GetTestMetadata, buffers));
+            Assert::AreEqual(std::wstring(L"bar.bar"), buffers.name);
+
+            Assert::IsTrue(TransformFileName(L"foo.foo", NameOnly, ReplaceFoo, GetTestMetadata, buffers));
+            Assert::AreEqual(std::wstring(L"bar.foo"), buffers.name);
+
+            Assert::IsTrue(TransformFileName(L"foo.foo", ExtensionOnly | Uppercase, ReplaceFoo, GetTestMetadata, buffers));
+            Assert::AreEqual(std::wstring(L"foo.BAR"), buffers.name);
+
+            Assert::IsTrue(TransformFileName(L"foo $YYYY.txt ", 0, ReplaceFoo, GetTestMetadata, buffers));
+            Assert::AreEqual(std::wstring(L"bar 2020.txt"), buffers.name);
+
+            Assert::IsTrue(TransformFileName(L"the lord of the rings.txt", Titlecase, NoReplace, GetTestMetadata, buffers));
+            Assert::AreEqual(std::wstring(L"The Lord of the Rings.txt"), buffers.name);
+
+            // No change from the original name
+            Assert::IsFalse(TransformFileName(L"bar.txt", 0, ReplaceFoo, GetTestMetadata, buffers));
+            Assert::IsFalse(TransformFileName(L"foo.txt", 0, NoReplace, GetTestMetadata, buffers));
+            Assert::IsFalse(TransformFileName(L"FOO.TXT", Uppercase, NoReplace, GetTestMetadata, buffers));
+        }
+
+        TEST_METHOD(VerifyNameLongerThanMaxPath)
+        {
+            std::wstring original;
+            std::wstring expected;
+            for (int i = 0; i < MAX_PATH; i++)
+            {
+                original += L"foo";
+                expected += L"BAR";
+            }
+            original += L".txt";
+            expected += L".txt";
+
+            NameTransformBuffers buffers;
+            Assert::IsTrue(TransformFileName(original, NameOnly | Uppercase, ReplaceFoo, GetTestMetadata, buffers));
+            Assert::AreEqual(expected, buffers.name);
+        }
+
+        TEST_METHOD(BenchmarkPipeline)
+        {
+            const int itemCount = 100000;
+            std::vector<std::wstring> names;
+            for (int i = 0; i < itemCount; i++)
+            {
+                names.push_back(L"  foo_vacation_" + std::to_wstring(i) + L"_$YYYY-$MM-$DD.jpg");
+            }
+
+            CPowerRenameLiteralMatcher matcher;
+            matcher.SetPattern(L"foo", true);
+            auto replace = [&matcher](PCWSTR source, std::wstring& result) {
+                result = matcher.Replace(source, L"bar", true);
+                return true;
+            };
+
+            NameTransformBuffers buffers;
+            size_t renamed = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const auto& name : names)
+            {
+                renamed += TransformFileName(name, NameOnly | Titlecase, replace, GetTestMetadata, buffers) ? 1 : 0;
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+            Assert::AreEqual(static_cast<size_t>(itemCount), renamed);
+
+            std::wstring message = std::to_wstring(itemCount) + L" names: " +
+                                   std::to_wstring(static_cast<double>(elapsed.count()) * 1000 / itemCount) + L" ns per name\n";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
@@ -0,0 +1,211 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <PowerRenameInterfaces.h>
+#include <PowerRenameManager.h>
+#include <PowerRenamePlan.h>
+#include "MockPowerRenameItem.h"
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PowerRenamePlanTests
+{
+    struct PlanItem
+    {
+        PCWSTR path;
+        UINT depth;
+        PCWSTR newName;
+    };
+
+    CComPtr<IPowerRenameManager> CreateManager(_In_reads_(count) const PlanItem* planItems, _In_ size_t count)
+    {
+        CComPtr<IPowerRenameManager> mgr;
+        CPowerRenameManager::s_CreateInstance(&mgr);
+        for (size_t i = 0; i < count; i++)
+        {
+            CComPtr<IPowerRenameItem> item;
+            CMockPowerRenameItem::CreateInstance(planItems[i].path, PathFindFileName(planItems[i].path), planItems[i].depth, false, &item);
+            item->put_newName(planItems[i].newName);
+            mgr->AddItem(item);
+        }
+        return mgr;
+    }
+
+    TEST_CLASS(RenamePlanTests)
+    {
+    public:
+        TEST_METHOD(VerifyBucketsByDepth)
+        {
+            const PlanItem planItems[] = {
+                { L"c:\\test\\foo", 0, L"bar" },
+                { L"c:\\test\\foo\\a.txt", 1, L"b.txt" },
+                { L"c:\\test\\foo\\sub", 1, nullptr },
+                { L"c:\\test\\foo\\sub\\c.txt", 2, L"d.txt" },
+                { L"c:\\test\\foo\\e.txt", 1, L"f.txt" },
+            };
+            auto mgr = CreateManager(planItems, ARRAYSIZE(planItems));
+
+            CPowerRenamePlan plan;
+            Assert::IsTrue(plan.Build(mgr, 0) == S_OK);
+
+            const auto& stats = plan.GetStats();
+            Assert::AreEqual(4u, stats.renameCount);
+            Assert::AreEqual(0u, stats.collisionCount);
+            Assert::AreEqual(0u, stats.caseOnlyCount);
+            Assert::AreEqual(0u, stats.invalidCount);
+
+            const auto& buckets = plan.GetBuckets();
+            Assert::AreEqual(size_t{ 3 }, buckets.size());
+            Assert::AreEqual(size_t{ 1 }, buckets[0].size());
+            Assert::AreEqual(size_t{ 2 }, buckets[1].size());
+            Assert::AreEqual(size_t{ 1 }, buckets[2].size());
+            Assert::AreEqual(std::wstring(L"b.txt"), buckets[1][0].newName);
+            Assert::AreEqual(std::wstring(L"f.txt"), buckets[1][1].newName);
+            Assert::AreEqual(std::wstring(L"d.txt"), buckets[2][0].newName);
+
+            mgr->Shutdown();
+        }
+
+        TEST_METHOD(VerifyCollisions)
+        {
+            const PlanItem planItems[] = {
+                // Two items renamed to the same name, differing only by case
+                { L"c:\\test\\a.txt", 0, L"same.txt" },
+                { L"c:\\test\\b.txt", 0, L"SAME.txt" },
+                // Renamed to the name of an item which keeps its name
+                { L"c:\\test\\c.txt", 0, L"kept.txt" },
+                { L"c:\\test\\kept.txt", 0, nullptr },
+                // Renamed to the name of an item which is renamed first, so it doesn't collide
+                { L"c:\\test\\f.txt", 0, L"a.txt" },
+                // Renamed to the name of an item which only changes its case
+                { L"c:\\test\\g.txt", 0, L"case.txt" },
+                { L"c:\\test\\case.txt", 0, L"CASE.txt" },
+                // Same name in another folder is not a conflict
+                { L"c:\\other\\a.txt", 0, L"same.txt" },
+            };
+            auto mgr = CreateManager(planItems, ARRAYSIZE(planItems));
+
+            CPowerRenamePlan plan;
+            Assert::IsTrue(plan.Build(mgr, 0) == S_OK);
+
+            // Items in conflict stay in the plan, the file operation adds a number to their new name
+            const auto& stats = plan.GetStats();
+            Assert::AreEqual(3u, stats.collisionCount);
+            Assert::AreEqual(7u, stats.renameCount);
+            Assert::AreEqual(1u, stats.caseOnlyCount);
+
+            const auto& buckets = plan.GetBuckets();
+            Assert::AreEqual(size_t{ 7 }, buckets[0].size());
+            Assert::AreEqual(std::wstring(L"same.txt"), buckets[0][0].newName);
+            Assert::AreEqual(std::wstring(L"SAME.txt"), buckets[0][1].newName);
+            Assert::AreEqual(std::wstring(L"kept.txt"), buckets[0][2].newName);
+            Assert::AreEqual(std::wstring(L"case.txt"), buckets[0][3].newName);
+            Assert::AreEqual(std::wstring(L"CASE.txt"), buckets[0][4].newName);
+            Assert::AreEqual(std::wstring(L"a.txt"), buckets[0][5].newName);
+            Assert::AreEqual(std::wstring(L"same.txt"), buckets[0][6].newName);
+
+            mgr->Shutdown();
+        }
+
+        TEST_METHOD(VerifyChainsAreOrderedAndCyclesCollide)
+        {
+            const PlanItem planItems[] = {
+                // Each item takes the name of the next one, which has to be renamed first
+                { L"c:\\test\\1.txt", 0, L"2.txt" },
+                { L"c:\\test\\2.txt", 0, L"3.txt" },
+                { L"c:\\test\\3.txt", 0, L"4.txt" },
+                // Swapping names can't be done one rename at a time, so the first rename collides
+                { L"c:\\test\\d.txt", 0, L"e.txt" },
+                { L"c:\\test\\e.txt", 0, L"d.txt" },
+                // Longer cycle
+                { L"c:\\test\\x.txt", 0, L"y.txt" },
+                { L"c:\\test\\y.txt", 0, L"z.txt" },
+                { L"c:\\test\\z.txt", 0, L"x.txt" },
+            };
+            auto mgr = CreateManager(planItems, ARRAYSIZE(planItems));
+
+            CPowerRenamePlan plan;
+            Assert::IsTrue(plan.Build(mgr, 0) == S_OK);
+
+            // One collision per cycle
+            const auto& stats = plan.GetStats();
+            Assert::AreEqual(8u, stats.renameCount);
+            Assert::AreEqual(2u, stats.collisionCount);
+
+            const auto& buckets = plan.GetBuckets();
+            Assert::AreEqual(size_t{ 1 }, buckets.size());
+            Assert::AreEqual(size_t{ 8 }, buckets[0].size());
+            const PCWSTR expected[] = { L"4.txt", L"d.txt", L"x.txt", L"3.txt", L"e.txt", L"z.txt", L"2.txt", L"y.txt" };
+            for (size_t i = 0; i < ARRAYSIZE(expected); i++)
+            {
+                Assert::AreEqual(std::wstring(expected[i]), buckets[0][i].newName);
+            }
+
+            mgr->Shutdown();
+        }
+
+        TEST_METHOD(VerifyCaseOnlyAndInvalidNames)
+        {
+            const PlanItem planItems[] = {
+                { L"c:\\test\\foo.txt", 0, L"FOO.txt" },
+                { L"c:\\test\\bar.txt", 0, L"b:r.txt" },
+                { L"c:\\test\\baz.txt", 0, L"b?z.txt" },
+                { L"c:\\test\\qux.txt", 0, L"quux.txt" },
+            };
+            auto mgr = CreateManager(planItems, ARRAYSIZE(planItems));
+
+            CPowerRenamePlan plan;
+            Assert::IsTrue(plan.Build(mgr, 0) == S_OK);
+
+            // Invalid names are left out of the plan and their items keep their names
+            const auto& stats = plan.GetStats();
+            Assert::AreEqual(2u, stats.renameCount);
+            Assert::AreEqual(1u, stats.caseOnlyCount);
+            Assert::AreEqual(2u, stats.invalidCount);
+            Assert::AreEqual(0u, stats.collisionCount);
+
+            Assert::IsTrue(CPowerRenamePlan::s_IsValidFileName(L"foo (1).txt"));
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L""));
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"foo\\bar"));
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"foo\tbar"));
+
+            // Windows strips trailing dots and spaces
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"foo."));
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"foo.txt "));
+            Assert::IsTrue(CPowerRenamePlan::s_IsValidFileName(L".gitignore"));
+
+            // Device names are reserved, with any extension
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"CON"));
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"nul.txt"));
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"Com1.tar.gz"));
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"LPT9"));
+            Assert::IsFalse(CPowerRenamePlan::s_IsValidFileName(L"aux .txt"));
+            Assert::IsTrue(CPowerRenamePlan::s_IsValidFileName(L"COM0"));
+            Assert::IsTrue(CPowerRenamePlan::s_IsValidFileName(L"COM10"));
+            Assert::IsTrue(CPowerRenamePlan::s_IsValidFileName(L"console.txt"));
+            Assert::IsTrue(CPowerRenamePlan::s_IsValidFileName(L"CON-1.txt"));
+
+            mgr->Shutdown();
+        }
+
+        TEST_METHOD(VerifyUnselectedItemsAreNotRenamed)
+        {
+            const PlanItem planItems[] = {
+                { L"c:\\test\\a.txt", 0, L"b.txt" },
+                { L"c:\\test\\c.txt", 0, L"b.txt" },
+            };
+            auto mgr = CreateManager(planItems, ARRAYSIZE(planItems));
+
+            CComPtr<IPowerRenameItem> item;
+            mgr->GetItemByIndex(1, &item);
+            item->put_selected(false);
+
+            CPowerRenamePlan plan;
+            Assert::IsTrue(plan.Build(mgr, 0) == S_OK);
+            Assert::AreEqual(1u, plan.GetStats().renameCount);
+            Assert::AreEqual(0u, plan.GetStats().collisionCount);
+
+            mgr->Shutdown();
+        }
+    };
+}
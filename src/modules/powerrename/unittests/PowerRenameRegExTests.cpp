@@ -2,7 +2,11 @@
 #include "CppUnitTest.h"
 #include <PowerRenameInterfaces.h>
 #include <PowerRenameRegEx.h>
+#include <PowerRenameLiteralMatcher.h>
 #include "MockPowerRenameRegExEvents.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -381,6 +385,196 @@ TEST_METHOD(VerifyEventsFire)
     Assert::IsTrue(renameRegEx->UnAdvise(cookie) == S_OK);
     mockEvents->Release();
 }
+
+TEST_METHOD(VerifyFlagsChangeRecompilesPattern)
+{
+    CComPtr<IPowerRenameRegEx> renameRegEx;
+    Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+    Assert::IsTrue(renameRegEx->put_searchTerm(L"f(o+)") == S_OK);
+    Assert::IsTrue(renameRegEx->put_replaceTerm(L"b$1") == S_OK);
+
+    // Search term set before regular expressions were enabled
+    Assert::IsTrue(renameRegEx->put_flags(MatchAllOccurences | UseRegularExpressions | CaseSensitive) == S_OK);
+    PWSTR result = nullptr;
+    Assert::IsTrue(renameRegEx->Replace(L"FOO foo", &result) == S_OK);
+    Assert::IsTrue(wcscmp(result, L"FOO boo") == 0);
+    CoTaskMemFree(result);
+
+    Assert::IsTrue(renameRegEx->put_flags(MatchAllOccurences | UseRegularExpressions) == S_OK);
+    result = nullptr;
+    Assert::IsTrue(renameRegEx->Replace(L"FOO foo", &result) == S_OK);
+    Assert::IsTrue(wcscmp(result, L"bOO boo") == 0);
+    CoTaskMemFree(result);
+}
+
+TEST_METHOD(VerifyInvalidRegExFails)
+{
+    CComPtr<IPowerRenameRegEx> renameRegEx;
+    Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+    Assert::IsTrue(renameRegEx->put_flags(MatchAllOccurences | UseRegularExpressions) == S_OK);
+    Assert::IsTrue(renameRegEx->put_searchTerm(L"foo(") == S_OK);
+    PWSTR result = nullptr;
+    Assert::IsTrue(renameRegEx->Replace(L"foobar", &result) == E_FAIL);
+    Assert::IsTrue(result == nullptr);
+
+    // Fixing the search term makes the pattern usable again
+    Assert::IsTrue(renameRegEx->put_searchTerm(L"foo()") == S_OK);
+    Assert::IsTrue(renameRegEx->Replace(L"foobar", &result) == S_OK);
+    Assert::IsTrue(wcscmp(result, L"bar") == 0);
+    CoTaskMemFree(result);
+}
+
+TEST_METHOD(BenchmarkReplaceThroughput)
+{
+    const DWORD flagsTable[] = {
+        MatchAllOccurences,
+        MatchAllOccurences | CaseSensitive,
+        MatchAllOccurences | UseRegularExpressions,
+        UseRegularExpressions | CaseSensitive,
+    };
+
+    for (UINT itemCount : { 10000u, 100000u })
+    {
+        std::vector<std::wstring> names;
+        names.reserve(itemCount);
+        for (UINT i = 0; i < itemCount; i++)
+        {
+            names.push_back(L"IMG_" + std::to_wstring(i) + L"_foo_vacation_foo.jpg");
+        }
+
+        for (DWORD flags : flagsTable)
+        {
+            CComPtr<IPowerRenameRegEx> renameRegEx;
+            Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+            Assert::IsTrue(renameRegEx->put_flags(flags) == S_OK);
+            Assert::IsTrue(renameRegEx->put_searchTerm((flags & UseRegularExpressions) ? L"IMG_(\\d+)" : L"foo") == S_OK);
+            Assert::IsTrue(renameRegEx->put_replaceTerm(L"Photo_$1") == S_OK);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const auto& name : names)
+            {
+                PWSTR result = nullptr;
+                Assert::IsTrue(renameRegEx->Replace(name.c_str(), &result) == S_OK);
+                CoTaskMemFree(result);
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+            std::wstring message = std::to_wstring(itemCount) + L" items, flags " + std::to_wstring(flags) + L": " +
+                                   std::to_wstring(static_cast<double>(elapsed.count()) * 1000 / itemCount) + L" ns per item\n";
+            Logger::WriteMessage(message.c_str());
+        }
+    }
+}
+
+// Search and replace loop previously used when regular expressions are disabled, kept as the reference behavior
+static std::wstring ReferenceLiteralReplace(std::wstring source, const std::wstring& search, const std::wstring& replace, bool caseInsensitive, bool allOccurrences)
+{
+    std::wstring res = source;
+    size_t pos = 0;
+    do
+    {
+        std::wstring data = source;
+        std::wstring toSearch = search;
+        if (caseInsensitive)
+        {
+            std::transform(data.begin(), data.end(), data.begin(), ::towlower);
+            std::transform(toSearch.begin(), toSearch.end(), toSearch.begin(), ::towlower);
+        }
+
+        pos = data.find(toSearch, pos);
+        if (pos != std::wstring::npos)
+        {
+            res = source.replace(pos, search.length(), replace);
+            pos += replace.length();
+        }
+
+        if (!allOccurrences)
+        {
+            break;
+        }
+    } while (pos != std::wstring::npos);
+    return res;
+}
+
+TEST_METHOD(VerifyLiteralMatcherFind)
+{
+    CPowerRenameLiteralMatcher matcher;
+    matcher.SetPattern(L"Foo", false);
+    Assert::AreEqual(size_t{ 3 }, matcher.PatternLength());
+    Assert::AreEqual(size_t{ 3 }, matcher.Find(L"barFoofoo", 0));
+    Assert::AreEqual(std::wstring::npos, matcher.Find(L"barFoofoo", 4));
+    Assert::AreEqual(std::wstring::npos, matcher.Find(L"Fo", 0));
+
+    matcher.SetPattern(L"Foo", true);
+    Assert::AreEqual(size_t{ 3 }, matcher.Find(L"barFoofoo", 0));
+    Assert::AreEqual(size_t{ 6 }, matcher.Find(L"barFoofoo", 4));
+    Assert::AreEqual(size_t{ 0 }, matcher.Find(L"FOO", 0));
+
+    matcher.SetPattern(L"\u00c9t\u00e9", true);
+    Assert::AreEqual(size_t{ 2 }, matcher.Find(L"L'\u00e9T\u00c9", 0));
+}
+
+TEST_METHOD(VerifyLiteralMatcherSameResultsAsReference)
+{
+    const std::wstring alphabet = L"aAbB.\u00e9\u00c9\u0100\u0101 ";
+    const std::wstring searches[] = { L"a", L"ab", L"AbA", L"\u00e9", L"\u00c9b", L"a.", L"\u0100\u0101", L"bbbb", L" " };
+    const std::wstring replaces[] = { L"", L"x", L"aba", L"LONGER_THAN_SEARCH" };
+
+    unsigned int seed = 12345;
+    auto next = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    };
+
+    CPowerRenameLiteralMatcher matcher;
+    for (int i = 0; i < 500; i++)
+    {
+        std::wstring source;
+        const size_t length = next() % 24;
+        for (size_t j = 0; j < length; j++)
+        {
+            source += alphabet[next() % alphabet.length()];
+        }
+
+        for (const auto& search : searches)
+        {
+            for (bool caseInsensitive : { false, true })
+            {
+                matcher.SetPattern(search, caseInsensitive);
+                for (const auto& replace : replaces)
+                {
+                    for (bool allOccurrences : { false, true })
+                    {
+                        Assert::AreEqual(ReferenceLiteralReplace(source, search, replace, caseInsensitive, allOccurrences),
+                                         matcher.Replace(source, replace, allOccurrences));
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_METHOD(VerifyPlainTextReplaceLongName)
+{
+    CComPtr<IPowerRenameRegEx> renameRegEx;
+    Assert::IsTrue(CPowerRenameRegEx::s_CreateInstance(&renameRegEx) == S_OK);
+    Assert::IsTrue(renameRegEx->put_flags(MatchAllOccurences) == S_OK);
+    Assert::IsTrue(renameRegEx->put_searchTerm(L"FOO") == S_OK);
+    Assert::IsTrue(renameRegEx->put_replaceTerm(L"bar") == S_OK);
+
+    std::wstring source;
+    std::wstring expected;
+    for (int i = 0; i < 200; i++)
+    {
+        source += L"foo-";
+        expected += L"bar-";
+    }
+
+    PWSTR result = nullptr;
+    Assert::IsTrue(renameRegEx->Replace(source.c_str(), &result) == S_OK);
+    Assert::AreEqual(expected.c_str(), result);
+    CoTaskMemFree(result);
+}
 }
 ;
 }
@@ -14,7 +14,7 @@ namespace
         {
             event.lParam = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
             event.wParam = wParam;
-            if (powertoys_events().signal_event(ll_keyboard, reinterpret_cast<intptr_t>(&event)) != 0)
+            if (powertoys_events().signal_event(PowertoyEventId::ll_keyboard, reinterpret_cast<intptr_t>(&event)) != 0)
             {
                 return 1;
             }
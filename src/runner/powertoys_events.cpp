@@ -3,21 +3,31 @@
 #include "lowlevel_keyboard_event.h"
 #include "win_hook_event.h"
 #include "system_menu_helper.h"
+#include <common/win_hook_event_ranges.h>
 
-void first_subscribed(const std::wstring& event)
+void first_subscribed(PowertoyEventId event)
 {
-    if (event == ll_keyboard)
+    // The win hook event is started by update_win_hook_event_ranges, since the system menu also needs it
+    if (event == PowertoyEventId::ll_keyboard)
         start_lowlevel_keyboard_hook();
-    else if (event == win_hook_event)
-        start_win_hook_event();
 }
 
-void last_unsubscribed(const std::wstring& event)
+void last_unsubscribed(PowertoyEventId event)
 {
-    if (event == ll_keyboard)
+    if (event == PowertoyEventId::ll_keyboard)
         stop_lowlevel_keyboard_hook();
-    else if (event == win_hook_event)
-        stop_win_hook_event();
+}
+
+namespace
+{
+    // Number of signals of each event in progress on this thread, so that a receiver which registers or
+    // unregisters from inside a signal doesn't wait for itself to return
+    thread_local std::array<int, static_cast<size_t>(PowertoyEventId::count)> signaling_depth{};
+}
+
+bool PowertoysEvents::Receiver::wants_win_hook_event(DWORD event) const
+{
+    return win_hook_event_ranges_contain(win_hook_event_ranges, event);
 }
 
 PowertoysEvents& powertoys_events()
@@ -26,34 +36,173 @@ PowertoysEvents& powertoys_events()
     return powertoys_events;
 }
 
+PowertoysEvents::~PowertoysEvents()
+{
+    for (auto& subscribers : receivers)
+    {
+        delete subscribers.load();
+    }
+    for (auto& retired : retired_receivers)
+    {
+        for (auto subscribers : retired)
+        {
+            delete subscribers;
+        }
+    }
+}
+
 void PowertoysEvents::register_receiver(const std::wstring& event, PowertoyModuleIface* module)
 {
+    PowertoyEventId id;
+    if (!powertoy_event_id_from_name(event.c_str(), id))
+    {
+        // The runner never signals an event it doesn't know
+        return;
+    }
+
     std::unique_lock lock(mutex);
-    auto& subscribers = receivers[event];
+    const Receivers* current = receivers[static_cast<size_t>(id)].load();
+    Receivers subscribers = current ? *current : Receivers{};
     if (subscribers.empty())
     {
-        first_subscribed(event);
+        first_subscribed(id);
+    }
+    Receiver receiver{ module };
+    if (id == PowertoyEventId::win_hook_event)
+    {
+        receiver.win_hook_event_ranges = win_hook_event_ranges_from_table(module->get_win_hook_event_ranges());
     }
-    subscribers.push_back(module);
+    subscribers.push_back(std::move(receiver));
+    const Receivers* replaced = publish_receivers(id, std::move(subscribers));
+    if (id == PowertoyEventId::win_hook_event)
+    {
+        update_win_hook_event_ranges();
+    }
+    lock.unlock();
+
+    release_receivers(id, replaced);
 }
 
 void PowertoysEvents::unregister_receiver(PowertoyModuleIface* module)
 {
+    std::array<const Receivers*, event_count> replaced{};
     std::unique_lock lock(mutex);
-    for (auto& [event, subscribers] : receivers)
+    for (size_t i = 0; i < event_count; ++i)
+    {
+        const Receivers* current = receivers[i].load();
+        auto is_module = [module](const Receiver& receiver) { return receiver.module == module; };
+        if (!current || std::none_of(begin(*current), end(*current), is_module))
+        {
+            continue;
+        }
+
+        Receivers subscribers = *current;
+        subscribers.erase(std::remove_if(begin(subscribers), end(subscribers), is_module), end(subscribers));
+        const bool last = subscribers.empty();
+        const auto id = static_cast<PowertoyEventId>(i);
+        replaced[i] = publish_receivers(id, std::move(subscribers));
+        if (last)
+        {
+            last_unsubscribed(id);
+        }
+        if (id == PowertoyEventId::win_hook_event)
+        {
+            update_win_hook_event_ranges();
+        }
+    }
+    lock.unlock();
+
+    // Unless called from inside a signal, the module is not signaled anymore once this returns
+    for (size_t i = 0; i < event_count; ++i)
+    {
+        if (replaced[i])
+        {
+            release_receivers(static_cast<PowertoyEventId>(i), replaced[i]);
+        }
+    }
+}
+
+const PowertoysEvents::Receivers* PowertoysEvents::publish_receivers(PowertoyEventId event, Receivers new_receivers)
+{
+    const size_t index = static_cast<size_t>(event);
+    const uint32_t event_bit = 1u << index;
+    if (new_receivers.empty())
     {
-        subscribers.erase(remove(begin(subscribers), end(subscribers), module), end(subscribers));
-        if (subscribers.empty())
+        subscribed_events &= ~event_bit;
+    }
+    else
+    {
+        subscribed_events |= event_bit;
+    }
+
+    return receivers[index].exchange(new Receivers(std::move(new_receivers)));
+}
+
+void PowertoysEvents::release_receivers(PowertoyEventId event, const Receivers* replaced)
+{
+    const size_t index = static_cast<size_t>(event);
+    if (signaling_depth[index] > 0)
+    {
+        // Called by a receiver from inside a signal of the event, which is still walking the replaced list
+        std::unique_lock lock(mutex);
+        retired_receivers[index].push_back(replaced);
+        return;
+    }
+
+    std::vector<const Receivers*> retired;
+    {
+        std::unique_lock lock(mutex);
+        retired.swap(retired_receivers[index]);
+    }
+
+    // A signal call of the event which started before the exchange may still walk the replaced list,
+    // and may still call a module which is being unregistered, so wait for it to return. Only the
+    // signals of this event are waited for, and the mutex isn't held, so a receiver of another thread
+    // can still register or unregister from inside a signal
+    while (active_signals[index].load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    delete replaced;
+    for (auto subscribers : retired)
+    {
+        delete subscribers;
+    }
+}
+
+void PowertoysEvents::update_win_hook_event_ranges()
+{
+    std::vector<WinHookEventRange> ranges;
+    if (const Receivers* subscribers = receivers[static_cast<size_t>(PowertoyEventId::win_hook_event)].load())
+    {
+        for (auto& receiver : *subscribers)
         {
-            last_unsubscribed(event);
+            ranges.insert(end(ranges), begin(receiver.win_hook_event_ranges), end(receiver.win_hook_event_ranges));
         }
     }
+    if (!system_menu_receivers.empty())
+    {
+        ranges.push_back({ EVENT_SYSTEM_MENUSTART, EVENT_SYSTEM_MENUSTART });
+        ranges.push_back({ EVENT_OBJECT_INVOKED, EVENT_OBJECT_INVOKED });
+    }
+
+    // Don't install any hook, nor run the dispatch thread, while nothing wants the events
+    ranges = merge_win_hook_event_ranges(std::move(ranges));
+    if (ranges.empty())
+    {
+        stop_win_hook_event();
+        return;
+    }
+    start_win_hook_event();
+    set_win_hook_event_ranges(ranges);
 }
 
 void PowertoysEvents::register_system_menu_action(PowertoyModuleIface* module)
 {
     std::unique_lock lock(mutex);
     system_menu_receivers.insert(module);
+    update_win_hook_event_ranges();
 }
 
 void PowertoysEvents::unregister_system_menu_action(PowertoyModuleIface* module)
@@ -64,6 +213,7 @@ void PowertoysEvents::unregister_system_menu_action(PowertoyModuleIface* module)
     {
         SystemMenuHelperInstance().Reset(module);
         system_menu_receivers.erase(it);
+        update_win_hook_event_ranges();
     }
 }
 
@@ -89,17 +239,48 @@ void PowertoysEvents::handle_system_menu_action(const WinHookEvent& data)
     }
 }
 
-intptr_t PowertoysEvents::signal_event(const std::wstring& event, intptr_t data)
+intptr_t PowertoysEvents::signal_event(PowertoyEventId event, intptr_t data)
 {
+    const size_t index = static_cast<size_t>(event);
+    if ((subscribed_events.load(std::memory_order_relaxed) & (1u << index)) == 0)
+    {
+        return 0;
+    }
+
     intptr_t rvalue = 0;
-    std::shared_lock lock(mutex);
-    if (auto it = receivers.find(event); it != end(receivers))
+    ++active_signals[index];
+    ++signaling_depth[index];
+    if (const Receivers* subscribers = receivers[index].load())
     {
-        for (auto& module : it->second)
+        for (auto& receiver : *subscribers)
         {
-            if (module)
-                rvalue |= module->signal_event(event.c_str(), data);
+            if (receiver.module)
+                rvalue |= receiver.module->signal_event(event, data);
         }
     }
+    --signaling_depth[index];
+    --active_signals[index];
     return rvalue;
+}
+
+void PowertoysEvents::signal_win_hook_event(WinHookEvent& event)
+{
+    const size_t index = static_cast<size_t>(PowertoyEventId::win_hook_event);
+    if ((subscribed_events.load(std::memory_order_relaxed) & (1u << index)) == 0)
+    {
+        return;
+    }
+
+    ++active_signals[index];
+    ++signaling_depth[index];
+    if (const Receivers* subscribers = receivers[index].load())
+    {
+        for (auto& receiver : *subscribers)
+        {
+            if (receiver.module && receiver.wants_win_hook_event(event.event))
+                receiver.module->signal_event(PowertoyEventId::win_hook_event, reinterpret_cast<intptr_t>(&event));
+        }
+    }
+    --signaling_depth[index];
+    --active_signals[index];
 }
\ No newline at end of file
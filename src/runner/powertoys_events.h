@@ -2,12 +2,17 @@
 
 #include <interface/powertoy_module_interface.h>
 #include <interface/win_hook_event_data.h>
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <string>
-#include <shared_mutex>
+#include <vector>
 
 class PowertoysEvents
 {
 public:
+    ~PowertoysEvents();
+
     void register_receiver(const std::wstring& event, PowertoyModuleIface* module);
     void unregister_receiver(PowertoyModuleIface* module);
 
@@ -15,15 +20,44 @@ public:
     void unregister_system_menu_action(PowertoyModuleIface* module);
     void handle_system_menu_action(const WinHookEvent& data);
 
-    intptr_t signal_event(const std::wstring& event, intptr_t data);
+    // Signal the event to its receivers without taking a lock. Called from the hook procs for every event
+    intptr_t signal_event(PowertoyEventId event, intptr_t data);
+    // Signal the win_hook_event only to the receivers whose ranges contain the event
+    void signal_win_hook_event(WinHookEvent& event);
 
 private:
-    std::shared_mutex mutex;
-    std::unordered_map<std::wstring, std::vector<PowertoyModuleIface*>> receivers;
+    struct Receiver
+    {
+        PowertoyModuleIface* module;
+        // Ranges of the win_hook_event events the module wants to be signaled
+        std::vector<WinHookEventRange> win_hook_event_ranges;
+
+        bool wants_win_hook_event(DWORD event) const;
+    };
+    using Receivers = std::vector<Receiver>;
+    static constexpr size_t event_count = static_cast<size_t>(PowertoyEventId::count);
+
+    // Publish a new list of receivers of the event. Called with the mutex held, returns the replaced list
+    const Receivers* publish_receivers(PowertoyEventId event, Receivers new_receivers);
+    // Free a replaced list once no signal of the event can still use it. Called without the mutex
+    void release_receivers(PowertoyEventId event, const Receivers* replaced);
+    // Hook only the union of the events wanted by the win_hook_event receivers and by the system menu,
+    // and stop the win hook event when that union is empty
+    void update_win_hook_event_ranges();
+
+    // Guards the writers. The receivers of each event are published as immutable lists, which signal_event loads atomically
+    std::mutex mutex;
+    std::array<std::atomic<const Receivers*>, event_count> receivers{};
+    // Bit i is set when the event with id i has receivers
+    std::atomic<uint32_t> subscribed_events = 0;
+    // Number of signal calls in progress, per event
+    std::array<std::atomic<int>, event_count> active_signals{};
+    // Lists replaced from inside a signal of their event, which can't wait for itself. Freed by the next release of the event
+    std::array<std::vector<const Receivers*>, event_count> retired_receivers;
     std::unordered_set<PowertoyModuleIface*> system_menu_receivers;
 };
 
 PowertoysEvents& powertoys_events();
 
-void first_subscribed(const std::wstring& event);
-void last_unsubscribed(const std::wstring& event);
+void first_subscribed(PowertoyEventId event);
+void last_unsubscribed(PowertoyEventId event);
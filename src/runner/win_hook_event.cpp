@@ -1,12 +1,13 @@
 #include "pch.h"
 #include "win_hook_event.h"
 #include "powertoy_module.h"
+#include <common/win_hook_event_queue.h>
 #include <mutex>
-#include <deque>
 #include <thread>
+#include <vector>
 
 static std::mutex mutex;
-static std::deque<WinHookEvent> hook_events;
+static WinHookEventQueue hook_events;
 static std::condition_variable dispatch_cv;
 
 void intercept_system_menu_action(intptr_t);
@@ -20,40 +21,54 @@ static void CALLBACK win_hook_event_proc(HWINEVENTHOOK winEventHook,
                                          DWORD eventTime)
 {
     std::unique_lock lock(mutex);
-    hook_events.push_back({ event,
-                            window,
-                            object,
-                            child,
-                            eventThread,
-                            eventTime });
+    const bool was_empty = hook_events.push({ event,
+                                              window,
+                                              object,
+                                              child,
+                                              eventThread,
+                                              eventTime });
     lock.unlock();
-    dispatch_cv.notify_one();
+    // The dispatch thread only waits when the queue is empty
+    if (was_empty)
+        dispatch_cv.notify_one();
 }
 
 static bool running = false;
 static std::thread dispatch_thread;
 static void dispatch_thread_proc()
 {
+    std::vector<WinHookEvent> batch;
     std::unique_lock lock(mutex);
     while (running)
     {
         dispatch_cv.wait(lock, [] { return !running || !hook_events.empty(); });
         if (!running)
             return;
-        while (!hook_events.empty())
+        // Take all the queued events at once, and signal them without holding the lock
+        hook_events.swap_batch(batch);
+        lock.unlock();
+        for (auto& event : batch)
         {
-            auto event = hook_events.front();
-            hook_events.pop_front();
-            lock.unlock();
-            intptr_t data = reinterpret_cast<intptr_t>(&event);
-            intercept_system_menu_action(data);
-            powertoys_events().signal_event(win_hook_event, data);
-            lock.lock();
+            intercept_system_menu_action(reinterpret_cast<intptr_t>(&event));
+            powertoys_events().signal_win_hook_event(event);
         }
+        batch.clear();
+        lock.lock();
     }
 }
 
-static HWINEVENTHOOK hook_handle;
+static std::vector<HWINEVENTHOOK> hook_handles;
+static std::vector<WinHookEventRange> hooked_ranges;
+
+static void unhook_win_events()
+{
+    for (auto hook_handle : hook_handles)
+    {
+        UnhookWinEvent(hook_handle);
+    }
+    hook_handles.clear();
+    hooked_ranges.clear();
+}
 
 void start_win_hook_event()
 {
@@ -62,7 +77,6 @@ void start_win_hook_event()
         return;
     running = true;
     dispatch_thread = std::thread(dispatch_thread_proc);
-    hook_handle = SetWinEventHook(EVENT_MIN, EVENT_MAX, nullptr, win_hook_event_proc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
 }
 
 void stop_win_hook_event()
@@ -71,13 +85,38 @@ void stop_win_hook_event()
     if (!running)
         return;
     running = false;
-    UnhookWinEvent(hook_handle);
+    unhook_win_events();
     lock.unlock();
     dispatch_cv.notify_one();
     dispatch_thread.join();
     lock.lock();
     hook_events.clear();
-    hook_events.shrink_to_fit();
+}
+
+WinHookEventCounters get_win_hook_event_counters()
+{
+    std::lock_guard lock(mutex);
+    return { hook_events.dropped_count(), hook_events.coalesced_count() };
+}
+
+void set_win_hook_event_ranges(const std::vector<WinHookEventRange>& ranges)
+{
+    std::lock_guard lock(mutex);
+    if (!running)
+        return;
+    auto same_range = [](const WinHookEventRange& a, const WinHookEventRange& b) { return a.min == b.min && a.max == b.max; };
+    if (std::equal(begin(ranges), end(ranges), begin(hooked_ranges), end(hooked_ranges), same_range))
+        return;
+
+    unhook_win_events();
+    for (auto& range : ranges)
+    {
+        if (auto hook_handle = SetWinEventHook(range.min, range.max, nullptr, win_hook_event_proc, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS))
+        {
+            hook_handles.push_back(hook_handle);
+        }
+    }
+    hooked_ranges = ranges;
 }
 
 void intercept_system_menu_action(intptr_t data)
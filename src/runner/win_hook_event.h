@@ -2,5 +2,19 @@
 
 #include <interface/win_hook_event_data.h>
 
+#include <vector>
+
 void start_win_hook_event();
 void stop_win_hook_event();
+
+struct WinHookEventCounters
+{
+    // Number of the events dropped or evicted because the queue was full
+    size_t dropped;
+    // Number of the location and name changes which replaced a queued change of the same window object
+    size_t coalesced;
+};
+WinHookEventCounters get_win_hook_event_counters();
+
+// Replace the hooked events with the ranges. The hooks are installed only while the win hook event is started
+void set_win_hook_event_ranges(const std::vector<WinHookEventRange>& ranges);